@@ -1,4 +1,4 @@
-dnl Copyright 2001,2002,2003,2004,2005,2006,2008 Free Software Foundation, Inc.
+dnl Copyright 2001,2002,2003,2004,2005,2006,2008,2010 Free Software Foundation, Inc.
 dnl 
 dnl This file is part of GNU Radio
 dnl 
@@ -22,9 +22,10 @@ AC_DEFUN([GRC_MBLOCK],[
 
     GRC_WITH(mblock)
 
-    dnl Don't do mblock if omnithread or pmt skipped
+    dnl Don't do mblock if omnithread, pmt or gruel skipped
     GRC_CHECK_DEPENDENCY(mblock, pmt)
     GRC_CHECK_DEPENDENCY(mblock, omnithread)
+    GRC_CHECK_DEPENDENCY(mblock, gruel)
 
     dnl If execution gets to here, $passed will be:
     dnl   with : if the --with code didn't error out
@@ -1,4 +1,4 @@
-dnl Copyright 2001,2002,2003,2004,2005,2006,2008 Free Software Foundation, Inc.
+dnl Copyright 2001,2002,2003,2004,2005,2006,2008,2010 Free Software Foundation, Inc.
 dnl 
 dnl This file is part of GNU Radio
 dnl 
@@ -21,8 +21,8 @@ AC_DEFUN([GRC_PMT],[
     GRC_ENABLE(pmt)
     GRC_WITH(pmt)
 
-    dnl Don't do pmt if omnithread skipped
-    GRC_CHECK_DEPENDENCY(pmt, omnithread)
+    dnl Don't do pmt if gruel skipped
+    GRC_CHECK_DEPENDENCY(pmt, gruel)
 
     dnl If execution gets to here, $passed will be:
     dnl   with : if the --with code didn't error out
@@ -26,24 +26,40 @@
 #include <gri_mmse_fir_interpolator_cc.h>
 #include <gr_fir_util.h>
 #include <gr_fir_ccf.h>
+#include <malloc16.h>
 #include <assert.h>
 #include <cmath>
 #include "interpolator_taps.h"
 
 gri_mmse_fir_interpolator_cc::gri_mmse_fir_interpolator_cc ()
+  : d_nsteps (NSTEPS)
 {
+  assert (NTAPS == NTAPS_PER_STEP);
+
   filters.resize (NSTEPS + 1);
   
   for (int i = 0; i < NSTEPS + 1; i++){
     std::vector<float> t (&taps[i][0], &taps[i][NTAPS]);
     filters[i] = gr_fir_util::create_gr_fir_ccf (t);
   }
+
+  // Like the gr_fir filters, the table holds the taps reversed so that
+  // input[0] meets the last tap.  Each tap appears twice, once for the
+  // real and once for the imaginary part of the input.
+  d_aligned_taps = (float *) calloc16Align ((NSTEPS + 1) * 2 * NTAPS, sizeof (float));
+  for (int i = 0; i < NSTEPS + 1; i++){
+    for (int j = 0; j < NTAPS; j++){
+      d_aligned_taps[i * 2 * NTAPS + 2 * j + 0] = taps[i][NTAPS - 1 - j];
+      d_aligned_taps[i * 2 * NTAPS + 2 * j + 1] = taps[i][NTAPS - 1 - j];
+    }
+  }
 }
 
 gri_mmse_fir_interpolator_cc::~gri_mmse_fir_interpolator_cc ()
 {
   for (int i = 0; i < NSTEPS + 1; i++)
     delete filters[i];
+  free16Align (d_aligned_taps);
 }
 
 unsigned
@@ -69,3 +85,19 @@ gri_mmse_fir_interpolator_cc::interpolate (const gr_complex input[], float mu)
   gr_complex r = filters[imu]->filter (input);
   return r;
 }
+
+void
+gri_mmse_fir_interpolator_cc::interpolate_n (gr_complex output[],
+					     const gr_complex *const input[],
+					     const float mu[],
+					     unsigned nchannels) const
+{
+  for (unsigned k = 0; k < nchannels; k++){
+    int	imu = (int) rint (mu[k] * NSTEPS);
+
+    assert (imu >= 0);
+    assert (imu <= NSTEPS);
+
+    output[k] = dotprod (input[k], &d_aligned_taps[imu * 2 * NTAPS]);
+  }
+}
@@ -24,6 +24,8 @@
 
 #include <gr_complex.h>
 #include <vector>
+#include <cmath>
+#include <assert.h>
 
 class gr_fir_ccf;
 
@@ -61,8 +63,55 @@ public:
    */
   gr_complex interpolate (const gr_complex input[], float mu);
 
+  /*!
+   * \brief compute a single interpolated output value without
+   * going through the gr_fir_ccf dispatch.
+   *
+   * Same contract as interpolate, except that \p input only needs
+   * the natural alignment of gr_complex.  The taps are read from a
+   * 16-byte aligned table in which each tap is duplicated for the I
+   * and Q arms, so both arms are accumulated by a single fixed length
+   * float loop that the compiler can keep in vector registers.
+   */
+  gr_complex interpolate_fast (const gr_complex input[], float mu) const
+  {
+    int	imu = (int) rint (mu * d_nsteps);
+
+    assert (imu >= 0);
+    assert (imu <= d_nsteps);
+
+    return dotprod (input, &d_aligned_taps[imu * 2 * NTAPS_PER_STEP]);
+  }
+
+  /*!
+   * \brief interpolate \p nchannels independent streams in lockstep.
+   *
+   * output[k] = interpolate_fast (input[k], mu[k]) for k in [0, nchannels).
+   * Intended for clock recovery running on the outputs of a channelizer.
+   */
+  void interpolate_n (gr_complex output[], const gr_complex *const input[],
+		      const float mu[], unsigned nchannels) const;
+
 protected:
   std::vector<gr_fir_ccf *>	filters;
+
+private:
+  static const int NTAPS_PER_STEP = 8;
+
+  float	*d_aligned_taps;	// (nsteps + 1) rows of I/Q duplicated, reversed taps
+  int	 d_nsteps;
+
+  static gr_complex dotprod (const gr_complex input[], const float *taps)
+  {
+    const float *in = (const float *) input;
+    float acc[4] = { 0, 0, 0, 0 };
+
+    for (int j = 0; j < 2 * NTAPS_PER_STEP; j += 4)
+      for (int k = 0; k < 4; k++)
+	acc[k] += in[j + k] * taps[j + k];
+
+    return gr_complex (acc[0] + acc[2], acc[1] + acc[3]);
+  }
 };
 
 
@@ -116,3 +116,40 @@ qa_gri_mmse_fir_interpolator_cc::t2()
 {
   CPPUNIT_ASSERT_THROW(t2_body(), std::invalid_argument);
 }
+
+/*
+ * interpolate_fast and the lockstep interpolate_n must agree with the
+ * gr_fir_ccf based interpolate
+ */
+void
+qa_gri_mmse_fir_interpolator_cc::t3()
+{
+  static const unsigned	N = 100;
+  static const unsigned	NCHAN = 5;
+  gr_complex input[NCHAN][N + 10] __attribute__ ((aligned (8)));
+
+  for (unsigned k = 0; k < NCHAN; k++)
+    for (unsigned i = 0; i < N + 10; i++)
+      input[k][i] = test_fcn ((double) i + 0.37 * k);
+
+  gri_mmse_fir_interpolator_cc	intr;
+  float inv_nsteps = 1.0 / intr.nsteps ();
+
+  for (unsigned i = 0; i < N; i++){
+    const gr_complex *in[NCHAN];
+    float mu[NCHAN];
+    gr_complex out[NCHAN];
+
+    for (unsigned k = 0; k < NCHAN; k++){
+      in[k] = &input[k][i];
+      mu[k] = ((i + 17 * k) % (intr.nsteps () + 1)) * inv_nsteps;
+    }
+    intr.interpolate_n (out, in, mu, NCHAN);
+
+    for (unsigned k = 0; k < NCHAN; k++){
+      gr_complex expected = intr.interpolate (in[k], mu[k]);
+      CPPUNIT_ASSERT_COMPLEXES_EQUAL (expected, intr.interpolate_fast (in[k], mu[k]), 1e-5);
+      CPPUNIT_ASSERT_COMPLEXES_EQUAL (expected, out[k], 1e-5);
+    }
+  }
+}
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2002 Free Software Foundation, Inc.
+ * Copyright 2002,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -25,6 +25,7 @@
 #endif
 
 #include <gr_circular_file.h>
+#include <gruel/atomic.h>
 
 #include <unistd.h>
 #ifdef HAVE_SYS_MMAN_H
@@ -32,165 +33,288 @@
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <unistd.h>
 #include <fcntl.h>
 #include <stdio.h>
-#include <assert.h>
-#include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
-#include <stdio.h>
-#include <string.h>
+#include <stdexcept>
+
+// should be handled via configure
+#ifdef O_LARGEFILE
+#define	OUR_O_LARGEFILE	O_LARGEFILE
+#else
+#define	OUR_O_LARGEFILE 0
+#endif
 
 static const int HEADER_SIZE = 4096;
-static const int HEADER_MAGIC = 0xEB021026;
+static const int HEADER_MAGIC = 0xEB021027;
+static const int FLAG_WRITER_ACTIVE = 0x1;
 
-static const int HD_MAGIC = 0;
-static const int HD_HEADER_SIZE = 1;	// integer offsets into header
-static const int HD_BUFFER_SIZE = 2;
-static const int HD_BUFFER_BASE = 3;
-static const int HD_BUFFER_CURRENT = 4;
+struct gr_circular_file::header {
+  gr_int32		magic;
+  gr_int32		header_size;
+  gr_int32		itemsize;
+  volatile gr_int32	flags;
+  gr_int64		buffer_size;
+  volatile gr_int64	head;
+  volatile gr_int64	write_limit;
+  double		sample_rate;
+  double		start_time;
+};
+
+/*
+ * 64-bit loads and stores aren't single instructions everywhere.  The
+ * writer stores with an atomic exchange.  Readers may have the file
+ * mapped read-only, so they can't use read-modify-write instructions;
+ * where long is narrower than 64 bits they read until two reads agree
+ * (the fields only ever move forward).
+ */
+static inline long long
+load64 (const volatile gr_int64 *p)
+{
+  long long v = gruel::atomic_load (p);
+  if (sizeof (long) < 8)
+    for (long long w; (w = gruel::atomic_load (p)) != v; v = w)
+      ;
+  return v;
+}
+
+static inline void
+store64 (volatile gr_int64 *p, long long v)
+{
+  gruel::atomic_exchange (p, (gr_int64) v);
+}
+
+static void
+fail (const char *filename, const char *what)
+{
+  perror (filename);
+  throw std::runtime_error (std::string ("gr_circular_file: ") + what);
+}
 
 gr_circular_file::gr_circular_file (const char *filename,
-				    bool writable, int size)
-  : d_fd (-1), d_header (0), d_buffer (0), d_mapped_size (0), d_bytes_read (0)
+				    bool writable, long long size)
+  : d_fd (-1), d_writable (writable), d_header (0), d_buffer (0), d_mapped_size (0),
+    d_read_offset (-1)
 {
+#ifndef HAVE_MMAP
+  throw std::runtime_error ("gr_circular_file: mmap unsupported by this system");
+#else
   int	mm_prot;
+  int	mm_flags = MAP_SHARED;
+
   if (writable){
-#ifdef HAVE_MMAP
+    if (size <= 0)
+      throw std::invalid_argument ("gr_circular_file: size must be > 0 when writable");
+
     mm_prot = PROT_READ | PROT_WRITE;
+    d_fd = open (filename, O_CREAT | O_RDWR | O_TRUNC | OUR_O_LARGEFILE, 0664);
+    if (d_fd < 0)
+      fail (filename, "can't create file");
+
+    // Reserve the blocks now so a full disk can't SIGBUS us later.
+#ifdef HAVE_POSIX_FALLOCATE
+    if (posix_fallocate (d_fd, 0, size + HEADER_SIZE) != 0
+	&& ftruncate (d_fd, size + HEADER_SIZE) < 0)
+#else
+    if (ftruncate (d_fd, size + HEADER_SIZE) < 0)
 #endif
-    d_fd = open (filename, O_CREAT | O_RDWR | O_TRUNC, 0664);
-    if (d_fd < 0){
-      perror (filename);
-      exit (1);
+    {
+      close (d_fd);
+      fail (filename, "can't size file");
     }
-#ifdef HAVE_MMAP	/* FIXME */
-    ftruncate (d_fd, size + HEADER_SIZE);
+
+#ifdef MAP_POPULATE
+    mm_flags |= MAP_POPULATE;	// take the page faults now, not while streaming
 #endif
   }
   else {
-#ifdef HAVE_MMAP
     mm_prot = PROT_READ;
-#endif
-    d_fd = open (filename, O_RDONLY);
-    if (d_fd < 0){
-      perror (filename);
-      exit (1);
-    }
+    d_fd = open (filename, O_RDONLY | OUR_O_LARGEFILE);
+    if (d_fd < 0)
+      fail (filename, "can't open file");
   }
 
   struct stat statbuf;
   if (fstat (d_fd, &statbuf) < 0){
-    perror (filename);
-    exit (1);
+    close (d_fd);
+    fail (filename, "can't stat file");
   }
 
   if (statbuf.st_size < HEADER_SIZE){
-    fprintf (stderr, "%s: file too small to be circular buffer\n", filename);
-    exit (1);
+    close (d_fd);
+    throw std::runtime_error ("gr_circular_file: file too small to be circular buffer");
   }
 
   d_mapped_size = statbuf.st_size;
-#ifdef HAVE_MMAP
-  void *p = mmap (0, d_mapped_size, mm_prot, MAP_SHARED, d_fd, 0);
+  void *p = mmap (0, d_mapped_size, mm_prot, mm_flags, d_fd, 0);
   if (p == MAP_FAILED){
-    perror ("gr_circular_file: mmap failed");
-    exit (1);
+    close (d_fd);
+    fail (filename, "mmap failed");
   }
-
-  d_header = (int *) p;
-#else
-    perror ("gr_circular_file: mmap unsupported by this system");
-    exit (1);
-#endif
+  d_header = (header *) p;
 
   if (writable){       	// init header
-
-    if (size < 0){
-      fprintf (stderr, "gr_circular_buffer: size must be > 0 when writable\n");
-      exit (1);
-    }
-
-    d_header[HD_MAGIC] = HEADER_MAGIC;
-    d_header[HD_HEADER_SIZE] = HEADER_SIZE;
-    d_header[HD_BUFFER_SIZE] = size;
-    d_header[HD_BUFFER_BASE] = HEADER_SIZE;	// right after header
-    d_header[HD_BUFFER_CURRENT] = 0;
+    memset (d_header, 0, sizeof (*d_header));
+    d_header->header_size = HEADER_SIZE;
+    d_header->buffer_size = size;
+    d_header->flags = FLAG_WRITER_ACTIVE;
+    gruel::memory_barrier ();
+    d_header->magic = HEADER_MAGIC;	// last: the file is now valid
   }
 
-  // sanity check (the asserts are a bit unforgiving...)
-
-  assert (d_header[HD_MAGIC] == HEADER_MAGIC);
-  assert (d_header[HD_HEADER_SIZE] == HEADER_SIZE);
-  assert (d_header[HD_BUFFER_SIZE] > 0);
-  assert (d_header[HD_BUFFER_BASE] >= d_header[HD_HEADER_SIZE]);
-  assert (d_header[HD_BUFFER_BASE] + d_header[HD_BUFFER_SIZE] <= d_mapped_size);
-  assert (d_header[HD_BUFFER_CURRENT] >= 0 &&
-	  d_header[HD_BUFFER_CURRENT] < d_header[HD_BUFFER_SIZE]);
+  // sanity check
+  if (d_header->magic != HEADER_MAGIC
+      || d_header->header_size != HEADER_SIZE
+      || d_header->buffer_size <= 0
+      || (long long) d_header->buffer_size + HEADER_SIZE > (long long) d_mapped_size){
+    munmap ((char *) d_header, d_mapped_size);
+    close (d_fd);
+    throw std::runtime_error ("gr_circular_file: not a circular buffer file");
+  }
 
-  d_bytes_read = 0;
-  d_buffer = (unsigned char *) d_header + d_header[HD_BUFFER_BASE];
+  d_buffer = (unsigned char *) d_header + HEADER_SIZE;
+#endif
 }
 
 gr_circular_file::~gr_circular_file ()
 {
 #ifdef HAVE_MMAP
-  if (munmap ((char *) d_header, d_mapped_size) < 0){
-    perror ("gr_circular_file: munmap");
-    exit (1);
-  }
+  if (d_writable)
+    set_writer_active (false);
+  munmap ((char *) d_header, d_mapped_size);
 #endif
   close (d_fd);
 }
 
 bool
-gr_circular_file::write (void *vdata, int nbytes)
+gr_circular_file::write (const void *vdata, int nbytes)
 {
-  unsigned char *data = (unsigned char *) vdata;
-  int	buffer_size = d_header[HD_BUFFER_SIZE];
-  int	buffer_current = d_header[HD_BUFFER_CURRENT];
-  
-  while (nbytes > 0){
-    int n = std::min (nbytes, buffer_size - buffer_current);
-    memcpy (d_buffer + buffer_current, data, n);
-    
-    buffer_current += n;
-    if (buffer_current >= buffer_size)
-      buffer_current = 0;
-    
-    data += n;
-    nbytes -= n;
+  const unsigned char *data = (const unsigned char *) vdata;
+  long long buffer_size = d_header->buffer_size;
+  long long head = d_header->head;	// we're the only writer
+
+  if (nbytes > buffer_size){		// only the tail end survives anyway
+    data += nbytes - buffer_size;
+    head += nbytes - buffer_size;
+    nbytes = buffer_size;
   }
 
-  d_header[HD_BUFFER_CURRENT] = buffer_current;
+  store64 (&d_header->write_limit, head + nbytes);
+
+  long long offset = head % buffer_size;
+  int n = std::min ((long long) nbytes, buffer_size - offset);
+  memcpy (d_buffer + offset, data, n);
+  memcpy (d_buffer, data + n, nbytes - n);
+
+  store64 (&d_header->head, head + nbytes);
   return true;
 }
 
 int
-gr_circular_file::read (void *vdata, int nbytes)
+gr_circular_file::read_at (long long &offset, void *vdata, int nbytes)
 {
   unsigned char *data = (unsigned char *) vdata;
-  int	buffer_current = d_header[HD_BUFFER_CURRENT];
-  int	buffer_size = d_header[HD_BUFFER_SIZE];
-  int	total = 0;
-  
-  nbytes = std::min (nbytes, buffer_size - d_bytes_read);
-
-  while (nbytes > 0){
-    int offset = (buffer_current + d_bytes_read) % buffer_size;
-    int n = std::min (nbytes, buffer_size - offset);
-    memcpy (data, d_buffer + offset, n);
-    data += n;
-    d_bytes_read += n;
-    total += n;
-    nbytes -= n;
+  long long buffer_size = d_header->buffer_size;
+
+  for (;;){
+    long long head = load64 (&d_header->head);
+    offset = std::max (offset, std::max (0LL, head - buffer_size));
+    int total = (int) std::max (0LL, std::min ((long long) nbytes, head - offset));
+    if (total == 0)
+      return 0;
+
+    long long start = offset % buffer_size;
+    int n = std::min ((long long) total, buffer_size - start);
+    memcpy (data, d_buffer + start, n);
+    memcpy (data + n, d_buffer, total - n);
+
+    // Drop whatever the writer may have overwritten while we copied.
+    // The barrier keeps the copy's loads ahead of the write_limit load.
+    gruel::memory_barrier ();
+    long long lost = load64 (&d_header->write_limit) - buffer_size - offset;
+    if (lost <= 0)
+      return total;
+    if (lost < total){
+      memmove (data, data + lost, total - lost);
+      offset += lost;
+      return total - lost;
+    }
+    // Lapped during the copy; try again from the new oldest byte.
   }
-  return total;
+}
+
+int
+gr_circular_file::read (void *data, int nbytes)
+{
+  if (d_read_offset < 0)
+    d_read_offset = oldest ();
+
+  int n = read_at (d_read_offset, data, nbytes);
+  d_read_offset += n;
+  return n;
 }
 
 void
 gr_circular_file::reset_read_pointer ()
 {
-  d_bytes_read = 0;
+  d_read_offset = -1;
+}
+
+long long
+gr_circular_file::size () const
+{
+  return d_header->buffer_size;
+}
+
+long long
+gr_circular_file::nbytes_written () const
+{
+  return load64 (&d_header->head);
+}
+
+long long
+gr_circular_file::oldest () const
+{
+  return std::max (0LL, nbytes_written () - size ());
+}
+
+bool
+gr_circular_file::writer_active () const
+{
+  return (gruel::atomic_load (&d_header->flags) & FLAG_WRITER_ACTIVE) != 0;
+}
+
+void
+gr_circular_file::set_writer_active (bool active)
+{
+  gruel::atomic_store (&d_header->flags, active ? FLAG_WRITER_ACTIVE : 0);
+}
+
+void
+gr_circular_file::set_info (int itemsize, double sample_rate, double start_time)
+{
+  d_header->itemsize = itemsize;
+  d_header->sample_rate = sample_rate;
+  d_header->start_time = start_time;
+  gruel::memory_barrier ();
+}
+
+int
+gr_circular_file::itemsize () const
+{
+  return d_header->itemsize;
+}
+
+double
+gr_circular_file::sample_rate () const
+{
+  return d_header->sample_rate;
+}
+
+double
+gr_circular_file::start_time () const
+{
+  return d_header->start_time;
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2002 Free Software Foundation, Inc.
+ * Copyright 2002,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,36 +23,92 @@
 #ifndef _GR_CIRCULAR_FILE_H_
 #define _GR_CIRCULAR_FILE_H_
 
+#include <gr_types.h>
+
 /*
  * writes input data into a circular buffer on disk.
  *
  * the file contains a fixed header:
- *   0x0000:    int32 magic (0xEB021026)
+ *   0x0000:    int32 magic (0xEB021027)
  *   0x0004:	int32 size in bytes of header (constant 4096)
- *   0x0008:	int32 size in bytes of circular buffer (not including header)
- *   0x000C:    int32 file offset to beginning of circular buffer
- *   0x0010:    int32 byte offset from beginning of circular buffer to 
- *		      current start of data
+ *   0x0008:	int32 item size in bytes, 0 if unknown
+ *   0x000C:	int32 flags (bit 0: a writer has the file open)
+ *   0x0010:	int64 size in bytes of circular buffer (not including header)
+ *   0x0018:	int64 total bytes written (head)
+ *   0x0020:	int64 write limit
+ *   0x0028:	double sample rate [items/s], 0 if unknown
+ *   0x0030:	double time of the first item [s since the Unix epoch]
+ *
+ * The circular buffer starts right after the header.  Byte n of the
+ * stream lives at offset n % size in the buffer, so the buffer holds
+ * the stream bytes [head - size, head).
  *
+ * The writer raises the write limit before it copies data into the
+ * buffer and raises head after.  A reader in another thread or
+ * process therefore never blocks the writer: it copies what it wants,
+ * then discards whatever lies below (write limit - size), which may
+ * have been overwritten during the copy.  head and the write limit
+ * are read and written atomically.
  */
 class gr_circular_file {
+  struct header;
+
   int		 d_fd;
-  int		*d_header;
+  bool		 d_writable;
+  header	*d_header;
   unsigned char	*d_buffer;
-  int		 d_mapped_size;
-  int		 d_bytes_read;
+  size_t	 d_mapped_size;
+  long long	 d_read_offset;	// stream offset for read(), -1 after reset
 
 public:
-  gr_circular_file (const char *filename, bool writable = false, int size = 0);
+  /*!
+   * Open \p filename.  If \p writable the file is created (or
+   * truncated) with a buffer of \p size bytes and the caller becomes
+   * its one writer.  Throws std::runtime_error on failure.
+   */
+  gr_circular_file (const char *filename, bool writable = false, long long size = 0);
   ~gr_circular_file ();
 
-  bool write (void *data, int nbytes);
+  bool write (const void *data, int nbytes);
 
   // returns # of bytes actually read or 0 if end of buffer, or -1 on error.
+  // Reading starts at the oldest byte in the buffer and continues with
+  // new data as it is written.
   int read (void *data, int nbytes);
 
   // reset read pointer to beginning of buffer.
   void reset_read_pointer ();
+
+  /*!
+   * \brief Copy up to \p nbytes stream bytes starting at \p offset.
+   *
+   * Safe while the writer runs.  If the bytes at \p offset have already
+   * been overwritten, \p offset is moved forward to the oldest byte
+   * still available.  Never returns bytes that have not been written yet.
+   *
+   * \returns the number of bytes copied, starting at stream offset \p offset
+   */
+  int read_at (long long &offset, void *data, int nbytes);
+
+  //! size of the circular buffer in bytes
+  long long size () const;
+  //! total bytes written since the file was created
+  long long nbytes_written () const;
+  //! stream offset of the oldest byte in the buffer
+  long long oldest () const;
+  //! true while a writer has the file open
+  bool writer_active () const;
+
+  /*!
+   * \brief Describe the stream, for readers that locate data by time.
+   * Only the writer may call this.
+   */
+  void set_info (int itemsize, double sample_rate, double start_time);
+  void set_writer_active (bool active);
+
+  int itemsize () const;
+  double sample_rate () const;
+  double start_time () const;
 };
 
 #endif /* _GR_CIRCULAR_FILE_H_ */
@@ -81,27 +81,20 @@ gr_clock_recovery_mm_cc::forecast(int noutput_items, gr_vector_int &ninput_items
       (int) ceil((noutput_items * d_omega) + d_interp->ntaps());
 }
 
+// The slicers are written as comparisons rather than branches; the
+// sign of a noisy symbol is unpredictable and mispredicts dominate
+// the per-symbol cost otherwise.
+
 gr_complex
 gr_clock_recovery_mm_cc::slicer_0deg (gr_complex sample)
 {
-  float real=0, imag=0;
-
-  if(sample.real() > 0)
-    real = 1;
-  if(sample.imag() > 0)
-    imag = 1;
-  return gr_complex(real,imag);
+  return gr_complex(sample.real() > 0, sample.imag() > 0);
 }
 
 gr_complex
 gr_clock_recovery_mm_cc::slicer_45deg (gr_complex sample)
 {
-  float real= -1, imag = -1;
-  if(sample.real() > 0)
-    real=1;
-  if(sample.imag() > 0)
-    imag = 1;
-  return gr_complex(real,imag);
+  return gr_complex(2 * (sample.real() > 0) - 1, 2 * (sample.imag() > 0) - 1);
 }
 
 /*
@@ -140,7 +133,7 @@ gr_clock_recovery_mm_cc::general_work (int noutput_items,
     while(oo < noutput_items && ii < ni) {
       d_p_2T = d_p_1T;
       d_p_1T = d_p_0T;
-      d_p_0T = d_interp->interpolate (&in[ii], d_mu);
+      d_p_0T = d_interp->interpolate_fast (&in[ii], d_mu);
 
       d_c_2T = d_c_1T;
       d_c_1T = d_c_0T;
@@ -173,7 +166,7 @@ gr_clock_recovery_mm_cc::general_work (int noutput_items,
     while(oo < noutput_items && ii < ni) {
       d_p_2T = d_p_1T;
       d_p_1T = d_p_0T;
-      d_p_0T = d_interp->interpolate (&in[ii], d_mu);
+      d_p_0T = d_interp->interpolate_fast (&in[ii], d_mu);
 
       d_c_2T = d_c_1T;
       d_c_1T = d_c_0T;
@@ -24,6 +24,7 @@
 
 #include <gr_decode_ccsds_27_fb.h>
 #include <gr_io_signature.h>
+#include <gr_prefs.h>
 
 gr_decode_ccsds_27_fb_sptr 
 gr_make_decode_ccsds_27_fb()
@@ -35,7 +36,9 @@ gr_decode_ccsds_27_fb::gr_decode_ccsds_27_fb()
   : gr_sync_decimator("decode_ccsds_27_fb",
 		      gr_make_io_signature(1, 1, sizeof(float)),
 		      gr_make_io_signature(1, 1, sizeof(char)),
-		      2*8)  // Rate 1/2 code, unpacked to packed translation
+		      2*8),  // Rate 1/2 code, unpacked to packed translation
+    d_generic(gr_prefs::singleton()->get_bool("decode_ccsds_27_fb", "generic", false)),
+    d_count(0)
 {
     float RATE = 0.5;
     float ebn0 = 12.0;
@@ -43,6 +46,7 @@ gr_decode_ccsds_27_fb::gr_decode_ccsds_27_fb()
 
     gen_met(d_mettab, 100, esn0, 0.0, 256);
     viterbi_chunks_init(d_state0);
+    viterbi_chunks_init_soa(&d_soa_state0);
 }
 
 gr_decode_ccsds_27_fb::~gr_decode_ccsds_27_fb()
@@ -69,12 +73,18 @@ gr_decode_ccsds_27_fb::work(int noutput_items,
     d_viterbi_in[d_count % 4] = sym;
     if ((d_count % 4) == 3) {
       // Every fourth symbol, perform butterfly operation
-      viterbi_butterfly2(d_viterbi_in, d_mettab, d_state0, d_state1);
+      if (d_generic)
+	viterbi_butterfly2(d_viterbi_in, d_mettab, d_state0, d_state1);
+      else
+	viterbi_butterfly2_soa(d_viterbi_in, d_mettab, &d_soa_state0, &d_soa_state1);
       
       // Every sixteenth symbol, read out a byte
       if (d_count % 16 == 11) {
 	// long metric = 
-	viterbi_get_output(d_state0, out++);
+	if (d_generic)
+	  viterbi_get_output(d_state0, out++);
+	else
+	  viterbi_get_output_soa(&d_soa_state0, out++);
 	// printf("%li\n", *(out-1), metric);
       }
     }
@@ -49,6 +49,10 @@ gr_decode_ccsds_27_fb_sptr gr_make_decode_ccsds_27_fb();
  * This block is designed for continuous data streaming, not packetized data.
  * The first 32 bits out will be zeroes, with the output delayed four bytes
  * from the corresponding inputs.
+ *
+ * By default the branch free structure-of-arrays decoder is used.  Setting
+ * generic = true in the [decode_ccsds_27_fb] section of the preferences
+ * selects the original implementation; both produce identical output.
  */
 
 class gr_decode_ccsds_27_fb : public gr_sync_decimator
@@ -62,7 +66,10 @@ private:
   int d_mettab[2][256];
   struct viterbi_state d_state0[64];
   struct viterbi_state d_state1[64];
+  struct viterbi_soa_state d_soa_state0;
+  struct viterbi_soa_state d_soa_state1;
   unsigned char d_viterbi_in[16];
+  bool d_generic;
 
   int d_count;
       
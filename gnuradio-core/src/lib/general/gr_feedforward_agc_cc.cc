@@ -77,14 +77,25 @@ gr_feedforward_agc_cc::work(int noutput_items,
   const gr_complex *in = (const gr_complex *) input_items[0];
   gr_complex *out = (gr_complex *) output_items[0];
   int	nsamples = d_nsamples;
+  int	ninput = noutput_items + nsamples - 1;
   float gain;
-  
+
+  if ((int) d_env.size() < ninput){
+    d_env.resize(ninput);
+    d_max_env.resize(ninput);
+  }
+
+  float *env = &d_env[0];
+  float *max_env = &d_max_env[0];
+
+  for (int j = 0; j < ninput; j++)
+    env[j] = envelope(in[j]);
+
+  d_window_max.run(max_env, env, noutput_items, nsamples);
+
   for (int i = 0; i < noutput_items; i++){
-    //float max_env = 1e-12;	// avoid divide by zero
-    float max_env = 1e-4;	// avoid divide by zero, indirectly set max gain
-    for (int j = 0; j < nsamples; j++)
-      max_env = std::max(max_env, envelope(in[i+j]));
-    gain = d_reference / max_env;
+    // the floor avoids divide by zero and indirectly sets the max gain
+    gain = d_reference / std::max(1e-4f, max_env[i]);
     out[i] = gain * in[i];
   }
   return noutput_items;
@@ -24,6 +24,8 @@
 #define INCLUDED_GR_FEEDFORWARD_AGC_CC_H
 
 #include <gr_sync_block.h>
+#include <gri_sliding_window.h>
+#include <vector>
 
 class gr_feedforward_agc_cc;
 typedef boost::shared_ptr<gr_feedforward_agc_cc> gr_feedforward_agc_cc_sptr;
@@ -34,6 +36,9 @@ gr_make_feedforward_agc_cc(int nsamples, float reference = 1.0);
 /*!
  * \brief Non-causal AGC which computes required gain based on max absolute value over nsamples
  * \ingroup level_blk
+ *
+ * The windowed maximum is tracked with a monotonic queue, so the cost
+ * per output sample is constant rather than proportional to nsamples.
  */
 class gr_feedforward_agc_cc : public gr_sync_block
 {
@@ -42,6 +47,9 @@ class gr_feedforward_agc_cc : public gr_sync_block
   
   int		d_nsamples;
   float		d_reference;
+  std::vector<float> d_env;	// envelope of the current input span
+  std::vector<float> d_max_env;	// windowed maximum of d_env
+  gri_sliding_max<float> d_window_max;
 
   gr_feedforward_agc_cc(int nsamples, float reference);
 
@@ -28,6 +28,22 @@
 #include <gr_io_signature.h>
 #include <stdexcept>
 #include <iostream>
+#include <string.h>
+
+/*
+ * s_table.bits[t][j] is bit (7 - j) of t.  Unpacking the low k <= 8 bits of
+ * a byte MSB first is then a copy of the last k entries of its row.
+ */
+static struct unpack_table {
+  unsigned char bits[256][8];
+
+  unpack_table ()
+  {
+    for (unsigned int t = 0; t < 256; t++)
+      for (unsigned int j = 0; j < 8; j++)
+	bits[t][j] = (t >> (7 - j)) & 0x01;
+  }
+} s_table;
 
 gr_unpack_k_bits_bb_sptr gr_make_unpack_k_bits_bb (unsigned k)
 {
@@ -59,10 +75,18 @@ gr_unpack_k_bits_bb::work (int noutput_items,
   unsigned char *out = (unsigned char *) output_items[0];
 
   int n = 0;
-  for (unsigned int i = 0; i < noutput_items/d_k; i++){
-    unsigned int t = in[i];
-    for (int j = d_k - 1; j >= 0; j--)
-      out[n++] = (t >> j) & 0x01;
+  if (d_k <= 8){
+    for (unsigned int i = 0; i < noutput_items/d_k; i++){
+      memcpy (&out[n], &s_table.bits[in[i]][8 - d_k], d_k);
+      n += d_k;
+    }
+  }
+  else {
+    for (unsigned int i = 0; i < noutput_items/d_k; i++){
+      unsigned int t = in[i];
+      for (int j = d_k - 1; j >= 0; j--)
+	out[n++] = (t >> j) & 0x01;
+    }
   }
 
   assert(n == noutput_items);
@@ -24,11 +24,17 @@
 #define _GRI_AGC2_CC_H_
 
 #include <math.h>
+#include <algorithm>
 
 /*!
  * \brief high performance Automatic Gain Control class
  *
  * For Power the absolute value of the complex number is used.
+ *
+ * With an update period of N > 1, scaleN holds the gain constant
+ * across blocks of N samples and picks the attack or decay rate from
+ * the mean error of the block.  The default period of 1 is the
+ * original per-sample loop.
  */
 class gri_agc2_cc {
 
@@ -36,19 +42,21 @@ class gri_agc2_cc {
   gri_agc2_cc (float attack_rate = 1e-1, float decay_rate = 1e-2, float reference = 1.0, 
 	       float gain = 1.0, float max_gain = 0.0)
     : _attack_rate(attack_rate), _decay_rate(decay_rate), _reference(reference),
-      _gain(gain), _max_gain(max_gain) {};
+      _gain(gain), _max_gain(max_gain), _update_period(1) {};
 
   float decay_rate () const  { return _decay_rate; }
   float attack_rate () const { return _attack_rate; }
   float reference () const   { return _reference; }
   float gain () const 	     { return _gain;  }
   float max_gain() const     { return _max_gain; }
+  unsigned update_period() const { return _update_period; }
 
   void set_decay_rate (float rate) { _decay_rate = rate; }
   void set_attack_rate (float rate) { _attack_rate = rate; }
   void set_reference (float reference) { _reference = reference; }
   void set_gain (float gain) { _gain = gain; }
   void set_max_gain(float max_gain) { _max_gain = max_gain; }
+  void set_update_period(unsigned n) { _update_period = n < 1 ? 1 : n; }
 
   gr_complex scale (gr_complex input){
     gr_complex output = input * _gain;
@@ -75,8 +83,34 @@ class gri_agc2_cc {
   }
 
   void scaleN (gr_complex output[], const gr_complex input[], unsigned n){
-    for (unsigned i = 0; i < n; i++)
-      output[i] = scale (input[i]);
+    if (_update_period <= 1){
+      for (unsigned i = 0; i < n; i++)
+	output[i] = scale (input[i]);
+      return;
+    }
+
+    for (unsigned i = 0; i < n; i += _update_period){
+      unsigned m = std::min (_update_period, n - i);
+      float *out = (float *) &output[i];
+      const float *in = (const float *) &input[i];
+      float gain = _gain;
+      float err = 0;
+
+      for (unsigned j = 0; j < 2 * m; j++)
+	out[j] = in[j] * gain;
+      for (unsigned j = 0; j < 2 * m; j += 2)
+	err += sqrtf(out[j]*out[j] + out[j+1]*out[j+1]) - _reference;
+
+      float rate = _decay_rate;
+      if (err / m > _gain)
+	rate = _attack_rate;
+      _gain -= err * rate;
+
+      if (_gain < 0.0)
+	_gain = 10e-5;
+      if (_max_gain > 0.0 && _gain > _max_gain)
+	_gain = _max_gain;
+    }
   }
   
  protected:
@@ -85,6 +119,7 @@ class gri_agc2_cc {
   float	_reference;		// reference value
   float	_gain;			// current gain
   float _max_gain;		// max allowable gain
+  unsigned _update_period;	// samples between gain updates in scaleN
 };
 
 #endif /* _GRI_AGC2_CC_H_ */
@@ -24,11 +24,19 @@
 #define INCLUDED_GRI_AGC_CC_H
 
 #include <math.h>
+#include <algorithm>
 
 /*!
  * \brief high performance Automatic Gain Control class
  *
  * For Power the absolute value of the complex number is used.
+ *
+ * By default the gain is updated after every sample.  With an update
+ * period of N > 1, scaleN holds the gain constant across blocks of N
+ * samples and applies the accumulated error of the whole block at once.
+ * This removes the per-sample dependency between gain and output and
+ * lets the scaling loop vectorize, at the cost of reacting N samples
+ * later.
  */
 
 class gri_agc_cc {
@@ -37,17 +45,19 @@ class gri_agc_cc {
   gri_agc_cc (float rate = 1e-4, float reference = 1.0, 
               float gain = 1.0, float max_gain = 0.0)
     : _rate(rate), _reference(reference),
-      _gain(gain), _max_gain(max_gain) {};
+      _gain(gain), _max_gain(max_gain), _update_period(1) {};
 
   float rate () const      { return _rate; }
   float reference () const { return _reference; }
   float gain () const 	   { return _gain;  }
   float max_gain() const   { return _max_gain; }
+  unsigned update_period() const { return _update_period; }
 
   void set_rate (float rate) { _rate = rate; }
   void set_reference (float reference) { _reference = reference; }
   void set_gain (float gain) { _gain = gain; }
   void set_max_gain(float max_gain) { _max_gain = max_gain; }
+  void set_update_period(unsigned n) { _update_period = n < 1 ? 1 : n; }
 
   gr_complex scale (gr_complex input){
     gr_complex output = input * _gain;
@@ -60,8 +70,28 @@ class gri_agc_cc {
   }
 
   void scaleN (gr_complex output[], const gr_complex input[], unsigned n){
-    for (unsigned i = 0; i < n; i++)
-      output[i] = scale (input[i]);
+    if (_update_period <= 1){
+      for (unsigned i = 0; i < n; i++)
+	output[i] = scale (input[i]);
+      return;
+    }
+
+    for (unsigned i = 0; i < n; i += _update_period){
+      unsigned m = std::min (_update_period, n - i);
+      float *out = (float *) &output[i];
+      const float *in = (const float *) &input[i];
+      float gain = _gain;
+      float err = 0;
+
+      for (unsigned j = 0; j < 2 * m; j++)
+	out[j] = in[j] * gain;
+      for (unsigned j = 0; j < 2 * m; j += 2)
+	err += _reference - sqrtf(out[j]*out[j] + out[j+1]*out[j+1]);
+
+      _gain += _rate * err;
+      if (_max_gain > 0.0 && _gain > _max_gain)
+	_gain = _max_gain;
+    }
   }
   
  protected:
@@ -69,6 +99,7 @@ class gri_agc_cc {
   float	_reference;		// reference value
   float	_gain;			// current gain
   float _max_gain;		// max allowable gain
+  unsigned _update_period;	// samples between gain updates in scaleN
 };
 
 #endif /* INCLUDED_GRI_AGC_CC_H */
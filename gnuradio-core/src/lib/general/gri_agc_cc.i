@@ -38,4 +38,6 @@ class gri_agc_cc {
   float reference ();
   float gain ();
   float max_gain ();
+  unsigned update_period ();
+  void set_update_period (unsigned n);
   };
@@ -0,0 +1,218 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GRI_SLIDING_WINDOW_H
+#define INCLUDED_GRI_SLIDING_WINDOW_H
+
+#include <gr_complex.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+/*
+ * Sliding window statistics over contiguous sample buffers.
+ *
+ * All routines follow the convention of a gr_sync_block with
+ * set_history(length): for n outputs the caller supplies
+ * in[0 .. n + length - 2] and out[i] describes the window
+ * in[i .. i + length - 1].
+ *
+ * Running sums are maintained by adding the newest and subtracting
+ * the oldest sample.  For floating point types that accumulates
+ * rounding error, so the sum is recomputed exactly every \p resync
+ * outputs.  Pass resync <= 0 to never resynchronize (fine for
+ * integer types).
+ *
+ * The sum and power routines work in batches of GRI_SW_BATCH outputs.
+ * The differences between successive windows (newest in, oldest out)
+ * don't depend on one another, and with a constant trip count the
+ * compiler vectorizes that loop even at -O2; what's left serial is a
+ * prefix sum of them, one add per output rather than an add and a
+ * subtract.
+ */
+
+static const int GRI_SW_BATCH = 64;
+
+static inline float  gri_sw_power (float x)       { return x * x; }
+static inline double gri_sw_power (double x)      { return x * x; }
+static inline float  gri_sw_power (gr_complex x)  { return x.real() * x.real() + x.imag() * x.imag(); }
+static inline int    gri_sw_power (int x)         { return x * x; }
+static inline int    gri_sw_power (short x)       { return x * x; }
+
+/*!
+ * \brief out[i] = scale * sum (in[i .. i + length - 1]), accumulated in acc_type
+ */
+template<class i_type, class acc_type, class o_type>
+void
+gri_sliding_sum (o_type *out, const i_type *in, int n, int length,
+		 o_type scale, int resync)
+{
+  acc_type delta[GRI_SW_BATCH];
+
+  int i = 0;
+  while (i < n){
+    int k = i + ((resync > 0) ? std::min (n - i, resync) : n - i);
+
+    acc_type sum = 0;
+    for (int j = 0; j < length; j++)
+      sum += in[i + j];
+    out[i++] = sum * scale;
+
+    for (; i + GRI_SW_BATCH <= k; i += GRI_SW_BATCH){
+      const i_type *newest = in + i + length - 1;
+      const i_type *oldest = in + i - 1;
+      for (int j = 0; j < GRI_SW_BATCH; j++)
+	delta[j] = (acc_type) newest[j] - (acc_type) oldest[j];
+      for (int j = 0; j < GRI_SW_BATCH; j++){
+	sum += delta[j];
+	out[i + j] = sum * scale;
+      }
+    }
+    for (; i < k; i++){
+      sum += (acc_type) in[i + length - 1] - (acc_type) in[i - 1];
+      out[i] = sum * scale;
+    }
+  }
+}
+
+/*!
+ * \brief out[i] = scale * sum (|in[i .. i + length - 1]|^2), accumulated in acc_type
+ */
+template<class i_type, class acc_type, class o_type>
+void
+gri_sliding_power (o_type *out, const i_type *in, int n, int length,
+		   o_type scale, int resync)
+{
+  acc_type delta[GRI_SW_BATCH];
+
+  int i = 0;
+  while (i < n){
+    int k = i + ((resync > 0) ? std::min (n - i, resync) : n - i);
+
+    acc_type sum = 0;
+    for (int j = 0; j < length; j++)
+      sum += gri_sw_power (in[i + j]);
+    out[i++] = sum * scale;
+
+    for (; i + GRI_SW_BATCH <= k; i += GRI_SW_BATCH){
+      const i_type *newest = in + i + length - 1;
+      const i_type *oldest = in + i - 1;
+      for (int j = 0; j < GRI_SW_BATCH; j++)
+	delta[j] = ((acc_type) gri_sw_power (newest[j])
+		    - (acc_type) gri_sw_power (oldest[j]));
+      for (int j = 0; j < GRI_SW_BATCH; j++){
+	sum += delta[j];
+	out[i + j] = sum * scale;
+      }
+    }
+    for (; i < k; i++){
+      sum += ((acc_type) gri_sw_power (in[i + length - 1])
+	      - (acc_type) gri_sw_power (in[i - 1]));
+      out[i] = sum * scale;
+    }
+  }
+}
+
+/*!
+ * \brief windowed mean and (population) variance of real samples
+ *
+ * Uses running sums of x and x^2 accumulated in double.
+ */
+template<class i_type, class o_type>
+void
+gri_sliding_mean_var (o_type *mean, o_type *var, const i_type *in,
+		      int n, int length, int resync)
+{
+  int i = 0;
+  while (i < n){
+    int m = (resync > 0) ? std::min (n - i, resync) : n - i;
+
+    double s1 = 0, s2 = 0;
+    for (int j = 0; j < length - 1; j++){
+      s1 += in[i + j];
+      s2 += (double) in[i + j] * in[i + j];
+    }
+
+    for (int k = i + m; i < k; i++){
+      double x = in[i + length - 1];
+      s1 += x;
+      s2 += x * x;
+      double mu = s1 / length;
+      mean[i] = mu;
+      var[i] = std::max (0.0, s2 / length - mu * mu);
+      x = in[i];
+      s1 -= x;
+      s2 -= x * x;
+    }
+  }
+}
+
+/*!
+ * \brief windowed maximum (or minimum) via a monotonic queue
+ *
+ * Each input index enters and leaves the queue at most once, so the
+ * cost per output is amortized O(1) regardless of the window length.
+ * The exact maximum is returned; there is no accumulated error.
+ *
+ * \p compare is std::greater_equal<T> for max, std::less_equal<T> for min.
+ */
+template<class T, class compare>
+class gri_sliding_extremum {
+  std::vector<int> d_q;		// indices into in, in[q[head..tail)] monotonic
+  compare	   d_dominates;
+
+ public:
+  void run (T *out, const T *in, int n, int length)
+  {
+    int ninput = n + length - 1;
+    if ((int) d_q.size() < ninput)
+      d_q.resize (ninput);
+
+    int *q = &d_q[0];
+    int head = 0, tail = 0;
+
+    // prime with all but the newest sample of the first window
+    for (int j = 0; j < length - 1; j++){
+      while (tail > head && d_dominates (in[j], in[q[tail-1]]))
+	tail--;
+      q[tail++] = j;
+    }
+
+    for (int i = 0; i < n; i++){
+      int j = i + length - 1;
+      while (tail > head && d_dominates (in[j], in[q[tail-1]]))
+	tail--;
+      q[tail++] = j;
+      if (q[head] < i)		// oldest sample fell out of the window
+	head++;
+      out[i] = in[q[head]];
+    }
+  }
+};
+
+template<class T>
+class gri_sliding_max : public gri_sliding_extremum<T, std::greater_equal<T> > {};
+
+template<class T>
+class gri_sliding_min : public gri_sliding_extremum<T, std::less_equal<T> > {};
+
+#endif /* INCLUDED_GRI_SLIDING_WINDOW_H */
@@ -33,6 +33,7 @@
 #include <qa_gr_fxpt_vco.h>
 #include <qa_gr_math.h>
 #include <qa_gri_lfsr.h>
+#include <qa_gri_sliding_window.h>
 
 CppUnit::TestSuite *
 qa_general::suite ()
@@ -46,6 +47,7 @@ qa_general::suite ()
   s->addTest (qa_gr_fxpt_vco::suite ());
   s->addTest (qa_gr_math::suite ());
   s->addTest (qa_gri_lfsr::suite ());
+  s->addTest (qa_gri_sliding_window::suite ());
   
   return s;
 }
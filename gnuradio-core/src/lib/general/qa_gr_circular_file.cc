@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2002 Free Software Foundation, Inc.
+ * Copyright 2002,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,6 +26,9 @@
 #include <qa_gr_circular_file.h>
 #include <gr_circular_file.h>
 #include <cppunit/TestAssert.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <vector>
 #include <iostream>
 #include <stdio.h>
 #include <unistd.h>
@@ -70,3 +73,60 @@ qa_gr_circular_file::t1 ()
 #endif // HAVE_MMAP
 }
 
+// write stream word i = i, in odd sized pieces
+static void
+writer (gr_circular_file *cf, int nwords)
+{
+  std::vector<unsigned int> buf (1000);
+  unsigned int next = 0;
+  int n = 1;
+  while ((int) next < nwords){
+    n = n % 997 + 1;
+    for (int i = 0; i < n; i++)
+      buf[i] = next + i;
+    cf->write (&buf[0], n * sizeof (unsigned int));
+    next += n;
+  }
+}
+
+// a reader racing the writer sees only bytes that are really there
+void
+qa_gr_circular_file::t2 ()
+{
+#ifdef HAVE_MMAP
+  static const int NWORDS = 4 * 1024 * 1024;
+  gr_circular_file cf_writer (test_file, true, 4096 * sizeof (unsigned int));
+  gr_circular_file cf_reader (test_file);
+
+  CPPUNIT_ASSERT_EQUAL (4096LL * 4, cf_reader.size ());
+  CPPUNIT_ASSERT (cf_reader.writer_active ());
+
+  boost::thread t (boost::bind (writer, &cf_writer, NWORDS));
+
+  std::vector<unsigned int> buf (4096);
+  long long nchecked = 0;
+  while (cf_reader.nbytes_written () < NWORDS * 4LL){
+    long long want = cf_reader.oldest ();	// the contested end
+    long long offset = want;
+    int n = cf_reader.read_at (offset, &buf[0], buf.size () * 4);
+    CPPUNIT_ASSERT (offset >= want);
+    CPPUNIT_ASSERT_EQUAL (0LL, offset % 4);
+    CPPUNIT_ASSERT_EQUAL (0, n % 4);
+    for (int i = 0; i < n / 4; i++)
+      CPPUNIT_ASSERT_EQUAL ((unsigned int) (offset / 4 + i), buf[i]);
+    nchecked += n;
+  }
+  t.join ();
+  CPPUNIT_ASSERT (nchecked > 0);
+
+  // once the writer has finished, the last 4096 words are all there
+  long long nwords = cf_reader.nbytes_written () / 4;
+  long long offset = 0;
+  CPPUNIT_ASSERT_EQUAL ((int) buf.size () * 4,
+			cf_reader.read_at (offset, &buf[0], buf.size () * 4));
+  CPPUNIT_ASSERT_EQUAL ((nwords - 4096) * 4, offset);
+  CPPUNIT_ASSERT_EQUAL ((unsigned int) nwords - 1, buf[4095]);
+
+  unlink (test_file);
+#endif // HAVE_MMAP
+}
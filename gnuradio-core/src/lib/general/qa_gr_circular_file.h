@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2002 Free Software Foundation, Inc.
+ * Copyright 2002,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,10 +29,12 @@ class qa_gr_circular_file : public CppUnit::TestCase {
 
   CPPUNIT_TEST_SUITE (qa_gr_circular_file);
   CPPUNIT_TEST (t1);
+  CPPUNIT_TEST (t2);
   CPPUNIT_TEST_SUITE_END ();
 
  private:
   void t1 ();
+  void t2 ();
 
 };
 
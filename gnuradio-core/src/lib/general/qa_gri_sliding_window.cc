@@ -0,0 +1,132 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gri_sliding_window.h>
+#include <qa_gri_sliding_window.h>
+#include <cppunit/TestAssert.h>
+#include <random.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const int NOUT = 5000;
+
+static float
+uniform ()
+{
+  return 2.0 * ((float) random() / RANDOM_MAX - 0.5);	// uniformly (-1, 1)
+}
+
+void
+qa_gri_sliding_window::test_sum ()
+{
+  for (int length = 1; length < 70; length += 7){
+    std::vector<float> in(NOUT + length - 1), out(NOUT);
+    std::vector<int> iin(NOUT + length - 1), iout(NOUT);
+    for (unsigned i = 0; i < in.size(); i++){
+      in[i] = uniform() * 1000;
+      iin[i] = random() % 2001 - 1000;
+    }
+
+    gri_sliding_sum<float, float, float>(&out[0], &in[0], NOUT, length, 0.5, 1000);
+    gri_sliding_sum<int, int, int>(&iout[0], &iin[0], NOUT, length, 3, 0);
+
+    for (int i = 0; i < NOUT; i++){
+      double sum = 0;
+      int isum = 0;
+      for (int j = 0; j < length; j++){
+	sum += in[i+j];
+	isum += iin[i+j];
+      }
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5 * sum, out[i], 1e-2);
+      CPPUNIT_ASSERT_EQUAL(3 * isum, iout[i]);
+    }
+  }
+}
+
+void
+qa_gri_sliding_window::test_power ()
+{
+  int length = 33;
+  std::vector<gr_complex> in(NOUT + length - 1);
+  std::vector<float> out(NOUT);
+  for (unsigned i = 0; i < in.size(); i++)
+    in[i] = gr_complex(uniform(), uniform());
+
+  gri_sliding_power<gr_complex, double, float>(&out[0], &in[0], NOUT, length,
+					       1.0 / length, 512);
+
+  for (int i = 0; i < NOUT; i++){
+    double pwr = 0;
+    for (int j = 0; j < length; j++)
+      pwr += std::norm(in[i+j]);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(pwr / length, out[i], 1e-5);
+  }
+}
+
+void
+qa_gri_sliding_window::test_mean_var ()
+{
+  int length = 100;
+  std::vector<float> in(NOUT + length - 1), mean(NOUT), var(NOUT);
+  for (unsigned i = 0; i < in.size(); i++)
+    in[i] = 3 + uniform();
+
+  gri_sliding_mean_var(&mean[0], &var[0], &in[0], NOUT, length, 1024);
+
+  for (int i = 0; i < NOUT; i++){
+    double mu = 0, v = 0;
+    for (int j = 0; j < length; j++)
+      mu += in[i+j];
+    mu /= length;
+    for (int j = 0; j < length; j++)
+      v += (in[i+j] - mu) * (in[i+j] - mu);
+    v /= length;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(mu, mean[i], 1e-5);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(v, var[i], 1e-5);
+  }
+}
+
+void
+qa_gri_sliding_window::test_extremum ()
+{
+  gri_sliding_max<float> wmax;
+  gri_sliding_min<float> wmin;
+
+  for (int length = 1; length < 100; length += 9){
+    std::vector<float> in(NOUT + length - 1), omax(NOUT), omin(NOUT);
+    for (unsigned i = 0; i < in.size(); i++)
+      in[i] = floorf(uniform() * 10);		// plenty of ties
+
+    wmax.run(&omax[0], &in[0], NOUT, length);
+    wmin.run(&omin[0], &in[0], NOUT, length);
+
+    for (int i = 0; i < NOUT; i++){
+      float mx = in[i], mn = in[i];
+      for (int j = 1; j < length; j++){
+	mx = std::max(mx, in[i+j]);
+	mn = std::min(mn, in[i+j]);
+      }
+      CPPUNIT_ASSERT_EQUAL(mx, omax[i]);
+      CPPUNIT_ASSERT_EQUAL(mn, omin[i]);
+    }
+  }
+}
@@ -62,10 +62,20 @@ int
     @O_TYPE@ *out = (@O_TYPE@ *) output_items[m];
 
     // per stream processing
-    for (int i = 0; i < noutput_items / d_D; i++){
-      assert (((unsigned int)in[i]*d_D+d_D) <= d_symbol_table.size());
-      memcpy(out, &d_symbol_table[(unsigned int)in[i]*d_D], d_D*sizeof(@O_TYPE@));
-      out+=d_D;
+    if (d_D == 1){
+      // one-dimensional constellation: a straight table lookup
+      const @O_TYPE@ *table = &d_symbol_table[0];
+      for (int i = 0; i < noutput_items; i++){
+	assert ((unsigned int)in[i] < d_symbol_table.size());
+	out[i] = table[(unsigned int)in[i]];
+      }
+    }
+    else {
+      for (int i = 0; i < noutput_items / d_D; i++){
+	assert (((unsigned int)in[i]*d_D+d_D) <= d_symbol_table.size());
+	memcpy(out, &d_symbol_table[(unsigned int)in[i]*d_D], d_D*sizeof(@O_TYPE@));
+	out+=d_D;
+      }
     }
     // end of per stream processing
 
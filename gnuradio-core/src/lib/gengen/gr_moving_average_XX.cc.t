@@ -28,6 +28,7 @@
 
 #include <@NAME@.h>
 #include <gr_io_signature.h>
+#include <gri_sliding_window.h>
 
 @SPTR_NAME@ 
 gr_make_@BASE_NAME@ (int length, @O_TYPE@ scale, int max_iter)
@@ -77,17 +78,11 @@ int
   const @I_TYPE@ *in = (const @I_TYPE@ *) input_items[0];
   @O_TYPE@ *out = (@O_TYPE@ *) output_items[0];
 
-  @I_TYPE@ sum = 0;
+  // the running sum is rebuilt at the start of every call, which
+  // bounds the accumulated rounding error to d_max_iter samples
   int num_iter = (noutput_items>d_max_iter) ? d_max_iter : noutput_items;
-  for (int i = 0; i < d_length-1 ; i++) {
-    sum += in[i];
-  }
-
-  for (int i = 0; i < num_iter; i++) {
-    sum += in[i+d_length-1];
-    out[i] = sum * d_scale;
-    sum -= in[i];
-  }
+  gri_sliding_sum<@I_TYPE@, @I_TYPE@, @O_TYPE@>(out, in, num_iter, d_length,
+						d_scale, d_max_iter);
 
   return num_iter;
 }
@@ -53,6 +53,41 @@ gr_make_@BASE_NAME@ (unsigned int bits_per_chunk, gr_endianness_t endianness)
   assert (bits_per_chunk > 0);
 
   set_relative_rate ((1.0 * BITS_PER_TYPE) / bits_per_chunk);
+
+  d_chunks_per_byte = 0;
+  if ((8 % bits_per_chunk) == 0
+      && (endianness == GR_MSB_FIRST || endianness == GR_LSB_FIRST))
+    build_table ();
+}
+
+/*
+ * Precompute the chunks each possible byte value unpacks into.  Since
+ * d_bits_per_chunk divides 8, chunks never straddle a byte and every
+ * input item can be expanded one byte at a time.
+ */
+void
+@NAME@::build_table ()
+{
+  unsigned int k = d_bits_per_chunk;
+  unsigned int mask = (1 << k) - 1;
+
+  d_chunks_per_byte = 8 / k;
+  d_table.resize (256 * d_chunks_per_byte);
+
+  for (unsigned int b = 0; b < 256; b++){
+    for (unsigned int p = 0; p < d_chunks_per_byte; p++){
+      unsigned int x = 0;
+      if (d_endianness == GR_MSB_FIRST)
+	x = (b >> (8 - k * (p + 1))) & mask;
+      else {
+	// bits are taken LSB first, but shifted into the chunk
+	// MSB first, exactly as get_bit_le does below
+	for (unsigned int j = 0; j < k; j++)
+	  x = (x << 1) | ((b >> (k * p + j)) & 1);
+      }
+      d_table[b * d_chunks_per_byte + p] = x;
+    }
+  }
 }
 
 void
@@ -81,6 +116,20 @@ get_bit_be (const @I_TYPE@ *in_vector,unsigned int bit_addr)
   return (x>>((BITS_PER_TYPE-1)-(bit_addr&(BITS_PER_TYPE-1))))&1;
 }
 
+static inline @O_TYPE@
+get_chunk (const @I_TYPE@ *in_vector, unsigned int bit_addr,
+	   unsigned int bits_per_chunk, gr_endianness_t endianness)
+{
+  @O_TYPE@ x = 0;
+  if (endianness == GR_MSB_FIRST)
+    for (unsigned int j = 0; j < bits_per_chunk; j++, bit_addr++)
+      x = (x<<1) | get_bit_be(in_vector, bit_addr);
+  else
+    for (unsigned int j = 0; j < bits_per_chunk; j++, bit_addr++)
+      x = (x<<1) | get_bit_le(in_vector, bit_addr);
+  return x;
+}
+
 int
 @NAME@::general_work (int noutput_items,
 					gr_vector_int &ninput_items,
@@ -99,7 +148,36 @@ int
 
     // per stream processing
 
-    switch (d_endianness){
+    if (!d_table.empty()){
+      int i = 0;
+
+      // finish off a partially consumed input item
+      while (i < noutput_items && (index_tmp & (BITS_PER_TYPE-1)) != 0){
+	out[i++] = get_chunk(in, index_tmp, d_bits_per_chunk, d_endianness);
+	index_tmp += d_bits_per_chunk;
+      }
+
+      // whole input items, a byte at a time through the table
+      const unsigned int chunks_per_item = d_chunks_per_byte * sizeof(@I_TYPE@);
+      const @I_TYPE@ *ip = &in[index_tmp >> LOG2_L_TYPE];
+      for (; i + (int) chunks_per_item <= noutput_items; ip++, index_tmp += BITS_PER_TYPE){
+	@I_TYPE@ x = *ip;
+	for (unsigned int j = 0; j < sizeof(@I_TYPE@); j++){
+	  unsigned int shift = (d_endianness == GR_MSB_FIRST
+				? BITS_PER_TYPE - 8 * (j + 1) : 8 * j);
+	  const unsigned char *t = &d_table[((x >> shift) & 0xff) * d_chunks_per_byte];
+	  for (unsigned int p = 0; p < d_chunks_per_byte; p++)
+	    out[i++] = t[p];
+	}
+      }
+
+      // leading chunks of the last, partially consumed input item
+      while (i < noutput_items){
+	out[i++] = get_chunk(in, index_tmp, d_bits_per_chunk, d_endianness);
+	index_tmp += d_bits_per_chunk;
+      }
+    }
+    else switch (d_endianness){
 
     case GR_MSB_FIRST:
       for (int i = 0; i < noutput_items; i++){
@@ -27,6 +27,7 @@
 
 #include <gr_block.h>
 #include <gr_endianness.h>
+#include <vector>
 
 class @NAME@;
 typedef boost::shared_ptr<@NAME@> @SPTR_NAME@;
@@ -53,6 +54,10 @@ gr_make_@BASE_NAME@ (unsigned int bits_per_chunk, gr_endianness_t endianness);
  * general case of mapping from a stream of bytes or shorts into 
  * arbitrary float or complex symbols.
  *
+ * When \p bits_per_chunk divides 8 (1, 2, 4 or 8) whole input items are
+ * expanded a byte at a time through a precomputed lookup table; other
+ * chunk sizes use the general bit-at-a-time path.
+ *
  * \sa gr_packed_to_unpacked_bb, gr_unpacked_to_packed_bb,
  * \sa gr_packed_to_unpacked_ss, gr_unpacked_to_packed_ss,
  * \sa gr_chunks_to_symbols_bf, gr_chunks_to_symbols_bc.
@@ -70,6 +75,12 @@ class @NAME@ : public gr_block
   gr_endianness_t d_endianness;
   unsigned int    d_index;
 
+  // byte -> chunks lookup table, empty unless 8 % d_bits_per_chunk == 0
+  std::vector<unsigned char> d_table;
+  unsigned int    d_chunks_per_byte;
+
+  void build_table ();
+
  public:
   void forecast(int noutput_items, gr_vector_int &ninput_items_required);
   int general_work (int noutput_items,
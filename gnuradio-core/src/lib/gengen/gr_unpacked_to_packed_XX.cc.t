@@ -51,6 +51,36 @@ gr_make_@BASE_NAME@ (unsigned int bits_per_chunk, gr_endianness_t endianness)
   assert (bits_per_chunk > 0);
 
   set_relative_rate (bits_per_chunk/(1.0 * BITS_PER_TYPE));
+
+  if ((8 % bits_per_chunk) == 0
+      && (endianness == GR_MSB_FIRST || endianness == GR_LSB_FIRST))
+    build_table ();
+}
+
+/*
+ * Precompute the low d_bits_per_chunk bits of every possible input
+ * value in the order they land in the output: as is for MSB first, bit
+ * reversed for LSB first.  Since d_bits_per_chunk divides 8 (and hence
+ * BITS_PER_TYPE), d_index is always zero and chunks never straddle
+ * output items.
+ */
+void
+@NAME@::build_table ()
+{
+  unsigned int k = d_bits_per_chunk;
+  unsigned int mask = (1 << k) - 1;
+
+  d_table.resize (256);
+  for (unsigned int v = 0; v < 256; v++){
+    unsigned int x = v & mask;
+    if (d_endianness == GR_LSB_FIRST){
+      unsigned int r = 0;
+      for (unsigned int j = 0; j < k; j++)
+	r = (r << 1) | ((x >> j) & 1);
+      x = r;
+    }
+    d_table[v] = x;
+  }
 }
 
 void
@@ -92,7 +122,31 @@ int
 
     //assert((ninput_items[m]-d_index)*d_bits_per_chunk >= noutput_items*BITS_PER_TYPE);
   
-    switch(d_endianness){
+    if (!d_table.empty()){
+      const unsigned int k = d_bits_per_chunk;
+      const unsigned int chunks_per_item = BITS_PER_TYPE / k;
+      const unsigned char *t = &d_table[0];
+      const @I_TYPE@ *ip = in;
+
+      if (d_endianness == GR_MSB_FIRST){
+	for (int i = 0; i < noutput_items; i++){
+	  unsigned long tmp = 0;
+	  for (unsigned int j = 0; j < chunks_per_item; j++)
+	    tmp = (tmp << k) | t[*ip++ & 0xff];
+	  out[i] = tmp;
+	}
+      }
+      else {
+	for (int i = 0; i < noutput_items; i++){
+	  unsigned long tmp = 0;
+	  for (unsigned int j = 0; j < chunks_per_item; j++)
+	    tmp |= (unsigned long) t[*ip++ & 0xff] << (j * k);
+	  out[i] = tmp;
+	}
+      }
+      index_tmp += noutput_items * BITS_PER_TYPE;
+    }
+    else switch(d_endianness){
 
     case GR_MSB_FIRST:
       for(int i=0;i<noutput_items;i++) {
@@ -27,6 +27,7 @@
 
 #include <gr_block.h>
 #include <gr_endianness.h>
+#include <vector>
 
 class @NAME@;
 typedef boost::shared_ptr<@NAME@> @NAME@_sptr;
@@ -47,6 +48,10 @@ gr_make_@BASE_NAME@ (unsigned int bits_per_chunk, gr_endianness_t endianness);
  * all 8 or 16 bits of the output bytes or shorts are filled with valid input bits.
  * The right thing is done if bits_per_chunk is not a power of two.
  *
+ * When \p bits_per_chunk divides 8 (1, 2, 4 or 8) each output item is
+ * assembled a whole chunk at a time through a precomputed lookup table;
+ * other chunk sizes use the general bit-at-a-time path.
+ *
  * The combination of gr_packed_to_unpacked_XX followed by
  * gr_chunks_to_symbols_Xf or gr_chunks_to_symbols_Xc handles the
  * general case of mapping from a stream of bytes or shorts into arbitrary float
@@ -68,6 +73,12 @@ class @NAME@ : public gr_block
   gr_endianness_t d_endianness;
   unsigned int    d_index;
 
+  // chunk value -> bits as shifted into the output, empty unless
+  // 8 % d_bits_per_chunk == 0
+  std::vector<unsigned char> d_table;
+
+  void build_table ();
+
  public:
   void forecast(int noutput_items, gr_vector_int &ninput_items_required);
   int general_work (int noutput_items,
@@ -0,0 +1,443 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_async_file_sink.h>
+#include <gr_io_signature.h>
+#include <gruel/thread_body_wrapper.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <posix_memalign.h>
+
+// win32 (mingw/msvc) specific
+#ifdef HAVE_IO_H
+#include <io.h>
+#endif
+#ifdef O_BINARY
+#define	OUR_O_BINARY O_BINARY
+#else
+#define	OUR_O_BINARY 0
+#endif
+
+// should be handled via configure
+#ifdef O_LARGEFILE
+#define	OUR_O_LARGEFILE	O_LARGEFILE
+#else
+#define	OUR_O_LARGEFILE 0
+#endif
+
+#ifdef O_DIRECT
+#define	OUR_O_DIRECT O_DIRECT
+#else
+#define	OUR_O_DIRECT 0
+#endif
+
+static const size_t DIRECT_ALIGN = 4096;	// O_DIRECT buffer, length and offset alignment
+
+static size_t
+gcd (size_t a, size_t b)
+{
+  while (b){
+    size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+static long long
+round_up (long long n, size_t unit)
+{
+  return (n + unit - 1) / unit * unit;
+}
+
+static double
+now ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+gr_async_file_sink_sptr
+gr_make_async_file_sink (size_t itemsize, const char *filename,
+			 bool drop, bool direct,
+			 size_t buffer_size, int nbuffers)
+{
+  return gr_async_file_sink_sptr (new gr_async_file_sink (itemsize, filename,
+							  drop, direct,
+							  buffer_size, nbuffers));
+}
+
+gr_async_file_sink::gr_async_file_sink (size_t itemsize, const char *filename,
+					bool drop, bool direct,
+					size_t buffer_size, int nbuffers)
+  : gr_sync_block ("async_file_sink",
+		   gr_make_io_signature (1, 1, itemsize),
+		   gr_make_io_signature (0, 0, 0)),
+    d_itemsize (itemsize), d_filename (filename), d_drop (drop),
+    d_direct (direct && OUR_O_DIRECT != 0),
+    d_full (std::max (nbuffers, 2)), d_free (std::max (nbuffers, 2)), d_cur (-1),
+    d_writer (0), d_stopping (false),
+    d_fd (-1), d_fileno (0), d_file_bytes (0), d_file_start (0),
+    d_preallocate (0), d_rotate_bytes (0), d_rotate_seconds (0),
+    d_nbytes_written (0), d_nbytes_dropped (0), d_noverruns (0),
+    d_nerrors (0), d_nfiles (0)
+{
+  // Buffers always end on an item boundary, so dropping a buffer's
+  // worth never splits an item.  With O_DIRECT they must also be a
+  // whole number of pages.
+  d_unit = itemsize;
+  if (d_direct)
+    d_unit = itemsize / gcd (itemsize, DIRECT_ALIGN) * DIRECT_ALIGN;
+  d_buffer_size = round_up (std::max (buffer_size, d_unit), d_unit);
+
+  d_buffers.resize (std::max (nbuffers, 2));
+  for (unsigned int i = 0; i < d_buffers.size (); i++){
+    void *p;
+    if (posix_memalign (&p, DIRECT_ALIGN, d_buffer_size) != 0)
+      throw std::bad_alloc ();
+    d_buffers[i].data = (char *) p;
+    d_buffers[i].len = 0;
+    d_free.push (i);
+  }
+
+  if (!open_file ())
+    throw std::runtime_error ("can't open file");
+}
+
+gr_async_file_sink::~gr_async_file_sink ()
+{
+  stop ();
+  close_file ();
+  for (unsigned int i = 0; i < d_buffers.size (); i++)
+    free (d_buffers[i].data);
+}
+
+void
+gr_async_file_sink::set_preallocate (long long nbytes)
+{
+  d_preallocate = nbytes;
+#ifdef HAVE_POSIX_FALLOCATE
+  if (d_fd >= 0 && d_file_bytes == 0 && nbytes > 0)
+    posix_fallocate (d_fd, 0, nbytes);
+#endif
+}
+
+void
+gr_async_file_sink::set_rotation (long long max_bytes, double max_seconds)
+{
+  d_rotate_bytes = max_bytes > 0 ? round_up (max_bytes, d_unit) : 0;
+  d_rotate_seconds = max_seconds > 0 ? max_seconds : 0;
+}
+
+long long
+gr_async_file_sink::nbytes_written ()
+{
+  return gruel::atomic_read (&d_nbytes_written);
+}
+
+long long
+gr_async_file_sink::nbytes_dropped ()
+{
+  return gruel::atomic_read (&d_nbytes_dropped);
+}
+
+long
+gr_async_file_sink::noverruns ()
+{
+  return gruel::atomic_read (&d_noverruns);
+}
+
+long
+gr_async_file_sink::nerrors ()
+{
+  return gruel::atomic_read (&d_nerrors);
+}
+
+int
+gr_async_file_sink::nfiles ()
+{
+  return gruel::atomic_read (&d_nfiles);
+}
+
+/*
+ * The rings are lock-free, but a waiter checks its ring and sleeps
+ * under d_mutex; taking it here means the wakeup can't fall between
+ * the two.  The waiter holds it only that long, so work() isn't held
+ * up behind the disk.
+ */
+void
+gr_async_file_sink::notify (gruel::condition_variable &cond)
+{
+  gruel::scoped_lock guard (d_mutex);
+  cond.notify_one ();
+}
+
+// ----------------------------------------------------------------
+// writer thread side
+
+bool
+gr_async_file_sink::open_file ()
+{
+  std::string name = d_filename;
+  if (d_fileno > 0){
+    char suffix[16];
+    snprintf (suffix, sizeof (suffix), ".%04d", d_fileno);
+    name += suffix;
+  }
+
+  int flags = O_WRONLY|O_CREAT|O_TRUNC|OUR_O_LARGEFILE|OUR_O_BINARY;
+  if (d_direct)
+    flags |= OUR_O_DIRECT;
+
+  if ((d_fd = ::open (name.c_str (), flags, 0664)) < 0 && d_direct){
+    // not every file system supports O_DIRECT
+    d_direct = false;
+    d_fd = ::open (name.c_str (), flags & ~OUR_O_DIRECT, 0664);
+  }
+  if (d_fd < 0){
+    perror (name.c_str ());
+    return false;
+  }
+
+#ifdef HAVE_POSIX_FALLOCATE
+  if (d_preallocate > 0)
+    posix_fallocate (d_fd, 0, d_preallocate);
+#endif
+
+  d_fileno++;
+  d_file_bytes = 0;
+  d_file_start = now ();
+  gruel::atomic_fetch_add (&d_nfiles, 1);
+  return true;
+}
+
+void
+gr_async_file_sink::close_file ()
+{
+  if (d_fd < 0)
+    return;
+  if (d_preallocate > d_file_bytes)
+    ftruncate (d_fd, d_file_bytes);	// give back the unused reservation
+  ::close (d_fd);
+  d_fd = -1;
+}
+
+bool
+gr_async_file_sink::write_chunk (const char *p, size_t len)
+{
+  // O_DIRECT needs aligned offsets and lengths; only the tail written
+  // at stop() is ever short, and that goes through the page cache.
+  bool buffered = d_direct && (len % DIRECT_ALIGN != 0
+			       || d_file_bytes % DIRECT_ALIGN != 0);
+  if (buffered)
+    fcntl (d_fd, F_SETFL, fcntl (d_fd, F_GETFL) & ~OUR_O_DIRECT);
+
+  bool ok = true;
+  while (len > 0){
+    ssize_t n = ::write (d_fd, p, len);
+    if (n < 0){
+      if (errno == EINTR)
+	continue;
+      perror ("gr_async_file_sink: write");
+      ok = false;
+      break;
+    }
+    p += n;
+    len -= n;
+    d_file_bytes += n;
+    gruel::atomic_fetch_add (&d_nbytes_written, (long long) n);
+  }
+
+  if (buffered)
+    fcntl (d_fd, F_SETFL, fcntl (d_fd, F_GETFL) | OUR_O_DIRECT);
+
+  if (!ok){
+    gruel::atomic_fetch_add (&d_nerrors, 1L);
+    gruel::atomic_fetch_add (&d_nbytes_dropped, (long long) len);
+  }
+  return ok;
+}
+
+void
+gr_async_file_sink::write_buffer (const buffer &b)
+{
+  const char *p = b.data;
+  size_t len = b.len;
+
+  while (len > 0){
+    bool rotate = d_file_bytes > 0
+      && ((d_rotate_bytes && d_file_bytes >= d_rotate_bytes)
+	  || (d_rotate_seconds && now () - d_file_start >= d_rotate_seconds));
+
+    if (rotate || d_fd < 0){
+      close_file ();
+      if (!open_file ()){
+	gruel::atomic_fetch_add (&d_nerrors, 1L);
+	gruel::atomic_fetch_add (&d_nbytes_dropped, (long long) len);
+	return;
+      }
+    }
+
+    size_t n = len;
+    if (d_rotate_bytes)
+      n = std::min ((long long) n, d_rotate_bytes - d_file_bytes);
+
+    if (!write_chunk (p, n)){
+      gruel::atomic_fetch_add (&d_nbytes_dropped, (long long) (len - n));
+      close_file ();			// try a fresh file with the next buffer
+      return;
+    }
+    p += n;
+    len -= n;
+  }
+}
+
+void
+gr_async_file_sink::run_writer ()
+{
+  while (1){
+    int i;
+    if (d_full.pop (i)){
+      write_buffer (d_buffers[i]);
+      d_buffers[i].len = 0;
+      d_free.push (i);
+      notify (d_free_cond);
+      continue;
+    }
+
+    if (d_stopping && d_full.empty ())
+      break;
+
+    gruel::scoped_lock guard (d_mutex);
+    if (d_full.empty () && !d_stopping)
+      d_full_cond.wait (guard);
+  }
+}
+
+// ----------------------------------------------------------------
+// scheduler thread side
+
+struct gr_async_file_sink::writer_body
+{
+  gr_async_file_sink *d_sink;
+
+  writer_body (gr_async_file_sink *sink) : d_sink (sink) {}
+  void operator() () { d_sink->run_writer (); }
+};
+
+bool
+gr_async_file_sink::start ()
+{
+  if (d_writer == 0){
+    d_stopping = false;
+    d_writer = new gruel::thread (
+      gruel::thread_body_wrapper<writer_body> (writer_body (this),
+					       "async_file_sink writer"));
+  }
+  return true;
+}
+
+bool
+gr_async_file_sink::stop ()
+{
+  if (d_writer){
+    queue_current ();			// flush the partial buffer
+    gruel::atomic_store (&d_stopping, true);
+    notify (d_full_cond);
+    d_writer->join ();
+    delete d_writer;
+    d_writer = 0;
+  }
+  return true;
+}
+
+void
+gr_async_file_sink::queue_current ()
+{
+  if (d_cur < 0 || d_buffers[d_cur].len == 0)
+    return;
+  d_full.push (d_cur);		// can't fail; there are only nbuffers indices
+  d_cur = -1;
+  notify (d_full_cond);
+}
+
+bool
+gr_async_file_sink::get_free_buffer ()
+{
+  while (!d_free.pop (d_cur)){
+    if (d_drop || d_writer == 0){
+      d_cur = -1;
+      return false;
+    }
+    gruel::scoped_lock guard (d_mutex);
+    if (d_free.empty ())
+      d_free_cond.wait (guard);
+  }
+  return true;
+}
+
+int
+gr_async_file_sink::work (int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+{
+  const char *in = (const char *) input_items[0];
+  size_t nbytes = (size_t) noutput_items * d_itemsize;
+
+  if (d_writer == 0)			// not started by a scheduler
+    start ();
+
+  while (nbytes > 0){
+    if (d_cur < 0 && !get_free_buffer ()){
+      gruel::atomic_fetch_add (&d_nbytes_dropped, (long long) nbytes);
+      gruel::atomic_fetch_add (&d_noverruns, 1L);
+      break;
+    }
+
+    buffer &b = d_buffers[d_cur];
+    size_t n = std::min (nbytes, d_buffer_size - b.len);
+    memcpy (b.data + b.len, in, n);
+    b.len += n;
+    in += n;
+    nbytes -= n;
+
+    if (b.len == d_buffer_size)
+      queue_current ();
+  }
+
+  return noutput_items;
+}
@@ -0,0 +1,158 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_ASYNC_FILE_SINK_H
+#define INCLUDED_GR_ASYNC_FILE_SINK_H
+
+#include <gr_sync_block.h>
+#include <gri_spsc_ring.h>
+#include <gruel/thread.h>
+#include <string>
+#include <vector>
+
+class gr_async_file_sink;
+typedef boost::shared_ptr<gr_async_file_sink> gr_async_file_sink_sptr;
+
+gr_async_file_sink_sptr
+gr_make_async_file_sink (size_t itemsize, const char *filename,
+			 bool drop = false, bool direct = false,
+			 size_t buffer_size = 4 * 1024 * 1024, int nbuffers = 4);
+
+/*!
+ * \brief Write stream to file from a dedicated writer thread
+ * \ingroup sink_blk
+ *
+ * work() copies its input into one of \p nbuffers buffers of about
+ * \p buffer_size bytes and hands full buffers to a writer thread
+ * through a lock-free queue, so a stalled disk does not stall the
+ * flow graph until every buffer is full.
+ *
+ * When all buffers are full and \p drop is false, work() waits for
+ * the writer like gr_file_sink would.  With \p drop true it never
+ * waits: the input is discarded and counted in nbytes_dropped() and
+ * noverruns().  Whole items are always kept or dropped together.
+ *
+ * If \p direct is true the file is opened with O_DIRECT (where
+ * supported) and buffers are page aligned, bypassing the page cache.
+ *
+ * Optionally each output file is preallocated, and output rotates
+ * to a new file after a number of bytes or seconds.  The first file
+ * is \p filename, later ones filename.0001, filename.0002, ...
+ */
+class gr_async_file_sink : public gr_sync_block
+{
+  friend gr_async_file_sink_sptr
+  gr_make_async_file_sink (size_t itemsize, const char *filename,
+			   bool drop, bool direct,
+			   size_t buffer_size, int nbuffers);
+
+  struct buffer {
+    char       *data;
+    size_t	len;
+  };
+
+  struct writer_body;
+  friend struct writer_body;
+
+  size_t		d_itemsize;
+  std::string		d_filename;
+  bool			d_drop;
+  bool			d_direct;
+  size_t		d_unit;		// buffer and rotation sizes are multiples of this
+  size_t		d_buffer_size;
+
+  std::vector<buffer>	d_buffers;
+  gri_spsc_ring<int>	d_full;		// work() -> writer
+  gri_spsc_ring<int>	d_free;		// writer -> work()
+  int			d_cur;		// buffer being filled by work(), or -1
+
+  gruel::thread	       *d_writer;
+  volatile bool		d_stopping;
+  gruel::mutex		d_mutex;
+  gruel::condition_variable d_full_cond;
+  gruel::condition_variable d_free_cond;
+
+  // writer thread state
+  int			d_fd;
+  int			d_fileno;
+  long long		d_file_bytes;
+  double		d_file_start;
+  long long		d_preallocate;
+  long long		d_rotate_bytes;
+  double		d_rotate_seconds;
+
+  // statistics
+  volatile long long	d_nbytes_written;
+  volatile long long	d_nbytes_dropped;
+  volatile long		d_noverruns;
+  volatile long		d_nerrors;
+  volatile int		d_nfiles;
+
+  bool open_file ();
+  void close_file ();
+  bool write_chunk (const char *p, size_t len);
+  void write_buffer (const buffer &b);
+  void run_writer ();
+  bool get_free_buffer ();
+  void notify (gruel::condition_variable &cond);
+  void queue_current ();
+
+ protected:
+  gr_async_file_sink (size_t itemsize, const char *filename,
+		      bool drop, bool direct,
+		      size_t buffer_size, int nbuffers);
+
+ public:
+  ~gr_async_file_sink ();
+
+  /*!
+   * \brief reserve \p nbytes on disk for each file as it is opened
+   *
+   * Files are truncated to the bytes actually written when closed.
+   * Must be called before the flow graph is started.
+   */
+  void set_preallocate (long long nbytes);
+
+  /*!
+   * \brief start a new file every \p max_bytes bytes and/or \p max_seconds seconds
+   *
+   * Zero disables that limit.  Size limits are rounded up to a whole
+   * number of items (and of pages with O_DIRECT).  Must be called
+   * before the flow graph is started.
+   */
+  void set_rotation (long long max_bytes, double max_seconds = 0);
+
+  long long nbytes_written ();		//!< bytes handed to the OS
+  long long nbytes_dropped ();		//!< bytes discarded for lack of a free buffer
+  long noverruns ();			//!< number of work() calls that dropped data
+  long nerrors ();			//!< write errors; the data is counted as dropped
+  int nfiles ();			//!< files opened so far
+
+  bool start ();
+  bool stop ();
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_ASYNC_FILE_SINK_H */
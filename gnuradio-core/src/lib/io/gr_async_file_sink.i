@@ -0,0 +1,48 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+GR_SWIG_BLOCK_MAGIC(gr,async_file_sink)
+
+gr_async_file_sink_sptr
+gr_make_async_file_sink (size_t itemsize, const char *filename,
+			 bool drop = false, bool direct = false,
+			 size_t buffer_size = 4 * 1024 * 1024, int nbuffers = 4);
+
+class gr_async_file_sink : public gr_sync_block
+{
+ protected:
+  gr_async_file_sink (size_t itemsize, const char *filename,
+		      bool drop, bool direct,
+		      size_t buffer_size, int nbuffers);
+
+ public:
+  ~gr_async_file_sink ();
+
+  void set_preallocate (long long nbytes);
+  void set_rotation (long long max_bytes, double max_seconds = 0);
+
+  long long nbytes_written ();
+  long long nbytes_dropped ();
+  long noverruns ();
+  long nerrors ();
+  int nfiles ();
+};
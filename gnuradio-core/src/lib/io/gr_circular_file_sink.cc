@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_circular_file_sink.h>
+#include <gr_io_signature.h>
+#include <sys/time.h>
+#include <math.h>
+
+gr_circular_file_sink_sptr
+gr_make_circular_file_sink (size_t itemsize, const char *filename,
+			    double sample_rate, double seconds,
+			    double start_time)
+{
+  return gr_circular_file_sink_sptr (new gr_circular_file_sink (itemsize, filename,
+								sample_rate, seconds,
+								start_time));
+}
+
+static long long
+ring_bytes (size_t itemsize, double sample_rate, double seconds)
+{
+  long long nitems = (long long) ceil (sample_rate * seconds);
+  if (sample_rate <= 0 || nitems <= 0)
+    throw std::invalid_argument ("gr_circular_file_sink: sample_rate and seconds must be > 0");
+  return nitems * itemsize;
+}
+
+gr_circular_file_sink::gr_circular_file_sink (size_t itemsize, const char *filename,
+					      double sample_rate, double seconds,
+					      double start_time)
+  : gr_sync_block ("circular_file_sink",
+		   gr_make_io_signature (1, 1, itemsize),
+		   gr_make_io_signature (0, 0, 0)),
+    d_file (0), d_sample_rate (sample_rate), d_start_time (start_time)
+{
+  d_file = new gr_circular_file (filename, true,
+				 ring_bytes (itemsize, sample_rate, seconds));
+  d_file->set_info (itemsize, sample_rate, start_time);
+}
+
+gr_circular_file_sink::~gr_circular_file_sink ()
+{
+  delete d_file;
+}
+
+bool
+gr_circular_file_sink::start ()
+{
+  d_file->set_writer_active (true);
+  return true;
+}
+
+bool
+gr_circular_file_sink::stop ()
+{
+  d_file->set_writer_active (false);	// readers stop waiting for more
+  return true;
+}
+
+int
+gr_circular_file_sink::work (int noutput_items,
+			     gr_vector_const_void_star &input_items,
+			     gr_vector_void_star &output_items)
+{
+  if (d_start_time == 0){
+    // The first items were sampled at least noutput_items ago.
+    struct timeval tv;
+    gettimeofday (&tv, 0);
+    d_start_time = tv.tv_sec + tv.tv_usec * 1e-6 - noutput_items / d_sample_rate;
+    d_file->set_info (d_file->itemsize (), d_sample_rate, d_start_time);
+  }
+
+  d_file->write (input_items[0], noutput_items * d_file->itemsize ());
+  return noutput_items;
+}
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_CIRCULAR_FILE_SINK_H
+#define INCLUDED_GR_CIRCULAR_FILE_SINK_H
+
+#include <gr_sync_block.h>
+#include <gr_circular_file.h>
+#include <stdexcept>
+
+class gr_circular_file_sink;
+typedef boost::shared_ptr<gr_circular_file_sink> gr_circular_file_sink_sptr;
+
+/*!
+ * \param itemsize	size of the stream items in bytes
+ * \param filename	ring file to create, ideally on tmpfs (/dev/shm)
+ * \param sample_rate	[items/s]
+ * \param seconds	how much history to keep
+ * \param start_time	time of the first item [s since the epoch], 0 means
+ *			the time the first items arrive
+ */
+gr_circular_file_sink_sptr
+gr_make_circular_file_sink (size_t itemsize, const char *filename,
+			    double sample_rate, double seconds,
+			    double start_time = 0);
+
+/*!
+ * \brief Keep the last \p seconds of a stream in a memory mapped ring file
+ * \ingroup sink_blk
+ *
+ * Pre-trigger capture: the stream runs continuously into a
+ * gr_circular_file.  When something interesting happens, any other
+ * thread or process can pull the samples around that moment out of
+ * the file (see gr_circular_file_source) without stopping or slowing
+ * the writer; work() is a memcpy and two atomic stores.
+ */
+class gr_circular_file_sink : public gr_sync_block
+{
+  friend gr_circular_file_sink_sptr
+  gr_make_circular_file_sink (size_t itemsize, const char *filename,
+			      double sample_rate, double seconds,
+			      double start_time);
+
+  gr_circular_file     *d_file;
+  double		d_sample_rate;
+  double		d_start_time;
+
+ protected:
+  gr_circular_file_sink (size_t itemsize, const char *filename,
+			 double sample_rate, double seconds,
+			 double start_time);
+
+ public:
+  ~gr_circular_file_sink ();
+
+  //! items written since the file was created
+  long long nitems_written () const { return d_file->nbytes_written () / d_file->itemsize (); }
+
+  //! time of the first item [s since the epoch], 0 until known
+  double start_time () const { return d_start_time; }
+
+  //! capacity of the ring in items
+  long long capacity () const { return d_file->size () / d_file->itemsize (); }
+
+  bool start ();
+  bool stop ();
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_CIRCULAR_FILE_SINK_H */
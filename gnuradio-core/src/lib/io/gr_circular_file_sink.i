@@ -0,0 +1,43 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+GR_SWIG_BLOCK_MAGIC(gr,circular_file_sink);
+
+gr_circular_file_sink_sptr
+gr_make_circular_file_sink (size_t itemsize, const char *filename,
+			    double sample_rate, double seconds,
+			    double start_time = 0) throw (std::runtime_error, std::invalid_argument);
+
+class gr_circular_file_sink : public gr_sync_block
+{
+ protected:
+  gr_circular_file_sink (size_t itemsize, const char *filename,
+			 double sample_rate, double seconds,
+			 double start_time) throw (std::runtime_error, std::invalid_argument);
+
+ public:
+  ~gr_circular_file_sink ();
+  long long nitems_written () const;
+  double start_time () const;
+  long long capacity () const;
+};
@@ -0,0 +1,131 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_circular_file_source.h>
+#include <gr_io_signature.h>
+#include <gruel/thread.h>
+#include <algorithm>
+#include <math.h>
+
+#define	POLL_INTERVAL	0.001		// seconds between looks at a writer we wait for
+
+gr_circular_file_source_sptr
+gr_make_circular_file_source (const char *filename, double start_time,
+			      double duration)
+{
+  return gr_circular_file_source_sptr (new gr_circular_file_source (filename,
+								    start_time,
+								    duration));
+}
+
+/*
+ * The io signature depends on the file, so the file is opened before
+ * the base class is constructed, and again below.
+ */
+static int
+file_itemsize (const char *filename)
+{
+  gr_circular_file f (filename);
+  if (f.itemsize () <= 0 || f.sample_rate () <= 0)
+    throw std::runtime_error ("gr_circular_file_source: file doesn't describe its items");
+  return f.itemsize ();
+}
+
+gr_circular_file_source::gr_circular_file_source (const char *filename,
+						  double start_time,
+						  double duration)
+  : gr_sync_block ("circular_file_source",
+		   gr_make_io_signature (0, 0, 0),
+		   gr_make_io_signature (1, 1, file_itemsize (filename))),
+    d_file (0), d_itemsize (0),
+    d_window_time (start_time), d_duration (duration),
+    d_start (-1), d_end (-1), d_next (-1), d_first (-1)
+{
+  if (duration <= 0)
+    throw std::invalid_argument ("gr_circular_file_source: duration must be > 0");
+
+  d_file = new gr_circular_file (filename);
+  d_itemsize = d_file->itemsize ();
+  locate_window ();
+}
+
+gr_circular_file_source::~gr_circular_file_source ()
+{
+  delete d_file;
+}
+
+bool
+gr_circular_file_source::locate_window ()
+{
+  if (d_start >= 0)
+    return true;
+
+  double t0 = d_file->start_time ();
+  if (t0 == 0)				// writer hasn't seen data yet
+    return false;
+
+  double rate = d_file->sample_rate ();
+  d_start = std::max (0LL, (long long) floor ((d_window_time - t0) * rate));
+  d_end = std::max (d_start, (long long) ceil ((d_window_time + d_duration - t0) * rate));
+  d_next = d_start;
+  return true;
+}
+
+int
+gr_circular_file_source::work (int noutput_items,
+			       gr_vector_const_void_star &input_items,
+			       gr_vector_void_star &output_items)
+{
+  char *out = (char *) output_items[0];
+
+  for (;;){
+    bool writing = d_file->writer_active ();	// before we look at the data
+
+    if (locate_window ()){
+      if (d_next >= d_end)
+	return -1;			// done
+
+      long long offset = d_next * d_itemsize;
+      int nbytes = std::min ((long long) noutput_items, d_end - d_next) * d_itemsize;
+      int n = d_file->read_at (offset, out, nbytes) / d_itemsize;
+
+      d_next = offset / d_itemsize;	// moves if the start was overwritten
+      if (d_next >= d_end)
+	return -1;			// the whole window is gone
+      if (n > 0){
+	if (d_first < 0)
+	  d_first = d_next;
+	d_next += n;
+	return n;
+      }
+    }
+
+    if (!writing)
+      return -1;			// nothing more is coming
+
+    boost::this_thread::sleep (boost::posix_time::microseconds ((long) (POLL_INTERVAL * 1e6)));
+  }
+}
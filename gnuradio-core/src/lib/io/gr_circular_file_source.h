@@ -0,0 +1,99 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_CIRCULAR_FILE_SOURCE_H
+#define INCLUDED_GR_CIRCULAR_FILE_SOURCE_H
+
+#include <gr_sync_block.h>
+#include <gr_circular_file.h>
+#include <stdexcept>
+
+class gr_circular_file_source;
+typedef boost::shared_ptr<gr_circular_file_source> gr_circular_file_source_sptr;
+
+/*!
+ * \param filename	ring file written by gr_circular_file_sink
+ * \param start_time	start of the window [s since the epoch]
+ * \param duration	length of the window [s]
+ */
+gr_circular_file_source_sptr
+gr_make_circular_file_source (const char *filename, double start_time,
+			      double duration);
+
+/*!
+ * \brief Read a time window out of a ring file that may still be written
+ * \ingroup source_blk
+ *
+ * Produces the items of [start_time, start_time + duration) from a
+ * file written by gr_circular_file_sink, then finishes.  The item size
+ * and timing come from the file.  The writer is never stopped or
+ * blocked.  If the start of the window has already been overwritten
+ * (or is being overwritten while we read) output begins with the
+ * oldest item still available; see first_item().  If the end of the
+ * window lies in the future, the source waits for the writer to get
+ * there, or to stop.
+ */
+class gr_circular_file_source : public gr_sync_block
+{
+  friend gr_circular_file_source_sptr
+  gr_make_circular_file_source (const char *filename, double start_time,
+				double duration);
+
+  gr_circular_file     *d_file;
+  int			d_itemsize;
+  double		d_window_time;
+  double		d_duration;
+  long long		d_start;	// first item of the window, -1 until known
+  long long		d_end;		// one past the last item of the window
+  long long		d_next;		// next item to produce
+  long long		d_first;	// first item produced, -1 until known
+
+  bool locate_window ();
+
+ protected:
+  gr_circular_file_source (const char *filename, double start_time,
+			   double duration);
+
+ public:
+  ~gr_circular_file_source ();
+
+  /*
+   * Item indices count from the first item the writer wrote.  They are
+   * -1 until known: the window can't be placed before the writer has
+   * recorded the time of its first item.
+   */
+
+  //! first item of the requested window
+  long long window_start () const { return d_start; }
+
+  //! one past the last item of the requested window
+  long long window_end () const { return d_end; }
+
+  //! first item actually produced
+  long long first_item () const { return d_first; }
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_CIRCULAR_FILE_SOURCE_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004 Free Software Foundation, Inc.
+ * Copyright 2004,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,12 +26,21 @@
 
 #include <gr_file_source.h>
 #include <gr_io_signature.h>
+#include <gr_pagesize.h>
 #include <cstdio>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdexcept>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 // win32 (mingw/msvc) specific
 #ifdef HAVE_IO_H
@@ -49,22 +58,43 @@
 #define	OUR_O_LARGEFILE 0
 #endif
 
-gr_file_source::gr_file_source (size_t itemsize, const char *filename, bool repeat)
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define	OUR_HAVE_MMAP 1
+#endif
+
+// mmap mode: bytes mapped at once, and how far ahead of the read
+// position the kernel is asked to fetch.  The window bounds our
+// address space use, so the file itself may be arbitrarily large.
+static const size_t MAP_WINDOW = 64 * 1024 * 1024;
+static const size_t READ_AHEAD = 4 * 1024 * 1024;
+
+gr_file_source::gr_file_source (size_t itemsize, const char *filename, bool repeat,
+				bool use_mmap)
   : gr_sync_block ("file_source",
 		   gr_make_io_signature (0, 0, 0),
 		   gr_make_io_signature (1, 1, itemsize)),
-    d_itemsize (itemsize), d_fp (0), d_repeat (repeat)
+    d_itemsize (itemsize), d_fp (0), d_repeat (repeat), d_fd (-1),
+    d_pos (0), d_start (0), d_end (0), d_to_eof (true),
+    d_mmap (false), d_map (0), d_map_off (0), d_map_len (0), d_prefetched (0)
 {
   // we use "open" to use to the O_LARGEFILE flag
   
-  int fd;
-  if ((fd = open (filename, O_RDONLY | OUR_O_LARGEFILE | OUR_O_BINARY)) < 0){
+  if ((d_fd = open (filename, O_RDONLY | OUR_O_LARGEFILE | OUR_O_BINARY)) < 0){
     perror (filename);
     throw std::runtime_error ("can't open file");
   }
 
-  if ((d_fp = fdopen (fd, "rb")) == NULL){
+#ifdef OUR_HAVE_MMAP
+  struct stat st;
+  if (use_mmap && fstat (d_fd, &st) == 0 && S_ISREG (st.st_mode))
+    d_mmap = true;
+#endif
+
+  if (d_mmap)
+    d_end = file_end ();
+  else if ((d_fp = fdopen (d_fd, "rb")) == NULL){
     perror (filename);
+    close (d_fd);
     throw std::runtime_error ("can't open file");
   }
 }
@@ -72,14 +102,126 @@ gr_file_source::gr_file_source (size_t itemsize, const char *filename, bool repe
 // public constructor that returns a shared_ptr
 
 gr_file_source_sptr
-gr_make_file_source (size_t itemsize, const char *filename, bool repeat)
+gr_make_file_source (size_t itemsize, const char *filename, bool repeat,
+		     bool use_mmap)
 {
-  return gr_file_source_sptr (new gr_file_source (itemsize, filename, repeat));
+  return gr_file_source_sptr (new gr_file_source (itemsize, filename, repeat,
+						  use_mmap));
 }
 
 gr_file_source::~gr_file_source ()
 {
-  fclose ((FILE *) d_fp);
+  if (d_mmap){
+    unmap_window ();
+    close (d_fd);
+  }
+  else
+    fclose ((FILE *) d_fp);
+}
+
+// offset just past the last whole item in the file
+
+off_t
+gr_file_source::file_end ()
+{
+  struct stat st;
+  if (fstat (d_fd, &st) < 0)
+    return 0;
+  return st.st_size - st.st_size % d_itemsize;
+}
+
+bool
+gr_file_source::map_window (off_t pos)
+{
+#ifdef OUR_HAVE_MMAP
+  unmap_window ();
+
+  off_t off = pos - pos % gr_pagesize ();
+  size_t len = std::min ((off_t) MAP_WINDOW, d_end - off);
+
+  void *p = mmap (0, len, PROT_READ, MAP_SHARED, d_fd, off);
+  if (p == MAP_FAILED){
+    perror ("gr_file_source: mmap");
+    return false;
+  }
+
+  d_map = (char *) p;
+  d_map_off = off;
+  d_map_len = len;
+  d_prefetched = off;
+  madvise (d_map, d_map_len, MADV_SEQUENTIAL);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+gr_file_source::unmap_window ()
+{
+#ifdef OUR_HAVE_MMAP
+  if (d_map)
+    munmap (d_map, d_map_len);
+#endif
+  d_map = 0;
+  d_map_len = 0;
+}
+
+// Keep at least READ_AHEAD / 2 bytes beyond d_pos requested from the
+// kernel, in READ_AHEAD / 2 sized steps.
+
+void
+gr_file_source::prefetch ()
+{
+#ifdef OUR_HAVE_MMAP
+  off_t map_end = d_map_off + d_map_len;
+  if (d_prefetched >= map_end || d_pos + (off_t) READ_AHEAD / 2 <= d_prefetched)
+    return;
+
+  off_t start = std::max (d_prefetched, d_pos);
+  start -= (start - d_map_off) % gr_pagesize ();
+  off_t end = std::min (d_pos + (off_t) READ_AHEAD, map_end);
+
+  madvise (d_map + (start - d_map_off), end - start, MADV_WILLNEED);
+  d_prefetched = end;
+#endif
+}
+
+// Read up to nitems items at d_pos without passing the end of the
+// range.  Returns the number of items read; 0 means EOF or error.
+
+int
+gr_file_source::read_items (char *o, int nitems)
+{
+  if (!d_mmap){
+    if (!d_to_eof)
+      nitems = std::min ((off_t) nitems, (d_end - d_pos) / (off_t) d_itemsize);
+    int n = fread (o, d_itemsize, nitems, (FILE *) d_fp);
+    d_pos += (off_t) n * d_itemsize;
+    return n;
+  }
+
+  if (d_to_eof && d_pos >= d_end)
+    d_end = file_end ();		// pick up data appended since we last looked
+
+  nitems = std::min ((off_t) nitems, (d_end - d_pos) / (off_t) d_itemsize);
+  size_t nbytes = (size_t) nitems * d_itemsize;
+
+  while (nbytes > 0){
+    if (d_map == 0 || d_pos < d_map_off || d_pos >= d_map_off + (off_t) d_map_len){
+      if (!map_window (d_pos))
+	break;
+    }
+
+    size_t n = std::min (nbytes, (size_t) (d_map_off + d_map_len - d_pos));
+    memcpy (o, d_map + (d_pos - d_map_off), n);
+    o += n;
+    d_pos += n;
+    nbytes -= n;
+    prefetch ();
+  }
+
+  return nitems - nbytes / d_itemsize;
 }
 
 int 
@@ -90,9 +232,10 @@ gr_file_source::work (int noutput_items,
   char *o = (char *) output_items[0];
   int i;
   int size = noutput_items;
+  bool rewound = false;
 
   while (size) {
-    i = fread(o, d_itemsize, size, (FILE *) d_fp);
+    i = read_items(o, size);
     
     size -= i;
     o += i * d_itemsize;
@@ -100,20 +243,25 @@ gr_file_source::work (int noutput_items,
     if (size == 0)		// done
       break;
 
-    if (i > 0)			// short read, try again
+    if (i > 0){			// short read, try again
+      rewound = false;
       continue;
+    }
 
-    // We got a zero from fread.  This is either EOF or error.  In
+    // We got a zero from read_items.  This is either EOF or error.  In
     // any event, if we're in repeat mode, seek back to the beginning
-    // of the file and try again, else break
+    // of the range and try again, else break.  An empty range would
+    // spin forever, so give up if a rewind produced nothing.
 
-    if (!d_repeat)
+    if (!d_repeat || rewound)
       break;
 
-    if (fseek ((FILE *) d_fp, 0, SEEK_SET) == -1) {
+    if (!d_mmap && fseeko ((FILE *) d_fp, d_start, SEEK_SET) == -1) {
       fprintf(stderr, "[%s] fseek failed\n", __FILE__);
       exit(-1);
     }
+    d_pos = d_start;
+    rewound = true;
   }
 
   if (size > 0){			// EOF or error
@@ -128,5 +276,60 @@ gr_file_source::work (int noutput_items,
 bool
 gr_file_source::seek (long seek_point, int whence)
 {
-   return fseek ((FILE *) d_fp, seek_point * d_itemsize, whence) == 0;
+  off_t pos = (off_t) seek_point * d_itemsize;
+  switch (whence){
+  case SEEK_SET:
+    break;
+  case SEEK_CUR:
+    pos += d_pos;
+    break;
+  case SEEK_END:
+    pos += file_end ();
+    break;
+  default:
+    return false;
+  }
+
+  if (pos < d_start || (!d_to_eof && pos > d_end))
+    return false;
+
+  if (d_mmap){
+    if (pos > file_end ())
+      return false;
+  }
+  else if (fseeko ((FILE *) d_fp, pos, SEEK_SET) != 0)
+    return false;
+
+  d_pos = pos;
+  return true;
+}
+
+bool
+gr_file_source::set_range (long start_item, long nitems)
+{
+  if (start_item < 0)
+    return false;
+
+  off_t start = (off_t) start_item * d_itemsize;
+  off_t end = file_end ();
+  bool to_eof = nitems <= 0;
+
+  if (!to_eof){
+    end = start + (off_t) nitems * d_itemsize;
+    if (d_mmap)
+      end = std::min (end, file_end ());	// never map past EOF
+  }
+
+  if (d_mmap){
+    if (start > end)
+      return false;
+  }
+  else if (fseeko ((FILE *) d_fp, start, SEEK_SET) != 0)
+    return false;
+
+  d_start = start;
+  d_end = end;
+  d_to_eof = to_eof;
+  d_pos = start;
+  return true;
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004 Free Software Foundation, Inc.
+ * Copyright 2004,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,30 +24,61 @@
 #define INCLUDED_GR_FILE_SOURCE_H
 
 #include <gr_sync_block.h>
+#include <sys/types.h>
 
 class gr_file_source;
 typedef boost::shared_ptr<gr_file_source> gr_file_source_sptr;
 
 gr_file_source_sptr
-gr_make_file_source (size_t itemsize, const char *filename, bool repeat = false);
+gr_make_file_source (size_t itemsize, const char *filename, bool repeat = false,
+		     bool use_mmap = true);
 
 /*!
  * \brief Read stream from file
  * \ingroup source_blk
+ *
+ * If \p use_mmap is true and \p filename is a regular file the block
+ * maps a window of the file at a time and copies straight from the
+ * page cache into the output buffer, hinting sequential access and
+ * asking the kernel to read ahead of the current position.  Files
+ * larger than memory or the address space are fine.  Pipes, devices
+ * and systems without mmap fall back to stdio.
  */
 
 class gr_file_source : public gr_sync_block
 {
   friend gr_file_source_sptr gr_make_file_source (size_t itemsize,
 						  const char *filename,
-						  bool repeat);
+						  bool repeat,
+						  bool use_mmap);
  private:
   size_t	d_itemsize;
   void	       *d_fp;
   bool		d_repeat;
+  int		d_fd;
+
+  // byte offsets into the file; items come from [d_start, d_end)
+  off_t		d_pos;
+  off_t		d_start;
+  off_t		d_end;
+  bool		d_to_eof;	// d_end tracks the end of the file
+
+  // mmap mode: d_map covers [d_map_off, d_map_off + d_map_len)
+  bool		d_mmap;
+  char	       *d_map;
+  off_t		d_map_off;
+  size_t	d_map_len;
+  off_t		d_prefetched;	// read-ahead has been requested up to here
+
+  off_t file_end ();
+  bool map_window (off_t pos);
+  void unmap_window ();
+  void prefetch ();
+  int read_items (char *o, int nitems);
 
  protected:
-  gr_file_source (size_t itemsize, const char *filename, bool repeat);
+  gr_file_source (size_t itemsize, const char *filename, bool repeat,
+		  bool use_mmap);
 
  public:
   ~gr_file_source ();
@@ -61,8 +92,22 @@ class gr_file_source : public gr_sync_block
    *
    * \param seek_point	sample offset in file
    * \param whence	one of SEEK_SET, SEEK_CUR, SEEK_END (man fseek)
+   *
+   * Fails if the new position lies outside the current range.
    */
   bool seek (long seek_point, int whence);
+
+  /*!
+   * \brief restrict output to items [\p start_item, \p start_item + \p nitems)
+   *
+   * With repeat enabled the block loops over just this range.  If
+   * \p nitems <= 0 the range extends to the end of the file.  The
+   * read position moves to \p start_item.
+   */
+  bool set_range (long start_item, long nitems = 0);
+
+  //! true if the file is being read through mmap rather than stdio
+  bool mmapped () const { return d_mmap; }
 };
 
 #endif /* INCLUDED_GR_FILE_SOURCE_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004 Free Software Foundation, Inc.
+ * Copyright 2004,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,15 +29,19 @@
 GR_SWIG_BLOCK_MAGIC(gr,file_source)
 
 gr_file_source_sptr 
-gr_make_file_source (size_t itemsize, const char *filename, bool repeat=false);
+gr_make_file_source (size_t itemsize, const char *filename, bool repeat=false,
+		     bool use_mmap=true);
 
 class gr_file_source : public gr_sync_block
 {
  protected:
-  gr_file_source (size_t itemsize, const char *filename, bool repeat);
+  gr_file_source (size_t itemsize, const char *filename, bool repeat,
+		  bool use_mmap);
 
  public:
   ~gr_file_source ();
 
   bool seek (long seek_point, int whence);
+  bool set_range (long start_item, long nitems = 0);
+  bool mmapped () const;
 };
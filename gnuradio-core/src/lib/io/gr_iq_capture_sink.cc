@@ -0,0 +1,180 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_iq_capture_sink.h>
+#include <gr_io_signature.h>
+#include <sys/time.h>
+#include <string.h>
+
+gr_iq_capture_sink_sptr
+gr_make_iq_capture_sink (int item_type, const char *filename,
+			 double sample_rate, double center_freq,
+			 double start_time, bool compress,
+			 int chunk_items)
+{
+  return gr_iq_capture_sink_sptr (new gr_iq_capture_sink (item_type, filename,
+							  sample_rate, center_freq,
+							  start_time, compress,
+							  chunk_items));
+}
+
+static int
+checked_itemsize (int item_type)
+{
+  int itemsize = gri_iq_capture_itemsize (item_type);
+  if (itemsize == 0)
+    throw std::invalid_argument ("gr_iq_capture_sink: unknown item_type");
+  return itemsize;
+}
+
+gr_iq_capture_sink::gr_iq_capture_sink (int item_type, const char *filename,
+					double sample_rate, double center_freq,
+					double start_time, bool compress,
+					int chunk_items)
+  : gr_sync_block ("iq_capture_sink",
+		   gr_make_io_signature (1, 1, checked_itemsize (item_type)),
+		   gr_make_io_signature (0, 0, 0)),
+    d_fp (0), d_nbuffered (0), d_offset (GRI_IQ_CAPTURE_HEADER_SIZE),
+    d_failed (false)
+{
+  if (chunk_items <= 0)
+    throw std::invalid_argument ("gr_iq_capture_sink: chunk_items must be > 0");
+
+  if (start_time == 0){
+    struct timeval tv;
+    gettimeofday (&tv, 0);
+    start_time = tv.tv_sec + tv.tv_usec * 1e-6;
+  }
+
+  d_header.item_type = item_type;
+  d_header.itemsize = gri_iq_capture_itemsize (item_type);
+  d_header.chunk_items = chunk_items;
+  d_header.compressed = compress;
+  d_header.sample_rate = sample_rate;
+  d_header.center_freq = center_freq;
+  d_header.start_time = start_time;
+  d_header.nitems = 0;
+  d_header.nchunks = 0;
+  d_header.index_offset = 0;
+
+  d_chunk.resize ((size_t) chunk_items * d_header.itemsize);
+  d_encoded.resize (gri_iq_capture_max_chunk_bytes (d_header, chunk_items));
+
+  if ((d_fp = fopen (filename, "wb")) == 0){
+    perror (filename);
+    throw std::runtime_error ("gr_iq_capture_sink: can't open file");
+  }
+  if (!gri_iq_capture_write_header (d_fp, d_header)){
+    fclose (d_fp);
+    d_fp = 0;
+    throw std::runtime_error ("gr_iq_capture_sink: can't write header");
+  }
+}
+
+gr_iq_capture_sink::~gr_iq_capture_sink ()
+{
+  close ();
+}
+
+// Part of the chunk may have reached the file; nothing after it can
+// be placed reliably, so the first failure is the last write.
+bool
+gr_iq_capture_sink::write_chunk (const void *items, int nitems)
+{
+  size_t n = gri_iq_capture_encode_chunk (&d_encoded[0], items, nitems, d_header);
+  if (fwrite (&d_encoded[0], 1, n, d_fp) != n){
+    perror ("gr_iq_capture_sink");
+    d_failed = true;
+    return false;
+  }
+  d_offsets.push_back (d_offset);
+  d_offset += n;
+  d_header.nitems += nitems;
+  return true;
+}
+
+void
+gr_iq_capture_sink::close ()
+{
+  if (d_fp == 0)
+    return;
+
+  if (d_nbuffered > 0 && !d_failed)
+    write_chunk (&d_chunk[0], d_nbuffered);
+  d_nbuffered = 0;
+
+  // Without an index the reader walks the chunks, which stops short of
+  // whatever the failed write left behind.
+  if (d_failed)
+    fprintf (stderr, "gr_iq_capture_sink: write failed, no index written\n");
+  else if (!gri_iq_capture_write_index (d_fp, d_header, d_offsets)){
+    perror ("gr_iq_capture_sink: writing index");
+    d_failed = true;
+  }
+
+  fclose (d_fp);
+  d_fp = 0;
+}
+
+int
+gr_iq_capture_sink::work (int noutput_items,
+			  gr_vector_const_void_star &input_items,
+			  gr_vector_void_star &output_items)
+{
+  const char *in = (const char *) input_items[0];
+  int itemsize = d_header.itemsize;
+  int chunk_items = d_header.chunk_items;
+
+  if (d_fp == 0)			// closed: drop everything
+    return noutput_items;
+  if (d_failed)
+    return -1;
+
+  int n = noutput_items;
+  while (n > 0){
+    if (d_nbuffered == 0 && n >= chunk_items){
+      if (!write_chunk (in, chunk_items))	// whole chunk straight from the input
+	return -1;
+      in += chunk_items * itemsize;
+      n -= chunk_items;
+      continue;
+    }
+
+    int m = std::min (n, chunk_items - d_nbuffered);
+    memcpy (&d_chunk[(size_t) d_nbuffered * itemsize], in, (size_t) m * itemsize);
+    d_nbuffered += m;
+    in += m * itemsize;
+    n -= m;
+
+    if (d_nbuffered == chunk_items){
+      d_nbuffered = 0;
+      if (!write_chunk (&d_chunk[0], chunk_items))
+	return -1;
+    }
+  }
+
+  return noutput_items;
+}
@@ -0,0 +1,113 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_IQ_CAPTURE_SINK_H
+#define INCLUDED_GR_IQ_CAPTURE_SINK_H
+
+#include <gr_sync_block.h>
+#include <gri_iq_capture.h>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+class gr_iq_capture_sink;
+typedef boost::shared_ptr<gr_iq_capture_sink> gr_iq_capture_sink_sptr;
+
+/*!
+ * \param item_type	one of the GRI_IQ_* item types
+ * \param filename	file to create
+ * \param sample_rate	recorded in the header [S/s]
+ * \param center_freq	recorded in the header [Hz]
+ * \param start_time	time of the first item [s since the epoch], 0 means now
+ * \param compress	losslessly compress 16-bit item types
+ * \param chunk_items	items per chunk, the unit of random access
+ */
+gr_iq_capture_sink_sptr
+gr_make_iq_capture_sink (int item_type, const char *filename,
+			 double sample_rate, double center_freq,
+			 double start_time = 0, bool compress = true,
+			 int chunk_items = 65536);
+
+/*!
+ * \brief Write a stream to a chunked, self-describing capture file
+ * \ingroup sink_blk
+ *
+ * The file header records the item type, sample rate, center
+ * frequency and start time.  Items are written in chunks of
+ * \p chunk_items; with \p compress, short and complex short chunks are
+ * delta coded and bit packed (see gri_iq_capture.h), which typically
+ * runs at several hundred MS/s on one core.  A chunk index written by
+ * close() lets gr_iq_capture_source seek without decoding.
+ *
+ * If a write fails the sink stops writing, work() returns -1 and
+ * close() leaves out the index, so a reader keeps the complete chunks
+ * written before the failure.
+ */
+class gr_iq_capture_sink : public gr_sync_block
+{
+  friend gr_iq_capture_sink_sptr
+  gr_make_iq_capture_sink (int item_type, const char *filename,
+			   double sample_rate, double center_freq,
+			   double start_time, bool compress,
+			   int chunk_items);
+
+  FILE			       *d_fp;
+  gri_iq_capture_header		d_header;
+  std::vector<char>		d_chunk;	// items of the partial chunk
+  int				d_nbuffered;	// ... how many
+  std::vector<unsigned char>	d_encoded;
+  std::vector<long long>	d_offsets;	// file offset of each chunk
+  long long			d_offset;	// where the next chunk goes
+  bool				d_failed;	// a write failed; stop writing
+
+  bool write_chunk (const void *items, int nitems);
+
+ protected:
+  gr_iq_capture_sink (int item_type, const char *filename,
+		      double sample_rate, double center_freq,
+		      double start_time, bool compress,
+		      int chunk_items);
+
+ public:
+  ~gr_iq_capture_sink ();
+
+  /*!
+   * \brief Write the partial chunk and the index, and close the file.
+   * Called by the destructor if necessary.
+   */
+  void close ();
+
+  //! number of items written so far
+  unsigned long long nitems () const { return d_header.nitems; }
+
+  //! bytes written so far (chunk headers and payload)
+  long long nbytes () const { return d_offset; }
+
+  //! true once a write to the file has failed
+  bool failed () const { return d_failed; }
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_IQ_CAPTURE_SINK_H */
@@ -0,0 +1,55 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+enum gri_iq_item_type {
+  GRI_IQ_BYTE		= 0,
+  GRI_IQ_SHORT		= 1,
+  GRI_IQ_COMPLEX_SHORT	= 2,
+  GRI_IQ_FLOAT		= 3,
+  GRI_IQ_COMPLEX	= 4,
+  GRI_IQ_COMPLEX_BYTE	= 5
+};
+
+GR_SWIG_BLOCK_MAGIC(gr,iq_capture_sink);
+
+gr_iq_capture_sink_sptr
+gr_make_iq_capture_sink (int item_type, const char *filename,
+			 double sample_rate, double center_freq,
+			 double start_time = 0, bool compress = true,
+			 int chunk_items = 65536) throw (std::runtime_error, std::invalid_argument);
+
+class gr_iq_capture_sink : public gr_sync_block
+{
+ protected:
+  gr_iq_capture_sink (int item_type, const char *filename,
+		      double sample_rate, double center_freq,
+		      double start_time, bool compress,
+		      int chunk_items) throw (std::runtime_error, std::invalid_argument);
+
+ public:
+  ~gr_iq_capture_sink ();
+  void close ();
+  unsigned long long nitems () const;
+  long long nbytes () const;
+  bool failed () const;
+};
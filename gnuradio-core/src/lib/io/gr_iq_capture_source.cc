@@ -0,0 +1,307 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_iq_capture_source.h>
+#include <gr_io_signature.h>
+#include <gruel/thread_body_wrapper.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+// win32 (mingw/msvc) specific
+#ifdef HAVE_IO_H
+#include <io.h>
+#endif
+#ifdef O_BINARY
+#define	OUR_O_BINARY O_BINARY
+#else
+#define	OUR_O_BINARY 0
+#endif
+
+// should be handled via configure
+#ifdef O_LARGEFILE
+#define	OUR_O_LARGEFILE	O_LARGEFILE
+#else
+#define	OUR_O_LARGEFILE 0
+#endif
+
+gr_iq_capture_source_sptr
+gr_make_iq_capture_source (const char *filename, bool repeat,
+			   int nthreads)
+{
+  return gr_iq_capture_source_sptr (new gr_iq_capture_source (filename, repeat,
+							      nthreads));
+}
+
+static int
+open_capture (const char *filename, gri_iq_capture_header &h,
+	      std::vector<long long> &offsets)
+{
+  int fd = open (filename, O_RDONLY | OUR_O_LARGEFILE | OUR_O_BINARY);
+  if (fd < 0){
+    perror (filename);
+    throw std::runtime_error ("gr_iq_capture_source: can't open file");
+  }
+  if (!gri_iq_capture_read_header (fd, h)){
+    ::close (fd);
+    throw std::runtime_error ("gr_iq_capture_source: not a capture file");
+  }
+  if (!gri_iq_capture_read_index (fd, h, offsets)){
+    ::close (fd);
+    throw std::runtime_error ("gr_iq_capture_source: bad chunk index");
+  }
+  return fd;
+}
+
+/*
+ * The io signature depends on the file, so the file is opened before
+ * the base class is constructed, and again below.
+ */
+static int
+capture_itemsize (const char *filename)
+{
+  gri_iq_capture_header h;
+  std::vector<long long> offsets;
+  ::close (open_capture (filename, h, offsets));
+  return h.itemsize;
+}
+
+gr_iq_capture_source::gr_iq_capture_source (const char *filename, bool repeat,
+					    int nthreads)
+  : gr_sync_block ("iq_capture_source",
+		   gr_make_io_signature (0, 0, 0),
+		   gr_make_io_signature (1, 1, capture_itemsize (filename))),
+    d_fd (-1), d_repeat (repeat), d_nthreads (std::max (0, nthreads)),
+    d_next_seq (0), d_read_seq (0), d_read_pos (0), d_generation (0),
+    d_stopping (false)
+{
+  d_fd = open_capture (filename, d_header, d_offsets);
+
+  d_slots.resize (2 * std::max (1, d_nthreads));
+  for (size_t i = 0; i < d_slots.size (); i++){
+    d_slots[i].data.resize ((size_t) d_header.chunk_items * d_header.itemsize);
+    d_slots[i].nitems = 0;
+    d_slots[i].seq = -1;
+    d_slots[i].busy = false;
+    d_slots[i].ready = false;
+    d_slots[i].error = false;
+  }
+}
+
+gr_iq_capture_source::~gr_iq_capture_source ()
+{
+  stop ();
+  ::close (d_fd);
+}
+
+// sequence numbers count chunks as output; with repeat they run on forever
+long long
+gr_iq_capture_source::end_seq () const
+{
+  if (d_offsets.empty ())
+    return 0;
+  return d_repeat ? -1 : (long long) d_offsets.size ();
+}
+
+bool
+gr_iq_capture_source::decode (long long seq, slot &s, std::vector<unsigned char> &buf)
+{
+  long long chunk = seq % (long long) d_offsets.size ();
+  long long off = d_offsets[chunk];
+
+  unsigned char h[GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE];
+  int codec, nitems;
+  size_t nbytes;
+  if (pread (d_fd, h, sizeof (h), off) != (ssize_t) sizeof (h)
+      || !gri_iq_capture_parse_chunk_header (h, codec, nitems, nbytes)
+      || nitems <= 0 || nitems > d_header.chunk_items)
+    return false;
+
+  if (buf.size () < nbytes)
+    buf.resize (nbytes);
+  size_t got = 0;
+  while (got < nbytes){
+    ssize_t r = pread (d_fd, &buf[got], nbytes - got, off + sizeof (h) + got);
+    if (r <= 0)
+      return false;
+    got += r;
+  }
+
+  s.nitems = nitems;
+  return gri_iq_capture_decode_chunk (&s.data[0], nitems, codec,
+				      nbytes ? &buf[0] : 0, nbytes, d_header);
+}
+
+void
+gr_iq_capture_source::run_decoder ()
+{
+  std::vector<unsigned char> buf;
+  gruel::scoped_lock guard (d_mutex);
+
+  while (!d_stopping){
+    long long seq = d_next_seq;
+    long long end = end_seq ();
+    slot &s = d_slots[seq % d_slots.size ()];
+
+    // stay within the window of slots ahead of the reader
+    if ((end >= 0 && seq >= end) || seq >= d_read_seq + (long long) d_slots.size ()
+	|| s.busy){
+      d_cond.wait (guard);
+      continue;
+    }
+
+    d_next_seq++;
+    s.busy = true;
+    s.ready = false;
+    long generation = d_generation;
+
+    guard.unlock ();
+    bool ok = decode (seq, s, buf);
+    guard.lock ();
+
+    s.busy = false;
+    if (generation == d_generation){
+      s.seq = seq;
+      s.ready = true;
+      s.error = !ok;
+    }
+    d_cond.notify_all ();
+  }
+}
+
+struct gr_iq_capture_source::decoder_body
+{
+  gr_iq_capture_source *d_source;
+
+  decoder_body (gr_iq_capture_source *source) : d_source (source) {}
+  void operator() () { d_source->run_decoder (); }
+};
+
+bool
+gr_iq_capture_source::start ()
+{
+  gruel::scoped_lock guard (d_mutex);
+  if (d_decoders.empty ()){
+    d_stopping = false;
+    for (int i = 0; i < d_nthreads; i++)
+      d_decoders.push_back (new gruel::thread (
+	gruel::thread_body_wrapper<decoder_body> (decoder_body (this),
+						  "iq_capture_source decoder")));
+  }
+  return true;
+}
+
+bool
+gr_iq_capture_source::stop ()
+{
+  {
+    gruel::scoped_lock guard (d_mutex);
+    d_stopping = true;
+    d_cond.notify_all ();
+  }
+  for (size_t i = 0; i < d_decoders.size (); i++){
+    d_decoders[i]->join ();
+    delete d_decoders[i];
+  }
+  d_decoders.clear ();
+  return true;
+}
+
+bool
+gr_iq_capture_source::seek (unsigned long long item)
+{
+  if (item >= d_header.nitems)
+    return false;
+
+  gruel::scoped_lock guard (d_mutex);
+  d_generation++;
+  for (size_t i = 0; i < d_slots.size (); i++)
+    d_slots[i].ready = false;
+  d_read_seq = d_next_seq = item / d_header.chunk_items;
+  d_read_pos = item % d_header.chunk_items;
+  d_cond.notify_all ();
+  return true;
+}
+
+int
+gr_iq_capture_source::work (int noutput_items,
+			    gr_vector_const_void_star &input_items,
+			    gr_vector_void_star &output_items)
+{
+  char *out = (char *) output_items[0];
+  int itemsize = d_header.itemsize;
+  int nn = 0;
+
+  gruel::scoped_lock guard (d_mutex);
+
+  while (nn < noutput_items){
+    long long end = end_seq ();
+    if (end >= 0 && d_read_seq >= end)
+      break;				// end of file
+
+    slot &s = d_slots[d_read_seq % d_slots.size ()];
+    if (!(s.ready && s.seq == d_read_seq)){
+      if (d_decoders.empty ()){		// not started by a scheduler: decode here
+	std::vector<unsigned char> buf;
+	s.error = !decode (d_read_seq, s, buf);
+	s.seq = d_read_seq;
+	s.ready = true;
+	if (d_next_seq <= d_read_seq)
+	  d_next_seq = d_read_seq + 1;
+      }
+      else {
+	if (nn > 0)			// return what we have
+	  break;
+	d_cond.wait (guard);
+	continue;
+      }
+    }
+
+    if (s.error){
+      fprintf (stderr, "gr_iq_capture_source: corrupt chunk %lld\n",
+	       d_read_seq % (long long) d_offsets.size ());
+      return nn > 0 ? nn : -1;
+    }
+
+    int m = std::min (noutput_items - nn, s.nitems - d_read_pos);
+    memcpy (out, &s.data[(size_t) d_read_pos * itemsize], (size_t) m * itemsize);
+    out += m * itemsize;
+    nn += m;
+    d_read_pos += m;
+
+    if (d_read_pos >= s.nitems){		// done with this chunk
+      s.ready = false;
+      d_read_seq++;
+      d_read_pos = 0;
+      d_cond.notify_all ();
+    }
+  }
+
+  return nn > 0 ? nn : -1;
+}
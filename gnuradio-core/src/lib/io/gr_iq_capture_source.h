@@ -0,0 +1,121 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_IQ_CAPTURE_SOURCE_H
+#define INCLUDED_GR_IQ_CAPTURE_SOURCE_H
+
+#include <gr_sync_block.h>
+#include <gri_iq_capture.h>
+#include <gruel/thread.h>
+#include <stdexcept>
+#include <vector>
+
+class gr_iq_capture_source;
+typedef boost::shared_ptr<gr_iq_capture_source> gr_iq_capture_source_sptr;
+
+/*!
+ * \param filename	capture written by gr_iq_capture_sink
+ * \param repeat	start over at the end of the file
+ * \param nthreads	decoder threads; 0 decodes each chunk in work()
+ */
+gr_iq_capture_source_sptr
+gr_make_iq_capture_source (const char *filename, bool repeat = false,
+			   int nthreads = 2);
+
+/*!
+ * \brief Read a stream from a capture file written by gr_iq_capture_sink
+ * \ingroup source_blk
+ *
+ * The output item size follows the file's item type.  While the flow
+ * graph runs, \p nthreads threads read and decode the chunks ahead of
+ * the current position, up to two chunks per thread, so work() only
+ * copies decoded items; with no decoder threads work() decodes each
+ * chunk as it reaches it.  seek() uses the chunk index and only decodes
+ * the chunk it lands in.  Files whose writer never called close() are
+ * read up to the last complete chunk.
+ */
+class gr_iq_capture_source : public gr_sync_block
+{
+  friend gr_iq_capture_source_sptr
+  gr_make_iq_capture_source (const char *filename, bool repeat,
+			     int nthreads);
+
+  struct slot {
+    std::vector<char>	data;		// decoded items
+    int			nitems;
+    long long		seq;		// which chunk it holds
+    bool		busy;		// a decoder is writing it
+    bool		ready;		// holds chunk seq of this generation
+    bool		error;
+  };
+
+  struct decoder_body;
+  friend struct decoder_body;
+
+  int				d_fd;
+  bool				d_repeat;
+  int				d_nthreads;
+  gri_iq_capture_header		d_header;
+  std::vector<long long>	d_offsets;
+
+  gruel::mutex			d_mutex;
+  gruel::condition_variable	d_cond;
+  std::vector<slot>		d_slots;
+  long long			d_next_seq;	// next chunk to hand to a decoder
+  long long			d_read_seq;	// chunk work() is reading
+  int				d_read_pos;	// ... items already output
+  long				d_generation;	// bumped by seek()
+  bool				d_stopping;
+  std::vector<gruel::thread *>	d_decoders;
+
+  long long end_seq () const;
+  bool decode (long long seq, slot &s, std::vector<unsigned char> &buf);
+  void run_decoder ();
+
+ protected:
+  gr_iq_capture_source (const char *filename, bool repeat,
+			int nthreads);
+
+ public:
+  ~gr_iq_capture_source ();
+
+  int item_type () const { return d_header.item_type; }
+  double sample_rate () const { return d_header.sample_rate; }
+  double center_freq () const { return d_header.center_freq; }
+  double start_time () const { return d_header.start_time; }
+  bool compressed () const { return d_header.compressed; }
+
+  //! number of items in the file
+  unsigned long long nitems () const { return d_header.nitems; }
+
+  //! continue reading at item \p item; false if out of range
+  bool seek (unsigned long long item);
+
+  bool start ();
+  bool stop ();
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_IQ_CAPTURE_SOURCE_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,6 +26,10 @@
 
 #include <gr_message_sink.h>
 #include <gr_io_signature.h>
+#include <gr_block_detail.h>
+#include <gr_buffer.h>
+#include <gruel/thread.h>
+#include <deque>
 #include <cstdio>
 #include <errno.h>
 #include <sys/types.h>
@@ -35,19 +39,79 @@
 #include <string.h>
 
 
+// zero copy: how long work waits for a message to be released
+static const long PIN_WAIT_MS = 5;
+
+/*
+ * Messages handed out in zero copy mode, oldest first.  Each entry is
+ * released (possibly by another thread) when its message is destroyed;
+ * work consumes the items of the released entries at the front.
+ */
+struct gr_message_sink::pin_state {
+  gruel::mutex			    d_mutex;
+  gruel::condition_variable	    d_released;
+  std::deque<std::pair<int,bool> >  d_entries;	// (nitems, released)
+  unsigned long			    d_front_seq;	// seq # of d_entries.front()
+
+  pin_state() : d_front_seq(0) {}
+
+  unsigned long add(int nitems, bool released)
+  {
+    gruel::scoped_lock guard(d_mutex);
+    d_entries.push_back(std::make_pair(nitems, released));
+    return d_front_seq + d_entries.size() - 1;
+  }
+
+  void release(unsigned long seq)
+  {
+    gruel::scoped_lock guard(d_mutex);
+    d_entries[seq - d_front_seq].second = true;
+    d_released.notify_one();
+  }
+
+  // number of items that may be consumed; wait up to timeout_ms for some
+  int collect(long timeout_ms)
+  {
+    gruel::scoped_lock guard(d_mutex);
+    if (timeout_ms > 0 && !(!d_entries.empty() && d_entries.front().second))
+      d_released.timed_wait(guard, boost::posix_time::milliseconds(timeout_ms));
+
+    int n = 0;
+    while (!d_entries.empty() && d_entries.front().second){
+      n += d_entries.front().first;
+      d_entries.pop_front();
+      d_front_seq++;
+    }
+    return n;
+  }
+};
+
+// owner deleter of a zero copy message; keeps the buffer memory alive
+struct gr_message_sink::pin_release {
+  boost::shared_ptr<pin_state>	d_state;
+  gr_buffer_reader_sptr		d_reader;
+  unsigned long			d_seq;
+
+  void operator()(void *) { d_state->release(d_seq); }
+};
+
 // public constructor that returns a shared_ptr
 
 gr_message_sink_sptr 
-gr_make_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block)
+gr_make_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block,
+		      bool zero_copy)
 {
-  return gr_message_sink_sptr(new gr_message_sink(itemsize, msgq, dont_block));
+  return gr_message_sink_sptr(new gr_message_sink(itemsize, msgq, dont_block,
+						  zero_copy));
 }
 
-gr_message_sink::gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block)
+gr_message_sink::gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block,
+				  bool zero_copy)
   : gr_sync_block("message_sink",
 		  gr_make_io_signature(1, 1, itemsize),
 		  gr_make_io_signature(0, 0, 0)),
-    d_itemsize(itemsize), d_msgq(msgq), d_dont_block(dont_block)
+    d_itemsize(itemsize), d_msgq(msgq), d_dont_block(dont_block),
+    d_zero_copy(zero_copy), d_npinned(0)
 {
 }
 
@@ -62,6 +126,9 @@ gr_message_sink::work(int noutput_items,
 {
   const char *in = (const char *) input_items[0];
 
+  if (d_zero_copy)
+    return work_zero_copy(noutput_items, in);
+
   // if we'd block, drop the data on the floor and say everything is OK
   if (d_dont_block && d_msgq->full_p())
     return noutput_items;
@@ -77,3 +144,60 @@ gr_message_sink::work(int noutput_items,
 
   return noutput_items;
 }
+
+/*
+ * in[0 .. d_npinned) has already been sent; the rest is new.
+ */
+int
+gr_message_sink::work_zero_copy(int noutput_items, const char *in)
+{
+  gr_buffer_reader_sptr reader = detail()->input(0);
+  if (reader != d_reader){		// new flow graph, new buffer
+    d_pins.reset(new pin_state());
+    d_reader = reader;
+    d_npinned = 0;
+  }
+
+  // Once the writer is done nothing will overwrite the data, and the
+  // messages keep the buffer alive, so it is safe to consume all of it.
+  bool writer_done = reader->done();
+
+  int nnew = std::max(0, noutput_items - d_npinned);
+  if (!writer_done){
+    int budget = reader->max_possible_items_available() / 2;
+    nnew = std::min(nnew, std::max(0, budget - d_npinned));
+  }
+
+  if (nnew > 0){
+    const char *p = in + d_npinned * d_itemsize;
+
+    if (d_dont_block && d_msgq->full_p())
+      d_pins->add(nnew, true);		// drop, consume when our turn comes
+    else {
+      pin_release r;
+      r.d_state = d_pins;
+      r.d_reader = reader;
+      r.d_seq = d_pins->add(nnew, false);
+
+      gr_message_sptr msg =
+	gr_make_message_from_buffer((unsigned char *) p, nnew * d_itemsize,
+				    boost::shared_ptr<void>((void *) p, r),
+				    0,			// msg type
+				    d_itemsize,		// arg1 for other end
+				    nnew);		// arg2 for other end (redundant)
+      d_msgq->handle(msg);
+    }
+    d_npinned += nnew;
+  }
+
+  if (writer_done){
+    d_pins.reset(new pin_state());	// outstanding releases no longer matter
+    d_npinned = std::max(0, d_npinned - noutput_items);
+    return noutput_items;
+  }
+
+  // If there was nothing to send, wait a little for a release
+  int n = d_pins->collect(nnew == 0 ? PIN_WAIT_MS : 0);
+  d_npinned -= n;
+  return n;
+}
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -32,24 +32,47 @@ typedef boost::shared_ptr<gr_message_sink> gr_message_sink_sptr;
 
 gr_message_sink_sptr gr_make_message_sink (size_t itemsize,
 					   gr_msg_queue_sptr msgq,
-					   bool dont_block);
+					   bool dont_block,
+					   bool zero_copy=false);
 
 /*!
  * \brief Gather received items into messages and insert into msgq
  * \ingroup sink_blk
+ *
+ * Normally the items are copied into each message.  With \p zero_copy
+ * the message payload points straight into the input buffer instead:
+ * the items stay unconsumed, and so cannot be overwritten, until the
+ * message is destroyed.  Treat such payloads as read-only.  Items are
+ * consumed in order, so holding on to one message eventually stalls
+ * the upstream blocks; at most half the buffer is handed out at once.
+ * Once the upstream block is done nothing can overwrite the data and
+ * the items are consumed right away.
  */
 class gr_message_sink : public gr_sync_block
 {
  private:
+  struct pin_state;
+  struct pin_release;
+
   size_t	 	d_itemsize;
   gr_msg_queue_sptr	d_msgq;
   bool			d_dont_block;
+  bool			d_zero_copy;
+
+  // zero copy: items handed out but not yet consumed
+  boost::shared_ptr<pin_state>	d_pins;
+  gr_buffer_reader_sptr		d_reader;	// reader d_pins refers to
+  int				d_npinned;
 
   friend gr_message_sink_sptr
-  gr_make_message_sink(size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block);
+  gr_make_message_sink(size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block,
+		       bool zero_copy);
+
+  int work_zero_copy (int noutput_items, const char *in);
 
  protected:
-  gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block);
+  gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block,
+		   bool zero_copy);
 
  public:
   ~gr_message_sink ();
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,12 +24,14 @@ GR_SWIG_BLOCK_MAGIC(gr,message_sink);
 
 gr_message_sink_sptr gr_make_message_sink (size_t itemsize,
 					   gr_msg_queue_sptr msgq,
-					   bool dont_block);
+					   bool dont_block,
+					   bool zero_copy=false);
 
 class gr_message_sink : public gr_sync_block
 {
  protected:
-  gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block);
+  gr_message_sink (size_t itemsize, gr_msg_queue_sptr msgq, bool dont_block,
+		   bool zero_copy);
 
  public:
   ~gr_message_sink ();
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -36,6 +36,12 @@ gr_message_source_sptr gr_make_message_source (size_t itemsize, gr_msg_queue_spt
 /*!
  * \brief Turn received messages into a stream
  * \ingroup source_blk
+ *
+ * Payloads are copied into the output buffer and each message is
+ * dropped as soon as it has been copied.  To feed externally allocated
+ * memory without an extra copy into the message, build the messages
+ * with gr_make_message_from_buffer; the owner's deleter then tells you
+ * when the memory is free again.
  */
 class gr_message_source : public gr_sync_block
 {
@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_shm_sink.h>
+#include <gr_io_signature.h>
+#include <algorithm>
+
+gr_shm_sink_sptr
+gr_make_shm_sink (size_t itemsize, const char *name, size_t buffer_bytes)
+{
+  return gr_shm_sink_sptr (new gr_shm_sink (itemsize, name, buffer_bytes));
+}
+
+gr_shm_sink::gr_shm_sink (size_t itemsize, const char *name, size_t buffer_bytes)
+  : gr_sync_block ("shm_sink",
+		   gr_make_io_signature (1, 1, itemsize),
+		   gr_make_io_signature (0, 0, 0)),
+    d_ring (0), d_itemsize (itemsize), d_max_bytes (0)
+{
+  if (buffer_bytes < 2 * itemsize)
+    throw std::invalid_argument ("gr_shm_sink: buffer_bytes must hold at least 2 items");
+
+  d_ring = new gri_shm_ring (name, buffer_bytes, itemsize);
+  d_max_bytes = std::max (d_ring->size () / 2 / itemsize, (size_t) 1) * itemsize;
+}
+
+gr_shm_sink::~gr_shm_sink ()
+{
+  delete d_ring;
+}
+
+bool
+gr_shm_sink::start ()
+{
+  d_ring->set_writer_alive (true);
+  return true;
+}
+
+bool
+gr_shm_sink::stop ()
+{
+  d_ring->set_writer_alive (false);	// readers finish once they've drained the ring
+  return true;
+}
+
+int
+gr_shm_sink::work (int noutput_items,
+		   gr_vector_const_void_star &input_items,
+		   gr_vector_void_star &output_items)
+{
+  const char *in = (const char *) input_items[0];
+  size_t nbytes = noutput_items * d_itemsize;
+
+  while (nbytes > 0){
+    size_t n = std::min (nbytes, d_max_bytes);
+    d_ring->write (in, n);
+    in += n;
+    nbytes -= n;
+  }
+  return noutput_items;
+}
@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_SHM_SINK_H
+#define INCLUDED_GR_SHM_SINK_H
+
+#include <gr_sync_block.h>
+#include <gri_shm_ring.h>
+#include <stdexcept>
+
+class gr_shm_sink;
+typedef boost::shared_ptr<gr_shm_sink> gr_shm_sink_sptr;
+
+/*!
+ * \param itemsize	size of the stream items in bytes
+ * \param name		shared memory segment to create
+ * \param buffer_bytes	size of the ring; rounded up to a page
+ */
+gr_shm_sink_sptr
+gr_make_shm_sink (size_t itemsize, const char *name,
+		  size_t buffer_bytes = 16 * 1024 * 1024);
+
+/*!
+ * \brief Publish a stream to other processes through shared memory
+ * \ingroup sink_blk
+ *
+ * Any number of gr_shm_source blocks (up to
+ * gri_shm_ring::MAX_READERS), in this process or others, can attach
+ * to the stream by name at any time.  work() is a single memcpy into
+ * the ring; the sink never waits for its readers, so a reader that
+ * falls more than a ring behind loses data and is told so, but
+ * cannot slow down the writer or the other readers.
+ */
+class gr_shm_sink : public gr_sync_block
+{
+  friend gr_shm_sink_sptr
+  gr_make_shm_sink (size_t itemsize, const char *name, size_t buffer_bytes);
+
+  gri_shm_ring	       *d_ring;
+  size_t		d_itemsize;
+  size_t		d_max_bytes;	// per write, so readers keep up with their copies
+
+ protected:
+  gr_shm_sink (size_t itemsize, const char *name, size_t buffer_bytes);
+
+ public:
+  ~gr_shm_sink ();
+
+  //! items written since the segment was created
+  long long nitems_written () const { return d_ring->head () / d_itemsize; }
+
+  //! number of attached readers
+  int nreaders () const { return d_ring->nreaders (); }
+
+  bool start ();
+  bool stop ();
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_SHM_SINK_H */
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_shm_source.h>
+#include <gr_io_signature.h>
+#include <gruel/thread.h>
+
+static const double WAIT_TIMEOUT = 0.1;	// [s] between checks for interruption
+
+gr_shm_source_sptr
+gr_make_shm_source (size_t itemsize, const char *name)
+{
+  return gr_shm_source_sptr (new gr_shm_source (itemsize, name));
+}
+
+gr_shm_source::gr_shm_source (size_t itemsize, const char *name)
+  : gr_sync_block ("shm_source",
+		   gr_make_io_signature (0, 0, 0),
+		   gr_make_io_signature (1, 1, itemsize)),
+    d_ring (new gri_shm_ring (name)), d_itemsize (itemsize)
+{
+  if (d_ring->itemsize () != (int) itemsize){
+    delete d_ring;
+    throw std::invalid_argument ("gr_shm_source: itemsize does not match the sink's");
+  }
+}
+
+gr_shm_source::~gr_shm_source ()
+{
+  delete d_ring;
+}
+
+int
+gr_shm_source::work (int noutput_items,
+		     gr_vector_const_void_star &input_items,
+		     gr_vector_void_star &output_items)
+{
+  size_t nbytes = noutput_items * d_itemsize;
+
+  for (;;){
+    size_t n = d_ring->read (output_items[0], nbytes, d_itemsize);
+    if (n > 0)
+      return n / d_itemsize;
+
+    if (!d_ring->writer_alive ()){
+      // It may have written more just before it finished.
+      n = d_ring->read (output_items[0], nbytes, d_itemsize);
+      return n > 0 ? (int) (n / d_itemsize) : -1;
+    }
+
+    d_ring->wait (WAIT_TIMEOUT);
+    boost::this_thread::interruption_point ();
+  }
+}
@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_SHM_SOURCE_H
+#define INCLUDED_GR_SHM_SOURCE_H
+
+#include <gr_sync_block.h>
+#include <gri_shm_ring.h>
+#include <stdexcept>
+
+class gr_shm_source;
+typedef boost::shared_ptr<gr_shm_source> gr_shm_source_sptr;
+
+/*!
+ * \param itemsize	size of the stream items in bytes; must match the sink
+ * \param name		shared memory segment created by gr_shm_sink
+ */
+gr_shm_source_sptr
+gr_make_shm_source (size_t itemsize, const char *name);
+
+/*!
+ * \brief Read a stream published by gr_shm_sink, possibly in another process
+ * \ingroup source_blk
+ *
+ * Output starts with the items written after the source attached (in
+ * the constructor).  The source sleeps until the sink writes more and
+ * finishes when the sink has stopped and everything it wrote has been
+ * produced.  If this reader falls more than a ring behind it skips
+ * ahead; noverruns() and nitems_lost() say how often and how much.
+ */
+class gr_shm_source : public gr_sync_block
+{
+  friend gr_shm_source_sptr
+  gr_make_shm_source (size_t itemsize, const char *name);
+
+  gri_shm_ring	       *d_ring;
+  size_t		d_itemsize;
+
+ protected:
+  gr_shm_source (size_t itemsize, const char *name);
+
+ public:
+  ~gr_shm_source ();
+
+  //! times this reader was overrun
+  long noverruns () const { return d_ring->noverruns (); }
+
+  //! items lost to overruns
+  long long nitems_lost () const { return d_ring->nbytes_lost () / d_itemsize; }
+
+  //! items the sink is ahead of us
+  long long nitems_behind () const { return (d_ring->head () - d_ring->offset ()) / d_itemsize; }
+
+  int work (int noutput_items,
+	    gr_vector_const_void_star &input_items,
+	    gr_vector_void_star &output_items);
+};
+
+#endif /* INCLUDED_GR_SHM_SOURCE_H */
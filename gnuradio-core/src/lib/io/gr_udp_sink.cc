@@ -47,7 +47,18 @@ typedef void* optval_t;
 typedef char* optval_t;
 #endif
 
+#if !defined(USING_WINSOCK)
+#include <gri_udp_batch.h>
+#define HAVE_UDP_BATCH 1
+#if defined(HAVE_NETINET_IN_H)
+#include <netinet/in.h>
+#endif
+#endif
+
 #include <gruel/thread.h>
+#include <gruel/atomic.h>
+#include <stdint.h>
+#include <vector>
 
 #define SNK_VERBOSE 0
 
@@ -90,6 +101,16 @@ static void report_error( const char *msg1, const char *msg2 )
   return;
 }
 
+// Per-datagram headers for the batched send path
+struct gr_udp_sink::batch_state
+{
+#if defined(HAVE_UDP_BATCH)
+  std::vector<gri_mmsghdr>  msgs;
+  std::vector<struct iovec> iov;      // sequence number, data
+#endif
+  std::vector<uint32_t>     seqno;
+};
+
 gr_udp_sink::gr_udp_sink (size_t itemsize, 
 			  const char *host, unsigned short port,
 			  int payload_size, bool eof)
@@ -97,7 +118,9 @@ gr_udp_sink::gr_udp_sink (size_t itemsize,
 		   gr_make_io_signature (1, 1, itemsize),
 		   gr_make_io_signature (0, 0, 0)),
     d_itemsize (itemsize), d_payload_size(payload_size), d_eof(eof),
-    d_socket(-1), d_connected(false)
+    d_socket(-1), d_connected(false),
+    d_batch_size(1), d_seqno(false), d_next_seqno(0), d_batch(new batch_state),
+    d_ndatagrams(0), d_nbytes(0), d_ndiscarded(0)
 {
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // initialize winsock DLL
@@ -155,6 +178,8 @@ gr_udp_sink::~gr_udp_sink ()
     d_socket = -1;
   }
 
+  delete d_batch;
+
 #if defined(USING_WINSOCK) // for Windows (with MinGW)
   // free winsock resources
   WSACleanup();
@@ -176,22 +201,36 @@ gr_udp_sink::work (int noutput_items,
 
   gruel::scoped_lock guard(d_mutex);  // protect d_socket
 
+  if(d_batch_size > 1 || d_seqno) {
+    if(work_batched(in, total_size) < 0)
+      return -1;
+    return noutput_items;
+  }
+
   while(bytes_sent <  total_size) {
     bytes_to_send = std::min((ssize_t)d_payload_size, (total_size-bytes_sent));
   
     if(d_connected) {
       r = send(d_socket, (in+bytes_sent), bytes_to_send, 0);
       if(r == -1) {         // error on send command
-	if( is_error(ECONNREFUSED) )
+	if( is_error(ECONNREFUSED) ) {
 	  r = bytes_to_send;  // discard data until receiver is started
+	  gruel::atomic_fetch_add(&d_ndiscarded, (unsigned long long) r);
+	}
 	else {
 	  report_error("udp_sink",NULL); // there should be no error case where
 	  return -1;                  // this function should not exit immediately
 	}
       }
+      else {
+	gruel::atomic_fetch_add(&d_ndatagrams, 1ULL);
+	gruel::atomic_fetch_add(&d_nbytes, (unsigned long long) r);
+      }
     }
-    else
+    else {
       r = bytes_to_send;  // discarded for lack of connection
+      gruel::atomic_fetch_add(&d_ndiscarded, (unsigned long long) r);
+    }
     bytes_sent += r;
     
     #if SNK_VERBOSE
@@ -300,3 +339,106 @@ void gr_udp_sink::disconnect()
 
   return;
 }
+
+void
+gr_udp_sink::set_batch_size(int n)
+{
+#if defined(HAVE_UDP_BATCH)
+  if(n > 1 && d_payload_size < (int) d_itemsize)
+    throw std::invalid_argument("gr_udp_sink: payload_size smaller than an item");
+  gruel::scoped_lock guard(d_mutex);
+  d_batch_size = std::max(n, 1);
+#endif
+}
+
+void
+gr_udp_sink::set_sequence_numbers(bool on)
+{
+#if defined(HAVE_UDP_BATCH)
+  if(on && d_payload_size < (int) (sizeof(uint32_t) + d_itemsize))
+    throw std::invalid_argument("gr_udp_sink: payload_size too small for sequence numbers");
+  gruel::scoped_lock guard(d_mutex);
+  d_seqno = on;
+#else
+  if(on)
+    throw std::runtime_error("gr_udp_sink: sequence numbers need POSIX sockets");
+#endif
+}
+
+unsigned long long gr_udp_sink::ndatagrams() { return gruel::atomic_read(&d_ndatagrams); }
+unsigned long long gr_udp_sink::nbytes() { return gruel::atomic_read(&d_nbytes); }
+unsigned long long gr_udp_sink::ndiscarded() { return gruel::atomic_read(&d_ndiscarded); }
+
+// Send total_size bytes from in as datagrams of up to payload_size
+// bytes, d_batch_size at a time.  Datagrams carry whole items, so
+// the receiver never has to put one back together.  The iovecs point straight into the
+// input buffer.  Called with d_mutex held.
+
+int
+gr_udp_sink::work_batched(const char *in, ssize_t total_size)
+{
+#if defined(HAVE_UDP_BATCH)
+  size_t hdr = d_seqno ? sizeof(uint32_t) : 0;
+  ssize_t slot = (d_payload_size - hdr) / d_itemsize * d_itemsize;
+  unsigned int n = d_batch_size;
+  batch_state &b = *d_batch;
+
+  if(b.msgs.size() < n) {
+    b.msgs.resize(n);
+    b.iov.resize(2*n);
+    b.seqno.resize(n);
+  }
+
+  ssize_t bytes_sent = 0;
+  while(bytes_sent < total_size) {
+    unsigned int count = 0;
+    ssize_t offset = bytes_sent;
+    for(; count < n && offset < total_size; count++) {
+      ssize_t len = std::min(slot, total_size - offset);
+      struct msghdr &m = b.msgs[count].msg_hdr;
+      b.seqno[count] = htonl(d_next_seqno + count);
+      b.iov[2*count].iov_base = &b.seqno[count];
+      b.iov[2*count].iov_len = hdr;
+      b.iov[2*count+1].iov_base = (void *) (in + offset);
+      b.iov[2*count+1].iov_len = len;
+      memset(&m, 0, sizeof(m));
+      m.msg_iov = &b.iov[d_seqno ? 2*count : 2*count+1];
+      m.msg_iovlen = d_seqno ? 2 : 1;
+      offset += len;
+    }
+
+    // Sequence numbers advance for discarded data too, so the
+    // receiver sees it as lost.
+    if(!d_connected) {
+      d_next_seqno += count;
+      gruel::atomic_fetch_add(&d_ndiscarded, (unsigned long long) (offset - bytes_sent));
+      bytes_sent = offset;
+      continue;
+    }
+
+    int r = gri_sendmmsg(d_socket, &b.msgs[0], count, 0);
+    if(r < 0) {
+      if(is_error(EINTR))
+	continue;
+      if(!is_error(ECONNREFUSED)) {
+	report_error("udp_sink/sendmmsg",NULL);
+	return -1;
+      }
+      r = 1;			// discard one datagram until receiver is started
+      gruel::atomic_fetch_add(&d_ndiscarded, (unsigned long long) b.iov[1].iov_len);
+    }
+    else {
+      gruel::atomic_fetch_add(&d_ndatagrams, (unsigned long long) r);
+      for(int i = 0; i < r; i++)
+	gruel::atomic_fetch_add(&d_nbytes, (unsigned long long) b.msgs[i].msg_len);
+    }
+
+    for(int i = 0; i < r; i++)
+      bytes_sent += b.iov[2*i+1].iov_len;
+    d_next_seqno += r;
+  }
+  return 0;
+#else
+  return -1;
+#endif
+}
@@ -45,6 +45,12 @@ gr_make_udp_sink (size_t itemsize,
  * \param payload_size UDP payload size by default set to 1472 =
  *                     (1500 MTU - (8 byte UDP header) - (20 byte IP header))
  * \param eof          Send zero-length packet on disconnect
+ *
+ * set_batch_size() sends up to that many datagrams per system call
+ * (sendmmsg), gathered straight from the input buffer.
+ * set_sequence_numbers() prefixes every datagram with a 32-bit
+ * big-endian sequence number, which a gr_udp_source with the same
+ * setting uses to count lost datagrams.  Both require POSIX sockets.
  */
 
 class gr_udp_sink : public gr_sync_block
@@ -62,6 +68,19 @@ class gr_udp_sink : public gr_sync_block
   bool          d_connected;       // are we connected?
   gruel::mutex  d_mutex;           // protects d_socket and d_connected
 
+  int           d_batch_size;      // datagrams per send call
+  bool          d_seqno;           // prefix datagrams with a sequence number
+  unsigned int  d_next_seqno;      // number for the next datagram
+
+  struct batch_state;
+  batch_state  *d_batch;
+
+  volatile unsigned long long d_ndatagrams;
+  volatile unsigned long long d_nbytes;
+  volatile unsigned long long d_ndiscarded;
+
+  int work_batched(const char *in, ssize_t total_size);
+
  protected:
   /*!
    * \brief UDP Sink Constructor
@@ -101,6 +120,21 @@ class gr_udp_sink : public gr_sync_block
    * its top_block stops.*/
   void disconnect();
 
+  /*! \brief send up to \p n datagrams per system call (default 1) */
+  void set_batch_size(int n);
+  int batch_size() const { return d_batch_size; }
+
+  /*! \brief prefix datagrams with a 4-byte sequence number (default false)
+   *
+   * Each datagram then carries as many whole items as fit in
+   * payload_size - 4 bytes. */
+  void set_sequence_numbers(bool on);
+  bool sequence_numbers() const { return d_seqno; }
+
+  unsigned long long ndatagrams();      //!< datagrams sent
+  unsigned long long nbytes();          //!< payload bytes sent, headers included
+  unsigned long long ndiscarded();      //!< data bytes discarded (not connected or refused)
+
   // should we export anything else?
 
   int work (int noutput_items,
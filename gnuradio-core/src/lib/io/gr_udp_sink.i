@@ -43,4 +43,13 @@ class gr_udp_sink : public gr_sync_block
   void connect( const char *host, unsigned short port );
   void disconnect();
 
+  void set_batch_size(int n);
+  int batch_size() const;
+  void set_sequence_numbers(bool on);
+  bool sequence_numbers() const;
+
+  unsigned long long ndatagrams();
+  unsigned long long nbytes();
+  unsigned long long ndiscarded();
+
 };
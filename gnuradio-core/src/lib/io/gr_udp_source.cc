@@ -57,6 +57,15 @@ typedef void* optval_t;
 typedef char* optval_t;
 #endif
 
+#if !defined(USING_WINSOCK)
+#include <gri_udp_batch.h>
+#define HAVE_UDP_BATCH 1
+#endif
+
+#include <gruel/atomic.h>
+#include <stdint.h>
+#include <vector>
+
 #define USE_SELECT    1  // non-blocking receive on all platforms
 #define USE_RCV_TIMEO 0  // non-blocking receive on all but Cygwin
 #define SRC_VERBOSE 0
@@ -97,6 +106,18 @@ static void report_error( const char *msg1, const char *msg2 )
   return;
 }
 
+// Per-datagram headers for the batched receive path
+struct gr_udp_source::batch_state
+{
+#if defined(HAVE_UDP_BATCH)
+  std::vector<gri_mmsghdr>  msgs;
+  std::vector<struct iovec> iov;      // sequence number, data
+#endif
+  std::vector<uint32_t>     seqno;
+  std::vector<char>         control;  // ancillary data (drop counter)
+  size_t                    control_len;
+};
+
 gr_udp_source::gr_udp_source(size_t itemsize, const char *host, 
 			     unsigned short port, int payload_size,
 			     bool eof, bool wait)
@@ -104,7 +125,11 @@ gr_udp_source::gr_udp_source(size_t itemsize, const char *host,
 		   gr_make_io_signature(0, 0, 0),
 		   gr_make_io_signature(1, 1, itemsize)),
     d_itemsize(itemsize), d_payload_size(payload_size),
-    d_eof(eof), d_wait(wait), d_socket(-1), d_residual(0), d_temp_offset(0)
+    d_eof(eof), d_wait(wait), d_socket(-1), d_residual(0), d_temp_offset(0),
+    d_batch_size(1), d_seqno(false), d_seqno_valid(false), d_next_seqno(0),
+    d_eof_pending(false), d_batch(new batch_state),
+    d_ndatagrams(0), d_nbytes(0), d_nseq_gaps(0), d_nseq_lost(0),
+    d_ntruncated(0), d_nkernel_drops(0)
 {
   int ret = 0;
 
@@ -177,6 +202,13 @@ gr_udp_source::gr_udp_source(size_t itemsize, const char *host,
   }
 #endif // USE_RCV_TIMEO
 
+#if defined(SO_RXQ_OVFL)
+  // Ask for the count of datagrams dropped on this socket with each
+  // message; only the batched path reads it, so failure is harmless.
+  opt_val = 1;
+  setsockopt(d_socket, SOL_SOCKET, SO_RXQ_OVFL, (optval_t)&opt_val, sizeof(int));
+#endif
+
   // bind socket to an address and port number to listen on
   if(bind (d_socket, ip_src->ai_addr, ip_src->ai_addrlen) == -1) {
     report_error("socket bind","can't bind socket");
@@ -196,6 +228,7 @@ gr_make_udp_source (size_t itemsize, const char *ipaddr,
 gr_udp_source::~gr_udp_source ()
 {
   delete [] d_temp_buff;
+  delete d_batch;
 
   if (d_socket != -1){
     shutdown(d_socket, SHUT_RDWR);
@@ -226,6 +259,9 @@ gr_udp_source::work (int noutput_items,
   printf("\nEntered udp_source\n");
   #endif
 
+  if(d_batch_size > 1 || d_seqno)
+    return work_batched(out, total_bytes);
+
   // Remove items from temp buffer if they are in there
   if(d_residual) {
     nbytes = std::min(d_residual, total_bytes);
@@ -336,6 +372,8 @@ gr_udp_source::work (int noutput_items,
 
       // keep track of the total number of bytes received
       bytes_received += nbytes;
+      gruel::atomic_fetch_add(&d_ndatagrams, 1ULL);
+      gruel::atomic_fetch_add(&d_nbytes, (unsigned long long) r);
 
       // increment the pointer
       out += nbytes;
@@ -370,3 +408,208 @@ int gr_udp_source::get_port(void)
   }
   return ntohs(name.sin_port);
 }
+
+void
+gr_udp_source::set_batch_size(int n)
+{
+#if defined(HAVE_UDP_BATCH)
+  if(n > 1 && d_payload_size < (int) d_itemsize)
+    throw std::invalid_argument("gr_udp_source: payload_size smaller than an item");
+  d_batch_size = std::max(n, 1);
+#endif
+}
+
+void
+gr_udp_source::set_sequence_numbers(bool on)
+{
+#if defined(HAVE_UDP_BATCH)
+  if(on && d_payload_size < (int) (sizeof(uint32_t) + d_itemsize))
+    throw std::invalid_argument("gr_udp_source: payload_size too small for sequence numbers");
+  d_seqno = on;
+  d_seqno_valid = false;
+#else
+  if(on)
+    throw std::runtime_error("gr_udp_source: sequence numbers need POSIX sockets");
+#endif
+}
+
+unsigned long long gr_udp_source::ndatagrams() { return gruel::atomic_read(&d_ndatagrams); }
+unsigned long long gr_udp_source::nbytes() { return gruel::atomic_read(&d_nbytes); }
+unsigned long long gr_udp_source::nseq_gaps() { return gruel::atomic_read(&d_nseq_gaps); }
+unsigned long long gr_udp_source::nseq_lost() { return gruel::atomic_read(&d_nseq_lost); }
+unsigned long long gr_udp_source::ntruncated() { return gruel::atomic_read(&d_ntruncated); }
+unsigned long long gr_udp_source::nkernel_drops() { return gruel::atomic_read(&d_nkernel_drops); }
+
+// Wait until the socket is readable.  Returns 1 when it is, 0 if it
+// timed out and we shouldn't wait, -1 on error.
+int
+gr_udp_source::wait_for_data()
+{
+  while(1) {
+    fd_set readfds;
+    timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    FD_ZERO(&readfds);
+    FD_SET(d_socket, &readfds);
+    int r = select(FD_SETSIZE, &readfds, NULL, NULL, &timeout);
+    if(r < 0) {
+      report_error("udp_source/select",NULL);
+      return -1;
+    }
+    if(r > 0)
+      return 1;
+    if(!d_wait)
+      return 0;
+    // Allow boost thread interrupt, then try again
+    boost::this_thread::interruption_point();
+  }
+}
+
+void
+gr_udp_source::check_seqno(unsigned int seqno)
+{
+  if(d_seqno_valid && seqno != d_next_seqno) {
+    gruel::atomic_fetch_add(&d_nseq_gaps, 1ULL);
+    unsigned int lost = seqno - d_next_seqno;
+    if(lost < 0x80000000)	// otherwise reordered or duplicated, nothing lost
+      gruel::atomic_fetch_add(&d_nseq_lost, (unsigned long long) lost);
+  }
+  d_next_seqno = seqno + 1;
+  d_seqno_valid = true;
+}
+
+// Receive up to d_batch_size datagrams with one system call.  When
+// the output buffer has room for whole datagrams they are scattered
+// directly into it, one slot per datagram, and then packed together;
+// otherwise a single datagram goes through d_temp_buff.  Slots hold
+// whole items, matching what gr_udp_sink puts in each datagram.
+
+int
+gr_udp_source::work_batched(char *out, ssize_t total_bytes)
+{
+#if defined(HAVE_UDP_BATCH)
+  size_t hdr = d_seqno ? sizeof(uint32_t) : 0;
+  size_t slot = (d_payload_size - hdr) / d_itemsize * d_itemsize;
+  batch_state &b = *d_batch;
+
+  // Hand out what's left of a datagram that didn't fit last time
+  if(d_residual) {
+    ssize_t nbytes = std::min(d_residual, total_bytes);
+    memcpy(out, d_temp_buff+d_temp_offset, nbytes);
+    d_residual -= nbytes;
+    d_temp_offset += nbytes;
+    return nbytes/d_itemsize;
+  }
+
+  if(d_eof_pending)
+    return -1;
+
+  unsigned int nslots = total_bytes / slot;
+  unsigned int n = nslots ? std::min(nslots, (unsigned int) d_batch_size) : 1;
+  char *base = nslots ? out : d_temp_buff;
+
+#if defined(SO_RXQ_OVFL)
+  b.control_len = CMSG_SPACE(sizeof(uint32_t));
+#else
+  b.control_len = 0;
+#endif
+  if(b.msgs.size() < n) {
+    b.msgs.resize(n);
+    b.iov.resize(2*n);
+    b.seqno.resize(n);
+    b.control.resize(n*b.control_len + 1);
+  }
+
+  while(1) {
+    int r = wait_for_data();
+    if(r <= 0)
+      return -1;
+
+    for(unsigned int i = 0; i < n; i++) {
+      struct msghdr &m = b.msgs[i].msg_hdr;
+      b.iov[2*i].iov_base = &b.seqno[i];
+      b.iov[2*i].iov_len = hdr;
+      b.iov[2*i+1].iov_base = base + i*slot;
+      b.iov[2*i+1].iov_len = slot;
+      memset(&m, 0, sizeof(m));
+      m.msg_iov = &b.iov[d_seqno ? 2*i : 2*i+1];
+      m.msg_iovlen = d_seqno ? 2 : 1;
+      if(b.control_len) {
+	m.msg_control = &b.control[i*b.control_len];
+	m.msg_controllen = b.control_len;
+      }
+    }
+
+    r = gri_recvmmsg(d_socket, &b.msgs[0], n, 0);
+    if(r < 0) {
+      if(is_error(EAGAIN) || is_error(EINTR)) {
+	if(!d_wait)
+	  return -1;
+	boost::this_thread::interruption_point();
+	continue;
+      }
+      report_error("udp_source/recvmmsg",NULL);
+      return -1;
+    }
+
+    ssize_t produced = 0;
+    for(int i = 0; i < r; i++) {
+      struct msghdr &m = b.msgs[i].msg_hdr;
+      size_t len = b.msgs[i].msg_len;
+
+      if(len == 0) {
+	if(d_eof) {		// zero-length packet is EOF
+	  d_eof_pending = true;
+	  break;
+	}
+	continue;
+      }
+
+      gruel::atomic_fetch_add(&d_ndatagrams, 1ULL);
+      gruel::atomic_fetch_add(&d_nbytes, (unsigned long long) len);
+      if(m.msg_flags & MSG_TRUNC)
+	gruel::atomic_fetch_add(&d_ntruncated, 1ULL);
+
+#if defined(SO_RXQ_OVFL)
+      for(struct cmsghdr *c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c))
+	if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+	  uint32_t drops;
+	  memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+	  gruel::atomic_store(&d_nkernel_drops, (unsigned long long) drops);
+	}
+#endif
+
+      if(len < hdr)		// runt; can't be one of ours
+	continue;
+      if(d_seqno)
+	check_seqno(ntohl(b.seqno[i]));
+
+      // If the sender is broken, don't propagate the problem
+      size_t nbytes = std::min(len - hdr, slot);
+      nbytes = (nbytes/d_itemsize) * d_itemsize;
+
+      if(!nslots) {		// single datagram in d_temp_buff
+	produced = std::min((ssize_t) nbytes, total_bytes);
+	produced -= produced % d_itemsize;
+	memcpy(out, d_temp_buff, produced);
+	d_residual = nbytes - produced;
+	d_temp_offset = produced;
+	break;
+      }
+
+      if(base + i*slot != out + produced)
+	memmove(out + produced, base + i*slot, nbytes);
+      produced += nbytes;
+    }
+
+    if(produced > 0)
+      return produced/d_itemsize;
+    if(d_eof_pending)
+      return -1;
+    boost::this_thread::interruption_point();
+  }
+#else
+  return -1;
+#endif
+}
@@ -50,6 +50,12 @@ gr_udp_source_sptr gr_make_udp_source(size_t itemsize, const char *host,
  * \param wait         Wait for data if not immediately available
  *                     (default: true)
  *
+ * set_batch_size() receives up to that many datagrams per system call
+ * (recvmmsg), scattering them straight into the output buffer when
+ * there is room for whole datagrams.  set_sequence_numbers() expects
+ * each datagram to start with the 32-bit big-endian sequence number
+ * written by a gr_udp_sink with the same setting, and counts gaps.
+ * Both require POSIX sockets.
 */
 
 class gr_udp_source : public gr_sync_block
@@ -70,6 +76,26 @@ class gr_udp_source : public gr_sync_block
   ssize_t d_residual;   // hold information about number of bytes stored in the temp buffer
   size_t d_temp_offset; // point to temp buffer location offset
 
+  int           d_batch_size;    // datagrams per receive call
+  bool          d_seqno;         // datagrams carry a sequence number
+  bool          d_seqno_valid;   // d_next_seqno has been seen
+  unsigned int  d_next_seqno;    // expected sequence number
+  bool          d_eof_pending;   // EOF seen behind data already returned
+
+  struct batch_state;
+  batch_state  *d_batch;
+
+  volatile unsigned long long d_ndatagrams;
+  volatile unsigned long long d_nbytes;
+  volatile unsigned long long d_nseq_gaps;
+  volatile unsigned long long d_nseq_lost;
+  volatile unsigned long long d_ntruncated;
+  volatile unsigned long long d_nkernel_drops;
+
+  int work_batched(char *out, ssize_t total_bytes);
+  int wait_for_data();
+  void check_seqno(unsigned int seqno);
+
  protected:
   /*!
    * \brief UDP Source Constructor
@@ -98,6 +124,21 @@ class gr_udp_source : public gr_sync_block
   /*! \brief return the port number of the socket */
   int get_port();
 
+  /*! \brief receive up to \p n datagrams per system call (default 1) */
+  void set_batch_size(int n);
+  int batch_size() const { return d_batch_size; }
+
+  /*! \brief datagrams start with a 4-byte sequence number (default false) */
+  void set_sequence_numbers(bool on);
+  bool sequence_numbers() const { return d_seqno; }
+
+  unsigned long long ndatagrams();      //!< datagrams received
+  unsigned long long nbytes();          //!< payload bytes received
+  unsigned long long nseq_gaps();       //!< times the sequence number jumped
+  unsigned long long nseq_lost();       //!< datagrams missing according to sequence numbers
+  unsigned long long ntruncated();      //!< datagrams longer than payload_size
+  unsigned long long nkernel_drops();   //!< datagrams the kernel dropped for lack of buffer space (Linux)
+
   // should we export anything else?
 
   int work(int noutput_items,
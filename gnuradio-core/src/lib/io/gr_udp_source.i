@@ -38,4 +38,16 @@ class gr_udp_source : public gr_sync_block
 
   int payload_size() { return d_payload_size; }
   int get_port();
+
+  void set_batch_size(int n);
+  int batch_size() const;
+  void set_sequence_numbers(bool on);
+  bool sequence_numbers() const;
+
+  unsigned long long ndatagrams();
+  unsigned long long nbytes();
+  unsigned long long nseq_gaps();
+  unsigned long long nseq_lost();
+  unsigned long long ntruncated();
+  unsigned long long nkernel_drops();
 };
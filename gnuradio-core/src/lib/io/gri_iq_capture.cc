@@ -0,0 +1,547 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gri_iq_capture.h>
+#include <gr_complex.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <sys/types.h>
+#include <unistd.h>
+
+static const char HEADER_MAGIC[8] = { 'G', 'R', 'I', 'Q', 'C', 'A', 'P', '1' };
+static const unsigned CHUNK_MAGIC = 0x4b4e4843;		// "CHNK"
+static const unsigned INDEX_MAGIC = 0x58444e49;		// "INDX"
+static const unsigned VERSION = 1;
+
+static const int BLOCK = 128;		// values per bit packed block
+static const int LANES = 8;		// interleaved lanes in a block
+static const int NO_DELTA = 0x80;	// width byte flag: values, not deltas
+
+// ----------------------------------------------------------------
+//			little endian fields
+// ----------------------------------------------------------------
+
+static void
+put_u32(unsigned char *p, unsigned int v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = v >> (8 * i);
+}
+
+static void
+put_u64(unsigned char *p, unsigned long long v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = v >> (8 * i);
+}
+
+static void
+put_f64(unsigned char *p, double d)
+{
+  unsigned long long v;
+  memcpy(&v, &d, sizeof(v));
+  put_u64(p, v);
+}
+
+static unsigned int
+get_u32(const unsigned char *p)
+{
+  unsigned int v = 0;
+  for (int i = 3; i >= 0; i--)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static unsigned long long
+get_u64(const unsigned char *p)
+{
+  unsigned long long v = 0;
+  for (int i = 7; i >= 0; i--)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static double
+get_f64(const unsigned char *p)
+{
+  unsigned long long v = get_u64(p);
+  double d;
+  memcpy(&d, &v, sizeof(d));
+  return d;
+}
+
+// byte swap 16-bit words in place on big endian hosts
+static void
+le16_inplace(void *p, size_t n)
+{
+#ifdef WORDS_BIGENDIAN
+  uint16_t *w = (uint16_t *) p;
+  for (size_t i = 0; i < n; i++)
+    w[i] = (w[i] >> 8) | (w[i] << 8);
+#endif
+}
+
+static bool
+pread_all(int fd, void *buf, size_t len, long long offset)
+{
+  char *p = (char *) buf;
+  while (len > 0){
+    ssize_t r = pread(fd, p, len, offset);
+    if (r <= 0)
+      return false;
+    p += r;
+    len -= r;
+    offset += r;
+  }
+  return true;
+}
+
+// ----------------------------------------------------------------
+//			    the 16-bit codec
+// ----------------------------------------------------------------
+
+/*
+ * Lane l of a block holds values l, l + 8, l + 16, ...  Each lane packs
+ * its 16 values of W bits into W 16-bit words, and the words of the
+ * eight lanes are interleaved.  W is a template argument so the bit
+ * position bookkeeping is resolved at compile time and the lane loops
+ * become straight vector code.
+ */
+template<int W>
+static void
+pack(uint16_t *out, const uint16_t *z)
+{
+  uint32_t acc[LANES] = { 0 };
+  int bits = 0;
+  for (int j = 0; j < BLOCK / LANES; j++){
+    for (int l = 0; l < LANES; l++)
+      acc[l] |= (uint32_t) z[j * LANES + l] << bits;
+    bits += W;
+    if (bits >= 16){
+      for (int l = 0; l < LANES; l++){
+	*out++ = acc[l];
+	acc[l] >>= 16;
+      }
+      bits -= 16;
+    }
+  }
+}
+
+template<int W>
+static void
+unpack(uint16_t *z, const uint16_t *in)
+{
+  const uint32_t mask = (1u << W) - 1;
+  uint32_t acc[LANES] = { 0 };
+  int bits = 0;
+  for (int j = 0; j < BLOCK / LANES; j++){
+    if (bits < W){
+      for (int l = 0; l < LANES; l++)
+	acc[l] |= (uint32_t) *in++ << bits;
+      bits += 16;
+    }
+    for (int l = 0; l < LANES; l++){
+      z[j * LANES + l] = acc[l] & mask;
+      acc[l] >>= W;
+    }
+    bits -= W;
+  }
+}
+
+template<>
+void
+pack<0>(uint16_t *, const uint16_t *)
+{
+}
+
+template<>
+void
+unpack<0>(uint16_t *z, const uint16_t *)
+{
+  memset(z, 0, BLOCK * sizeof(uint16_t));
+}
+
+typedef void (*pack_fn)(uint16_t *, const uint16_t *);
+
+static const pack_fn pack_table[17] = {
+  pack<0>,  pack<1>,  pack<2>,  pack<3>,  pack<4>,  pack<5>,
+  pack<6>,  pack<7>,  pack<8>,  pack<9>,  pack<10>, pack<11>,
+  pack<12>, pack<13>, pack<14>, pack<15>, pack<16>
+};
+
+static const pack_fn unpack_table[17] = {
+  unpack<0>,  unpack<1>,  unpack<2>,  unpack<3>,  unpack<4>,  unpack<5>,
+  unpack<6>,  unpack<7>,  unpack<8>,  unpack<9>,  unpack<10>, unpack<11>,
+  unpack<12>, unpack<13>, unpack<14>, unpack<15>, unpack<16>
+};
+
+static inline int
+bit_width(unsigned int v)
+{
+  return v ? 32 - __builtin_clz(v) : 0;
+}
+
+/*
+ * Layout: one width byte per block, padded to an even length, the
+ * packed words of all blocks, then the n % 128 trailing values as is.
+ * A block whose width byte has NO_DELTA set packs zigzagged values
+ * rather than deltas.
+ */
+size_t
+gri_delta_bp_max_bytes(size_t n)
+{
+  size_t nblocks = n / BLOCK;
+  return ((nblocks + 1) & ~1) + n * sizeof(uint16_t);
+}
+
+size_t
+gri_delta_bp_encode(unsigned char *out, const short *in, size_t n, int stride)
+{
+  size_t nblocks = n / BLOCK;
+  unsigned char *widths = out;
+  uint16_t *words = (uint16_t *) (out + ((nblocks + 1) & ~1));
+  uint16_t *w0 = words;
+  uint16_t z[BLOCK];
+
+  for (size_t b = 0; b < nblocks; b++){
+    const short *x = in + b * BLOCK;
+    uint16_t zx[BLOCK];
+    unsigned int or_d = 0, or_x = 0;
+
+    int k0 = 0;
+    if (b == 0){			// no earlier values; delta against 0
+      for (; k0 < stride; k0++)
+	z[k0] = ((uint16_t) x[k0] << 1) ^ (uint16_t) (x[k0] >> 15);
+    }
+    for (int k = k0; k < BLOCK; k++){
+      int16_t d = x[k] - x[k - stride];
+      z[k] = ((uint16_t) d << 1) ^ (uint16_t) (d >> 15);
+    }
+    for (int k = 0; k < BLOCK; k++){
+      zx[k] = ((uint16_t) x[k] << 1) ^ (uint16_t) (x[k] >> 15);
+      or_d |= z[k];
+      or_x |= zx[k];
+    }
+
+    // Deltas win for oversampled signals, plain values for noise
+    int wd = bit_width(or_d);
+    int wx = bit_width(or_x);
+    if (wx < wd){
+      widths[b] = wx | NO_DELTA;
+      pack_table[wx](words, zx);
+      words += LANES * wx;
+    }
+    else {
+      widths[b] = wd;
+      pack_table[wd](words, z);
+      words += LANES * wd;
+    }
+  }
+  if (nblocks & 1)
+    widths[nblocks] = 0;
+  le16_inplace(w0, words - w0);
+
+  size_t tail = n - nblocks * BLOCK;
+  memcpy(words, in + nblocks * BLOCK, tail * sizeof(short));
+  le16_inplace(words, tail);
+
+  return (unsigned char *) (words + tail) - out;
+}
+
+bool
+gri_delta_bp_decode(short *out, size_t n, const unsigned char *in,
+		    size_t nbytes, int stride)
+{
+  size_t nblocks = n / BLOCK;
+  size_t tail = n - nblocks * BLOCK;
+  size_t header = (nblocks + 1) & ~1;
+
+  size_t nwords = 0;
+  for (size_t b = 0; b < nblocks; b++){
+    int w = in[b] & ~NO_DELTA;
+    if (w > 16)
+      return false;
+    nwords += LANES * w;
+  }
+  if (nbytes != header + (nwords + tail) * sizeof(uint16_t))
+    return false;
+
+  const uint16_t *words = (const uint16_t *) (in + header);
+#ifdef WORDS_BIGENDIAN
+  std::vector<uint16_t> swapped(words, words + nwords + tail);
+  le16_inplace(&swapped[0], swapped.size());
+  words = &swapped[0];
+#endif
+
+  uint16_t z[BLOCK];
+  for (size_t b = 0; b < nblocks; b++){
+    int w = in[b] & ~NO_DELTA;
+    unpack_table[w](z, words);
+    words += LANES * w;
+
+    short *x = out + b * BLOCK;
+    if (in[b] & NO_DELTA){
+      for (int k = 0; k < BLOCK; k++)
+	x[k] = (z[k] >> 1) ^ -(z[k] & 1);
+      continue;
+    }
+
+    int k0 = 0;
+    if (b == 0){
+      for (; k0 < stride; k0++)
+	x[k0] = (z[k0] >> 1) ^ -(z[k0] & 1);
+    }
+    for (int k = k0; k < BLOCK; k++)
+      x[k] = x[k - stride] + (int16_t) ((z[k] >> 1) ^ -(z[k] & 1));
+  }
+
+  memcpy(out + nblocks * BLOCK, words, tail * sizeof(short));
+  return true;
+}
+
+// ----------------------------------------------------------------
+//			 header, chunks and index
+// ----------------------------------------------------------------
+
+int
+gri_iq_capture_itemsize(int item_type)
+{
+  switch (item_type){
+  case GRI_IQ_BYTE:		return 1;
+  case GRI_IQ_SHORT:		return sizeof(short);
+  case GRI_IQ_COMPLEX_SHORT:	return 2 * sizeof(short);
+  case GRI_IQ_FLOAT:		return sizeof(float);
+  case GRI_IQ_COMPLEX:		return sizeof(gr_complex);
+  case GRI_IQ_COMPLEX_BYTE:	return 2;
+  default:			return 0;
+  }
+}
+
+// number of shorts per item and delta stride, or 0 if not 16-bit data
+static int
+shorts_per_item(int item_type)
+{
+  switch (item_type){
+  case GRI_IQ_SHORT:		return 1;
+  case GRI_IQ_COMPLEX_SHORT:	return 2;
+  default:			return 0;
+  }
+}
+
+bool
+gri_iq_capture_write_header(FILE *fp, const gri_iq_capture_header &h)
+{
+  unsigned char b[GRI_IQ_CAPTURE_HEADER_SIZE];
+  memset(b, 0, sizeof(b));
+
+  memcpy(b, HEADER_MAGIC, sizeof(HEADER_MAGIC));
+  put_u32(b + 8, VERSION);
+  put_u32(b + 12, GRI_IQ_CAPTURE_HEADER_SIZE);
+  put_u32(b + 16, h.item_type);
+  put_u32(b + 20, h.itemsize);
+  put_u32(b + 24, h.chunk_items);
+  put_u32(b + 28, h.compressed ? 1 : 0);
+  put_f64(b + 32, h.sample_rate);
+  put_f64(b + 40, h.center_freq);
+  put_f64(b + 48, h.start_time);
+  put_u64(b + 56, h.nitems);
+  put_u64(b + 64, h.nchunks);
+  put_u64(b + 72, h.index_offset);
+
+  return (fseeko(fp, 0, SEEK_SET) == 0
+	  && fwrite(b, sizeof(b), 1, fp) == 1);
+}
+
+bool
+gri_iq_capture_read_header(int fd, gri_iq_capture_header &h)
+{
+  unsigned char b[GRI_IQ_CAPTURE_HEADER_SIZE];
+  if (!pread_all(fd, b, sizeof(b), 0))
+    return false;
+
+  if (memcmp(b, HEADER_MAGIC, sizeof(HEADER_MAGIC)) != 0
+      || get_u32(b + 8) != VERSION
+      || get_u32(b + 12) != (unsigned) GRI_IQ_CAPTURE_HEADER_SIZE)
+    return false;
+
+  h.item_type = get_u32(b + 16);
+  h.itemsize = get_u32(b + 20);
+  h.chunk_items = get_u32(b + 24);
+  h.compressed = get_u32(b + 28) & 1;
+  h.sample_rate = get_f64(b + 32);
+  h.center_freq = get_f64(b + 40);
+  h.start_time = get_f64(b + 48);
+  h.nitems = get_u64(b + 56);
+  h.nchunks = get_u64(b + 64);
+  h.index_offset = get_u64(b + 72);
+
+  return (h.itemsize > 0 && h.itemsize == gri_iq_capture_itemsize(h.item_type)
+	  && h.chunk_items > 0);
+}
+
+bool
+gri_iq_capture_read_index(int fd, gri_iq_capture_header &h,
+			  std::vector<long long> &offsets)
+{
+  offsets.clear();
+  off_t end = lseek(fd, 0, SEEK_END);
+
+  // nchunks is only trusted as far as the file has room for its index
+  if (h.index_offset >= GRI_IQ_CAPTURE_HEADER_SIZE
+      && h.index_offset + 8 <= end
+      && h.nchunks <= (unsigned long long) (end - h.index_offset - 8) / 8){
+    unsigned char b[8];
+    std::vector<unsigned char> raw(h.nchunks * 8);
+    if (pread_all(fd, b, sizeof(b), h.index_offset)
+	&& get_u32(b) == INDEX_MAGIC
+	&& (h.nchunks == 0
+	    || pread_all(fd, &raw[0], raw.size(), h.index_offset + 8))){
+      for (unsigned long long i = 0; i < h.nchunks; i++)
+	offsets.push_back(get_u64(&raw[8 * i]));
+      return true;
+    }
+  }
+
+  // Writer did not finish, or the file was cut short after it did;
+  // walk the chunks, keeping the complete ones.
+  long long off = GRI_IQ_CAPTURE_HEADER_SIZE;
+  h.nitems = 0;
+  for (;;){
+    unsigned char b[GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE];
+    int codec, nitems;
+    size_t nbytes;
+    if (off + (long long) sizeof(b) > end
+	|| !pread_all(fd, b, sizeof(b), off)
+	|| !gri_iq_capture_parse_chunk_header(b, codec, nitems, nbytes)
+	|| off + (long long) (sizeof(b) + nbytes) > end)
+      break;
+    offsets.push_back(off);
+    h.nitems += nitems;
+    off += sizeof(b) + nbytes;
+    if (nitems != h.chunk_items)	// short chunk: must be the last
+      break;
+  }
+  h.nchunks = offsets.size();
+  return true;
+}
+
+bool
+gri_iq_capture_write_index(FILE *fp, gri_iq_capture_header &h,
+			   const std::vector<long long> &offsets)
+{
+  if (fseeko(fp, 0, SEEK_END) != 0)
+    return false;
+  h.index_offset = ftello(fp);
+  h.nchunks = offsets.size();
+
+  std::vector<unsigned char> b(8 + 8 * offsets.size());
+  put_u32(&b[0], INDEX_MAGIC);
+  put_u32(&b[4], 0);
+  for (size_t i = 0; i < offsets.size(); i++)
+    put_u64(&b[8 + 8 * i], offsets[i]);
+
+  return (fwrite(&b[0], b.size(), 1, fp) == 1
+	  && gri_iq_capture_write_header(fp, h)
+	  && fflush(fp) == 0);
+}
+
+size_t
+gri_iq_capture_max_chunk_bytes(const gri_iq_capture_header &h, int nitems)
+{
+  size_t raw = (size_t) nitems * h.itemsize;
+  size_t spi = shorts_per_item(h.item_type);
+  if (h.compressed && spi)
+    raw = std::max(raw, gri_delta_bp_max_bytes(nitems * spi));
+  return GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE + raw;
+}
+
+size_t
+gri_iq_capture_encode_chunk(unsigned char *out, const void *in, int nitems,
+			    const gri_iq_capture_header &h)
+{
+  unsigned char *payload = out + GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE;
+  size_t raw = (size_t) nitems * h.itemsize;
+  size_t nbytes = raw;
+  int codec = GRI_IQ_CODEC_RAW;
+
+  int spi = shorts_per_item(h.item_type);
+  if (h.compressed && spi){
+    nbytes = gri_delta_bp_encode(payload, (const short *) in, (size_t) nitems * spi, spi);
+    codec = GRI_IQ_CODEC_DELTA_BP;
+  }
+  if (nbytes >= raw){			// incompressible: store as is
+    memcpy(payload, in, raw);
+    if (spi)
+      le16_inplace(payload, raw / 2);
+    nbytes = raw;
+    codec = GRI_IQ_CODEC_RAW;
+  }
+
+  put_u32(out, CHUNK_MAGIC);
+  put_u32(out + 4, codec);
+  put_u32(out + 8, nitems);
+  put_u32(out + 12, nbytes);
+  return GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE + nbytes;
+}
+
+bool
+gri_iq_capture_parse_chunk_header(const unsigned char *p, int &codec,
+				  int &nitems, size_t &nbytes)
+{
+  if (get_u32(p) != CHUNK_MAGIC)
+    return false;
+  codec = get_u32(p + 4);
+  nitems = get_u32(p + 8);
+  nbytes = get_u32(p + 12);
+  return codec == GRI_IQ_CODEC_RAW || codec == GRI_IQ_CODEC_DELTA_BP;
+}
+
+bool
+gri_iq_capture_decode_chunk(void *out, int nitems, int codec,
+			    const unsigned char *in, size_t nbytes,
+			    const gri_iq_capture_header &h)
+{
+  int spi = shorts_per_item(h.item_type);
+
+  switch (codec){
+  case GRI_IQ_CODEC_RAW:
+    if (nbytes != (size_t) nitems * h.itemsize)
+      return false;
+    memcpy(out, in, nbytes);
+    if (spi)
+      le16_inplace(out, nbytes / 2);
+    return true;
+
+  case GRI_IQ_CODEC_DELTA_BP:
+    if (!spi)
+      return false;
+    return gri_delta_bp_decode((short *) out, (size_t) nitems * spi, in, nbytes, spi);
+
+  default:
+    return false;
+  }
+}
@@ -0,0 +1,162 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GRI_IQ_CAPTURE_H
+#define INCLUDED_GRI_IQ_CAPTURE_H
+
+// This file stores all the capture container knowledge for the
+// gr_iq_capture_* blocks.
+//
+// A capture file is a fixed header followed by chunks and, once the
+// writer has closed the file, a chunk index:
+//
+//   header	  GRI_IQ_CAPTURE_HEADER_SIZE bytes, see gri_iq_capture_header
+//   chunk 0	  16 byte chunk header (magic, codec, nitems, nbytes), payload
+//   chunk 1	  ...
+//   index	  "INDX", 0, then one 64-bit file offset per chunk
+//
+// Every chunk but the last holds chunk_items items, so item i lives in
+// chunk i / chunk_items.  Header fields and 16-bit payloads are little
+// endian; other item types are stored in host byte order.  If the writer
+// died before writing the index, readers rebuild it by walking the
+// chunk headers.
+
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+
+enum gri_iq_item_type {
+  GRI_IQ_BYTE		= 0,	// 8-bit, opaque
+  GRI_IQ_SHORT		= 1,	// 16-bit real
+  GRI_IQ_COMPLEX_SHORT	= 2,	// 16-bit I, 16-bit Q
+  GRI_IQ_FLOAT		= 3,	// 32-bit float real
+  GRI_IQ_COMPLEX	= 4,	// 32-bit float I, Q (gr_complex)
+  GRI_IQ_COMPLEX_BYTE	= 5	// 8-bit I, 8-bit Q
+};
+
+enum gri_iq_codec {
+  GRI_IQ_CODEC_RAW	= 0,	// items as they are
+  GRI_IQ_CODEC_DELTA_BP	= 1	// 16-bit delta + zigzag + bit packing
+};
+
+static const int GRI_IQ_CAPTURE_HEADER_SIZE = 96;
+static const int GRI_IQ_CAPTURE_CHUNK_HEADER_SIZE = 16;
+
+struct gri_iq_capture_header {
+  int			item_type;	// gri_iq_item_type
+  int			itemsize;	// bytes
+  int			chunk_items;	// items per chunk
+  bool			compressed;	// chunks may use GRI_IQ_CODEC_DELTA_BP
+  double		sample_rate;	// [S/s]
+  double		center_freq;	// [Hz]
+  double		start_time;	// of the first item [s since the Unix epoch]
+  unsigned long long	nitems;		// 0 until the writer closes the file
+  unsigned long long	nchunks;	// ditto
+  long long		index_offset;	// ditto
+};
+
+/*!
+ * \brief size in bytes of one item of \p item_type, or 0 if unknown
+ */
+int
+gri_iq_capture_itemsize(int item_type);
+
+/*!
+ * \brief Write the file header at the start of \p fp.
+ * The stream is left positioned after the header.
+ */
+bool
+gri_iq_capture_write_header(FILE *fp, const gri_iq_capture_header &h);
+
+/*!
+ * \brief Read and check the file header; false if \p fd does not hold one.
+ */
+bool
+gri_iq_capture_read_header(int fd, gri_iq_capture_header &h);
+
+/*!
+ * \brief Read the chunk index, or rebuild it if the file was not closed
+ * or has been truncated.
+ *
+ * On return \p offsets holds the file offset of every complete chunk
+ * and h.nitems / h.nchunks are filled in.
+ */
+bool
+gri_iq_capture_read_index(int fd, gri_iq_capture_header &h,
+			  std::vector<long long> &offsets);
+
+/*!
+ * \brief Write the chunk index at the current end of \p fp and
+ * complete the header.
+ */
+bool
+gri_iq_capture_write_index(FILE *fp, gri_iq_capture_header &h,
+			   const std::vector<long long> &offsets);
+
+//! upper bound on the encoded size of \p nitems items
+size_t
+gri_iq_capture_max_chunk_bytes(const gri_iq_capture_header &h, int nitems);
+
+/*!
+ * \brief Encode \p nitems items as one chunk (header and payload) into \p out.
+ * \returns the number of bytes used
+ */
+size_t
+gri_iq_capture_encode_chunk(unsigned char *out, const void *in, int nitems,
+			    const gri_iq_capture_header &h);
+
+/*!
+ * \brief Check a chunk header.
+ * \returns false if \p p does not start a chunk
+ */
+bool
+gri_iq_capture_parse_chunk_header(const unsigned char *p, int &codec,
+				  int &nitems, size_t &nbytes);
+
+/*!
+ * \brief Decode a chunk payload of \p nbytes bytes into \p nitems items.
+ * \returns false if the payload is corrupt
+ */
+bool
+gri_iq_capture_decode_chunk(void *out, int nitems, int codec,
+			    const unsigned char *in, size_t nbytes,
+			    const gri_iq_capture_header &h);
+
+/*
+ * The 16-bit codec.  Values are replaced by their difference to the
+ * value \p stride positions earlier (stride 2 keeps I and Q apart),
+ * zigzag mapped to unsigned and bit packed in blocks of 128 with one
+ * width byte per block.  Blocks where the plain values pack tighter
+ * (noise) skip the delta step.  Packing interleaves eight lanes so that the
+ * inner loops vectorize.
+ */
+size_t
+gri_delta_bp_max_bytes(size_t n);
+
+size_t
+gri_delta_bp_encode(unsigned char *out, const short *in, size_t n, int stride);
+
+bool
+gri_delta_bp_decode(short *out, size_t n, const unsigned char *in,
+		    size_t nbytes, int stride);
+
+#endif /* INCLUDED_GRI_IQ_CAPTURE_H */
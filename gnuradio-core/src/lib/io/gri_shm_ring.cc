@@ -0,0 +1,438 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gri_shm_ring.h>
+#include <gr_pagesize.h>
+#include <gruel/atomic.h>
+#include <stdexcept>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+static const int MAGIC = 0x47524d52;	// "GRMR"
+static const int VERSION = 1;
+
+/*
+ * Lives at the start of the segment.  The per-reader slots each get
+ * their own cache line so readers don't slow the writer or each other.
+ */
+struct gri_shm_ring::header {
+  int			magic;
+  int			version;
+  int			itemsize;
+  int			header_size;
+  long long		size;
+  volatile int		writer_pid;	// 0 once the writer has finished
+  volatile int		seq;		// bumped by every write; readers sleep on it
+  volatile int		nwaiters;	// readers sleeping on seq
+  int			pad0;
+  volatile long long	head;		// total bytes written
+  volatile long long	write_limit;	// bytes below this - size may be overwritten
+  char			pad1[64];
+
+  struct slot {
+    volatile int	pid;		// owner, 0 if free
+    volatile int	noverruns;
+    volatile long long	offset;
+    volatile long long	nlost;
+    char		pad[40];
+  } readers[MAX_READERS];
+};
+
+// 64-bit fields may tear on 32-bit hosts; reread until two loads agree
+static inline long long
+load64 (const volatile long long *p)
+{
+  long long v = gruel::atomic_load (p);
+  if (sizeof (long) < 8)
+    for (long long w; (w = gruel::atomic_load (p)) != v; v = w)
+      ;
+  return v;
+}
+
+static inline void
+store64 (volatile long long *p, long long v)
+{
+  gruel::atomic_exchange (p, v);
+}
+
+static bool
+process_alive (int pid)
+{
+  return pid != 0 && (kill (pid, 0) == 0 || errno != ESRCH);
+}
+
+static std::string
+segment_name (const std::string &name)
+{
+  if (!name.empty () && name[0] == '/')
+    return name;
+  return "/gnuradio-shm-" + name;
+}
+
+static void
+fail (const std::string &what)
+{
+  perror (what.c_str ());
+  throw std::runtime_error (what);
+}
+
+// ------------------------------------------------------------------------
+
+void
+gri_shm_ring::map (int fd, size_t size)
+{
+#if !defined(HAVE_MMAP)
+  throw std::runtime_error ("gri_shm_ring: mmap is not available");
+#else
+  int header_size = d_header->header_size;
+
+  // Reserve twice the ring, then map the data area into both halves.
+  void *base = mmap (0, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    fail ("gri_shm_ring: mmap (reserve)");
+
+  for (int i = 0; i < 2; i++){
+    void *p = mmap ((char *) base + i * size, size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_FIXED, fd, (off_t) header_size);
+    if (p == MAP_FAILED){
+      munmap (base, 2 * size);
+      fail ("gri_shm_ring: mmap (data)");
+    }
+  }
+
+  d_base = (char *) base;
+  d_size = size;
+#endif
+}
+
+static gri_shm_ring::header *
+map_header (int fd, size_t header_size)
+{
+#if !defined(HAVE_MMAP)
+  throw std::runtime_error ("gri_shm_ring: mmap is not available");
+#else
+  void *p = mmap (0, header_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED)
+    fail ("gri_shm_ring: mmap (header)");
+  return (gri_shm_ring::header *) p;
+#endif
+}
+
+gri_shm_ring::gri_shm_ring (const std::string &name, size_t size, int itemsize)
+  : d_name (segment_name (name)), d_writer (true), d_header (0), d_base (0),
+    d_size (0), d_slot (-1), d_offset (0)
+{
+#if !defined(HAVE_MMAP) || !defined(HAVE_SHM_OPEN)
+  throw std::runtime_error ("gri_shm_ring: mmap or shm_open is not available");
+#else
+  size_t pagesize = gr_pagesize ();
+  size_t header_size = (sizeof (header) + pagesize - 1) / pagesize * pagesize;
+  size = std::max ((size + pagesize - 1) / pagesize * pagesize, pagesize);
+
+  shm_unlink (d_name.c_str ());		// stale segment from an earlier writer
+  int fd = shm_open (d_name.c_str (), O_RDWR | O_CREAT | O_EXCL, 0660);
+  if (fd < 0)
+    fail ("gri_shm_ring: shm_open " + d_name);
+
+  if (ftruncate (fd, (off_t) (header_size + size)) < 0){
+    close (fd);
+    shm_unlink (d_name.c_str ());
+    fail ("gri_shm_ring: ftruncate");
+  }
+
+  try {
+    d_header = map_header (fd, header_size);
+    memset (d_header, 0, sizeof (header));
+    d_header->version = VERSION;
+    d_header->itemsize = itemsize;
+    d_header->header_size = header_size;
+    d_header->size = size;
+    d_header->writer_pid = getpid ();
+    map (fd, size);
+  }
+  catch (...){
+    close (fd);
+    shm_unlink (d_name.c_str ());
+    throw;
+  }
+  close (fd);
+
+  gruel::memory_barrier ();
+  d_header->magic = MAGIC;		// last: readers may attach now
+#endif
+}
+
+gri_shm_ring::gri_shm_ring (const std::string &name)
+  : d_name (segment_name (name)), d_writer (false), d_header (0), d_base (0),
+    d_size (0), d_slot (-1), d_offset (0)
+{
+#if !defined(HAVE_MMAP) || !defined(HAVE_SHM_OPEN)
+  throw std::runtime_error ("gri_shm_ring: mmap or shm_open is not available");
+#else
+  int fd = shm_open (d_name.c_str (), O_RDWR, 0);
+  if (fd < 0)
+    fail ("gri_shm_ring: shm_open " + d_name);
+
+  struct stat st;
+  size_t pagesize = gr_pagesize ();
+  size_t header_size = (sizeof (header) + pagesize - 1) / pagesize * pagesize;
+  if (fstat (fd, &st) < 0 || (size_t) st.st_size < header_size){
+    close (fd);
+    throw std::runtime_error ("gri_shm_ring: " + d_name + " is not a stream");
+  }
+
+  d_header = map_header (fd, header_size);
+  if (gruel::atomic_load (&d_header->magic) != MAGIC
+      || d_header->version != VERSION
+      || d_header->header_size != (int) header_size
+      || d_header->size + header_size > (size_t) st.st_size){
+    munmap ((void *) d_header, header_size);
+    close (fd);
+    throw std::runtime_error ("gri_shm_ring: " + d_name + " is not a stream");
+  }
+
+  try {
+    map (fd, d_header->size);
+  }
+  catch (...){
+    munmap ((void *) d_header, header_size);
+    close (fd);
+    throw;
+  }
+  close (fd);
+
+  // Claim a free slot, else one whose owner died without detaching.
+  int me = getpid ();
+  for (int pass = 0; pass < 2 && d_slot < 0; pass++){
+    for (int i = 0; i < MAX_READERS; i++){
+      volatile int *pid = &d_header->readers[i].pid;
+      int old = *pid;
+      if ((pass == 0 ? old == 0 : !process_alive (old))
+	  && gruel::atomic_cas (pid, old, me)){
+	d_slot = i;
+	break;
+      }
+    }
+  }
+  if (d_slot < 0){
+    munmap ((void *) d_header, header_size);
+    munmap (d_base, 2 * d_size);
+    throw std::runtime_error ("gri_shm_ring: too many readers on " + d_name);
+  }
+
+  header::slot &s = d_header->readers[d_slot];
+  d_offset = load64 (&d_header->head);
+  store64 (&s.nlost, 0);
+  gruel::atomic_store (&s.noverruns, 0);
+  store64 (&s.offset, d_offset);
+#endif
+}
+
+gri_shm_ring::~gri_shm_ring ()
+{
+#if defined(HAVE_MMAP) && defined(HAVE_SHM_OPEN)
+  if (d_writer){
+    set_writer_alive (false);
+    shm_unlink (d_name.c_str ());	// attached readers keep their mappings
+  }
+  else
+    gruel::atomic_store (&d_header->readers[d_slot].pid, 0);
+
+  munmap (d_base, 2 * d_size);
+  munmap ((void *) d_header, d_header->header_size);
+#endif
+}
+
+int
+gri_shm_ring::itemsize () const
+{
+  return d_header->itemsize;
+}
+
+// ------------------------------------------------------------------------
+//				writer
+// ------------------------------------------------------------------------
+
+#ifdef HAVE_LINUX_FUTEX_H
+static void
+futex_wait (volatile int *addr, int val, double timeout)
+{
+  struct timespec ts;
+  ts.tv_sec = (time_t) timeout;
+  ts.tv_nsec = (long) ((timeout - ts.tv_sec) * 1e9);
+  syscall (SYS_futex, addr, FUTEX_WAIT, val, &ts, 0, 0);
+}
+
+static void
+futex_wake (volatile int *addr)
+{
+  syscall (SYS_futex, addr, FUTEX_WAKE, INT_MAX, 0, 0, 0);
+}
+#endif
+
+void
+gri_shm_ring::write (const void *data, size_t nbytes)
+{
+  long long head = d_header->head;	// we're the only writer
+
+  store64 (&d_header->write_limit, head + nbytes);
+  memcpy (d_base + head % d_size, data, nbytes);
+  store64 (&d_header->head, head + nbytes);
+
+  gruel::atomic_fetch_add (&d_header->seq, 1);
+#ifdef HAVE_LINUX_FUTEX_H
+  if (gruel::atomic_load (&d_header->nwaiters) > 0)
+    futex_wake (&d_header->seq);
+#endif
+}
+
+void
+gri_shm_ring::set_writer_alive (bool alive)
+{
+  gruel::atomic_store (&d_header->writer_pid, alive ? (int) getpid () : 0);
+  gruel::atomic_fetch_add (&d_header->seq, 1);
+#ifdef HAVE_LINUX_FUTEX_H
+  futex_wake (&d_header->seq);
+#endif
+}
+
+int
+gri_shm_ring::nreaders () const
+{
+  int n = 0;
+  for (int i = 0; i < MAX_READERS; i++)
+    if (process_alive (gruel::atomic_load (&d_header->readers[i].pid)))
+      n++;
+  return n;
+}
+
+// ------------------------------------------------------------------------
+//				reader
+// ------------------------------------------------------------------------
+
+size_t
+gri_shm_ring::read (void *data, size_t nbytes, size_t granule)
+{
+  header::slot &s = d_header->readers[d_slot];
+
+  for (;;){
+    long long head = load64 (&d_header->head);
+    size_t n = (size_t) std::min ((long long) nbytes, head - d_offset);
+    n -= n % granule;
+
+    if (head - d_offset <= (long long) d_size && n > 0){
+      memcpy (data, d_base + d_offset % d_size, n);
+
+      // Did the writer get to any of it while we were copying?  The
+      // barrier keeps the copy's loads ahead of the write_limit load.
+      gruel::memory_barrier ();
+      if (load64 (&d_header->write_limit) - (long long) d_size <= d_offset){
+	d_offset += n;
+	store64 (&s.offset, d_offset);
+	return n;
+      }
+      head = load64 (&d_header->head);
+    }
+    else if (head - d_offset <= (long long) d_size)
+      return 0;				// nothing new
+
+    // Overrun.  Resume half a ring behind the writer, on an item boundary.
+    long long resume = head - d_size / 2;
+    resume -= resume % granule;
+    resume = std::max (resume, d_offset);
+    store64 (&s.nlost, s.nlost + (resume - d_offset));
+    gruel::atomic_fetch_add (&s.noverruns, 1);
+    d_offset = resume;
+    store64 (&s.offset, d_offset);
+  }
+}
+
+bool
+gri_shm_ring::wait (double timeout)
+{
+  if (load64 (&d_header->head) > d_offset)
+    return true;
+
+#ifdef HAVE_LINUX_FUTEX_H
+  gruel::atomic_fetch_add (&d_header->nwaiters, 1);
+  int seq = gruel::atomic_load (&d_header->seq);
+  if (load64 (&d_header->head) == d_offset
+      && gruel::atomic_load (&d_header->writer_pid) != 0)
+    futex_wait (&d_header->seq, seq, timeout);
+  gruel::atomic_fetch_add (&d_header->nwaiters, -1);
+#else
+  struct timespec ts;
+  ts.tv_sec = 0;
+  ts.tv_nsec = (long) (std::min (timeout, 0.0005) * 1e9);	// poll
+  nanosleep (&ts, 0);
+#endif
+
+  return load64 (&d_header->head) > d_offset;
+}
+
+bool
+gri_shm_ring::writer_alive () const
+{
+  return process_alive (gruel::atomic_load (&d_header->writer_pid));
+}
+
+long
+gri_shm_ring::noverruns () const
+{
+  return gruel::atomic_load (&d_header->readers[d_slot].noverruns);
+}
+
+long long
+gri_shm_ring::nbytes_lost () const
+{
+  return load64 (&d_header->readers[d_slot].nlost);
+}
+
+long long
+gri_shm_ring::head () const
+{
+  return load64 (&d_header->head);
+}
@@ -0,0 +1,130 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GRI_SHM_RING_H
+#define INCLUDED_GRI_SHM_RING_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * A byte ring in a named POSIX shared memory segment, with one writer
+ * and up to MAX_READERS readers, each of which may live in a
+ * different process.
+ *
+ * The data area is mapped twice, back to back, like gr_vmcircbuf, so
+ * any run of up to size() bytes starting anywhere in the ring is
+ * contiguous in memory and every copy is a single memcpy.
+ *
+ * The writer never waits for readers.  It raises the write limit
+ * before it copies data into the ring and the head (total bytes
+ * written) after.  A reader that falls more than size() bytes behind,
+ * or whose copy was overwritten while it was being made, has been
+ * overrun: it skips ahead to half a ring behind the head and counts
+ * the loss.  Readers sleep on a futex (where available) that the
+ * writer wakes after each write if anybody is waiting.
+ *
+ * Each reader owns a slot in the shared header holding its position
+ * and overrun count, so a monitor can see how far behind everybody is.
+ */
+class gri_shm_ring
+{
+ public:
+  static const int MAX_READERS = 16;
+
+  struct header;
+
+ private:
+  std::string	d_name;		// shm_open name
+  bool		d_writer;
+  header       *d_header;
+  char	       *d_base;		// start of the first of the two mappings
+  size_t	d_size;
+  int		d_slot;		// our reader slot, or -1
+  long long	d_offset;	// next byte we'll read
+
+  void map (int fd, size_t size);
+
+ public:
+  /*!
+   * \brief Create the segment \p name as its writer.
+   *
+   * An existing segment of that name is replaced; readers still
+   * attached to it see its writer gone.  \p size is rounded up to a
+   * multiple of the page size.  Throws std::runtime_error.
+   */
+  gri_shm_ring (const std::string &name, size_t size, int itemsize);
+
+  /*!
+   * \brief Attach to the existing segment \p name as a reader.
+   *
+   * Reading starts with the next byte written.  Throws
+   * std::runtime_error if there is no such segment or all reader
+   * slots are taken.
+   */
+  gri_shm_ring (const std::string &name);
+
+  ~gri_shm_ring ();
+
+  size_t size () const { return d_size; }
+  int itemsize () const;
+
+  // ---------------- writer ----------------
+
+  //! Append \p nbytes (at most size()) and wake any waiting readers
+  void write (const void *data, size_t nbytes);
+
+  //! Mark the stream finished (or, with true, running again)
+  void set_writer_alive (bool alive);
+
+  //! number of attached readers
+  int nreaders () const;
+
+  // ---------------- reader ----------------
+
+  /*!
+   * \brief Copy up to \p nbytes, in multiples of \p granule bytes.
+   * \returns the number of bytes copied, 0 if there is nothing new
+   */
+  size_t read (void *data, size_t nbytes, size_t granule = 1);
+
+  /*!
+   * \brief Wait up to \p timeout seconds for data past our position.
+   * \returns true if there is data to read
+   */
+  bool wait (double timeout);
+
+  //! false once the writer has finished or died
+  bool writer_alive () const;
+
+  //! times we were overrun
+  long noverruns () const;
+
+  //! bytes lost to overruns
+  long long nbytes_lost () const;
+
+  //! total bytes written, and our position in that stream
+  long long head () const;
+  long long offset () const { return d_offset; }
+};
+
+#endif /* INCLUDED_GRI_SHM_RING_H */
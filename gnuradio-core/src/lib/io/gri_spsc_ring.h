@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GRI_SPSC_RING_H
+#define INCLUDED_GRI_SPSC_RING_H
+
+#include <gruel/atomic.h>
+#include <vector>
+
+/*!
+ * \brief bounded lock-free queue for exactly one producer and one consumer thread
+ *
+ * push() is only ever called from the producer and pop() only from
+ * the consumer.  Neither blocks; they return false when the ring is
+ * full or empty respectively.
+ */
+template<class T>
+class gri_spsc_ring {
+  std::vector<T>	d_items;
+  volatile unsigned int	d_head;		// next slot to pop; written by consumer
+  volatile unsigned int	d_tail;		// next slot to push; written by producer
+
+ public:
+  gri_spsc_ring (unsigned int capacity)
+    : d_items (capacity + 1), d_head (0), d_tail (0) {}
+
+  bool push (const T &item)
+  {
+    unsigned int tail = d_tail;
+    unsigned int next = tail + 1 == d_items.size () ? 0 : tail + 1;
+    if (next == gruel::atomic_load (&d_head))
+      return false;			// full
+    d_items[tail] = item;
+    gruel::atomic_store (&d_tail, next);
+    return true;
+  }
+
+  bool pop (T &item)
+  {
+    unsigned int head = d_head;
+    if (head == gruel::atomic_load (&d_tail))
+      return false;			// empty
+    item = d_items[head];
+    gruel::atomic_store (&d_head, head + 1 == d_items.size () ? 0 : head + 1);
+    return true;
+  }
+
+  bool empty () const
+  {
+    return gruel::atomic_load (&d_head) == gruel::atomic_load (&d_tail);
+  }
+};
+
+#endif /* INCLUDED_GRI_SPSC_RING_H */
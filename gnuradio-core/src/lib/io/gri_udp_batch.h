@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GRI_UDP_BATCH_H
+#define INCLUDED_GRI_UDP_BATCH_H
+
+/*
+ * Send or receive several datagrams per system call.  Uses
+ * recvmmsg/sendmmsg where the system has them and otherwise falls
+ * back to a loop of recvmsg/sendmsg with the same semantics.  POSIX
+ * sockets only.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+typedef struct mmsghdr gri_mmsghdr;
+#else
+struct gri_mmsghdr {
+  struct msghdr	msg_hdr;
+  unsigned int	msg_len;
+};
+#endif
+
+/*!
+ * \brief receive up to \p n datagrams; returns the number received or -1
+ *
+ * Only the first datagram may block (unless \p flags has MSG_DONTWAIT).
+ */
+static inline int
+gri_recvmmsg (int fd, gri_mmsghdr *msgs, unsigned int n, int flags)
+{
+#if defined(HAVE_RECVMMSG)
+  return recvmmsg (fd, msgs, n, flags | MSG_WAITFORONE, 0);
+#else
+  unsigned int i;
+  for (i = 0; i < n; i++){
+    ssize_t r = recvmsg (fd, &msgs[i].msg_hdr, flags | (i ? MSG_DONTWAIT : 0));
+    if (r < 0)
+      return i ? (int) i : -1;
+    msgs[i].msg_len = r;
+  }
+  return i;
+#endif
+}
+
+/*!
+ * \brief send up to \p n datagrams; returns the number sent or -1
+ */
+static inline int
+gri_sendmmsg (int fd, gri_mmsghdr *msgs, unsigned int n, int flags)
+{
+#if defined(HAVE_SENDMMSG)
+  return sendmmsg (fd, msgs, n, flags);
+#else
+  unsigned int i;
+  for (i = 0; i < n; i++){
+    ssize_t r = sendmsg (fd, &msgs[i].msg_hdr, flags);
+    if (r < 0)
+      return i ? (int) i : -1;
+    msgs[i].msg_len = r;
+  }
+  return i;
+#endif
+}
+
+#endif /* INCLUDED_GRI_UDP_BATCH_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004,2007 Free Software Foundation, Inc.
+ * Copyright 2004,2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,11 +26,16 @@
 #include "config.h"
 #endif
 
+#include <gr_async_file_sink.h>
 #include <gr_file_sink.h>
 #include <gr_file_source.h>
+#include <gr_circular_file_sink.h>
+#include <gr_circular_file_source.h>
 #include <gr_file_descriptor_sink.h>
 #include <gr_file_descriptor_source.h>
 #include <gr_histo_sink_f.h>
+#include <gr_iq_capture_sink.h>
+#include <gr_iq_capture_source.h>
 #include <microtune_4702_eval_board.h>
 #include <microtune_4937_eval_board.h>
 #include <sdr_1000.h>
@@ -39,6 +44,8 @@
 #include <ppio.h>
 #include <gr_message_source.h>
 #include <gr_message_sink.h>
+#include <gr_shm_sink.h>
+#include <gr_shm_source.h>
 #include <gr_udp_sink.h>
 #include <gr_udp_source.h>
 #include <gr_wavfile_sink.h>
@@ -46,12 +53,17 @@
 
 %}
 
+%include "gr_async_file_sink.i"
 %include "gr_file_sink_base.i"
 %include "gr_file_sink.i"
 %include "gr_file_source.i"
+%include "gr_circular_file_sink.i"
+%include "gr_circular_file_source.i"
 %include "gr_file_descriptor_sink.i"
 %include "gr_file_descriptor_source.i"
 %include "gr_histo_sink.i"
+%include "gr_iq_capture_sink.i"
+%include "gr_iq_capture_source.i"
 %include "microtune_xxxx_eval_board.i"
 %include "microtune_4702_eval_board.i"
 %include "microtune_4937_eval_board.i"
@@ -60,6 +72,8 @@
 %include "ppio.i"
 %include "gr_message_source.i"
 %include "gr_message_sink.i"
+%include "gr_shm_sink.i"
+%include "gr_shm_source.i"
 %include "gr_udp_sink.i"
 %include "gr_udp_source.i"
 %include "gr_wavfile_sink.i"
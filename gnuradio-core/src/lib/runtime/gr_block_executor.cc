@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004,2008,2009 Free Software Foundation, Inc.
+ * Copyright 2004,2008,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -28,9 +28,11 @@
 #include <gr_block.h>
 #include <gr_block_detail.h>
 #include <gr_buffer.h>
+#include <gr_trace.h>
 #include <boost/thread.hpp>
 #include <iostream>
 #include <limits>
+#include <math.h>
 #include <assert.h>
 #include <stdio.h>
 
@@ -68,7 +70,7 @@ min_available_space (gr_block_detail *d, int output_multiple)
   int	min_space = std::numeric_limits<int>::max();
 
   for (int i = 0; i < d->noutputs (); i++){
-    gruel::scoped_lock guard(*d->output(i)->mutex());
+    gruel::futex_scoped_lock guard(*d->output(i)->mutex());
 #if 0
     int n = round_down(d->output(i)->space_available(), output_multiple);
 #else
@@ -101,6 +103,8 @@ gr_block_executor::gr_block_executor (gr_block_sptr block)
 	   << d_block << std::endl;
   }
 
+  gr_trace_block_name(d_block->unique_id(), d_block->name());
+
   d_block->start();			// enable any drivers, etc.
 }
 
@@ -143,6 +147,7 @@ gr_block_executor::run_one_iteration()
 
     if (noutput_items == 0){		// we're output blocked
       LOG(*d_log << "  BLKD_OUT\n");
+      GR_TRACE(m->unique_id(), GR_TRACE_BLKD_OUT, m->output_multiple(), 0);
       return BLKD_OUT;
     }
 
@@ -163,7 +168,7 @@ gr_block_executor::run_one_iteration()
 	/*
 	 * Acquire the mutex and grab local copies of items_available and done.
 	 */
-	gruel::scoped_lock guard(*d->input(i)->mutex());
+	gruel::futex_scoped_lock guard(*d->input(i)->mutex());
 	d_ninput_items[i] = d->input(i)->items_available();
 	d_input_done[i] = d->input(i)->done();
       }
@@ -185,6 +190,9 @@ gr_block_executor::run_one_iteration()
 
     if (noutput_items == 0){	// we're blocked on input
       LOG(*d_log << "  BLKD_IN\n");
+      // every input is short, port 0 included, of what one output_multiple needs
+      GR_TRACE(m->unique_id(), GR_TRACE_BLKD_IN, 0,
+	       (long) ceil (m->output_multiple () / m->relative_rate ()));
       return BLKD_IN;
     }
 
@@ -205,7 +213,7 @@ gr_block_executor::run_one_iteration()
 	/*
 	 * Acquire the mutex and grab local copies of items_available and done.
 	 */
-	gruel::scoped_lock guard(*d->input(i)->mutex());
+	gruel::futex_scoped_lock guard(*d->input(i)->mutex());
 	d_ninput_items[i] = d->input(i)->items_available ();
 	d_input_done[i] = d->input(i)->done();
       }
@@ -228,6 +236,7 @@ gr_block_executor::run_one_iteration()
 
     if (noutput_items == 0){		// we're output blocked
       LOG(*d_log << "  BLKD_OUT\n");
+      GR_TRACE(m->unique_id(), GR_TRACE_BLKD_OUT, m->output_multiple(), 0);
       return BLKD_OUT;
     }
 
@@ -279,6 +288,7 @@ gr_block_executor::run_one_iteration()
 	goto were_done;
       }
 
+      GR_TRACE(m->unique_id(), GR_TRACE_BLKD_IN, i, d_ninput_items_required[i]);
       return BLKD_IN;
     }
 
@@ -295,8 +305,11 @@ gr_block_executor::run_one_iteration()
       d_output_items[i] = d->output(i)->write_pointer();
 
     // Do the actual work of the block
+    GR_TRACE(m->unique_id(), GR_TRACE_WORK_BEGIN, noutput_items,
+	     d_ninput_items.empty() ? 0 : d_ninput_items[0]);
     int n = m->general_work (noutput_items, d_ninput_items,
 			     d_input_items, d_output_items);
+    GR_TRACE(m->unique_id(), GR_TRACE_WORK_END, (long) n, d->d_produce_or);
     LOG(*d_log << "  general_work: noutput_items = " << noutput_items
 	<< " result = " << n << std::endl);
 
@@ -327,6 +340,7 @@ gr_block_executor::run_one_iteration()
     
  were_done:
   LOG(*d_log << "  were_done\n");
+  GR_TRACE(m->unique_id(), GR_TRACE_DONE, 0, 0);
   d->set_done (true);
   return DONE;
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2004,2009 Free Software Foundation, Inc.
+ * Copyright 2004,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,6 +26,7 @@
 #include <gr_runtime_types.h>
 #include <boost/weak_ptr.hpp>
 #include <gruel/thread.h>
+#include <gruel/futex.h>
 
 class gr_vmcircbuf;
 
@@ -86,7 +87,7 @@ class gr_buffer {
   size_t nreaders() const { return d_readers.size(); }
   gr_buffer_reader* reader(size_t index) { return d_readers[index]; }
 
-  gruel::mutex *mutex() { return &d_mutex; }
+  gruel::futex_mutex *mutex() { return &d_mutex; }
 
   // -------------------------------------------------------------------------
 
@@ -108,7 +109,7 @@ class gr_buffer {
   //
   // The mutex protects d_write_index, d_done and the d_read_index's in the buffer readers.
   //
-  gruel::mutex				d_mutex;
+  gruel::futex_mutex			d_mutex;
   unsigned int				d_write_index;	// in items [0,d_bufsize)
   bool					d_done;
   
@@ -217,7 +218,7 @@ class gr_buffer_reader {
   void set_done (bool done)   { d_buffer->set_done (done); }
   bool done () const { return d_buffer->done (); }
 
-  gruel::mutex *mutex() { return d_buffer->mutex(); }
+  gruel::futex_mutex *mutex() { return d_buffer->mutex(); }
 
 
   /*!
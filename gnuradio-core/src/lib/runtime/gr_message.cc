@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,15 +24,42 @@
 #include "config.h"
 #endif
 #include <gr_message.h>
+#include <gr_message_pool.h>
+#include <gruel/atomic.h>
+#include <boost/checked_delete.hpp>
 #include <assert.h>
 #include <string.h>
+#include <stdexcept>
 
-static long s_ncurrently_allocated = 0;
+static volatile long s_ncurrently_allocated = 0;
+
+static pmt::pmt_pool &
+message_pool ()
+{
+  // never destroyed: messages may outlive static destructors
+  static pmt::pmt_pool *s_pool = new pmt::pmt_pool (sizeof (gr_message), 16, 64 * 1024);
+  return *s_pool;
+}
+
+void *
+gr_message::operator new (size_t size)
+{
+  assert (size == sizeof (gr_message));
+  return message_pool ().malloc ();
+}
+
+void
+gr_message::operator delete (void *p, size_t size)
+{
+  message_pool ().free (p);
+}
 
 gr_message_sptr
 gr_make_message (long type, double arg1, double arg2, size_t length)
 {
-  return gr_message_sptr (new gr_message (type, arg1, arg2, length));
+  return gr_message_sptr (new gr_message (type, arg1, arg2, length),
+			  boost::checked_deleter<gr_message> (),
+			  gr_message_pool_allocator<gr_message> ());
 }
 
 gr_message_sptr
@@ -43,26 +70,46 @@ gr_make_message_from_string(const std::string s, long type, double arg1, double
   return m;
 }
 
+gr_message_sptr
+gr_make_message_from_buffer(unsigned char *buf, size_t length,
+			    boost::shared_ptr<void> owner,
+			    long type, double arg1, double arg2)
+{
+  if (!owner)
+    throw std::invalid_argument("gr_make_message_from_buffer: owner is null");
+
+  gr_message_sptr m = gr_make_message(type, arg1, arg2, 0);
+  m->d_owner = owner;
+  m->d_buf_start = m->d_msg_start = buf;
+  m->d_msg_end = m->d_buf_end = buf + length;
+  return m;
+}
 
 gr_message::gr_message (long type, double arg1, double arg2, size_t length)
   : d_type(type), d_arg1(arg1), d_arg2(arg2)
 {
+  d_link.next = 0;
+  d_link.msg = this;
+
   if (length == 0)
     d_buf_start = d_msg_start = d_msg_end = d_buf_end = 0;
   else {
-    d_buf_start = new unsigned char [length];
+    d_buf_start = gr_message_pool::singleton()->alloc (length);
     d_msg_start = d_buf_start;
     d_msg_end = d_buf_end = d_buf_start + length;
   }
-  s_ncurrently_allocated++;
+  gruel::atomic_fetch_add (&s_ncurrently_allocated, 1L);
 }
 
 gr_message::~gr_message ()
 {
-  assert (d_next == 0);
-  delete [] d_buf_start;
+  assert (d_queue_ref == 0);
+  if (d_owner)
+    d_owner.reset ();
+  else
+    gr_message_pool::singleton()->free (d_buf_start, buf_len ());
   d_msg_start = d_msg_end = d_buf_end = 0;
-  s_ncurrently_allocated--;
+  gruel::atomic_fetch_add (&s_ncurrently_allocated, -1L);
 }
 
 std::string
@@ -74,5 +121,5 @@ gr_message::to_string() const
 long
 gr_message_ncurrently_allocated ()
 {
-  return s_ncurrently_allocated;
+  return gruel::atomic_read (&s_ncurrently_allocated);
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -37,6 +37,26 @@ gr_make_message(long type = 0, double arg1 = 0, double arg2 = 0, size_t length =
 gr_message_sptr
 gr_make_message_from_string(const std::string s, long type = 0, double arg1 = 0, double arg2 = 0);
 
+/*!
+ * \brief make a message whose payload is \p length bytes at \p buf, without copying
+ *
+ * The message keeps a copy of \p owner (which must not be empty)
+ * until it is destroyed; use its deleter to learn when the memory may
+ * be reused or freed.
+ */
+gr_message_sptr
+gr_make_message_from_buffer(unsigned char *buf, size_t length,
+			    boost::shared_ptr<void> owner,
+			    long type = 0, double arg1 = 0, double arg2 = 0);
+
+/*!
+ * \brief intrusive link used by gr_msg_queue
+ */
+struct gr_message_link {
+  gr_message_link *volatile	next;
+  gr_message		       *msg;	// message this link is embedded in
+};
+
 /*!
  * \brief Message class.
  *
@@ -45,7 +65,8 @@ gr_make_message_from_string(const std::string s, long type = 0, double arg1 = 0,
  * lifted from the click modular router "Packet" class.
  */
 class gr_message {
-  gr_message_sptr d_next;	// link field for msg queue
+  gr_message_link d_link;	// link field for msg queue
+  gr_message_sptr d_queue_ref;	// keeps us alive while in a msg queue
   long		  d_type;	// type of the message
   double	  d_arg1;	// optional arg1
   double 	  d_arg2;	// optional arg2
@@ -54,7 +75,8 @@ class gr_message {
   unsigned char  *d_msg_start;	// where the msg starts
   unsigned char  *d_msg_end;	// one beyond end of msg
   unsigned char  *d_buf_end;	// one beyond end of allocated buffer
-  
+  boost::shared_ptr<void> d_owner;	// non-zero if the buffer is not ours
+
   gr_message (long type, double arg1, double arg2, size_t length);
 
   friend gr_message_sptr
@@ -63,6 +85,11 @@ class gr_message {
   friend gr_message_sptr
     gr_make_message_from_string (const std::string s, long type, double arg1, double arg2);
 
+  friend gr_message_sptr
+    gr_make_message_from_buffer (unsigned char *buf, size_t length,
+				 boost::shared_ptr<void> owner,
+				 long type, double arg1, double arg2);
+
   friend class gr_msg_queue;
 
   unsigned char *buf_data() const  { return d_buf_start; }
@@ -71,6 +98,10 @@ class gr_message {
 public:
   ~gr_message ();
 
+  // objects come from a pmt_pool rather than the heap
+  static void *operator new (size_t size);
+  static void operator delete (void *p, size_t size);
+
   long type() const   { return d_type; }
   double arg1() const { return d_arg1; }
   double arg2() const { return d_arg2; }
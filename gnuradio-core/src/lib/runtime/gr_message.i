@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005 Free Software Foundation, Inc.
+ * Copyright 2005,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -63,3 +63,10 @@ public:
 %rename(message_ncurrently_allocated) gr_message_ncurrently_allocated;
 long gr_message_ncurrently_allocated();
 
+%rename(message_pool_nallocs) gr_message_pool_nallocs;
+long gr_message_pool_nallocs();
+%rename(message_pool_nhits) gr_message_pool_nhits;
+long gr_message_pool_nhits();
+%rename(message_pool_ncached) gr_message_pool_ncached;
+long gr_message_pool_ncached();
+
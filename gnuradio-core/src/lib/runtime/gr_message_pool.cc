@@ -0,0 +1,183 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <gr_message_pool.h>
+#include <gr_prefs.h>
+#include <gruel/atomic.h>
+
+static const size_t MIN_CLASS_SIZE = 64;
+static const size_t MAX_CACHED_BYTES = 1024 * 1024;	// per class
+
+gr_message_pool *
+gr_message_pool::singleton ()
+{
+  // never destroyed: messages may outlive static destructors
+  static gr_message_pool *s_pool = new gr_message_pool;
+  return s_pool;
+}
+
+gr_message_pool::gr_message_pool ()
+  : d_enabled (gr_prefs::singleton()->get_bool ("gr_message", "pool", true))
+{
+  size_t size = MIN_CLASS_SIZE;
+  for (int i = 0; i < NCLASSES; i++, size *= 4){
+    d_class[i].d_size = size;
+    d_class[i].d_max_cached = std::max ((size_t) 16, MAX_CACHED_BYTES / size);
+  }
+  d_class[NCLASSES].d_size = 0;
+  d_class[NCLASSES].d_max_cached = 0;
+
+  for (int i = 0; i <= NCLASSES; i++){
+    d_class[i].d_freelist = 0;
+    d_class[i].d_nallocs = 0;
+    d_class[i].d_nhits = 0;
+    d_class[i].d_noutstanding = 0;
+    d_class[i].d_ncached = 0;
+  }
+}
+
+gr_message_pool::~gr_message_pool ()
+{
+  trim ();
+}
+
+int
+gr_message_pool::size_class_index (size_t length) const
+{
+  if (!d_enabled)
+    return NCLASSES;
+  for (int i = 0; i < NCLASSES; i++)
+    if (length <= d_class[i].d_size)
+      return i;
+  return NCLASSES;
+}
+
+unsigned char *
+gr_message_pool::alloc (size_t length)
+{
+  size_class &c = d_class[size_class_index (length)];
+  gruel::atomic_fetch_add (&c.d_nallocs, 1L);
+  gruel::atomic_fetch_add (&c.d_noutstanding, 1L);
+
+  if (c.d_size == 0)			// oversized or pool disabled
+    return new unsigned char [length];
+
+  {
+    gruel::scoped_lock guard (c.d_mutex);
+    free_item *p = c.d_freelist;
+    if (p){
+      c.d_freelist = p->d_next;
+      c.d_ncached--;
+      c.d_nhits++;
+      return (unsigned char *) p;
+    }
+  }
+  return new unsigned char [c.d_size];
+}
+
+void
+gr_message_pool::free (unsigned char *p, size_t length)
+{
+  if (p == 0)
+    return;
+
+  size_class &c = d_class[size_class_index (length)];
+  gruel::atomic_fetch_add (&c.d_noutstanding, -1L);
+
+  if (c.d_size != 0){
+    gruel::scoped_lock guard (c.d_mutex);
+    if (c.d_ncached < c.d_max_cached){
+      free_item *f = (free_item *) p;
+      f->d_next = c.d_freelist;
+      c.d_freelist = f;
+      c.d_ncached++;
+      return;
+    }
+  }
+  delete [] p;
+}
+
+void
+gr_message_pool::get_stats (std::vector<gr_message_pool_stats> &stats)
+{
+  stats.resize (NCLASSES + 1);
+  for (int i = 0; i <= NCLASSES; i++){
+    size_class &c = d_class[i];
+    gruel::scoped_lock guard (c.d_mutex);
+    stats[i].size = c.d_size;
+    stats[i].nallocs = gruel::atomic_read (&c.d_nallocs);
+    stats[i].nhits = c.d_nhits;
+    stats[i].noutstanding = gruel::atomic_read (&c.d_noutstanding);
+    stats[i].ncached = c.d_ncached;
+  }
+}
+
+void
+gr_message_pool::trim ()
+{
+  for (int i = 0; i < NCLASSES; i++){
+    size_class &c = d_class[i];
+    gruel::scoped_lock guard (c.d_mutex);
+    while (c.d_freelist){
+      free_item *p = c.d_freelist;
+      c.d_freelist = p->d_next;
+      delete [] (unsigned char *) p;
+    }
+    c.d_ncached = 0;
+  }
+}
+
+long
+gr_message_pool_nallocs ()
+{
+  std::vector<gr_message_pool_stats> stats;
+  gr_message_pool::singleton()->get_stats (stats);
+  long n = 0;
+  for (unsigned int i = 0; i < stats.size (); i++)
+    n += stats[i].nallocs;
+  return n;
+}
+
+long
+gr_message_pool_nhits ()
+{
+  std::vector<gr_message_pool_stats> stats;
+  gr_message_pool::singleton()->get_stats (stats);
+  long n = 0;
+  for (unsigned int i = 0; i < stats.size (); i++)
+    n += stats[i].nhits;
+  return n;
+}
+
+long
+gr_message_pool_ncached ()
+{
+  std::vector<gr_message_pool_stats> stats;
+  gr_message_pool::singleton()->get_stats (stats);
+  long n = 0;
+  for (unsigned int i = 0; i < stats.size (); i++)
+    n += stats[i].ncached;
+  return n;
+}
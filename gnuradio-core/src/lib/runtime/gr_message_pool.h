@@ -0,0 +1,156 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_MESSAGE_POOL_H
+#define INCLUDED_GR_MESSAGE_POOL_H
+
+#include <gruel/thread.h>
+#include <gruel/pmt_pool.h>
+#include <cstddef>
+#include <vector>
+
+/*!
+ * \brief statistics for one gr_message_pool size class
+ */
+struct gr_message_pool_stats {
+  size_t	size;		// buffer size of this class; 0 for oversized requests
+  long		nallocs;	// buffers handed out
+  long		nhits;		// ... of which came from the cache
+  long		noutstanding;	// buffers currently owned by messages
+  long		ncached;	// buffers waiting in the cache
+};
+
+/*!
+ * \brief size-classed, thread-safe cache of message payload buffers
+ * \ingroup misc
+ *
+ * Requests are rounded up to the next power-of-four class between 64
+ * bytes and 64 kB.  Freed buffers go back on their class' free list,
+ * up to about 1 MB per class, and are handed out again before new
+ * memory is allocated.  Larger requests bypass the cache.
+ *
+ * The pool can be disabled by setting pool = false in the
+ * [gr_message] section of the preferences (handy under valgrind).
+ */
+class gr_message_pool {
+ public:
+  static const int NCLASSES = 6;
+
+ private:
+  struct free_item {
+    free_item  *d_next;
+  };
+
+  struct size_class {
+    gruel::mutex	d_mutex;
+    size_t		d_size;
+    long		d_max_cached;
+    free_item	       *d_freelist;
+    volatile long	d_nallocs;
+    volatile long	d_nhits;
+    volatile long	d_noutstanding;
+    volatile long	d_ncached;
+  };
+
+  bool			d_enabled;
+  size_class		d_class[NCLASSES + 1];	// last one counts oversized requests
+
+  gr_message_pool ();
+  int size_class_index (size_t length) const;
+
+ public:
+  ~gr_message_pool ();
+
+  static gr_message_pool *singleton ();
+
+  //! return a buffer of at least \p length bytes (> 0)
+  unsigned char *alloc (size_t length);
+
+  //! return a buffer obtained from alloc (\p length)
+  void free (unsigned char *p, size_t length);
+
+  bool enabled () const { return d_enabled; }
+
+  //! one entry per size class, then one for oversized requests
+  void get_stats (std::vector<gr_message_pool_stats> &stats);
+
+  //! free every cached buffer
+  void trim ();
+};
+
+// totals over all size classes, for the Python side
+long gr_message_pool_nallocs ();	//!< payload buffers handed out
+long gr_message_pool_nhits ();		//!< ... of which came from the cache
+long gr_message_pool_ncached ();	//!< buffers waiting in the cache
+
+/*!
+ * \brief allocator for boost::shared_ptr control blocks drawn from a pmt_pool
+ */
+template<class T>
+class gr_message_pool_allocator {
+ public:
+  typedef T		value_type;
+  typedef T	       *pointer;
+  typedef const T      *const_pointer;
+  typedef T	       &reference;
+  typedef const T      &const_reference;
+  typedef size_t	size_type;
+  typedef ptrdiff_t	difference_type;
+
+  template<class U> struct rebind { typedef gr_message_pool_allocator<U> other; };
+
+  gr_message_pool_allocator () {}
+  template<class U> gr_message_pool_allocator (const gr_message_pool_allocator<U> &) {}
+
+  static pmt::pmt_pool &pool ()
+  {
+    // never destroyed: blocks may be freed during static destruction
+    static pmt::pmt_pool *s_pool = new pmt::pmt_pool (sizeof (T), 16, 64 * 1024);
+    return *s_pool;
+  }
+
+  pointer allocate (size_type n, const void * = 0)
+  {
+    if (n == 1)
+      return (pointer) pool ().malloc ();
+    return (pointer) ::operator new (n * sizeof (T));
+  }
+
+  void deallocate (pointer p, size_type n)
+  {
+    if (n == 1)
+      pool ().free (p);
+    else
+      ::operator delete (p);
+  }
+
+  void construct (pointer p, const T &v) { new ((void *) p) T (v); }
+  void destroy (pointer p) { p->~T (); }
+  size_type max_size () const { return size_t (-1) / sizeof (T); }
+  pointer address (reference r) const { return &r; }
+  const_pointer address (const_reference r) const { return &r; }
+
+  template<class U> bool operator== (const gr_message_pool_allocator<U> &) const { return true; }
+  template<class U> bool operator!= (const gr_message_pool_allocator<U> &) const { return false; }
+};
+
+#endif /* INCLUDED_GR_MESSAGE_POOL_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005,2009 Free Software Foundation, Inc.
+ * Copyright 2005,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,7 +24,13 @@
 #include "config.h"
 #endif
 #include <gr_msg_queue.h>
+#include <gruel/atomic.h>
 #include <stdexcept>
+#include <algorithm>
+#include <unistd.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 gr_msg_queue_sptr
 gr_make_msg_queue(unsigned int limit)
@@ -33,86 +39,215 @@ gr_make_msg_queue(unsigned int limit)
 }
 
 gr_msg_queue::gr_msg_queue(unsigned int limit)
-  : d_not_empty(), d_not_full(),
-    /*d_head(0), d_tail(0),*/ d_count(0), d_limit(limit)
+  : d_tail(&d_stub), d_head(&d_stub), d_count(0), d_limit(limit),
+    d_wakeup_fd(-1)
 {
+  d_stub.next = 0;
+  d_stub.msg = 0;
 }
 
 gr_msg_queue::~gr_msg_queue()
 {
   flush ();
+  if (d_wakeup_fd >= 0)
+    close (d_wakeup_fd);
 }
 
+/*
+ * Append link.  Producers serialize on the exchange; until prev->next
+ * is stored the consumer sees the list as ending at prev.
+ */
 void
-gr_msg_queue::insert_tail(gr_message_sptr msg)
+gr_msg_queue::push(gr_message_link *link)
 {
-  if (msg->d_next)
-    throw std::invalid_argument("gr_msg_queue::insert_tail: msg already in queue");
+  link->next = 0;
+  gr_message_link *prev = gruel::atomic_exchange(&d_tail, link);
+  gruel::atomic_store(&prev->next, link);
+}
 
-  gruel::scoped_lock guard(d_mutex);
+/*
+ * Unlink the head message.  Must hold d_consumer_mutex.  Returns 0 if
+ * the queue is empty or the next message is still being pushed.
+ */
+gr_message_sptr
+gr_msg_queue::pop()
+{
+  gr_message_link *head = d_head;
+  gr_message_link *next = gruel::atomic_load(&head->next);
 
-  while (full_p())
-    d_not_full.wait(guard);
+  if (head == &d_stub){
+    if (next == 0)
+      return gr_message_sptr();
+    d_head = head = next;
+    next = gruel::atomic_load(&head->next);
+  }
 
-  if (d_tail == 0){
-    d_tail = d_head = msg;
-    //msg->d_next = 0;
-    msg->d_next.reset();
+  if (next == 0){
+    if (head != gruel::atomic_load(&d_tail))
+      return gr_message_sptr();		// a producer is between its two steps
+    push(&d_stub);			// last message: put the stub behind it
+    next = gruel::atomic_load(&head->next);
+    if (next == 0)
+      return gr_message_sptr();
   }
-  else {
-    d_tail->d_next = msg;
-    d_tail = msg;
-    //msg->d_next = 0;
-    msg->d_next.reset();
+
+  d_head = next;
+  gr_message_sptr m;
+  m.swap(head->msg->d_queue_ref);
+  return m;
+}
+
+/*
+ * Remove up to max messages.  Every message counted in d_count has been
+ * or is about to be pushed, so keep trying until we have those or max.
+ */
+unsigned int
+gr_msg_queue::remove(gr_message_sptr *msgs, unsigned int max)
+{
+  for (;;){
+    unsigned int n = 0;
+    {
+      gruel::futex_scoped_lock guard(d_consumer_mutex);
+
+      long avail = std::min((long) max, gruel::atomic_load(&d_count));
+      while ((long) n < avail){
+	if ((msgs[n] = pop()) == 0)
+	  boost::this_thread::yield();
+	else
+	  n++;
+      }
+      if (n > 0)
+	gruel::atomic_fetch_add(&d_count, -(long) n);
+    }
+
+    if (n > 0){
+      if (d_limit != 0)
+	d_not_full.notify_all();
+      return n;
+    }
+
+#ifdef HAVE_SYS_EVENTFD_H
+    // Found the queue empty: rearm the descriptor, then look again in
+    // case a producer wrote it between our check and the read.
+    if (d_wakeup_fd >= 0){
+      eventfd_t v;
+      eventfd_read(d_wakeup_fd, &v);
+      if (gruel::atomic_load(&d_count) != 0)
+	continue;
+    }
+#endif
+    return 0;
   }
-  d_count++;
-  d_not_empty.notify_one();
 }
 
-gr_message_sptr
-gr_msg_queue::delete_head()
+/*
+ * Claim a slot, blocking while the queue is full.  Returns the number
+ * of messages that were queued before us.
+ */
+long
+gr_msg_queue::reserve()
 {
-  gruel::scoped_lock guard(d_mutex);
-  gr_message_sptr m;
+  if (d_limit == 0)
+    return gruel::atomic_fetch_add(&d_count, 1L);
 
-  while ((m = d_head) == 0)
-    d_not_empty.wait(guard);
+  for (;;){
+    long n = d_count;
+    if (n < (long) d_limit){
+      if (gruel::atomic_cas(&d_count, n, n + 1))
+	return n;
+      continue;
+    }
 
-  d_head = m->d_next;
-  if (d_head == 0){
-    //d_tail = 0;
-    d_tail.reset();
+    gruel::event_count::key_type key = d_not_full.prepare_wait();
+    if (full_p())
+      d_not_full.wait(key);
   }
+}
 
-  d_count--;
-  // m->d_next = 0;
-  m->d_next.reset();
-  d_not_full.notify_one();
+void
+gr_msg_queue::wait_not_empty()
+{
+  gruel::event_count::key_type key = d_not_empty.prepare_wait();
+  if (empty_p())
+    d_not_empty.wait(key);
+}
+
+void
+gr_msg_queue::insert_tail(gr_message_sptr msg)
+{
+  if (msg->d_queue_ref)
+    throw std::invalid_argument("gr_msg_queue::insert_tail: msg already in queue");
+
+  long before = reserve();
+  msg->d_queue_ref = msg;
+  push(&msg->d_link);
+
+  // reserve() bumped d_count with a full barrier, so wakeup_fd() either
+  // sees our message or we see its descriptor
+#ifdef HAVE_SYS_EVENTFD_H
+  if (before == 0 && d_wakeup_fd >= 0)
+    eventfd_write(d_wakeup_fd, 1);
+#endif
+  d_not_empty.notify_all();
+}
+
+gr_message_sptr
+gr_msg_queue::delete_head()
+{
+  gr_message_sptr m;
+  while (remove(&m, 1) == 0)
+    wait_not_empty();
   return m;
 }
 
 gr_message_sptr
 gr_msg_queue::delete_head_nowait()
 {
-  gruel::scoped_lock guard(d_mutex);
   gr_message_sptr m;
+  remove(&m, 1);
+  return m;
+}
 
-  if ((m = d_head) == 0){
-    //return 0;
-    return gr_message_sptr();
-  }
+std::vector<gr_message_sptr>
+gr_msg_queue::delete_head_batch(unsigned int max)
+{
+  std::vector<gr_message_sptr> msgs;
+  if (max == 0)
+    return msgs;
+  while (delete_head_batch_nowait(msgs, max) == 0)
+    wait_not_empty();
+  return msgs;
+}
 
-  d_head = m->d_next;
-  if (d_head == 0){
-    //d_tail = 0;
-    d_tail.reset();
-  }
+unsigned int
+gr_msg_queue::delete_head_batch_nowait(std::vector<gr_message_sptr> &msgs,
+				       unsigned int max)
+{
+  size_t old_size = msgs.size();
+  msgs.resize(old_size + max);
+  unsigned int n = remove(max ? &msgs[old_size] : 0, max);
+  msgs.resize(old_size + n);
+  return n;
+}
 
-  d_count--;
-  //m->d_next = 0;
-  m->d_next.reset();
-  d_not_full.notify_one();
-  return m;
+int
+gr_msg_queue::wakeup_fd()
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  gruel::futex_scoped_lock guard(d_consumer_mutex);
+  if (d_wakeup_fd < 0){
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+      return -1;
+    gruel::atomic_store(&d_wakeup_fd, fd);
+    gruel::memory_barrier();		// pairs with reserve() in insert_tail
+    if (!empty_p())
+      eventfd_write(fd, 1);
+  }
+  return d_wakeup_fd;
+#else
+  return -1;
+#endif
 }
 
 void
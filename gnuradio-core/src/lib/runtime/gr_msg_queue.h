@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005,2009 Free Software Foundation, Inc.
+ * Copyright 2005,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,6 +24,8 @@
 
 #include <gr_msg_handler.h>
 #include <gruel/thread.h>
+#include <gruel/event_count.h>
+#include <vector>
 
 class gr_msg_queue;
 typedef boost::shared_ptr<gr_msg_queue> gr_msg_queue_sptr;
@@ -33,17 +35,40 @@ gr_msg_queue_sptr gr_make_msg_queue(unsigned int limit=0);
 /*!
  * \brief thread-safe message queue
  * \ingroup misc
+ *
+ * Any number of threads may insert messages without taking a lock.
+ * Messages are linked through gr_message::d_link into an intrusive
+ * multi-producer / single-consumer list (D. Vyukov's algorithm):
+ * producers atomically swap themselves in as the new tail, the consumer
+ * follows the links from the head.  Removal is serialized by a mutex
+ * that is only contended if several threads consume from one queue.
+ *
+ * Threads only sleep when the queue is empty (consumers) or full
+ * (producers), and are only woken by a peer that knows they are
+ * waiting.  Consumers that multiplex several sources with poll(2)
+ * can use wakeup_fd() instead of blocking in delete_head().
  */
 class gr_msg_queue : public gr_msg_handler {
 
-  gruel::mutex		    d_mutex;
-  gruel::condition_variable d_not_empty;
-  gruel::condition_variable d_not_full;
-  gr_message_sptr	    d_head;
-  gr_message_sptr	    d_tail;
-  unsigned int		    d_count;    // # of messages in queue.
+  gr_message_link	    d_stub;	// keeps the list non-empty
+  gr_message_link *volatile d_tail;	// most recently inserted link
+  gr_message_link	   *d_head;	// next link to remove
+  gruel::futex_mutex	    d_consumer_mutex;	// protects d_head
+
+  volatile long		    d_count;    // # of messages in queue.
   unsigned int		    d_limit;    // max # of messages in queue.  0 -> unbounded
 
+  // slow path: blocking when empty or full
+  gruel::event_count	    d_not_empty;
+  gruel::event_count	    d_not_full;
+  volatile int		    d_wakeup_fd;	// eventfd, -1 until requested
+
+  void push(gr_message_link *link);
+  gr_message_sptr pop();
+  unsigned int remove(gr_message_sptr *msgs, unsigned int max);
+  long reserve();
+  void wait_not_empty();
+
 public:
   gr_msg_queue(unsigned int limit);
   ~gr_msg_queue();
@@ -70,7 +95,30 @@ public:
    * If no message is available, return 0.
    */
   gr_message_sptr delete_head_nowait();
-  
+
+  /*!
+   * \brief Delete up to \p max messages from the head of the queue.
+   * Block until at least one message is available.
+   */
+  std::vector<gr_message_sptr> delete_head_batch(unsigned int max);
+
+  /*!
+   * \brief Delete up to \p max messages from the head of the queue.
+   * \returns number of messages appended to \p msgs, possibly 0.
+   */
+  unsigned int delete_head_batch_nowait(std::vector<gr_message_sptr> &msgs,
+					unsigned int max);
+
+  /*!
+   * \brief file descriptor that polls readable when messages are queued
+   *
+   * The descriptor is created on the first call and owned by the queue.
+   * After poll(2) reports it readable, remove messages with the _nowait
+   * methods until they come back empty; that also rearms the descriptor.
+   * Returns -1 where eventfd(2) is not available.
+   */
+  int wakeup_fd();
+
   //! Delete all messages from the queue
   void flush();
 
@@ -78,7 +126,7 @@ public:
   bool empty_p() const { return d_count == 0; }
   
   //! is the queue full?
-  bool full_p() const { return d_limit != 0 && d_count >= d_limit; }
+  bool full_p() const { return d_limit != 0 && d_count >= (long) d_limit; }
   
   //! return number of messages in queue
   unsigned int count() const { return d_count; }
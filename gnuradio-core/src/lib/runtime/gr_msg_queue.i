@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2005,2009 Free Software Foundation, Inc.
+ * Copyright 2005,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,6 +24,8 @@ class gr_msg_queue;
 typedef boost::shared_ptr<gr_msg_queue> gr_msg_queue_sptr;
 %template(gr_msg_queue_sptr) boost::shared_ptr<gr_msg_queue>;
 
+%template(gr_message_sptr_vector) std::vector<gr_message_sptr>;
+
 %rename(msg_queue) gr_make_msg_queue;
 gr_msg_queue_sptr gr_make_msg_queue(unsigned limit=0);
 
@@ -58,7 +60,10 @@ public:
    * If no message is available, return 0.
    */
   gr_message_sptr delete_head_nowait();
-  
+
+  //! file descriptor that polls readable when messages are queued
+  int wakeup_fd();
+
   //! is the queue empty?
   bool empty_p() const;
   
@@ -68,6 +73,9 @@ public:
   //! return number of messages in queue
   unsigned int count() const;
 
+  //! return limit on number of message in queue.  0 -> unbounded
+  unsigned int limit() const;
+
   //! Delete all messages from the queue
   void flush();
 };
@@ -90,6 +98,15 @@ public:
     return msg;
   }
 
+  std::vector<gr_message_sptr> gr_py_msg_queue__delete_head_batch(gr_msg_queue_sptr q,
+								  unsigned int max) {
+    std::vector<gr_message_sptr> msgs;
+    Py_BEGIN_ALLOW_THREADS;		// release global interpreter lock
+    msgs = q->delete_head_batch(max);	// possibly blocking call
+    Py_END_ALLOW_THREADS;		// acquire global interpreter lock
+    return msgs;
+  }
+
   void gr_py_msg_queue__insert_tail(gr_msg_queue_sptr q, gr_message_sptr msg) {
     Py_BEGIN_ALLOW_THREADS;		// release global interpreter lock
     q->insert_tail(msg);		// possibly blocking call
@@ -100,6 +117,7 @@ public:
 // smash in new python delete_head and insert_tail methods...
 %pythoncode %{
 gr_msg_queue_sptr.delete_head = gr_py_msg_queue__delete_head
+gr_msg_queue_sptr.delete_head_batch = gr_py_msg_queue__delete_head_batch
 gr_msg_queue_sptr.insert_tail = gr_py_msg_queue__insert_tail
 gr_msg_queue_sptr.handle = gr_py_msg_queue__insert_tail
 %}
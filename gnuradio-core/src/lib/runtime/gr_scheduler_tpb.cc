@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2008 Free Software Foundation, Inc.
+ * Copyright 2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -59,21 +59,21 @@ gr_scheduler_tpb::gr_scheduler_tpb(gr_flat_flowgraph_sptr ffg)
 
   gr_basic_block_vector_t used_blocks = ffg->calc_used_blocks();
   used_blocks = ffg->topological_sort(used_blocks);
-  gr_block_vector_t blocks = gr_flat_flowgraph::make_block_vector(used_blocks);
+  d_blocks = gr_flat_flowgraph::make_block_vector(used_blocks);
 
   // Ensure that the done flag is clear on all blocks
 
-  for (size_t i = 0; i < blocks.size(); i++){
-    blocks[i]->detail()->set_done(false);
+  for (size_t i = 0; i < d_blocks.size(); i++){
+    d_blocks[i]->detail()->set_done(false);
   }
 
   // Fire off a thead for each block
 
-  for (size_t i = 0; i < blocks.size(); i++){
+  for (size_t i = 0; i < d_blocks.size(); i++){
     std::stringstream name;
-    name << "thread-per-block[" << i << "]: " << blocks[i];
+    name << "thread-per-block[" << i << "]: " << d_blocks[i];
     d_threads.create_thread(
-      gruel::thread_body_wrapper<tpb_container>(tpb_container(blocks[i]), name.str()));
+      gruel::thread_body_wrapper<tpb_container>(tpb_container(d_blocks[i]), name.str()));
   }
 }
 
@@ -86,6 +86,10 @@ void
 gr_scheduler_tpb::stop()
 {
   d_threads.interrupt_all();
+
+  // Blocked threads sleep on event counts, which boost can't interrupt
+  for (size_t i = 0; i < d_blocks.size(); i++)
+    d_blocks[i]->detail()->d_tpb.wakeup();
 }
 
 void
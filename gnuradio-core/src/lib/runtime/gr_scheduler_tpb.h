@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2008 Free Software Foundation, Inc.
+ * Copyright 2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -30,6 +30,7 @@
 class gr_scheduler_tpb : public gr_scheduler
 {
   gruel::thread_group		       d_threads;
+  gr_block_vector_t		       d_blocks;
 
 protected:
   /*!
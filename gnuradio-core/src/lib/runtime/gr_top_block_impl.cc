@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  *
  * This file is part of GNU Radio
  *
@@ -29,6 +29,7 @@
 #include <gr_flat_flowgraph.h>
 #include <gr_scheduler_sts.h>
 #include <gr_scheduler_tpb.h>
+#include <gr_trace.h>
 
 #include <stdexcept>
 #include <iostream>
@@ -105,6 +106,7 @@ gr_top_block_impl::start()
   d_ffg->validate();
   d_ffg->setup_connections();
 
+  gr_trace_start_from_env();
   d_scheduler = make_scheduler(d_ffg);
   d_state = RUNNING;
 }
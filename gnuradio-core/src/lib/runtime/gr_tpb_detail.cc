@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2008,2009 Free Software Foundation, Inc.
+ * Copyright 2008,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -71,40 +71,18 @@ gr_tpb_detail::notify_neighbors(gr_block_detail *d)
 void
 gr_tpb_detail::insert_tail(pmt::pmt_t msg)
 {
-  gruel::scoped_lock guard(mutex);
+  msg_queue.insert_tail(msg);
 
-  msg_queue.push_back(msg);
-
-  // wake up thread if BLKD_IN or BLKD_OUT
-  input_cond.notify_one();
-  output_cond.notify_one();
+  // wake up thread if BLKD_IN or BLKD_OUT.  It waits on one or the
+  // other; a notify on the one nobody is waiting on is just a load.
+  input_events.notify_all();
+  output_events.notify_all();
 }
 
 pmt_t 
 gr_tpb_detail::delete_head_nowait()
 {
-  gruel::scoped_lock guard(mutex);
-
-  if (empty_p())
-    return pmt_t();
-
-  pmt_t m(msg_queue.front());
-  msg_queue.pop_front();
-
-  return m;
-}
-
-/*
- * Caller must already be holding the mutex
- */
-pmt_t 
-gr_tpb_detail::delete_head_nowait_already_holding_mutex()
-{
-  if (empty_p())
-    return pmt_t();
-
-  pmt_t m(msg_queue.front());
-  msg_queue.pop_front();
-
+  pmt_t m;
+  msg_queue.delete_head(m);
   return m;
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2008,2009 Free Software Foundation, Inc.
+ * Copyright 2008,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -21,25 +21,34 @@
 #ifndef INCLUDED_GR_TPB_DETAIL_H
 #define INCLUDED_GR_TPB_DETAIL_H
 
-#include <gruel/thread.h>
-#include <deque>
-#include <gruel/pmt.h>
+#include <gruel/event_count.h>
+#include <gruel/mpsc_queue.h>
+#include <boost/thread.hpp>
+#include <vector>
 
 class gr_block_detail;
 
 /*!
  * \brief used by thread-per-block scheduler
+ *
+ * The changed flags and the message queue are lock-free, and our
+ * thread sleeps on an event count for each direction, so a block that
+ * is keeping up costs its neighbors a couple of barriers per
+ * notification instead of a lock and a condition variable signal.  A
+ * message arriving while we're blocked wakes us through the same event
+ * count as the stream notifications.  Sleeping on an event count isn't
+ * a boost interruption point, so the scheduler calls wakeup() after
+ * interrupting us and we check for the interruption each time around.
  */
 struct gr_tpb_detail {
 
-  gruel::mutex			mutex;			//< protects all vars
-  bool				input_changed;
-  gruel::condition_variable	input_cond;
-  bool				output_changed;
-  gruel::condition_variable	output_cond;
+  volatile bool			input_changed;
+  gruel::event_count		input_events;
+  volatile bool			output_changed;
+  gruel::event_count		output_events;
 
 private:
-  std::deque<pmt::pmt_t>	msg_queue;
+  gruel::mpsc_queue		msg_queue;
 
 public:
   gr_tpb_detail()
@@ -57,44 +66,79 @@ public:
   //! Called by us
   void clear_changed()
   {
-    gruel::scoped_lock guard(mutex);
     input_changed = false;
     output_changed = false;
+    gruel::memory_barrier();	// before we look at the buffers
   }
   
   //! is the queue empty?
-  bool empty_p() const { return msg_queue.empty(); }
+  bool empty_p() const { return msg_queue.empty_p(); }
 
-  //| Acquires and release the mutex	
+  //| Lock-free; calls into the kernel only if our thread is asleep
   void insert_tail(pmt::pmt_t msg);
 
   /*!
    * \returns returns pmt at head of queue or pmt_t() if empty.
+   * Only our thread may remove messages.
    */
   pmt::pmt_t delete_head_nowait();
 
   /*!
-   * \returns returns pmt at head of queue or pmt_t() if empty.
-   * Caller must already be holding the mutex
+   * \brief Append all queued messages to \p msgs, oldest first.
+   * Only our thread may remove messages.
+   * \returns the number of messages appended
    */
-  pmt::pmt_t delete_head_nowait_already_holding_mutex();
+  size_t delete_all(std::vector<pmt::pmt_t> &msgs)
+  {
+    return msg_queue.delete_all(msgs);
+  }
+
+  //! Called by the scheduler after interrupting our thread
+  void wakeup()
+  {
+    input_events.notify_all();
+    output_events.notify_all();
+  }
+
+  //! Called by us: sleep until our input changes or a message arrives
+  void wait_input()
+  {
+    wait(input_changed, input_events);
+  }
+
+  //! Called by us: sleep until our output changes or a message arrives
+  void wait_output()
+  {
+    wait(output_changed, output_events);
+  }
 
 private:
 
+  void wait(volatile bool &changed, gruel::event_count &events)
+  {
+    while (1){
+      gruel::event_count::key_type key = events.prepare_wait();
+      if (changed || !empty_p())
+	return;
+      boost::this_thread::interruption_point();
+      events.wait(key);
+    }
+  }
+
   //! Used by notify_downstream
   void set_input_changed()
   {
-    gruel::scoped_lock guard(mutex);
+    gruel::memory_barrier();	// buffer updates are visible first
     input_changed = true;
-    input_cond.notify_one();
+    input_events.notify_all();
   }
 
   //! Used by notify_upstream
   void set_output_changed()
   {
-    gruel::scoped_lock guard(mutex);
+    gruel::memory_barrier();
     output_changed = true;
-    output_cond.notify_one();
+    output_events.notify_all();
   }
 
 };
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2008,2009 Free Software Foundation, Inc.
+ * Copyright 2008,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -22,12 +22,24 @@
 #include <config.h>
 #endif
 #include <gr_tpb_thread_body.h>
+#include <gr_trace.h>
 #include <iostream>
 #include <boost/thread.hpp>
 #include <gruel/pmt.h>
 
 using namespace pmt;
 
+// Hand every queued message to the block, oldest first.
+static void
+handle_msgs(gr_block *block, gr_tpb_detail *tpb, std::vector<pmt_t> &msgs)
+{
+  if (tpb->delete_all(msgs) == 0)
+    return;
+  for (size_t i = 0; i < msgs.size(); i++)
+    block->handle_msg(msgs[i]);
+  msgs.clear();
+}
+
 gr_tpb_thread_body::gr_tpb_thread_body(gr_block_sptr block)
   : d_exec(block)
 {
@@ -35,15 +47,14 @@ gr_tpb_thread_body::gr_tpb_thread_body(gr_block_sptr block)
 
   gr_block_detail *d = block->detail().get();
   gr_block_executor::state s;
-  pmt_t msg;
+  std::vector<pmt_t> msgs;
 
 
   while (1){
     boost::this_thread::interruption_point();
  
     // handle any queued up messages
-    while ((msg = d->d_tpb.delete_head_nowait()))
-      block->handle_msg(msg);
+    handle_msgs(block.get(), &d->d_tpb, msgs);
 
     d->d_tpb.clear_changed();
     s = d_exec.run_one_iteration();
@@ -62,42 +73,20 @@ gr_tpb_thread_body::gr_tpb_thread_body(gr_block_sptr block)
       return;
 
     case gr_block_executor::BLKD_IN:		// Wait for input.
-      {
-	gruel::scoped_lock guard(d->d_tpb.mutex);
-	while (!d->d_tpb.input_changed){
-	  
-	  // wait for input or message
-	  while(!d->d_tpb.input_changed && d->d_tpb.empty_p())
-	    d->d_tpb.input_cond.wait(guard);
-
-	  // handle all pending messages
-	  while ((msg = d->d_tpb.delete_head_nowait_already_holding_mutex())){
-	    guard.unlock();			// release lock while processing msg
-	    block->handle_msg(msg);
-	    guard.lock();
-	  }
-	}
+      while (!d->d_tpb.input_changed){
+	d->d_tpb.wait_input();		// for input or a message
+	handle_msgs(block.get(), &d->d_tpb, msgs);
       }
+      GR_TRACE(block->unique_id(), GR_TRACE_WAKE, s, 0);
       break;
 
       
     case gr_block_executor::BLKD_OUT:		// Wait for output buffer space.
-      {
-	gruel::scoped_lock guard(d->d_tpb.mutex);
-	while (!d->d_tpb.output_changed){
-	  
-	  // wait for output room or message
-	  while(!d->d_tpb.output_changed && d->d_tpb.empty_p())
-	    d->d_tpb.output_cond.wait(guard);
-
-	  // handle all pending messages
-	  while ((msg = d->d_tpb.delete_head_nowait_already_holding_mutex())){
-	    guard.unlock();			// release lock while processing msg
-	    block->handle_msg(msg);
-	    guard.lock();
-	  }
-	}
+      while (!d->d_tpb.output_changed){
+	d->d_tpb.wait_output();		// for output room or a message
+	handle_msgs(block.get(), &d->d_tpb, msgs);
       }
+      GR_TRACE(block->unique_id(), GR_TRACE_WAKE, s, 0);
       break;
 
     default:
@@ -0,0 +1,404 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gr_trace.h>
+#include <gruel/atomic.h>
+#include <gruel/thread.h>
+#include <gruel/thread_body_wrapper.h>
+#include <boost/thread/tss.hpp>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#define	DRAIN_PERIOD	0.020		// seconds between collector passes
+
+static const gr_uint32 TAG_RECS = 0x53434552;	// "RECS"
+static const gr_uint32 TAG_NAME = 0x454d414e;	// "NAME"
+static const gr_uint32 TAG_DROP = 0x504f5244;	// "DROP"
+
+volatile bool gr_trace_on = false;
+
+/*
+ * One per thread that has logged an event.  The owning thread is the
+ * only producer and the collector the only consumer.  Rings live until
+ * their thread has exited and the collector has drained them.
+ */
+struct trace_ring {
+  gr_trace_record	       *d_records;
+  unsigned long			d_mask;
+  volatile unsigned long	d_head;		// written by the collector
+  volatile unsigned long	d_tail;		// written by the producer
+  unsigned long			d_cached_head;	// producer's last look at d_head
+  volatile unsigned long	d_ndropped;	// written by the producer
+  unsigned long			d_ndropped_base;	// at gr_trace_start
+  unsigned long			d_ndropped_reported;
+  gr_uint32			d_index;
+  volatile bool			d_orphaned;	// producer thread has exited
+};
+
+static gruel::mutex			s_mutex;	// guards everything below
+static std::vector<trace_ring *>	s_rings;
+static std::vector<std::pair<long, std::string> > s_names;
+static size_t				s_names_written;
+static gr_uint32			s_next_index;
+static int				s_ring_records = 65536;
+static int				s_fd = -1;
+static gruel::thread		       *s_collector;
+static gruel::condition_variable	s_cond;
+static bool				s_stop_collector;
+static volatile gr_uint64		s_nwritten;
+static gr_uint64			s_ndropped_retired;	// by rings since deleted
+
+static void
+orphan_ring (trace_ring *r)
+{
+  gruel::atomic_store (&r->d_orphaned, true);
+}
+
+static boost::thread_specific_ptr<trace_ring> s_my_ring (orphan_ring);
+
+static trace_ring *
+new_ring ()
+{
+  int n = 1;
+  while (n < s_ring_records)
+    n <<= 1;
+
+  trace_ring *r = new trace_ring;
+  r->d_records = new gr_trace_record[n];
+  r->d_mask = n - 1;
+  r->d_head = r->d_tail = r->d_cached_head = 0;
+  r->d_ndropped = r->d_ndropped_base = r->d_ndropped_reported = 0;
+  r->d_orphaned = false;
+
+  gruel::scoped_lock guard (s_mutex);
+  r->d_index = s_next_index++;
+  s_rings.push_back (r);
+  s_my_ring.reset (r);
+  return r;
+}
+
+static void
+delete_ring (trace_ring *r)
+{
+  delete [] r->d_records;
+  delete r;
+}
+
+static inline gr_uint64
+now_ns ()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gr_uint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (gr_uint64) tv.tv_sec * 1000000000 + (gr_uint64) tv.tv_usec * 1000;
+#endif
+}
+
+void
+gr_trace_log (long block_id, unsigned int event, gr_uint64 arg0, gr_uint64 arg1)
+{
+  trace_ring *r = s_my_ring.get ();
+  if (r == 0)
+    r = new_ring ();
+
+  unsigned long tail = r->d_tail;
+  if (tail - r->d_cached_head > r->d_mask){
+    r->d_cached_head = gruel::atomic_load (&r->d_head);
+    if (tail - r->d_cached_head > r->d_mask){	// really full
+      r->d_ndropped = r->d_ndropped + 1;
+      return;
+    }
+  }
+
+  gr_trace_record *p = &r->d_records[tail & r->d_mask];
+  p->timestamp = now_ns ();
+  p->block_id = block_id;
+  p->event = event;
+  p->arg0 = arg0;
+  p->arg1 = arg1;
+  gruel::atomic_store (&r->d_tail, tail + 1);
+}
+
+// ------------------------------------------------------------------------
+//				collector side
+// ------------------------------------------------------------------------
+
+static void
+put_section (struct iovec *iov, gr_uint32 *hdr, gr_uint32 tag, size_t len)
+{
+  hdr[0] = tag;
+  hdr[1] = len;
+  iov->iov_base = hdr;
+  iov->iov_len = 2 * sizeof (gr_uint32);
+}
+
+static bool
+writev_all (int fd, struct iovec *iov, int iovcnt)
+{
+  while (iovcnt > 0){
+    ssize_t n = writev (fd, iov, iovcnt);
+    if (n < 0){
+      if (errno == EINTR)
+	continue;
+      perror ("gr_trace: write");
+      return false;
+    }
+    while (iovcnt > 0 && (size_t) n >= iov->iov_len){
+      n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0){
+      iov->iov_base = (char *) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+/*
+ * Write everything that is in \p r now.  The records are handed to
+ * writev straight out of the ring.  Call with s_mutex held.
+ */
+static void
+drain_ring (trace_ring *r)
+{
+  unsigned long head = r->d_head;
+  unsigned long tail = gruel::atomic_load (&r->d_tail);
+  unsigned long n = tail - head;
+
+  if (n > 0){
+    unsigned long first = head & r->d_mask;
+    unsigned long n1 = std::min (n, r->d_mask + 1 - first);
+    gr_uint32 hdr[4];
+    struct iovec iov[3];
+    put_section (&iov[0], hdr, TAG_RECS, 8 + n * sizeof (gr_trace_record));
+    hdr[2] = r->d_index;
+    hdr[3] = 0;
+    iov[0].iov_len = sizeof (hdr);
+    iov[1].iov_base = &r->d_records[first];
+    iov[1].iov_len = n1 * sizeof (gr_trace_record);
+    iov[2].iov_base = &r->d_records[0];
+    iov[2].iov_len = (n - n1) * sizeof (gr_trace_record);
+    if (writev_all (s_fd, iov, n1 < n ? 3 : 2))
+      s_nwritten = s_nwritten + n;
+    gruel::atomic_store (&r->d_head, tail);
+  }
+
+  unsigned long ndropped = r->d_ndropped - r->d_ndropped_base;
+  if (ndropped != r->d_ndropped_reported){
+    gr_uint32 hdr[6];
+    gr_uint64 count = ndropped;
+    struct iovec iov[1];
+    put_section (&iov[0], hdr, TAG_DROP, 16);
+    hdr[2] = r->d_index;
+    hdr[3] = 0;
+    memcpy (&hdr[4], &count, sizeof (count));
+    iov[0].iov_len = sizeof (hdr);
+    writev_all (s_fd, iov, 1);
+    r->d_ndropped_reported = ndropped;
+  }
+}
+
+// Call with s_mutex held.
+static void
+drain_all ()
+{
+  for (; s_names_written < s_names.size (); s_names_written++){
+    const std::pair<long, std::string> &e = s_names[s_names_written];
+    gr_uint32 hdr[2];
+    gr_int64 id = e.first;
+    struct iovec iov[3];
+    put_section (&iov[0], hdr, TAG_NAME, sizeof (id) + e.second.size ());
+    iov[1].iov_base = &id;
+    iov[1].iov_len = sizeof (id);
+    iov[2].iov_base = (void *) e.second.data ();
+    iov[2].iov_len = e.second.size ();
+    writev_all (s_fd, iov, 3);
+  }
+
+  for (size_t i = 0; i < s_rings.size (); ){
+    trace_ring *r = s_rings[i];
+    bool orphaned = gruel::atomic_load (&r->d_orphaned);
+    drain_ring (r);
+    if (orphaned){			// producer gone, nothing more will arrive
+      s_ndropped_retired += r->d_ndropped - r->d_ndropped_base;
+      s_rings[i] = s_rings.back ();
+      s_rings.pop_back ();
+      delete_ring (r);
+    }
+    else
+      i++;
+  }
+}
+
+struct collector_body {
+  void operator() ()
+  {
+    gruel::scoped_lock guard (s_mutex);
+    while (!s_stop_collector){
+      s_cond.timed_wait (guard, gruel::get_new_timeout (DRAIN_PERIOD));
+      drain_all ();
+    }
+  }
+};
+
+static void
+stop_at_exit ()
+{
+  gr_trace_stop ();
+}
+
+bool
+gr_trace_start (const std::string &filename, int ring_records)
+{
+  static bool registered = false;
+
+  gruel::scoped_lock guard (s_mutex);
+  if (s_fd >= 0)
+    return false;
+
+  int fd = open (filename.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+  if (fd < 0){
+    perror (filename.c_str ());
+    return false;
+  }
+
+  gr_uint32 hdr[4];
+  memcpy (hdr, "GRTRACE1", 8);
+  hdr[2] = 0x01020304;
+  hdr[3] = sizeof (gr_trace_record);
+  struct iovec iov = { hdr, sizeof (hdr) };
+  s_fd = fd;
+  if (!writev_all (s_fd, &iov, 1)){
+    close (s_fd);
+    s_fd = -1;
+    return false;
+  }
+
+  // Discard anything left over from an earlier trace.
+  for (size_t i = 0; i < s_rings.size (); ){
+    trace_ring *r = s_rings[i];
+    if (gruel::atomic_load (&r->d_orphaned)){
+      s_rings[i] = s_rings.back ();
+      s_rings.pop_back ();
+      delete_ring (r);
+      continue;
+    }
+    gruel::atomic_store (&r->d_head, gruel::atomic_load (&r->d_tail));
+    r->d_ndropped_base = r->d_ndropped;
+    r->d_ndropped_reported = 0;
+    i++;
+  }
+  s_ndropped_retired = 0;
+  s_names_written = 0;
+  s_nwritten = 0;
+  s_ring_records = ring_records;
+
+  if (!registered){
+    atexit (stop_at_exit);
+    registered = true;
+  }
+
+  s_stop_collector = false;
+  s_collector = new gruel::thread (
+    gruel::thread_body_wrapper<collector_body> (collector_body (), "gr_trace"));
+
+  gruel::atomic_store (&gr_trace_on, true);
+  return true;
+}
+
+void
+gr_trace_stop ()
+{
+  gruel::thread *collector;
+  {
+    gruel::scoped_lock guard (s_mutex);
+    if (s_fd < 0)
+      return;
+    gruel::atomic_store (&gr_trace_on, false);
+    s_stop_collector = true;
+    s_cond.notify_one ();
+    collector = s_collector;
+    s_collector = 0;
+  }
+
+  collector->join ();
+  delete collector;
+
+  gruel::scoped_lock guard (s_mutex);
+  drain_all ();
+  close (s_fd);
+  s_fd = -1;
+}
+
+void
+gr_trace_start_from_env ()
+{
+  const char *filename = getenv ("GR_TRACE");
+  if (filename && *filename && !gr_trace_enabled ())
+    gr_trace_start (filename);
+}
+
+void
+gr_trace_block_name (long block_id, const std::string &name)
+{
+  gruel::scoped_lock guard (s_mutex);
+  for (size_t i = 0; i < s_names.size (); i++)
+    if (s_names[i].first == block_id)
+      return;
+  s_names.push_back (std::make_pair (block_id, name));
+}
+
+gr_uint64
+gr_trace_ndropped ()
+{
+  gruel::scoped_lock guard (s_mutex);
+  gr_uint64 n = s_ndropped_retired;
+  for (size_t i = 0; i < s_rings.size (); i++)
+    n += s_rings[i]->d_ndropped - s_rings[i]->d_ndropped_base;
+  return n;
+}
+
+gr_uint64
+gr_trace_nwritten ()
+{
+  gruel::scoped_lock guard (s_mutex);
+  return s_nwritten;
+}
@@ -0,0 +1,120 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_TRACE_H
+#define INCLUDED_GR_TRACE_H
+
+#include <gr_types.h>
+#include <string>
+
+/*
+ * Binary event trace for hot-path diagnostics.
+ *
+ * Each thread that logs an event gets its own lock-free ring of
+ * fixed-size records; recording an event is a clock read, a copy of
+ * 32 bytes and a release store.  A collector thread drains all rings
+ * into the trace file a few times per second with one write(2) per
+ * ring.  When a ring is full the event is dropped and counted, the
+ * producer never waits.
+ *
+ * While tracing is off GR_TRACE costs one load and a not-taken branch.
+ * Define GR_TRACE_DISABLED before including this file to compile the
+ * calls out completely.
+ *
+ * Tracing is started by gr_trace_start(), or for any flow graph by
+ * setting the GR_TRACE environment variable to the output filename.
+ * Decode the file with gr_trace_decode.py.
+ *
+ * File layout (host byte order; the header tells which):
+ *
+ *   "GRTRACE1", u32 0x01020304, u32 record size (32)
+ *   sections, each u32 tag, u32 payload length, payload:
+ *     'RECS'  u32 thread index, u32 0, records (see gr_trace_record)
+ *     'NAME'  i64 block id, name (not terminated)
+ *     'DROP'  u32 thread index, u32 0, u64 events dropped so far
+ */
+
+/*!
+ * \brief event ids used by the runtime.  Applications use
+ * GR_TRACE_USER and up.
+ */
+enum gr_trace_event {
+  GR_TRACE_WORK_BEGIN = 1,	// arg0 = noutput_items, arg1 = ninput_items[0]
+  GR_TRACE_WORK_END   = 2,	// arg0 = result of general_work, arg1 = produced
+  GR_TRACE_BLKD_IN    = 3,	// arg0 = input port, arg1 = items required
+  GR_TRACE_BLKD_OUT   = 4,	// arg0 = output_multiple, the fewest items work can make, arg1 = 0
+  GR_TRACE_DONE	      = 5,	// block finished
+  GR_TRACE_WAKE	      = 6,	// arg0 = executor state we had been waiting in
+
+  GR_TRACE_USER	      = 1024
+};
+
+struct gr_trace_record {
+  gr_uint64	timestamp;	// [ns], monotonic clock
+  gr_int32	block_id;	// gr_basic_block::unique_id(), or -1
+  gr_uint32	event;		// gr_trace_event
+  gr_uint64	arg0;
+  gr_uint64	arg1;
+};
+
+extern volatile bool gr_trace_on;
+
+//! true while a trace is being written
+static inline bool gr_trace_enabled() { return gr_trace_on; }
+
+/*!
+ * \brief Start tracing to \p filename.
+ * \param ring_records	per-thread ring size, rounded up to a power of 2
+ * \returns false if the file can't be created or tracing is already on
+ */
+bool gr_trace_start(const std::string &filename, int ring_records = 65536);
+
+//! Stop tracing; drains all rings and closes the file
+void gr_trace_stop();
+
+//! Start tracing if the GR_TRACE environment variable names a file
+void gr_trace_start_from_env();
+
+//! Record one event.  Use the GR_TRACE macro instead.
+void gr_trace_log(long block_id, unsigned int event,
+		  gr_uint64 arg0 = 0, gr_uint64 arg1 = 0);
+
+//! Associate a name with a block id in the trace (cold path)
+void gr_trace_block_name(long block_id, const std::string &name);
+
+//! Events dropped because a ring was full, since the last start
+gr_uint64 gr_trace_ndropped();
+
+//! Events written to the file, since the last start
+gr_uint64 gr_trace_nwritten();
+
+#ifdef GR_TRACE_DISABLED
+#define GR_TRACE(block_id, event, arg0, arg1) do {;} while(0)
+#else
+#define GR_TRACE(block_id, event, arg0, arg1)				\
+  do {									\
+    if (gr_trace_enabled())						\
+      gr_trace_log((block_id), (event), (gr_uint64) (arg0), (gr_uint64) (arg1)); \
+  } while(0)
+#endif
+
+#endif /* INCLUDED_GR_TRACE_H */
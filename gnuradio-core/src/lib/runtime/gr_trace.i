@@ -0,0 +1,51 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+%rename(trace_start) gr_trace_start;
+bool gr_trace_start(const std::string &filename, int ring_records = 65536);
+
+%rename(trace_stop) gr_trace_stop;
+void gr_trace_stop();
+
+%rename(trace_enabled) gr_trace_enabled;
+bool gr_trace_enabled();
+
+%rename(trace_log) gr_trace_log;
+void gr_trace_log(long block_id, unsigned int event,
+		  unsigned long long arg0 = 0, unsigned long long arg1 = 0);
+
+%rename(trace_ndropped) gr_trace_ndropped;
+unsigned long long gr_trace_ndropped();
+
+%rename(trace_nwritten) gr_trace_nwritten;
+unsigned long long gr_trace_nwritten();
+
+enum gr_trace_event {
+  GR_TRACE_WORK_BEGIN = 1,
+  GR_TRACE_WORK_END   = 2,
+  GR_TRACE_BLKD_IN    = 3,
+  GR_TRACE_BLKD_OUT   = 4,
+  GR_TRACE_DONE	      = 5,
+  GR_TRACE_WAKE	      = 6,
+  GR_TRACE_USER	      = 1024
+};
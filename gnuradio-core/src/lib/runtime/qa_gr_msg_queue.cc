@@ -0,0 +1,194 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <qa_gr_msg_queue.h>
+#include <gr_msg_queue.h>
+#include <boost/bind.hpp>
+#include <sys/time.h>
+#include <poll.h>
+#include <stdio.h>
+
+static double
+now ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// each producer sends n messages of type id, arg1 = sequence number
+static void
+producer (gr_msg_queue_sptr q, long id, int n)
+{
+  for (int i = 0; i < n; i++)
+    q->insert_tail (gr_make_message (id, i, 0, 0));
+}
+
+// FIFO order, counts and the non-blocking calls
+void
+qa_gr_msg_queue::t0 ()
+{
+  gr_msg_queue_sptr q = gr_make_msg_queue ();
+
+  CPPUNIT_ASSERT (q->empty_p ());
+  CPPUNIT_ASSERT (q->delete_head_nowait () == 0);
+
+  for (int i = 0; i < 10; i++)
+    q->insert_tail (gr_make_message (i));
+  CPPUNIT_ASSERT_EQUAL (10U, q->count ());
+  CPPUNIT_ASSERT (!q->full_p ());
+
+  for (int i = 0; i < 5; i++)
+    CPPUNIT_ASSERT_EQUAL ((long) i, q->delete_head ()->type ());
+  for (int i = 5; i < 10; i++)
+    CPPUNIT_ASSERT_EQUAL ((long) i, q->delete_head_nowait ()->type ());
+
+  CPPUNIT_ASSERT (q->empty_p ());
+  CPPUNIT_ASSERT (q->delete_head_nowait () == 0);
+
+  // the queue must keep working after it ran dry
+  q->insert_tail (gr_make_message (42));
+  CPPUNIT_ASSERT_EQUAL (42L, q->delete_head ()->type ());
+}
+
+// a message can only be in one queue at a time
+void
+qa_gr_msg_queue::t1 ()
+{
+  gr_msg_queue_sptr q = gr_make_msg_queue ();
+  gr_message_sptr m = gr_make_message (0);
+  q->insert_tail (m);
+  q->insert_tail (m);	// throws std::invalid_argument
+}
+
+// batch removal and flush
+void
+qa_gr_msg_queue::t2 ()
+{
+  gr_msg_queue_sptr q = gr_make_msg_queue ();
+  for (int i = 0; i < 10; i++)
+    q->insert_tail (gr_make_message (i));
+
+  std::vector<gr_message_sptr> v = q->delete_head_batch (4);
+  CPPUNIT_ASSERT_EQUAL ((size_t) 4, v.size ());
+  for (int i = 0; i < 4; i++)
+    CPPUNIT_ASSERT_EQUAL ((long) i, v[i]->type ());
+
+  CPPUNIT_ASSERT_EQUAL (6U, q->delete_head_batch_nowait (v, 100));
+  CPPUNIT_ASSERT_EQUAL ((size_t) 10, v.size ());
+  for (int i = 4; i < 10; i++)
+    CPPUNIT_ASSERT_EQUAL ((long) i, v[i]->type ());
+  CPPUNIT_ASSERT_EQUAL (0U, q->delete_head_batch_nowait (v, 100));
+
+  // removed messages may be queued again
+  for (int i = 0; i < 10; i++)
+    q->insert_tail (v[i]);
+  CPPUNIT_ASSERT_EQUAL (10U, q->count ());
+  q->flush ();
+  CPPUNIT_ASSERT (q->empty_p ());
+}
+
+// a bounded queue blocks the producer until the consumer catches up
+void
+qa_gr_msg_queue::t3 ()
+{
+  const int N = 10000;
+  gr_msg_queue_sptr q = gr_make_msg_queue (4);
+  gruel::thread t (boost::bind (producer, q, 0L, N));
+
+  for (int i = 0; i < N; i++){
+    CPPUNIT_ASSERT (q->count () <= 4);
+    gr_message_sptr m = q->delete_head ();
+    CPPUNIT_ASSERT_EQUAL ((double) i, m->arg1 ());
+  }
+  t.join ();
+  CPPUNIT_ASSERT (q->empty_p ());
+}
+
+// contention: several producers, one consumer draining in batches
+void
+qa_gr_msg_queue::t4 ()
+{
+  const int NPRODUCERS = 4;
+  const int N = 200000;
+  gr_msg_queue_sptr q = gr_make_msg_queue ();
+  std::vector<double> next (NPRODUCERS, 0);
+  int nbatches = 0;
+
+  double t0 = now ();
+  boost::thread_group producers;
+  for (long id = 0; id < NPRODUCERS; id++)
+    producers.create_thread (boost::bind (producer, q, id, N));
+
+  for (int nreceived = 0; nreceived < NPRODUCERS * N; nbatches++){
+    std::vector<gr_message_sptr> v = q->delete_head_batch (256);
+    for (size_t i = 0; i < v.size (); i++){
+      long id = v[i]->type ();
+      CPPUNIT_ASSERT (id >= 0 && id < NPRODUCERS);
+      CPPUNIT_ASSERT_EQUAL (next[id], v[i]->arg1 ());	// per-producer order
+      next[id] += 1;
+    }
+    nreceived += v.size ();
+  }
+  producers.join_all ();
+  double dt = now () - t0;
+
+  CPPUNIT_ASSERT (q->empty_p ());
+  printf ("\nqa_gr_msg_queue: %d producers, %.2f Mmsg/s, %.1f msgs/wakeup\n",
+	  NPRODUCERS, NPRODUCERS * N / dt * 1e-6, (double) NPRODUCERS * N / nbatches);
+}
+
+// wakeup_fd polls readable while messages are queued
+void
+qa_gr_msg_queue::t5 ()
+{
+  gr_msg_queue_sptr q = gr_make_msg_queue ();
+  int fd = q->wakeup_fd ();
+  if (fd < 0)		// no eventfd on this platform
+    return;
+
+  struct pollfd p;
+  p.fd = fd;
+  p.events = POLLIN;
+
+  CPPUNIT_ASSERT_EQUAL (0, poll (&p, 1, 0));
+  q->insert_tail (gr_make_message (1));
+  q->insert_tail (gr_make_message (2));
+  CPPUNIT_ASSERT_EQUAL (1, poll (&p, 1, 0));
+
+  std::vector<gr_message_sptr> v;
+  while (q->delete_head_batch_nowait (v, 1) != 0)
+    ;
+  CPPUNIT_ASSERT_EQUAL ((size_t) 2, v.size ());
+  CPPUNIT_ASSERT_EQUAL (0, poll (&p, 1, 0));
+
+  // a consumer thread sleeping in poll is woken by insert_tail
+  gruel::thread t (boost::bind (producer, q, 3L, 1));
+  CPPUNIT_ASSERT_EQUAL (1, poll (&p, 1, 5000));
+  t.join ();
+  CPPUNIT_ASSERT_EQUAL (3L, q->delete_head_nowait ()->type ());
+  CPPUNIT_ASSERT (q->delete_head_nowait () == 0);
+  CPPUNIT_ASSERT_EQUAL (0, poll (&p, 1, 0));
+}
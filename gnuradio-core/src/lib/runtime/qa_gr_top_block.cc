@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007 Free Software Foundation, Inc.
+ * Copyright 2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,6 +29,9 @@
 #include <gr_head.h>
 #include <gr_null_source.h>
 #include <gr_null_sink.h>
+#include <gr_keep_one_in_n.h>
+#include <boost/thread.hpp>
+#include <climits>
 #include <iostream>
 
 #define VERBOSE 0
@@ -119,3 +122,23 @@ void qa_gr_top_block::t4_reconfigure()
   // Wait for flowgraph to end on its own
   tb->wait();
 }
+
+void qa_gr_top_block::t5_stop_starved()
+{
+  if (VERBOSE) std::cout << "qa_gr_top_block::t5()\n";
+
+  gr_top_block_sptr tb = gr_make_top_block("top");
+
+  // the sink never gets an item, so it stays blocked waiting for input
+  gr_block_sptr src = gr_make_null_source(sizeof(int));
+  gr_block_sptr keep = gr_make_keep_one_in_n(sizeof(int), INT_MAX);
+  gr_block_sptr dst = gr_make_null_sink(sizeof(int));
+
+  tb->connect(src, 0, keep, 0);
+  tb->connect(keep, 0, dst, 0);
+
+  tb->start();
+  boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+  tb->stop();
+  tb->wait();
+}
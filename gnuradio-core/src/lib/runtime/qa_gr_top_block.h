@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007 Free Software Foundation, Inc.
+ * Copyright 2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -36,6 +36,7 @@ class qa_gr_top_block : public CppUnit::TestCase
   CPPUNIT_TEST(t2_start_stop_wait);
   CPPUNIT_TEST(t3_lock_unlock);
   CPPUNIT_TEST(t4_reconfigure);  // triggers 'join never returns' bug
+  CPPUNIT_TEST(t5_stop_starved);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -46,6 +47,7 @@ private:
   void t2_start_stop_wait();
   void t3_lock_unlock();
   void t4_reconfigure();
+  void t5_stop_starved();
 };
 
 #endif /* INCLUDED_QA_GR_TOP_BLOCK_H */
@@ -0,0 +1,187 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <qa_gr_trace.h>
+#include <gr_trace.h>
+#include <gr_tmp_path.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+#include <map>
+#include <string>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+struct parsed_trace {
+  std::vector<std::vector<gr_trace_record> >	records;	// by thread index
+  std::map<gr_int64, std::string>		names;
+  std::map<gr_uint32, gr_uint64>		dropped;	// by thread index
+  gr_uint64					ndropped;	// sum of dropped
+};
+
+static std::string
+tmp_filename ()
+{
+  char name[256];
+  snprintf (name, sizeof (name), "%s/qa_gr_trace.%d", gr_tmp_path (), getpid ());
+  return name;
+}
+
+// minimal version of gr_trace_decode.py
+static bool
+parse (const std::string &filename, parsed_trace &t)
+{
+  FILE *fp = fopen (filename.c_str (), "rb");
+  if (fp == 0)
+    return false;
+
+  t.dropped.clear ();
+  gr_uint32 hdr[4];
+  bool ok = (fread (hdr, sizeof (hdr), 1, fp) == 1
+	     && memcmp (hdr, "GRTRACE1", 8) == 0
+	     && hdr[2] == 0x01020304
+	     && hdr[3] == sizeof (gr_trace_record));
+
+  gr_uint32 sec[2];
+  while (ok && fread (sec, sizeof (sec), 1, fp) == 1){
+    std::vector<char> payload (sec[1]);
+    if (sec[1] > 0 && fread (&payload[0], sec[1], 1, fp) != 1){
+      ok = false;
+      break;
+    }
+    if (memcmp (sec, "RECS", 4) == 0){
+      gr_uint32 thread;
+      memcpy (&thread, &payload[0], 4);
+      if (t.records.size () <= thread)
+	t.records.resize (thread + 1);
+      size_t n = (sec[1] - 8) / sizeof (gr_trace_record);
+      for (size_t i = 0; i < n; i++){
+	gr_trace_record r;
+	memcpy (&r, &payload[8 + i * sizeof (r)], sizeof (r));
+	t.records[thread].push_back (r);
+      }
+    }
+    else if (memcmp (sec, "NAME", 4) == 0){
+      gr_int64 id;
+      memcpy (&id, &payload[0], 8);
+      t.names[id] = std::string (&payload[8], sec[1] - 8);
+    }
+    else if (memcmp (sec, "DROP", 4) == 0){
+      gr_uint32 thread;
+      gr_uint64 n;
+      memcpy (&thread, &payload[0], 4);
+      memcpy (&n, &payload[8], 8);
+      t.dropped[thread] = n;	// cumulative, so the last one counts
+    }
+    else
+      ok = false;
+  }
+  fclose (fp);
+
+  t.ndropped = 0;
+  std::map<gr_uint32, gr_uint64>::const_iterator i;
+  for (i = t.dropped.begin (); i != t.dropped.end (); ++i)
+    t.ndropped += i->second;
+  return ok;
+}
+
+// well clear of the ids of real blocks other tests may have traced
+static const long ID0 = 1000000000;
+
+static void
+logger (long id, int n)
+{
+  for (int i = 0; i < n; i++)
+    GR_TRACE (id, GR_TRACE_USER, i, id);
+}
+
+// everything logged by several threads shows up once and in order
+void
+qa_gr_trace::t0 ()
+{
+  static const int NTHREADS = 3;
+  static const int N = 100000;
+  std::string filename = tmp_filename ();
+
+  GR_TRACE (ID0, GR_TRACE_USER, 0, 0);	// off: goes nowhere
+  CPPUNIT_ASSERT (!gr_trace_enabled ());
+
+  gr_trace_block_name (ID0 + 1, "block one");
+  CPPUNIT_ASSERT (gr_trace_start (filename));
+  CPPUNIT_ASSERT (gr_trace_enabled ());
+  CPPUNIT_ASSERT (!gr_trace_start (filename));	// already on
+  gr_trace_block_name (ID0 + 2, "block two");
+
+  boost::thread_group threads;
+  for (int i = 0; i < NTHREADS; i++)
+    threads.create_thread (boost::bind (logger, ID0 + i + 1, N));
+  threads.join_all ();
+
+  gr_trace_stop ();
+  CPPUNIT_ASSERT (!gr_trace_enabled ());
+  CPPUNIT_ASSERT_EQUAL ((gr_uint64) NTHREADS * N,
+			gr_trace_nwritten () + gr_trace_ndropped ());
+
+  parsed_trace t;
+  CPPUNIT_ASSERT (parse (filename, t));
+  unlink (filename.c_str ());
+
+  CPPUNIT_ASSERT (t.names[ID0 + 1] == "block one");
+  CPPUNIT_ASSERT (t.names[ID0 + 2] == "block two");
+
+  size_t total = 0;
+  for (size_t i = 0; i < t.records.size (); i++){
+    const std::vector<gr_trace_record> &r = t.records[i];
+    for (size_t j = 1; j < r.size (); j++){
+      CPPUNIT_ASSERT_EQUAL (r[0].block_id, r[j].block_id);	// one thread, one id
+      CPPUNIT_ASSERT (r[j].arg0 > r[j-1].arg0);
+      CPPUNIT_ASSERT (r[j].timestamp >= r[j-1].timestamp);
+    }
+    total += r.size ();
+  }
+  CPPUNIT_ASSERT_EQUAL ((size_t) gr_trace_nwritten (), total);
+}
+
+// a full ring drops events and counts them, but never blocks
+void
+qa_gr_trace::t1 ()
+{
+  static const int N = 100000;
+  std::string filename = tmp_filename ();
+
+  CPPUNIT_ASSERT (gr_trace_start (filename, 16));
+  boost::thread t (boost::bind (logger, ID0 + 7, N));	// new thread, new small ring
+  t.join ();
+  gr_trace_stop ();
+
+  CPPUNIT_ASSERT (gr_trace_ndropped () > 0);
+  CPPUNIT_ASSERT_EQUAL ((gr_uint64) N, gr_trace_nwritten () + gr_trace_ndropped ());
+
+  parsed_trace p;
+  CPPUNIT_ASSERT (parse (filename, p));
+  unlink (filename.c_str ());
+  CPPUNIT_ASSERT_EQUAL (gr_trace_ndropped (), p.ndropped);
+}
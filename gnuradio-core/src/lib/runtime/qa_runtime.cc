@@ -38,6 +38,8 @@
 #include <qa_gr_hier_block2.h>
 #include <qa_gr_hier_block2_derived.h>
 #include <qa_gr_buffer.h>
+#include <qa_gr_msg_queue.h>
+#include <qa_gr_trace.h>
 
 CppUnit::TestSuite *
 qa_runtime::suite ()
@@ -52,6 +54,8 @@ qa_runtime::suite ()
   s->addTest (qa_gr_hier_block2::suite ());
   s->addTest (qa_gr_hier_block2_derived::suite ());
   s->addTest (qa_gr_buffer::suite ());
+  s->addTest (qa_gr_msg_queue::suite ());
+  s->addTest (qa_gr_trace::suite ());
   
   return s;
 }
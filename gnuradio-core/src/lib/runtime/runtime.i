@@ -29,6 +29,7 @@
 #include <gr_hier_block2.h>
 #include <gr_single_threaded_scheduler.h>
 #include <gr_message.h>
+#include <gr_message_pool.h>
 #include <gr_msg_handler.h>
 #include <gr_msg_queue.h>
 #include <gr_dispatcher.h>
@@ -38,6 +39,7 @@
 #include <gr_sync_decimator.h>
 #include <gr_sync_interpolator.h>
 #include <gr_top_block.h>
+#include <gr_trace.h>
 %}
 
 %include <gr_io_signature.i>
@@ -58,3 +60,4 @@
 %include <gr_sync_decimator.i>
 %include <gr_sync_interpolator.i>
 %include <gr_top_block.i>
+%include <gr_trace.i>
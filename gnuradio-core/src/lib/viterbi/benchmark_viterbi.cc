@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Decode the same noisy K=7 r=1/2 stream with the original and the
+ * structure-of-arrays decoders.  Reports decoded bits per second for
+ * each and the bit error rate at several Eb/N0.  qa_viterbi checks
+ * that the two decoders agree.
+ */
+
+extern "C" {
+#include "viterbi.h"
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sys/time.h>
+#include <vector>
+
+#define NBYTES		(64 * 1024)
+#define NSYMS		(NBYTES * 16)
+#define DELAY		4		// output lags input by four bytes
+
+static double
+now ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static double
+gaussian ()
+{
+  double u1 = (random () + 1.0) / (RAND_MAX + 2.0);
+  double u2 = (random () + 1.0) / (RAND_MAX + 2.0);
+  return sqrt (-2 * log (u1)) * cos (2 * M_PI * u2);
+}
+
+static double
+decode_generic (int mettab[2][256], const unsigned char *syms, unsigned char *out)
+{
+  struct viterbi_state state0[64];
+  struct viterbi_state state1[64];
+  double start = now ();
+
+  viterbi_chunks_init (state0);
+  for (int i = 0; i < NSYMS; i += 4){
+    viterbi_butterfly2 ((unsigned char *) &syms[i], mettab, state0, state1);
+    if (i % 16 == 8)
+      viterbi_get_output (state0, out++);
+  }
+  return now () - start;
+}
+
+static double
+decode_soa (int mettab[2][256], const unsigned char *syms, unsigned char *out)
+{
+  struct viterbi_soa_state state0;
+  struct viterbi_soa_state state1;
+  double start = now ();
+
+  viterbi_chunks_init_soa (&state0);
+  for (int i = 0; i < NSYMS; i += 4){
+    viterbi_butterfly2_soa ((unsigned char *) &syms[i], mettab, &state0, &state1);
+    if (i % 16 == 8)
+      viterbi_get_output_soa (&state0, out++);
+  }
+  return now () - start;
+}
+
+int main ()
+{
+  static const double ebn0_db[] = { 2.0, 3.0, 4.0, 5.0, 6.0 };
+  int amp = 100;
+  int mettab[2][256];
+  std::vector<unsigned char> data (NBYTES);
+  std::vector<unsigned char> enc (NSYMS);
+  std::vector<unsigned char> syms (NSYMS);
+  std::vector<unsigned char> out_generic (NBYTES);
+  std::vector<unsigned char> out_soa (NBYTES);
+
+  srandom (0);
+  for (int i = 0; i < NBYTES; i++)
+    data[i] = random () & 0xff;
+  encode (&enc[0], &data[0], NBYTES, 0);
+
+  for (unsigned e = 0; e < sizeof (ebn0_db) / sizeof (ebn0_db[0]); e++){
+    float esn0 = 0.5 * pow (10.0, ebn0_db[e] / 10);
+    double sigma = amp / sqrt (2 * esn0);
+
+    gen_met (mettab, amp, esn0, 0.0, 256);
+
+    for (int i = 0; i < NSYMS; i++){
+      double s = 128 + (enc[i] ? amp : -amp) + sigma * gaussian ();
+      syms[i] = s < 0 ? 0 : s > 255 ? 255 : (unsigned char) s;
+    }
+
+    double t_generic = decode_generic (mettab, &syms[0], &out_generic[0]);
+    double t_soa = decode_soa (mettab, &syms[0], &out_soa[0]);
+
+    int nout = NSYMS / 16;
+    int errors = 0;
+    for (int i = DELAY; i < nout; i++)
+      errors += __builtin_popcount (out_soa[i] ^ data[i - DELAY]);
+
+    printf ("Eb/N0 %.1f dB  BER %.2e  generic %6.2f Mb/s  soa %6.2f Mb/s\n",
+	    ebn0_db[e], (double) errors / (8.0 * (nout - DELAY)),
+	    8e-6 * nout / t_generic, 8e-6 * nout / t_soa);
+  }
+
+  return 0;
+}
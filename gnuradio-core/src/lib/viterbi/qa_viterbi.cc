@@ -0,0 +1,137 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Check that the structure-of-arrays decoder makes exactly the same
+ * decisions as the original one, on a clean stream and on noisy ones
+ * from well below to well above the coding threshold.
+ */
+
+extern "C" {
+#include "viterbi.h"
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#define NBYTES		(16 * 1024)
+#define NSYMS		(NBYTES * 16)
+#define DELAY		4		// output lags input by four bytes
+
+static double
+gaussian ()
+{
+  double u1 = (random () + 1.0) / (RAND_MAX + 2.0);
+  double u2 = (random () + 1.0) / (RAND_MAX + 2.0);
+  return sqrt (-2 * log (u1)) * cos (2 * M_PI * u2);
+}
+
+static void
+decode_generic (int mettab[2][256], const unsigned char *syms, unsigned char *out)
+{
+  struct viterbi_state state0[64];
+  struct viterbi_state state1[64];
+
+  viterbi_chunks_init (state0);
+  for (int i = 0; i < NSYMS; i += 4){
+    viterbi_butterfly2 ((unsigned char *) &syms[i], mettab, state0, state1);
+    if (i % 16 == 8)
+      viterbi_get_output (state0, out++);
+  }
+}
+
+static void
+decode_soa (int mettab[2][256], const unsigned char *syms, unsigned char *out)
+{
+  struct viterbi_soa_state state0;
+  struct viterbi_soa_state state1;
+
+  viterbi_chunks_init_soa (&state0);
+  for (int i = 0; i < NSYMS; i += 4){
+    viterbi_butterfly2_soa ((unsigned char *) &syms[i], mettab, &state0, &state1);
+    if (i % 16 == 8)
+      viterbi_get_output_soa (&state0, out++);
+  }
+}
+
+// Decode enc at ebn0_db with both decoders, with noise or without.
+// Returns true if they agree (and, when clean, get data back).
+static bool
+check (const std::vector<unsigned char> &data,
+       const std::vector<unsigned char> &enc, double ebn0_db, bool noisy)
+{
+  int amp = 100;
+  int mettab[2][256];
+  std::vector<unsigned char> syms (NSYMS);
+  std::vector<unsigned char> out_generic (NBYTES);
+  std::vector<unsigned char> out_soa (NBYTES);
+  int nout = NSYMS / 16;
+  bool ok = true;
+
+  float esn0 = 0.5 * pow (10.0, ebn0_db / 10);
+  double sigma = noisy ? amp / sqrt (2 * esn0) : 0;
+
+  gen_met (mettab, amp, esn0, 0.0, 256);
+
+  for (int i = 0; i < NSYMS; i++){
+    double s = 128 + (enc[i] ? amp : -amp) + sigma * gaussian ();
+    syms[i] = s < 0 ? 0 : s > 255 ? 255 : (unsigned char) s;
+  }
+
+  decode_generic (mettab, &syms[0], &out_generic[0]);
+  decode_soa (mettab, &syms[0], &out_soa[0]);
+
+  if (memcmp (&out_generic[0], &out_soa[0], nout) != 0){
+    fprintf (stderr, "Eb/N0 %.1f dB%s: generic and soa decoders disagree\n",
+	     ebn0_db, noisy ? "" : " (no noise)");
+    ok = false;
+  }
+
+  if (!noisy && memcmp (&out_soa[DELAY], &data[0], nout - DELAY) != 0){
+    fprintf (stderr, "noiseless stream decoded with errors\n");
+    ok = false;
+  }
+
+  return ok;
+}
+
+int main ()
+{
+  static const double ebn0_db[] = { 0.0, 2.0, 4.0, 6.0 };
+  std::vector<unsigned char> data (NBYTES);
+  std::vector<unsigned char> enc (NSYMS);
+  bool ok = true;
+
+  srandom (0);
+  for (int i = 0; i < NBYTES; i++)
+    data[i] = random () & 0xff;
+  encode (&enc[0], &data[0], NBYTES, 0);
+
+  ok &= check (data, enc, 6.0, false);
+  for (unsigned e = 0; e < sizeof (ebn0_db) / sizeof (ebn0_db[0]); e++)
+    ok &= check (data, enc, ebn0_db[e], true);
+
+  return ok ? 0 : 1;
+}
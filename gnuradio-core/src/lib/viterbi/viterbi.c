@@ -353,3 +353,118 @@ viterbi_get_output(struct viterbi_state *state, unsigned char *outbuf) {
 //  for(i=1;i<64;i += 2)
 //    state[i].metric = -9999999;
 
+
+
+/* Branch metric selector of butterfly i, as passed to the BUTTERFLY
+ * macro calls above (generated by genbut.c)
+ */
+static const unsigned char Butsym[32] = {
+  0, 1, 3, 2, 3, 2, 0, 1, 0, 1, 3, 2, 3, 2, 0, 1,
+  2, 3, 1, 0, 1, 0, 2, 3, 2, 3, 1, 0, 1, 0, 2, 3
+};
+
+void
+viterbi_chunks_init_soa(struct viterbi_soa_state *state)
+{
+  /* Initialize starting metrics to prefer 0 state */
+  int i;
+  for(i=0;i<64;i++){
+    state->path[i] = 0;
+    state->metric[i] = -999999;
+  }
+  state->metric[0] = 0;
+}
+
+/* One trellis step.  The 32 butterflies are independent and written
+ * without data dependent branches, so the compiler can evaluate them
+ * with packed compares and selects instead of 64 unpredictable jumps.
+ * Survivors for the even and odd successor states are computed into
+ * contiguous lanes first and interleaved afterwards.
+ */
+static void
+acs_soa(const int mets[4], const struct viterbi_soa_state *state,
+	struct viterbi_soa_state *next)
+{
+  int bm0[32], bm1[32];
+  int em[32], om[32];
+  unsigned int ep[32], op[32];
+  int i;
+
+  for(i=0;i<32;i++){
+    bm0[i] = mets[Butsym[i]];
+    bm1[i] = mets[3^Butsym[i]];
+  }
+
+  for(i=0;i<32;i++){
+    int lo = state->metric[i];
+    int hi = state->metric[i+32];
+    unsigned int plo = state->path[i] << 1;
+    unsigned int phi = (state->path[i+32] << 1) | 1;
+    int m0, m1;
+
+    /* ACS for 0 branch */
+    m0 = lo + bm0[i];
+    m1 = hi + bm1[i];
+    em[i] = m0 > m1 ? m0 : m1;
+    ep[i] = m0 > m1 ? plo : phi;
+
+    /* ACS for 1 branch */
+    m0 = lo + bm1[i];
+    m1 = hi + bm0[i];
+    om[i] = m0 > m1 ? m0 : m1;
+    op[i] = m0 > m1 ? plo : phi;
+  }
+
+  for(i=0;i<32;i++){
+    next->metric[2*i] = em[i];
+    next->metric[2*i+1] = om[i];
+    next->path[2*i] = ep[i];
+    next->path[2*i+1] = op[i];
+  }
+}
+
+void
+viterbi_butterfly2_soa(unsigned char *symbols, int mettab[2][256],
+		       struct viterbi_soa_state *state0,
+		       struct viterbi_soa_state *state1)
+{
+  int mets[4];
+
+  /* Operate on 4 symbols (2 bits) at a time, ending up back in state0 */
+  mets[0] = mettab[0][symbols[0]] + mettab[0][symbols[1]];
+  mets[1] = mettab[0][symbols[0]] + mettab[1][symbols[1]];
+  mets[2] = mettab[1][symbols[0]] + mettab[0][symbols[1]];
+  mets[3] = mettab[1][symbols[0]] + mettab[1][symbols[1]];
+  acs_soa(mets, state0, state1);
+
+  mets[0] = mettab[0][symbols[2]] + mettab[0][symbols[3]];
+  mets[1] = mettab[0][symbols[2]] + mettab[1][symbols[3]];
+  mets[2] = mettab[1][symbols[2]] + mettab[0][symbols[3]];
+  mets[3] = mettab[1][symbols[2]] + mettab[1][symbols[3]];
+  acs_soa(mets, state1, state0);
+}
+
+int
+viterbi_get_output_soa(struct viterbi_soa_state *state, unsigned char *outbuf)
+{
+  unsigned int i,beststate;
+  int bestmetric;
+
+  /* Find current best path; ties go to the lowest state as above */
+  bestmetric = state->metric[0];
+  beststate = 0;
+  for(i=1;i<64;i++)
+    if(state->metric[i] > bestmetric){
+      bestmetric = state->metric[i];
+      beststate = i;
+    }
+  *outbuf = state->path[beststate] >> 24;
+
+  /* Renormalize so the best metric is 0.  The spread between states is
+   * bounded, so the metrics can no longer drift out of range.
+   */
+  for(i=0;i<64;i++)
+    state->metric[i] -= bestmetric;
+
+  return bestmetric;
+}
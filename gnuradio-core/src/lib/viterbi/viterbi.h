@@ -47,3 +47,26 @@ viterbi_butterfly2(unsigned char *symbols, int mettab[2][256],
 
 unsigned char
 viterbi_get_output(struct viterbi_state *state, unsigned char *outbuf);
+
+/* Structure-of-arrays variant of the decoder state used by the
+ * branch free add-compare-select in viterbi_butterfly2_soa().  Metrics
+ * are renormalized on every viterbi_get_output_soa() so they stay in
+ * 32 bits; since the same offset is removed from every state the
+ * decisions, and therefore the decoded bits, are identical to the
+ * viterbi_state version.
+ */
+struct viterbi_soa_state {
+  unsigned int path[64];	/* Decoded path to each state */
+  int metric[64];		/* Cumulative metric to each state */
+};
+
+void
+viterbi_chunks_init_soa(struct viterbi_soa_state *state);
+
+void
+viterbi_butterfly2_soa(unsigned char *symbols, int mettab[2][256],
+		       struct viterbi_soa_state *state0,
+		       struct viterbi_soa_state *state1);
+
+int
+viterbi_get_output_soa(struct viterbi_soa_state *state, unsigned char *outbuf);
@@ -22,6 +22,7 @@
 
 from gnuradio import gr, gr_unittest
 import math
+import random
 
 test_output = False
 
@@ -411,6 +412,26 @@ class test_sig_source (gr_unittest.TestCase):
         self.assertComplexTuplesAlmostEqual (expected_result, dst_data, 4)
 
 
+    def test_006(self):
+        ''' Test the complex AGC loop with block-wise gain updates '''
+        tb = self.tb
+
+        sampling_freq = 100
+        src1 = gr.sig_source_c (sampling_freq, gr.GR_SIN_WAVE,
+                                sampling_freq * 0.10, 100.0)
+        dst1 = gr.vector_sink_c ()
+        head = gr.head (gr.sizeof_gr_complex, 4096)
+
+        agc = gr.agc_cc(1e-3, 1, 1, 1000)
+        agc.set_update_period(16)
+        self.assertEqual(16, agc.update_period())
+
+        tb.connect (src1, head, agc, dst1)
+        tb.run ()
+        dst_data = dst1.data ()
+        for x in dst_data[-256:]:
+            self.assertAlmostEqual (1.0, abs(x), 2)
+
     def test_100(self):        # FIXME needs work
         ''' Test complex feedforward agc with constant input '''
         input_data = 16*(0.0,) + 64*(1.0,) + 64*(0.0,)
@@ -428,6 +449,32 @@ class test_sig_source (gr_unittest.TestCase):
         dst_data = dst.data ()
         #self.assertComplexTuplesAlmostEqual (expected_result, dst_data, 4)
 
+    def test_101(self):
+        ''' Compare complex feedforward agc against a rescanning reference '''
+        def envelope(x):
+            r_abs = abs(x.real)
+            i_abs = abs(x.imag)
+            if r_abs > i_abs:
+                return r_abs + 0.4 * i_abs
+            return i_abs + 0.4 * r_abs
+
+        random.seed(0)
+        nsamples = 23
+        input_data = [complex(random.uniform(-1, 1), random.uniform(-1, 1)) *
+                      random.choice((0.1, 1.0, 10.0)) for i in range(2000)]
+        padded = (nsamples - 1) * [0j] + input_data
+        expected_result = []
+        for i in range(len(input_data)):
+            max_env = max([1e-4] + [envelope(x) for x in padded[i:i+nsamples]])
+            expected_result.append(padded[i] * 2.0 / max_env)
+
+        src = gr.vector_source_c(input_data)
+        agc = gr.feedforward_agc_cc(nsamples, 2.0)
+        dst = gr.vector_sink_c ()
+        self.tb.connect (src, agc, dst)
+        self.tb.run ()
+        self.assertComplexTuplesAlmostEqual (expected_result, dst.data (), 4)
+
 
 if __name__ == '__main__':
     gr_unittest.main ()
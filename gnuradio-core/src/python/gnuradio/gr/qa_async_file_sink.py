@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest
+import os
+import tempfile
+
+class test_async_file_sink (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+        self.src_data = [int(x) for x in range(200000)]
+        fd, self.filename = tempfile.mkstemp ()
+        os.close (fd)
+
+    def tearDown (self):
+        self.tb = None
+        os.unlink (self.filename)
+
+    def read_file (self, filename):
+        tb = gr.top_block ()
+        dst = gr.vector_sink_i ()
+        tb.connect (gr.file_source (gr.sizeof_int, filename), dst)
+        tb.run ()
+        return dst.data ()
+
+    def test_001_write (self):
+        snk = gr.async_file_sink (gr.sizeof_int, self.filename, False, False,
+                                  64 * 1024, 3)
+        snk.set_preallocate (4 * 1024 * 1024)
+        self.tb.connect (gr.vector_source_i (self.src_data), snk)
+        self.tb.run ()
+        self.assertEqual (len(self.src_data) * gr.sizeof_int, snk.nbytes_written ())
+        self.assertEqual (0, snk.nbytes_dropped ())
+        self.assertEqual (0, snk.noverruns ())
+        snk = None
+        self.assertEqual (tuple(self.src_data), self.read_file (self.filename))
+
+    def test_002_rotate (self):
+        nbytes = 300000		# a whole number of items
+        snk = gr.async_file_sink (gr.sizeof_int, self.filename, False, False,
+                                  64 * 1024, 3)
+        snk.set_rotation (nbytes)
+        self.tb.connect (gr.vector_source_i (self.src_data), snk)
+        self.tb.run ()
+        nfiles = snk.nfiles ()
+        self.assertEqual (3, nfiles)
+        snk = None
+
+        result = self.read_file (self.filename)
+        self.assertEqual (nbytes / gr.sizeof_int, len(result))
+        for i in range(1, nfiles):
+            name = '%s.%04d' % (self.filename, i)
+            result += self.read_file (name)
+            os.unlink (name)
+        self.assertEqual (tuple(self.src_data), result)
+
+    def test_003_drop (self):
+        # small buffers, so the writer may well fall behind
+        snk = gr.async_file_sink (gr.sizeof_int, self.filename, True, False,
+                                  4096, 2)
+        self.tb.connect (gr.vector_source_i (self.src_data), snk)
+        self.tb.run ()
+        written = snk.nbytes_written ()
+        self.assertEqual (len(self.src_data) * gr.sizeof_int,
+                          written + snk.nbytes_dropped ())
+        self.assertEqual (snk.noverruns () == 0, snk.nbytes_dropped () == 0)
+        snk = None
+
+        # whatever was kept is whole items, in order
+        result = self.read_file (self.filename)
+        self.assertEqual (written, len(result) * gr.sizeof_int)
+        for i in range(1, len(result)):
+            self.assert_(result[i-1] < result[i])
+
+    def test_004_direct (self):
+        # 800000 bytes: whole pages go O_DIRECT, the tail through the cache
+        snk = gr.async_file_sink (gr.sizeof_int, self.filename, False, True,
+                                  64 * 1024, 3)
+        self.tb.connect (gr.vector_source_i (self.src_data), snk)
+        self.tb.run ()
+        self.assertEqual (len(self.src_data) * gr.sizeof_int, snk.nbytes_written ())
+        self.assertEqual (0, snk.nerrors ())
+        snk = None
+        self.assertEqual (tuple(self.src_data), self.read_file (self.filename))
+
+
+if __name__ == '__main__':
+    gr_unittest.main ()
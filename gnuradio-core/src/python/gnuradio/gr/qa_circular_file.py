@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest
+import os
+import tempfile
+
+class test_circular_file (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+        fd, self.filename = tempfile.mkstemp ()
+        os.close (fd)
+
+    def tearDown (self):
+        self.tb = None
+        os.unlink (self.filename)
+
+    def read_window (self, start_time, duration):
+        tb = gr.top_block ()
+        src = gr.circular_file_source (self.filename, start_time, duration)
+        dst = gr.vector_sink_i ()
+        tb.connect (src, dst)
+        tb.run ()
+        return src, dst.data ()
+
+    def test_001_window (self):
+        # 1000 items/s, keep the last 50 s of 100 s
+        src_data = tuple(range(100000))
+        snk = gr.circular_file_sink (gr.sizeof_int, self.filename, 1000, 50, 1000.0)
+        self.tb.connect (gr.vector_source_i (src_data), snk)
+        self.tb.run ()
+        self.assertEqual (50000, snk.capacity ())
+        self.assertEqual (100000, snk.nitems_written ())
+        self.assertEqual (1000.0, snk.start_time ())
+
+        src, result = self.read_window (1060.0, 10.0)
+        self.assertEqual (src_data[60000:70000], result)
+        self.assertEqual (60000, src.first_item ())
+
+        # the first 10 s of this window have been overwritten
+        src, result = self.read_window (1040.0, 20.0)
+        self.assertEqual (src_data[50000:60000], result)
+        self.assertEqual (40000, src.window_start ())
+        self.assertEqual (50000, src.first_item ())
+
+
+if __name__ == '__main__':
+    gr_unittest.main ()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest
+import os
+import tempfile
+
+class test_file_source (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+        self.src_data = [int(x) for x in range(100000)]
+        fd, self.filename = tempfile.mkstemp ()
+        os.close (fd)
+        snk = gr.file_sink (gr.sizeof_int, self.filename)
+        tb = gr.top_block ()
+        tb.connect (gr.vector_source_i (self.src_data), snk)
+        tb.run ()
+        snk.close ()
+
+    def tearDown (self):
+        self.tb = None
+        os.unlink (self.filename)
+
+    def read (self, src, nitems=None):
+        dst = gr.vector_sink_i ()
+        if nitems is None:
+            self.tb.connect (src, dst)
+        else:
+            self.tb.connect (src, gr.head (gr.sizeof_int, nitems), dst)
+        self.tb.run ()
+        return dst.data ()
+
+    def test_001_stdio (self):
+        src = gr.file_source (gr.sizeof_int, self.filename, False, False)
+        self.assertFalse (src.mmapped ())
+        self.assertEqual (tuple(self.src_data), self.read (src))
+
+    def test_002_mmap (self):
+        src = gr.file_source (gr.sizeof_int, self.filename, False, True)
+        self.assertTrue (src.mmapped ())
+        self.assertEqual (tuple(self.src_data), self.read (src))
+
+    def test_003_range_repeat (self):
+        for use_mmap in (False, True):
+            self.tb = gr.top_block ()
+            src = gr.file_source (gr.sizeof_int, self.filename, True, use_mmap)
+            self.assertTrue (src.set_range (1000, 300))
+            expected_result = tuple(self.src_data[1000:1300] * 4)
+            self.assertEqual (expected_result, self.read (src, 1200))
+
+    def test_004_seek (self):
+        for use_mmap in (False, True):
+            self.tb = gr.top_block ()
+            src = gr.file_source (gr.sizeof_int, self.filename, False, use_mmap)
+            self.assertTrue (src.seek (-500, gr.SEEK_END))
+            self.assertEqual (tuple(self.src_data[-500:]), self.read (src))
+
+    def test_005_seek_outside_range (self):
+        src = gr.file_source (gr.sizeof_int, self.filename, False, True)
+        self.assertTrue (src.set_range (1000, 300))
+        self.assertFalse (src.seek (999, gr.SEEK_SET))
+        self.assertFalse (src.seek (1301, gr.SEEK_SET))
+        self.assertTrue (src.seek (1200, gr.SEEK_SET))
+        self.assertEqual (tuple(self.src_data[1200:1300]), self.read (src))
+
+
+if __name__ == '__main__':
+    gr_unittest.main ()
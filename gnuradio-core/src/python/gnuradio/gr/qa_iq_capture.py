@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest
+import os
+import struct
+import tempfile
+
+class test_iq_capture (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.tb = gr.top_block ()
+        fd, self.filename = tempfile.mkstemp ()
+        os.close (fd)
+        # slowly varying I/Q with a little noise, about 12 bits wide
+        self.src_data = []
+        x = 0
+        for i in range(100003):
+            x = (x + 37 + (i * 7919) % 13) % 4096 - 2048
+            self.src_data += [x, -x]
+
+    def tearDown (self):
+        self.tb = None
+        os.unlink (self.filename)
+
+    def write (self, compress):
+        snk = gr.iq_capture_sink (gr.GRI_IQ_COMPLEX_SHORT, self.filename,
+                                  10e6, 915e6, 1234.5, compress, 4096)
+        self.tb.connect (gr.vector_source_s (self.src_data, False, 2), snk)
+        self.tb.run ()
+        snk.close ()
+        self.assertEqual (len(self.src_data) / 2, snk.nitems ())
+        return snk.nbytes ()
+
+    def read (self, src):
+        tb = gr.top_block ()
+        dst = gr.vector_sink_s (2)
+        tb.connect (src, dst)
+        tb.run ()
+        return dst.data ()
+
+    def test_001_roundtrip (self):
+        nbytes = self.write (True)
+        self.assertTrue (nbytes < len(self.src_data) * 2)
+        src = gr.iq_capture_source (self.filename)
+        self.assertEqual (gr.GRI_IQ_COMPLEX_SHORT, src.item_type ())
+        self.assertEqual (10e6, src.sample_rate ())
+        self.assertEqual (915e6, src.center_freq ())
+        self.assertEqual (1234.5, src.start_time ())
+        self.assertTrue (src.compressed ())
+        self.assertEqual (len(self.src_data) / 2, src.nitems ())
+        self.assertEqual (tuple(self.src_data), self.read (src))
+
+    def test_002_raw (self):
+        self.write (False)
+        src = gr.iq_capture_source (self.filename, False, 0)
+        self.assertFalse (src.compressed ())
+        self.assertEqual (tuple(self.src_data), self.read (src))
+
+    def test_003_seek (self):
+        self.write (True)
+        src = gr.iq_capture_source (self.filename)
+        self.assertTrue (src.seek (50001))
+        self.assertFalse (src.seek (src.nitems () + 1))
+        self.assertEqual (tuple(self.src_data[2*50001:]), self.read (src))
+
+    def test_004_truncated (self):
+        nbytes = self.write (True)
+        # lose the index and the end of the last (short) chunk
+        f = open (self.filename, 'r+b')
+        f.truncate (nbytes - 1)
+        f.close ()
+        src = gr.iq_capture_source (self.filename)
+        n = (len(self.src_data) / 2) // 4096 * 4096
+        self.assertEqual (n, src.nitems ())
+        self.assertEqual (tuple(self.src_data[:2*n]), self.read (src))
+
+    def test_005_bad_index (self):
+        self.write (True)
+        # an nchunks the index can't hold: rebuild instead of trusting it
+        f = open (self.filename, 'r+b')
+        f.seek (64)
+        f.write (struct.pack ('<Q', 1 << 62))
+        f.close ()
+        src = gr.iq_capture_source (self.filename)
+        self.assertEqual (len(self.src_data) / 2, src.nitems ())
+        self.assertEqual (tuple(self.src_data), self.read (src))
+
+    def test_006_write_error (self):
+        if not os.path.exists ('/dev/full'):
+            return
+        snk = gr.iq_capture_sink (gr.GRI_IQ_COMPLEX_SHORT, '/dev/full',
+                                  10e6, 915e6, 1234.5, False, 4096)
+        self.tb.connect (gr.vector_source_s (self.src_data, False, 2), snk)
+        self.tb.run ()			# stops at the first failed write
+        snk.close ()
+        self.assertTrue (snk.failed ())
+        self.assertEqual (0, snk.nitems ())
+
+
+if __name__ == '__main__':
+    gr_unittest.main ()
@@ -1,6 +1,6 @@
 #!/usr/bin/env python
 #
-# Copyright 2004 Free Software Foundation, Inc.
+# Copyright 2004,2010 Free Software Foundation, Inc.
 # 
 # This file is part of GNU Radio
 # 
@@ -89,6 +89,18 @@ class test_message (gr_unittest.TestCase):
         # global msg
         msg = gr.message (666)
 
+    def test_203 (self):
+        self.leak_check (self.body_203)
+
+    def body_203 (self):
+        for i in range (5):
+            self.msgq.insert_tail (gr.message (i))
+        msgs = self.msgq.delete_head_batch (3)
+        self.assertEquals ((0, 1, 2), tuple ([m.type() for m in msgs]))
+        msgs = self.msgq.delete_head_batch (100)
+        self.assertEquals ((3, 4), tuple ([m.type() for m in msgs]))
+        self.assertEquals (0, self.msgq.count())
+
     def test_300(self):
         input_data = (0,1,2,3,4,5,6,7,8,9)
         src = gr.vector_source_b(input_data)
@@ -127,5 +139,32 @@ class test_message (gr_unittest.TestCase):
         tb.run()
         self.assertEquals(tuple(map(ord, '0123456789')), dst.data())
 
+    def test_303(self):
+        # zero copy sink: payloads reference the flow graph buffer
+        input_data = tuple([i & 0xff for i in range(10000)])
+        msgq = gr.msg_queue()
+        src = gr.vector_source_b(input_data)
+        dst = gr.message_sink(gr.sizeof_char, msgq, False, True)
+        tb = gr.top_block()
+        tb.connect(src, dst)
+        tb.run()
+        data = ''
+        while not msgq.empty_p():
+            msg = msgq.delete_head()
+            self.assertEquals(msg.length(), int(msg.arg2()))
+            data += msg.to_string()
+        self.assertEquals(input_data, tuple(map(ord, data)))
+
+    def test_400(self):
+        # payload buffers are recycled through the message pool
+        msg = gr.message_from_string('x' * 100)
+        del msg
+        nhits = gr.message_pool_nhits()
+        msg = gr.message_from_string('y' * 90)
+        self.assertEquals('y' * 90, msg.to_string())
+        self.assertEquals(90, msg.length())
+        self.assert_(gr.message_pool_nhits() > nhits)
+        del msg
+
 if __name__ == '__main__':
     gr_unittest.main ()
@@ -23,6 +23,38 @@
 from gnuradio import gr, gr_unittest
 import random
 
+def ref_packed_to_unpacked(data, k, endianness):
+    bits = []
+    for b in data:
+        for i in range(8):
+            if endianness == gr.GR_MSB_FIRST:
+                bits.append((b >> (7 - i)) & 1)
+            else:
+                bits.append((b >> i) & 1)
+    result = []
+    for c in range(len(bits) // k):
+        x = 0
+        for j in range(k):
+            x = (x << 1) | bits[c * k + j]
+        result.append(x)
+    return tuple(result)
+
+def ref_unpacked_to_packed(data, k, endianness):
+    bits = []
+    for x in data:
+        for j in range(k - 1, -1, -1):
+            bits.append((x >> j) & 1)
+    result = []
+    for i in range(len(bits) // 8):
+        b = 0
+        for j in range(8):
+            if endianness == gr.GR_MSB_FIRST:
+                b = (b << 1) | bits[8 * i + j]
+            else:
+                b = b | (bits[8 * i + j] << j)
+        result.append(b)
+    return tuple(result)
+
 class test_packing(gr_unittest.TestCase):
 
     def setUp(self):
@@ -399,6 +431,55 @@ class test_packing(gr_unittest.TestCase):
         self.tb.run()
         self.assertEqual(expected_results, dst.data())
 
+    def test_300(self):
+        """
+        compare the table driven paths with the bit-at-a-time reference
+        for all chunk sizes and random lengths
+        """
+        random.seed(0)
+        for endianness in (gr.GR_MSB_FIRST, gr.GR_LSB_FIRST):
+            for k in range(1, 9):
+                n = random.randint(1, 3000)
+                src_data = tuple([random.randint(0, 255) for i in xrange(n)])
+                expected_results = ref_packed_to_unpacked(src_data, k, endianness)
+                tb = gr.top_block()
+                src = gr.vector_source_b(src_data, False)
+                op = gr.packed_to_unpacked_bb(k, endianness)
+                dst = gr.vector_sink_b()
+                tb.connect(src, op, dst)
+                tb.run()
+                self.assertEqual(expected_results, dst.data())
+
+    def test_301(self):
+        random.seed(0)
+        for endianness in (gr.GR_MSB_FIRST, gr.GR_LSB_FIRST):
+            for k in range(1, 9):
+                n = random.randint(1, 3000)
+                src_data = tuple([random.randint(0, 255) for i in xrange(n)])
+                expected_results = ref_unpacked_to_packed(src_data, k, endianness)
+                tb = gr.top_block()
+                src = gr.vector_source_b(src_data, False)
+                op = gr.unpacked_to_packed_bb(k, endianness)
+                dst = gr.vector_sink_b()
+                tb.connect(src, op, dst)
+                tb.run()
+                self.assertEqual(expected_results, dst.data())
+
+    def test_302(self):
+        random.seed(0)
+        for endianness in (gr.GR_MSB_FIRST, gr.GR_LSB_FIRST):
+            for k in (1, 2, 4, 8):
+                src_data = tuple([random.randint(-2**15, 2**15-1)
+                                  for i in xrange(random.randint(1, 1000))])
+                tb = gr.top_block()
+                src = gr.vector_source_s(src_data, False)
+                op1 = gr.packed_to_unpacked_ss(k, endianness)
+                op2 = gr.unpacked_to_packed_ss(k, endianness)
+                dst = gr.vector_sink_s()
+                tb.connect(src, op1, op2, dst)
+                tb.run()
+                self.assertEqual(src_data, dst.data())
+
 
 if __name__ == '__main__':
    gr_unittest.main ()
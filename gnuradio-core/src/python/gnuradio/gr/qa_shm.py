@@ -0,0 +1,75 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+from gnuradio import gr, gr_unittest
+import os
+
+class test_shm (gr_unittest.TestCase):
+
+    def setUp (self):
+        self.name = "qa_shm-%d" % (os.getpid (),)
+
+    def read_all (self, src):
+        tb = gr.top_block ()
+        dst = gr.vector_sink_i ()
+        tb.connect (src, dst)
+        tb.run ()
+        return dst.data ()
+
+    def test_001_stream (self):
+        src_data = tuple(range(100000))
+        tb = gr.top_block ()
+        snk = gr.shm_sink (gr.sizeof_int, self.name, 1024*1024)
+        tb.connect (gr.vector_source_i (src_data), snk)
+
+        # readers see what is written after they attach
+        src1 = gr.shm_source (gr.sizeof_int, self.name)
+        src2 = gr.shm_source (gr.sizeof_int, self.name)
+        self.assertEqual (2, snk.nreaders ())
+
+        tb.run ()
+        self.assertEqual (100000, snk.nitems_written ())
+        self.assertEqual (src_data, self.read_all (src1))
+        self.assertEqual (src_data, self.read_all (src2))
+        self.assertEqual (0, src1.noverruns ())
+
+    def test_002_overrun (self):
+        # a ring of 1024 items; the reader doesn't run until the writer is done
+        src_data = tuple(range(10000))
+        tb = gr.top_block ()
+        snk = gr.shm_sink (gr.sizeof_int, self.name, 4096)
+        tb.connect (gr.vector_source_i (src_data), snk)
+        src = gr.shm_source (gr.sizeof_int, self.name)
+        tb.run ()
+
+        result = self.read_all (src)
+        self.assertEqual (1, src.noverruns ())
+        self.assertEqual (10000, len (result) + src.nitems_lost ())
+        self.assertEqual (src_data[-len (result):], result)
+
+    def test_003_itemsize_mismatch (self):
+        snk = gr.shm_sink (gr.sizeof_int, self.name)
+        self.assertRaises (ValueError, gr.shm_source, gr.sizeof_short, self.name)
+
+
+if __name__ == '__main__':
+    gr_unittest.main ()
@@ -89,6 +89,75 @@ class test_sink_source(gr_unittest.TestCase):
         self.assertEqual(expected_result, result_data)
         self.assert_(self.timeout)  # source ignores EOF?
 
+    def test_003(self):
+        udp_rcv = gr.udp_source( gr.sizeof_float, '0.0.0.0', 0, eof=True )
+        rcv_port = udp_rcv.get_port()
+        udp_snd = gr.udp_sink( gr.sizeof_float, '127.0.0.1', rcv_port )
+
+        for blk in (udp_rcv, udp_snd):
+            blk.set_batch_size(16)
+            blk.set_sequence_numbers(True)
+
+        n_data = 4000
+        src_data = [float(x) for x in range(n_data)]
+        expected_result = tuple(src_data)
+        src = gr.vector_source_f(src_data)
+        dst = gr.vector_sink_f()
+
+        self.tb_snd.connect( src, udp_snd )
+        self.tb_rcv.connect( udp_rcv, dst )
+
+        self.tb_rcv.start()
+        self.tb_snd.run()
+        udp_snd.disconnect()
+        self.timeout = False
+        q = Timer(3.0,self.stop_rcv)
+        q.start()
+        self.tb_rcv.wait()
+        q.cancel()
+
+        result_data = dst.data()
+        self.assertEqual(expected_result, result_data)
+        self.assert_(not self.timeout)
+        self.assertEqual(udp_snd.ndatagrams(), udp_rcv.ndatagrams())
+        self.assertEqual(0, udp_rcv.nseq_lost())
+        self.assertEqual(0, udp_rcv.nseq_gaps())
+
+    def test_004(self):
+        # 1472 - 4 bytes of sequence number isn't a whole number of
+        # complex items; datagrams must still carry only whole items
+        udp_rcv = gr.udp_source( gr.sizeof_gr_complex, '0.0.0.0', 0, eof=True )
+        rcv_port = udp_rcv.get_port()
+        udp_snd = gr.udp_sink( gr.sizeof_gr_complex, '127.0.0.1', rcv_port )
+
+        for blk in (udp_rcv, udp_snd):
+            blk.set_batch_size(16)
+            blk.set_sequence_numbers(True)
+
+        n_data = 4000
+        src_data = [complex(x, -x) for x in range(n_data)]
+        expected_result = tuple(src_data)
+        src = gr.vector_source_c(src_data)
+        dst = gr.vector_sink_c()
+
+        self.tb_snd.connect( src, udp_snd )
+        self.tb_rcv.connect( udp_rcv, dst )
+
+        self.tb_rcv.start()
+        self.tb_snd.run()
+        udp_snd.disconnect()
+        self.timeout = False
+        q = Timer(3.0,self.stop_rcv)
+        q.start()
+        self.tb_rcv.wait()
+        q.cancel()
+
+        result_data = dst.data()
+        self.assertEqual(expected_result, result_data)
+        self.assert_(not self.timeout)
+        self.assertEqual(0, udp_rcv.nseq_lost())
+        self.assertEqual(0, udp_rcv.ntruncated())
+
     def stop_rcv(self):
         self.timeout = True
         self.tb_rcv.stop()
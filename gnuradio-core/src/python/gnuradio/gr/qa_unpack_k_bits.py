@@ -51,6 +51,23 @@ class test_unpack(gr_unittest.TestCase):
         self.tb.run()
         self.assertEqual(expected_results, dst.data())
 
+    def test_003(self):
+        random.seed(0)
+        for k in range(1, 9):
+            src_data = tuple([random.randint(0, 255)
+                              for i in xrange(random.randint(1, 1000))])
+            expected_results = []
+            for t in src_data:
+                for j in range(k - 1, -1, -1):
+                    expected_results.append((t >> j) & 1)
+            tb = gr.top_block()
+            src = gr.vector_source_b(src_data, False)
+            op = gr.unpack_k_bits_bb(k)
+            dst = gr.vector_sink_b()
+            tb.connect(src, op, dst)
+            tb.run()
+            self.assertEqual(tuple(expected_results), dst.data())
+
 
 if __name__ == '__main__':
    gr_unittest.main ()
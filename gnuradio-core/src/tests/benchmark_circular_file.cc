@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <gr_circular_file.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+
+/*
+ * Stream complex shorts into a gr_circular_file as gr_circular_file_sink
+ * does, alone and with a second thread continuously pulling 10 ms
+ * windows out of the ring the way an external trigger reader would.
+ *
+ *   benchmark_circular_file [seconds-of-history [filename]]
+ *
+ * The ring holds that many seconds at 100 MS/s; put it on tmpfs
+ * (the default is /dev/shm) unless you want to measure your disk.
+ */
+
+#define BLOCK_ITEMS	8192			// items per work() call
+#define ITEM_SIZE	(2 * sizeof (short))
+#define SAMPLE_RATE	100e6
+#define NBLOCKS		40000
+
+static double
+wall_seconds ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static volatile bool done;
+
+static void
+reader (const char *filename, long long *nbytes)
+{
+  gr_circular_file cf (filename);
+  std::vector<char> buf ((size_t) (0.010 * SAMPLE_RATE) * ITEM_SIZE);
+  while (!done){
+    long long offset = std::max (0LL, cf.nbytes_written () - (long long) buf.size ());
+    *nbytes += cf.read_at (offset, &buf[0], buf.size ());
+  }
+}
+
+static void
+benchmark (const char *filename, double seconds, bool with_reader)
+{
+  std::vector<short> block (2 * BLOCK_ITEMS);
+  for (size_t i = 0; i < block.size (); i++)
+    block[i] = random ();
+
+  gr_circular_file cf (filename, true,
+		       (long long) (seconds * SAMPLE_RATE) * ITEM_SIZE);
+
+  long long nread = 0;
+  boost::thread *t = 0;
+  done = false;
+  if (with_reader)
+    t = new boost::thread (boost::bind (reader, filename, &nread));
+
+  double start = wall_seconds ();
+  for (int i = 0; i < NBLOCKS; i++)
+    cf.write (&block[0], BLOCK_ITEMS * ITEM_SIZE);
+  double wall = wall_seconds () - start;
+
+  done = true;
+  if (t){
+    t->join ();
+    delete t;
+  }
+
+  printf ("%12s:  wall: %6.3f  MS/sec: %8.1f  reader MB/sec: %8.1f\n",
+	  with_reader ? "with reader" : "alone", wall,
+	  (double) NBLOCKS * BLOCK_ITEMS / wall * 1e-6, nread / wall * 1e-6);
+}
+
+int
+main (int argc, char **argv)
+{
+  double seconds = argc > 1 ? atof (argv[1]) : 2.0;
+  const char *filename = argc > 2 ? argv[2] : "/dev/shm/benchmark_circular_file.dat";
+
+  benchmark (filename, seconds, false);
+  benchmark (filename, seconds, true);
+
+  unlink (filename);
+  return 0;
+}
@@ -0,0 +1,145 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#include <unistd.h>
+#include <fcntl.h>
+#include <gr_file_source.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * Replay a scratch file through gr_file_source::work, once via stdio
+ * and once via mmap, and report sustained rate and CPU per byte.
+ *
+ *   benchmark_file_source [megabytes [filename]]
+ *
+ * Each mode is timed with the file evicted from the page cache
+ * (where the kernel honors POSIX_FADV_DONTNEED) and again warm.
+ */
+
+#define BLOCK_SIZE	(64 * 1024)	// items per work() call
+#define ITEM_SIZE	(2 * sizeof (float))
+
+static double
+timeval_to_double (const struct timeval *tv)
+{
+  return (double) tv->tv_sec + (double) tv->tv_usec * 1e-6;
+}
+
+static double
+cpu_seconds ()
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage	rusage;
+  if (getrusage (RUSAGE_SELF, &rusage) < 0){
+    perror ("getrusage");
+    exit (1);
+  }
+  return timeval_to_double (&rusage.ru_utime) + timeval_to_double (&rusage.ru_stime);
+#else
+  return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+static double
+wall_seconds ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return timeval_to_double (&tv);
+}
+
+static void
+drop_cache (const char *filename)
+{
+#ifdef POSIX_FADV_DONTNEED
+  int fd = open (filename, O_RDONLY);
+  if (fd >= 0){
+    fdatasync (fd);
+    posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+    close (fd);
+  }
+#endif
+}
+
+static void
+benchmark (const char *filename, bool use_mmap, bool cold, const char *implementation_name)
+{
+  static std::vector<char> buffer (BLOCK_SIZE * ITEM_SIZE);
+  gr_vector_const_void_star input_items;
+  gr_vector_void_star output_items (1);
+  output_items[0] = &buffer[0];
+
+  if (cold)
+    drop_cache (filename);
+
+  gr_file_source_sptr src = gr_make_file_source (ITEM_SIZE, filename, false, use_mmap);
+
+  double cpu_start = cpu_seconds ();
+  double wall_start = wall_seconds ();
+
+  double nbytes = 0;
+  int n;
+  while ((n = src->work (BLOCK_SIZE, input_items, output_items)) > 0)
+    nbytes += (double) n * ITEM_SIZE;
+
+  double wall = wall_seconds () - wall_start;
+  double cpu = cpu_seconds () - cpu_start;
+
+  printf ("%18s:  wall: %6.3f  cpu: %6.3f  MB/sec: %8.1f  cpu ns/byte: %6.3f\n",
+	  implementation_name, wall, cpu, nbytes / wall * 1e-6, cpu / nbytes * 1e9);
+}
+
+int
+main (int argc, char **argv)
+{
+  long megabytes = argc > 1 ? atol (argv[1]) : 512;
+  const char *filename = argc > 2 ? argv[2] : "benchmark_file_source.dat";
+
+  FILE *fp = fopen (filename, "wb");
+  if (fp == 0){
+    perror (filename);
+    exit (1);
+  }
+  std::vector<char> chunk (1024 * 1024);
+  for (size_t i = 0; i < chunk.size (); i++)
+    chunk[i] = random ();
+  for (long i = 0; i < megabytes; i++)
+    fwrite (&chunk[0], 1, chunk.size (), fp);
+  fclose (fp);
+
+  benchmark (filename, false, true,  "stdio cold");
+  benchmark (filename, true,  true,  "mmap cold");
+  benchmark (filename, false, false, "stdio warm");
+  benchmark (filename, true,  false, "mmap warm");
+
+  unlink (filename);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#include <math.h>
+#include <gri_iq_capture.h>
+#include <vector>
+
+/*
+ * Time the 16-bit delta / bit packing codec used by gr_iq_capture_sink
+ * and gr_iq_capture_source on complex short samples.
+ *
+ *   benchmark_iq_capture [msamples [bits]]
+ *
+ * The test signal is a tone with about \p bits bits of noise on top,
+ * i.e., what a 12 or 14 bit ADC delivers into a 16-bit container.
+ */
+
+#define CHUNK_ITEMS	65536
+
+static double
+timeval_to_double (const struct timeval *tv)
+{
+  return (double) tv->tv_sec + (double) tv->tv_usec * 1e-6;
+}
+
+static double
+cpu_seconds ()
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage	rusage;
+  if (getrusage (RUSAGE_SELF, &rusage) < 0){
+    perror ("getrusage");
+    exit (1);
+  }
+  return timeval_to_double (&rusage.ru_utime) + timeval_to_double (&rusage.ru_stime);
+#else
+  return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+int
+main (int argc, char **argv)
+{
+  long msamples = argc > 1 ? atol (argv[1]) : 100;
+  int bits = argc > 2 ? atoi (argv[2]) : 12;
+  int nchunks = (int) (msamples * 1000000 / CHUNK_ITEMS) + 1;
+
+  std::vector<short> in (2 * CHUNK_ITEMS);
+  double amp = (1 << (bits - 2));
+  for (int i = 0; i < CHUNK_ITEMS; i++){
+    double ph = 2 * M_PI * 0.01 * i;
+    in[2*i]   = (short) (amp * cos (ph) + (random () % (1 << (bits - 4))));
+    in[2*i+1] = (short) (amp * sin (ph) + (random () % (1 << (bits - 4))));
+  }
+
+  std::vector<unsigned char> enc (gri_delta_bp_max_bytes (2 * CHUNK_ITEMS));
+  std::vector<short> out (2 * CHUNK_ITEMS);
+  size_t nbytes = 0;
+
+  double start = cpu_seconds ();
+  for (int i = 0; i < nchunks; i++)
+    nbytes = gri_delta_bp_encode (&enc[0], &in[0], 2 * CHUNK_ITEMS, 2);
+  double encode = cpu_seconds () - start;
+
+  start = cpu_seconds ();
+  for (int i = 0; i < nchunks; i++)
+    if (!gri_delta_bp_decode (&out[0], 2 * CHUNK_ITEMS, &enc[0], nbytes, 2)){
+      fprintf (stderr, "benchmark_iq_capture: decode failed\n");
+      exit (1);
+    }
+  double decode = cpu_seconds () - start;
+
+  if (out != in){
+    fprintf (stderr, "benchmark_iq_capture: round trip mismatch\n");
+    exit (1);
+  }
+
+  double nsamples = (double) nchunks * CHUNK_ITEMS;
+  printf ("%d-bit samples, ratio %.3f\n", bits,
+	  (double) nbytes / (4 * CHUNK_ITEMS));
+  printf ("  encode:  cpu: %6.3f  MS/sec: %8.1f\n", encode, nsamples / encode * 1e-6);
+  printf ("  decode:  cpu: %6.3f  MS/sec: %8.1f\n", decode, nsamples / decode * 1e-6);
+  return 0;
+}
@@ -0,0 +1,143 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <gri_shm_ring.h>
+#include <vector>
+
+/*
+ * Stream blocks through a gri_shm_ring as gr_shm_sink does, to 0..N
+ * reader processes, and compare with plain memcpy of the same blocks.
+ *
+ *   benchmark_shm_stream [nreaders [ring-megabytes]]
+ *
+ * Each reader prints how much it got and how much it lost to overruns.
+ */
+
+#define BLOCK_BYTES	(64 * 1024)
+#define NBLOCKS		40000
+#define NAME		"benchmark_shm_stream"
+
+static double
+wall_seconds ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static int
+reader (int which)
+{
+  gri_shm_ring ring (NAME);
+  std::vector<char> buf (BLOCK_BYTES);
+  long long nbytes = 0;
+
+  double start = wall_seconds ();
+  for (;;){
+    size_t n = ring.read (&buf[0], buf.size ());
+    if (n > 0)
+      nbytes += n;
+    else if (!ring.writer_alive ()){
+      if (ring.read (&buf[0], buf.size ()) == 0)
+	break;
+    }
+    else
+      ring.wait (0.1);
+  }
+  double wall = wall_seconds () - start;
+
+  printf ("    reader %d:  MB/sec: %8.1f  overruns: %ld  MB lost: %.1f\n",
+	  which, nbytes / wall * 1e-6, ring.noverruns (), ring.nbytes_lost () * 1e-6);
+  fflush (stdout);
+  return 0;
+}
+
+// the same copies into an ordinary buffer the size of the ring
+static void
+benchmark_memcpy (size_t ring_bytes)
+{
+  std::vector<char> src (BLOCK_BYTES), dst (ring_bytes);
+  memset (&src[0], 1, src.size ());
+  size_t nslots = ring_bytes / BLOCK_BYTES;
+
+  double start = wall_seconds ();
+  for (int i = 0; i < NBLOCKS; i++)
+    memcpy (&dst[(i % nslots) * BLOCK_BYTES], &src[0], BLOCK_BYTES);
+  double wall = wall_seconds () - start;
+
+  printf ("%12s:  wall: %6.3f  MB/sec: %8.1f\n", "memcpy", wall,
+	  (double) NBLOCKS * BLOCK_BYTES / wall * 1e-6);
+}
+
+static void
+benchmark (int nreaders, size_t ring_bytes)
+{
+  std::vector<char> block (BLOCK_BYTES);
+  for (size_t i = 0; i < block.size (); i++)
+    block[i] = random ();
+
+  gri_shm_ring ring (NAME, ring_bytes, 1);
+
+  std::vector<pid_t> pids;
+  for (int i = 0; i < nreaders; i++){
+    fflush (stdout);
+    pid_t pid = fork ();
+    if (pid == 0)
+      _exit (reader (i));
+    pids.push_back (pid);
+  }
+  while (ring.nreaders () < nreaders)
+    usleep (1000);
+
+  double start = wall_seconds ();
+  for (int i = 0; i < NBLOCKS; i++)
+    ring.write (&block[0], BLOCK_BYTES);
+  double wall = wall_seconds () - start;
+
+  printf ("%9d rd:  wall: %6.3f  MB/sec: %8.1f\n", nreaders, wall,
+	  (double) NBLOCKS * BLOCK_BYTES / wall * 1e-6);
+  fflush (stdout);
+
+  ring.set_writer_alive (false);
+  for (size_t i = 0; i < pids.size (); i++)
+    waitpid (pids[i], 0, 0);
+}
+
+int
+main (int argc, char **argv)
+{
+  int nreaders = argc > 1 ? atoi (argv[1]) : 2;
+  size_t ring_bytes = (size_t) (argc > 2 ? atof (argv[2]) : 16) * 1024 * 1024;
+
+  benchmark_memcpy (ring_bytes);
+  for (int n = 0; n <= nreaders; n++)
+    benchmark (n, ring_bytes);
+  return 0;
+}
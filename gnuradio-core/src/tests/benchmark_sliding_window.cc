@@ -0,0 +1,155 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#include <unistd.h>
+#include <gri_sliding_window.h>
+#include <string.h>
+
+#define ITERATIONS	20000000
+#define BLOCK_SIZE	(4 * 1024)	// one work() call worth
+#define MAX_WINDOW	1024
+
+static float input[BLOCK_SIZE + MAX_WINDOW];
+static float output[BLOCK_SIZE];
+
+static double
+timeval_to_double (const struct timeval *tv)
+{
+  return (double) tv->tv_sec + (double) tv->tv_usec * 1e-6;
+}
+
+
+static void
+benchmark (void test (int length), int length, const char *implementation_name)
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage	rusage_start;
+  struct rusage	rusage_stop;
+#else
+  double clock_start;
+  double clock_end;
+#endif
+
+  // get starting CPU usage
+#ifdef HAVE_SYS_RESOURCE_H
+  if (getrusage (RUSAGE_SELF, &rusage_start) < 0){
+    perror ("getrusage");
+    exit (1);
+  }
+#else
+  clock_start = (double) clock() * (1000000. / CLOCKS_PER_SEC);
+#endif
+  // do the actual work
+
+  test (length);
+
+  // get ending CPU usage
+
+#ifdef HAVE_SYS_RESOURCE_H
+  if (getrusage (RUSAGE_SELF, &rusage_stop) < 0){
+    perror ("getrusage");
+    exit (1);
+  }
+
+  // compute results
+
+  double user =
+    timeval_to_double (&rusage_stop.ru_utime)
+    - timeval_to_double (&rusage_start.ru_utime);
+
+  double sys =
+    timeval_to_double (&rusage_stop.ru_stime)
+    - timeval_to_double (&rusage_start.ru_stime);
+
+  double total = user + sys;
+#else
+  clock_end = (double) clock () * (1000000. / CLOCKS_PER_SEC);
+  double total = clock_end - clock_start;
+#endif
+
+  printf ("%18s (N = %4d):  cpu: %6.3f  samples/sec: %10.3e\n",
+	  implementation_name, length, total, ITERATIONS / total);
+}
+
+// ----------------------------------------------------------------
+// The "rescan" versions are what gr_moving_average_XX and
+// gr_feedforward_agc_cc did per output before gri_sliding_window.h
+
+void rescan_sum (int length)
+{
+  for (int i = 0; i < ITERATIONS/BLOCK_SIZE; i++){
+    for (int j = 0; j < BLOCK_SIZE; j++){
+      float sum = 0;
+      for (int k = 0; k < length; k++)
+	sum += input[j+k];
+      output[j] = sum;
+    }
+  }
+}
+
+void sliding_sum (int length)
+{
+  for (int i = 0; i < ITERATIONS/BLOCK_SIZE; i++)
+    gri_sliding_sum<float, float, float>(output, input, BLOCK_SIZE, length, 1.0, 1024);
+}
+
+void rescan_max (int length)
+{
+  for (int i = 0; i < ITERATIONS/BLOCK_SIZE; i++){
+    for (int j = 0; j < BLOCK_SIZE; j++){
+      float mx = input[j];
+      for (int k = 1; k < length; k++)
+	mx = std::max (mx, input[j+k]);
+      output[j] = mx;
+    }
+  }
+}
+
+void sliding_max (int length)
+{
+  gri_sliding_max<float> wmax;
+
+  for (int i = 0; i < ITERATIONS/BLOCK_SIZE; i++)
+    wmax.run (output, input, BLOCK_SIZE, length);
+}
+
+int
+main (int argc, char **argv)
+{
+  for (unsigned i = 0; i < sizeof (input) / sizeof (input[0]); i++)
+    input[i] = (float) random () / RAND_MAX;
+
+  for (int length = 16; length <= MAX_WINDOW; length *= 4){
+    benchmark (rescan_sum, length, "rescan sum");
+    benchmark (sliding_sum, length, "sliding sum");
+    benchmark (rescan_max, length, "rescan max");
+    benchmark (sliding_max, length, "sliding max");
+  }
+}
@@ -0,0 +1,162 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#include <unistd.h>
+#include <gr_udp_sink.h>
+#include <gr_udp_source.h>
+#include <gruel/thread.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * Push a stream of floats through gr_udp_sink -> loopback ->
+ * gr_udp_source, calling work() directly from two threads, for
+ * several batch sizes.  Reports throughput, CPU per datagram and
+ * the source's loss counters (sequence numbers are on).  The sender
+ * is not paced, so expect the kernel to drop datagrams whenever the
+ * receiver falls behind.
+ *
+ *   benchmark_udp_loopback [megabytes]
+ */
+
+#define BLOCK_SIZE	(32 * 1024)	// items per work() call
+#define PORT		65499
+
+static double
+timeval_to_double (const struct timeval *tv)
+{
+  return (double) tv->tv_sec + (double) tv->tv_usec * 1e-6;
+}
+
+static double
+cpu_seconds ()
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage	rusage;
+  if (getrusage (RUSAGE_SELF, &rusage) < 0){
+    perror ("getrusage");
+    exit (1);
+  }
+  return timeval_to_double (&rusage.ru_utime) + timeval_to_double (&rusage.ru_stime);
+#else
+  return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+static double
+wall_seconds ()
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return timeval_to_double (&tv);
+}
+
+struct sender
+{
+  gr_udp_sink_sptr	d_sink;
+  long			d_nitems;
+
+  sender (gr_udp_sink_sptr sink, long nitems) : d_sink (sink), d_nitems (nitems) {}
+
+  void operator() ()
+  {
+    std::vector<float> buf (BLOCK_SIZE);
+    gr_vector_const_void_star input_items (1);
+    gr_vector_void_star output_items;
+
+    for (long i = 0; i < d_nitems; i += BLOCK_SIZE){
+      for (int j = 0; j < BLOCK_SIZE; j++)
+	buf[j] = i + j;
+      input_items[0] = &buf[0];
+      d_sink->work (BLOCK_SIZE, input_items, output_items);
+    }
+    d_sink->disconnect ();		// zero-length datagrams mark EOF
+  }
+};
+
+static void
+benchmark (int batch_size, long nitems)
+{
+  // Don't wait forever: the EOF datagrams can be dropped too
+  gr_udp_source_sptr src = gr_make_udp_source (sizeof (float), "127.0.0.1", PORT,
+					       1472, true, false);
+  gr_udp_sink_sptr snk = gr_make_udp_sink (sizeof (float), "127.0.0.1", PORT);
+  src->set_batch_size (batch_size);
+  snk->set_batch_size (batch_size);
+  src->set_sequence_numbers (true);
+  snk->set_sequence_numbers (true);
+
+  std::vector<float> buf (BLOCK_SIZE);
+  gr_vector_const_void_star input_items;
+  gr_vector_void_star output_items (1);
+  output_items[0] = &buf[0];
+
+  double cpu_start = cpu_seconds ();
+  double wall_start = wall_seconds ();
+
+  gruel::thread tx (sender (snk, nitems));
+
+  long nreceived = 0, nmisordered = 0;
+  float expected = 0;
+  double wall_stop = wall_start;
+  int n;
+  while ((n = src->work (BLOCK_SIZE, input_items, output_items)) > 0){
+    wall_stop = wall_seconds ();
+    for (int j = 0; j < n; j++){
+      if (buf[j] < expected)
+	nmisordered++;
+      expected = buf[j] + 1;
+    }
+    nreceived += n;
+  }
+  tx.join ();
+
+  double wall = wall_stop - wall_start;	// not counting the final receive timeout
+  double cpu = cpu_seconds () - cpu_start;
+  double ndatagrams = snk->ndatagrams ();
+
+  printf ("batch %3d:  wall: %6.3f  MB/sec: %8.1f  cpu us/datagram: %6.3f  "
+	  "received: %5.1f%%  lost: %llu  gaps: %llu  kernel drops: %llu%s\n",
+	  batch_size, wall, src->nbytes () / wall * 1e-6, cpu / ndatagrams * 1e6,
+	  100.0 * nreceived / nitems, src->nseq_lost (), src->nseq_gaps (),
+	  src->nkernel_drops (), nmisordered ? "  MISORDERED" : "");
+}
+
+int
+main (int argc, char **argv)
+{
+  long megabytes = argc > 1 ? atol (argv[1]) : 256;
+  long nitems = megabytes * 1024 * 1024 / sizeof (float);
+  static const int batch_sizes[] = { 1, 4, 16, 64 };
+
+  for (unsigned i = 0; i < sizeof (batch_sizes) / sizeof (batch_sizes[0]); i++)
+    benchmark (batch_sizes[i], nitems);
+  return 0;
+}
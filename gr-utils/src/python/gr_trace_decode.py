@@ -0,0 +1,184 @@
+#!/usr/bin/env python
+#
+# Copyright 2010 Free Software Foundation, Inc.
+# 
+# This file is part of GNU Radio
+# 
+# GNU Radio is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+# 
+# GNU Radio is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with GNU Radio; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+# 
+
+"""
+Decode a binary trace written by gr_trace (GR_TRACE=filename or
+gr.trace_start()) into text, or summarize it per block.
+"""
+
+import struct
+import sys
+from optparse import OptionParser
+
+event_names = {
+    1 : 'WORK_BEGIN',
+    2 : 'WORK_END',
+    3 : 'BLKD_IN',
+    4 : 'BLKD_OUT',
+    5 : 'DONE',
+    6 : 'WAKE',
+}
+
+# executor states, as found in the arg0 of WAKE events
+state_names = ['READY', 'READY_NO_OUTPUT', 'BLKD_IN', 'BLKD_OUT', 'DONE']
+
+RECORD_SIZE = 32
+
+class trace(object):
+    def __init__(self, filename):
+        self.records = []               # (timestamp, thread, block_id, event, arg0, arg1)
+        self.names = {}                 # block id -> name
+        self.dropped = {}               # thread -> events dropped
+        self._read(filename)
+
+    def _read(self, filename):
+        f = open(filename, 'rb')
+        hdr = f.read(16)
+        if len(hdr) != 16 or hdr[0:8] != 'GRTRACE1':
+            raise ValueError('%s: not a gr_trace file' % (filename,))
+        if struct.unpack('<I', hdr[8:12])[0] == 0x01020304:
+            e = '<'
+        else:
+            e = '>'
+        if struct.unpack(e + 'I', hdr[12:16])[0] != RECORD_SIZE:
+            raise ValueError('%s: unsupported record size' % (filename,))
+
+        rec = struct.Struct(e + 'QiIQQ')
+        while True:
+            sec = f.read(8)
+            if len(sec) < 8:
+                break                   # clean end, or the writer died mid-section
+            tag = sec[0:4]
+            length = struct.unpack(e + 'I', sec[4:8])[0]
+            payload = f.read(length)
+            if len(payload) < length:
+                break
+            if tag == 'RECS':
+                thread = struct.unpack(e + 'I', payload[0:4])[0]
+                for off in range(8, length - RECORD_SIZE + 1, RECORD_SIZE):
+                    ts, block_id, event, arg0, arg1 = rec.unpack_from(payload, off)
+                    self.records.append((ts, thread, block_id, event, arg0, arg1))
+            elif tag == 'NAME':
+                block_id = struct.unpack(e + 'q', payload[0:8])[0]
+                self.names[block_id] = payload[8:].decode('latin-1')
+            elif tag == 'DROP':
+                thread = struct.unpack(e + 'I', payload[0:4])[0]
+                self.dropped[thread] = struct.unpack(e + 'Q', payload[8:16])[0]
+            # unknown sections are skipped
+        f.close()
+        self.records.sort()
+
+    def block_name(self, block_id):
+        if block_id in self.names:
+            return '%s(%d)' % (self.names[block_id], block_id)
+        return '(%d)' % (block_id,)
+
+
+def signed(x):
+    if x >= 1 << 63:
+        return x - (1 << 64)
+    return x
+
+def format_args(event, arg0, arg1):
+    if event == 6 and arg0 < len(state_names):
+        return 'was %s' % (state_names[arg0],)
+    if event == 2:
+        return 'result=%d produced=%d' % (signed(arg0), arg1)
+    return '%d %d' % (signed(arg0), signed(arg1))
+
+def dump(t, out):
+    if not t.records:
+        return
+    t0 = t.records[0][0]
+    for ts, thread, block_id, event, arg0, arg1 in t.records:
+        out.write('%14.3f  %3d  %-30s %-10s %s\n' % (
+            (ts - t0) * 1e-3, thread, t.block_name(block_id),
+            event_names.get(event, str(event)), format_args(event, arg0, arg1)))
+
+def summarize(t, out):
+    class stats(object):
+        def __init__(self):
+            self.nwork = 0
+            self.work_ns = 0
+            self.produced = 0
+            self.nblkd_in = 0
+            self.nblkd_out = 0
+
+    blocks = {}
+    begin = {}                          # thread -> timestamp of pending WORK_BEGIN
+    for ts, thread, block_id, event, arg0, arg1 in t.records:
+        s = blocks.setdefault(block_id, stats())
+        if event == 1:
+            begin[thread] = ts
+        elif event == 2:
+            s.nwork += 1
+            s.produced += arg1
+            if thread in begin:
+                s.work_ns += ts - begin.pop(thread)
+        elif event == 3:
+            s.nblkd_in += 1
+        elif event == 4:
+            s.nblkd_out += 1
+
+    if t.records:
+        span = (t.records[-1][0] - t.records[0][0]) * 1e-9
+    else:
+        span = 0
+    out.write('%.3f s traced, %d events, %d dropped\n\n' % (
+        span, len(t.records), sum(t.dropped.values())))
+    out.write('%-30s %10s %12s %8s %14s %10s %10s\n' % (
+        'block', 'work', 'work [ms]', 'busy', 'produced', 'blkd_in', 'blkd_out'))
+    for block_id in sorted(blocks.keys()):
+        s = blocks[block_id]
+        if span > 0:
+            busy = '%7.1f%%' % (100 * s.work_ns * 1e-9 / span,)
+        else:
+            busy = '-'
+        out.write('%-30s %10d %12.3f %8s %14d %10d %10d\n' % (
+            t.block_name(block_id), s.nwork, s.work_ns * 1e-6, busy,
+            s.produced, s.nblkd_in, s.nblkd_out))
+
+def main():
+    usage = "%prog: [options] trace_file"
+    description = "Decodes a GNU Radio binary trace file (written when GR_TRACE is set, or after gr.trace_start()). By default every event is printed in time order with the time in microseconds since the first event, the thread, the block and the event arguments."
+
+    parser = OptionParser(usage=usage, description=description)
+    parser.add_option("-s", "--summary", action="store_true", default=False,
+                      help="Print per block statistics instead of the events")
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.print_help()
+        raise SystemExit(1)
+
+    t = trace(args[0])
+    if options.summary:
+        summarize(t, sys.stdout)
+    else:
+        dump(t, sys.stdout)
+    if t.dropped:
+        sys.stderr.write('warning: %d events were dropped\n' % (sum(t.dropped.values()),))
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,117 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef INCLUDED_GRUEL_ATOMIC_H
+#define INCLUDED_GRUEL_ATOMIC_H
+
+/*
+ * Minimal atomic operations for lock-free data structures.
+ *
+ * These map onto the GCC __sync builtins, which are full barriers.
+ * atomic_load has acquire and atomic_store release semantics; that is
+ * all the single producer / single consumer and CAS based structures
+ * in the tree rely on.
+ */
+
+namespace gruel {
+
+  //! full hardware and compiler memory barrier
+  static inline void memory_barrier() { __sync_synchronize(); }
+
+  //! load *p; later loads and stores are not moved before it
+  template<class T>
+  static inline T atomic_load(const volatile T *p)
+  {
+    T v = *p;
+    __sync_synchronize();
+    return v;
+  }
+
+  /*!
+   * \brief load a pointer that was published with atomic_store
+   *
+   * Reads through the result see everything written before it was
+   * stored, because they depend on it (every CPU we run on but the
+   * Alpha orders dependent loads).  No barrier, so it's cheap enough
+   * for lock-free lookups.
+   */
+  template<class T>
+  static inline T atomic_load_consume(const volatile T *p)
+  {
+    return *p;
+  }
+
+  //! store v to *p; earlier loads and stores are not moved after it
+  template<class T>
+  static inline void atomic_store(volatile T *p, T v)
+  {
+    __sync_synchronize();
+    *p = v;
+  }
+
+  //! if *p == expected, set *p = desired.  Returns true on success.
+  template<class T>
+  static inline bool atomic_cas(volatile T *p, T expected, T desired)
+  {
+    return __sync_bool_compare_and_swap(p, expected, desired);
+  }
+
+  //! set *p = v, returning the previous value of *p
+  template<class T>
+  static inline T atomic_exchange(volatile T *p, T v)
+  {
+    T old;
+    do {
+      old = *p;
+    } while (!__sync_bool_compare_and_swap(p, old, v));
+    return old;
+  }
+
+  //! *p += delta, returning the previous value of *p
+  template<class T>
+  static inline T atomic_fetch_add(volatile T *p, T delta)
+  {
+    return __sync_fetch_and_add(p, delta);
+  }
+
+  //! *p |= bits, returning the previous value of *p
+  template<class T>
+  static inline T atomic_fetch_or(volatile T *p, T bits)
+  {
+    return __sync_fetch_and_or(p, bits);
+  }
+
+  //! *p &= bits, returning the previous value of *p
+  template<class T>
+  static inline T atomic_fetch_and(volatile T *p, T bits)
+  {
+    return __sync_fetch_and_and(p, bits);
+  }
+
+  //! atomically read a counter that other threads update with atomic_fetch_add
+  template<class T>
+  static inline T atomic_read(volatile T *p)
+  {
+    return __sync_fetch_and_add(p, (T) 0);
+  }
+
+} /* namespace gruel */
+
+#endif /* INCLUDED_GRUEL_ATOMIC_H */
@@ -0,0 +1,108 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_GRUEL_EVENT_COUNT_H
+#define INCLUDED_GRUEL_EVENT_COUNT_H
+
+#include <gruel/futex.h>
+
+namespace gruel {
+
+  /*!
+   * \brief lets threads sleep until a lock-free data structure changes
+   *
+   * The condition variable of lock-free code: it adds blocking to a
+   * queue or flag without a mutex.  A thread that finds nothing to do
+   * does
+   *
+   * \code
+   *   event_count::key_type key = ec.prepare_wait();
+   *   if (!something_to_do())
+   *     ec.wait(key);
+   * \endcode
+   *
+   * and one that has just made something to do calls ec.notify_all().
+   * The re-check after prepare_wait closes the window in which a
+   * notification could be missed.
+   *
+   * The state is one word: an epoch, and a bit that says somebody may
+   * be waiting.  notify_all only bumps the epoch, clears the bit and
+   * calls into the kernel if the bit is set, so a notify with nobody
+   * waiting, or a second one before the sleepers have run, is just a
+   * barrier and a load (D. Vyukov's eventcount).  Every waiter is
+   * woken; those that still have nothing to do wait again.
+   *
+   * wait spins for a while before sleeping, so a thread that is woken
+   * again right away doesn't pay for a trip through the scheduler.
+   */
+  class event_count : boost::noncopyable {
+    volatile int	d_state;	// epoch << 1 | maybe-waiters bit
+
+  public:
+    typedef int key_type;
+
+    event_count() : d_state(0) {}
+
+    //! Announce that we're about to wait.  Re-check, then wait if need be.
+    key_type prepare_wait()
+    {
+      // full barrier, pairs with notify_all
+      return atomic_fetch_or(&d_state, 1) | 1;
+    }
+
+    //! Sleep until there has been a notify_all since prepare_wait returned \p key.
+    void wait(key_type key)
+    {
+      for (int i = spin_count(); i > 0 && atomic_load(&d_state) == key; i--)
+	cpu_relax();
+      while (atomic_load(&d_state) == key)
+	futex_wait(&d_state, key);
+    }
+
+    /*!
+     * \brief As wait, but give up at \p abs_time.
+     * \returns false if it timed out
+     */
+    bool timed_wait(key_type key, const struct timespec &abs_time)
+    {
+      while (atomic_load(&d_state) == key)
+	if (!futex_wait(&d_state, key, &abs_time))
+	  return atomic_load(&d_state) != key;
+      return true;
+    }
+
+    //! Wake every thread that is waiting.  Call after making the change.
+    void notify_all()
+    {
+      memory_barrier();		// the change is visible before we look for waiters
+      int s;
+      while ((s = d_state) & 1){
+	if (atomic_cas(&d_state, s, (s + 2) & ~1)){
+	  futex_wake_all(&d_state);
+	  return;
+	}
+      }
+    }
+  };
+
+} /* namespace gruel */
+
+#endif /* INCLUDED_GRUEL_EVENT_COUNT_H */
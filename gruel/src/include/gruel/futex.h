@@ -0,0 +1,181 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_GRUEL_FUTEX_H
+#define INCLUDED_GRUEL_FUTEX_H
+
+#include <gruel/atomic.h>
+#include <boost/utility.hpp>
+#include <boost/thread/locks.hpp>
+#include <time.h>
+
+/*
+ * Light-weight synchronization for the runtime's hot paths.
+ *
+ * Everything here is a word or two of state that is manipulated with
+ * the atomics in gruel/atomic.h, and only calls into the kernel to
+ * sleep or to wake a thread that is known to be sleeping.  On Linux
+ * that's a futex; elsewhere futex_wait and futex_wake are emulated
+ * with a small table of mutexes and condition variables.
+ *
+ * Timeouts are absolute CLOCK_REALTIME times, like mb_time and
+ * omni_condition::timedwait.
+ */
+
+namespace gruel {
+
+  /*!
+   * \brief Sleep if *addr == val.
+   *
+   * Returns when woken by futex_wake on \p addr, right away if *addr
+   * is no longer \p val, when \p abs_time passes (0 -> never), or
+   * spuriously.  Callers re-check their condition and loop.
+   *
+   * \returns false if \p abs_time passed, else true
+   */
+  bool futex_wait(volatile int *addr, int val,
+		  const struct timespec *abs_time = 0);
+
+  //! Wake up to \p nwaiters threads sleeping in futex_wait on \p addr
+  void futex_wake(volatile int *addr, int nwaiters);
+
+  //! Wake every thread sleeping in futex_wait on \p addr
+  void futex_wake_all(volatile int *addr);
+
+  //! tell the CPU we're in a spin loop
+  static inline void cpu_relax()
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__ ("pause" ::: "memory");
+#else
+    __asm__ __volatile__ ("" ::: "memory");
+#endif
+  }
+
+  /*!
+   * \brief number of times to poll before going to sleep
+   *
+   * 0 on a uniprocessor, where whoever we're waiting for can't make
+   * progress until we give up the CPU.
+   */
+  int spin_count();
+
+  /*!
+   * \brief back off while waiting a short time for another thread
+   *
+   * For loops that wait out another thread's few instructions, e.g.
+   * a producer between its two steps.  pause() spins for a while, then
+   * yields the CPU each time it's called.
+   */
+  class spin_backoff {
+    int d_count;
+
+  public:
+    spin_backoff() : d_count(0) {}
+
+    void pause();
+  };
+
+  /*!
+   * \brief mutex that spins a while, then sleeps on a futex
+   *
+   * An uncontended lock or unlock is one atomic instruction.  A thread
+   * that finds the mutex locked polls it for spin_count() rounds, since
+   * critical sections in the runtime are usually shorter than a trip
+   * through the scheduler, then sleeps.  unlock only calls into the
+   * kernel if somebody is asleep (U. Drepper, "Futexes Are Tricky").
+   *
+   * Works with boost::unique_lock; see futex_scoped_lock.
+   */
+  class futex_mutex : boost::noncopyable {
+    volatile int	d_state;	// 0: unlocked, 1: locked, 2: locked, maybe sleepers
+
+    void lock_slow();
+    void unlock_slow();
+
+  public:
+    futex_mutex() : d_state(0) {}
+
+    void lock()
+    {
+      if (!atomic_cas(&d_state, 0, 1))
+	lock_slow();
+    }
+
+    bool try_lock()
+    {
+      return atomic_cas(&d_state, 0, 1);
+    }
+
+    void unlock()
+    {
+      if (atomic_fetch_add(&d_state, -1) != 1)
+	unlock_slow();
+    }
+  };
+
+  typedef boost::unique_lock<futex_mutex> futex_scoped_lock;
+
+  /*!
+   * \brief condition variable for use with futex_mutex
+   *
+   * Waiters sleep on a sequence number that notify bumps.  notify is
+   * just a load when there are no waiters, so it's fine to call it
+   * every time the state changes.  The predicate must be changed with
+   * the mutex held, as with any condition variable; notify may be
+   * called with or without it.
+   */
+  class futex_condition : boost::noncopyable {
+    volatile int	d_seq;
+    volatile int	d_nwaiters;
+
+  public:
+    futex_condition() : d_seq(0), d_nwaiters(0) {}
+
+    //! Unlock \p lock, sleep until notified (or spuriously), then relock it.
+    void wait(futex_scoped_lock &lock);
+
+    /*!
+     * \brief As wait, but give up at \p abs_time.
+     * \returns false if it timed out
+     */
+    bool timed_wait(futex_scoped_lock &lock, const struct timespec &abs_time);
+
+    void notify_one()
+    {
+      if (atomic_load(&d_nwaiters) != 0){
+	atomic_fetch_add(&d_seq, 1);
+	futex_wake(&d_seq, 1);
+      }
+    }
+
+    void notify_all()
+    {
+      if (atomic_load(&d_nwaiters) != 0){
+	atomic_fetch_add(&d_seq, 1);
+	futex_wake_all(&d_seq);
+      }
+    }
+  };
+
+} /* namespace gruel */
+
+#endif /* INCLUDED_GRUEL_FUTEX_H */
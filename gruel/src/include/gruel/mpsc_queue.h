@@ -0,0 +1,106 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_GRUEL_MPSC_QUEUE_H
+#define INCLUDED_GRUEL_MPSC_QUEUE_H
+
+#include <gruel/pmt.h>
+#include <boost/utility.hpp>
+#include <vector>
+
+namespace pmt {
+  class pmt_pool;
+}
+
+namespace gruel {
+
+  /*!
+   * \brief lock-free multiple producer, single consumer queue of pmt's
+   *
+   * Any number of threads may insert at the same time; only one thread
+   * at a time may remove.  Neither side ever takes a lock or sleeps:
+   * this is the building block for gruel::msg_queue and the
+   * thread-per-block scheduler's message queue, which add the blocking.
+   *
+   * An insert is an increment of the count and one atomic exchange
+   * (D. Vyukov's intrusive MPSC list).  The consumer parks the node it
+   * frees in a spare slot that the next insert picks up, so a queue
+   * that keeps up reuses one node; the rest come from a pmt_pool.
+   *
+   * Producers reserve their place in the count before linking their
+   * message, so count() may include messages that are still on their
+   * way in; the remove functions wait them out.
+   */
+  class mpsc_queue : boost::noncopyable {
+
+    struct node {
+      node *volatile	d_next;
+      pmt::pmt_t	d_msg;
+    };
+
+    // Producers and the consumer each get their own cache line.
+    node *volatile	d_back;		// newest node, producers swap here
+    char		d_pad0[64 - sizeof(node *)];
+    node	       *d_front;	// consumer's stub; its d_next is the oldest message
+    char		d_pad1[64 - sizeof(node *)];
+    volatile long	d_count;
+    node *volatile	d_spare;	// freed node for the next insert, or 0
+
+    static pmt::pmt_pool &node_pool();
+    static node *new_node();
+    static void free_node(node *n);
+
+    node *wait_next(node *n) const;
+    void recycle(node *n);
+
+  public:
+    mpsc_queue();
+    ~mpsc_queue();
+
+    /*!
+     * \brief Insert \p msg at the back of the queue, unless that would
+     * take the count past \p limit (0 -> unbounded).
+     * \returns false if the queue was full.  May be called by any thread.
+     */
+    bool insert_tail(const pmt::pmt_t &msg, unsigned long limit = 0);
+
+    /*!
+     * \brief Remove the oldest message and store it in \p msg.
+     * \returns false if the queue is empty.  Consumer only.
+     */
+    bool delete_head(pmt::pmt_t &msg);
+
+    /*!
+     * \brief Move every message in the queue to the end of \p msgs,
+     * oldest first.  Consumer only.
+     * \returns the number of messages moved.
+     */
+    size_t delete_all(std::vector<pmt::pmt_t> &msgs);
+
+    //! number of messages in the queue, counting any still being inserted
+    long count() const { return d_count; }
+
+    bool empty_p() const { return d_count <= 0; }
+  };
+
+} /* namespace gruel */
+
+#endif /* INCLUDED_GRUEL_MPSC_QUEUE_H */
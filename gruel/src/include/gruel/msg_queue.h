@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2009 Free Software Foundation, Inc.
+ * Copyright 2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,8 +23,11 @@
 #define INCLUDED_MSG_QUEUE_H
 
 #include <gruel/thread.h>
+#include <gruel/futex.h>
+#include <gruel/event_count.h>
 #include <gruel/pmt.h>
-#include <deque>
+#include <gruel/mpsc_queue.h>
+#include <vector>
 
 namespace gruel {
 
@@ -35,16 +38,25 @@ namespace gruel {
 
   /*!
    * \brief thread-safe message queue
+   *
+   * Messages go through a lock-free gruel::mpsc_queue.  Threads that
+   * find it empty or full sleep on an event_count, which the other
+   * side only calls into the kernel for when somebody is asleep:
+   * inserting into a queue nobody is waiting on, or removing when no
+   * producer is blocked, costs a couple of atomic operations.
+   *
+   * Any number of threads may insert and remove.  Removers are
+   * serialized by d_consumer_mutex, which is uncontended in the usual
+   * case of a single reader, and never held while sleeping.
    */
   class msg_queue {
 
-    gruel::mutex              d_mutex;
-    gruel::condition_variable d_not_empty;
-    gruel::condition_variable d_not_full;
+    gruel::mpsc_queue	      d_msgs;
+    gruel::futex_mutex	      d_consumer_mutex;
+    gruel::event_count	      d_not_empty;
+    gruel::event_count	      d_not_full;
     unsigned int	      d_limit;    // max # of messages in queue.  0 -> unbounded
 
-    std::deque<pmt::pmt_t>    d_msgs;
-
   public:
     msg_queue(unsigned int limit);
     ~msg_queue();
@@ -68,18 +80,24 @@ namespace gruel {
      * If no message is available, return pmt_t().
      */
     pmt::pmt_t delete_head_nowait();
-    
+
+    /*!
+     * \brief Move every message in the queue to the end of \p msgs, oldest first.
+     * Never blocks.  \returns the number of messages moved.
+     */
+    size_t delete_all(std::vector<pmt::pmt_t> &msgs);
+
     //! Delete all messages from the queue
     void flush();
 
     //! is the queue empty?
-    bool empty_p() const { return d_msgs.empty(); }
+    bool empty_p() const { return d_msgs.empty_p(); }
   
     //! is the queue full?
     bool full_p() const { return d_limit != 0 && count() >= d_limit; }
   
     //! return number of messages in queue
-    unsigned int count() const { return d_msgs.size(); }
+    unsigned int count() const { return d_msgs.count(); }
 
     //! return limit on number of message in queue.  0 -> unbounded
     unsigned int limit() const { return d_limit; }
@@ -120,12 +120,26 @@ bool pmt_to_bool(pmt_t val);
 //! Return true if obj is a symbol, else false.
 bool pmt_is_symbol(const pmt_t& obj);
 
-//! Return the symbol whose name is \p s.
+/*!
+ * \brief Return the symbol whose name is \p s.
+ *
+ * Safe to call from any thread, and during static initialization.
+ * Looking up an existing symbol takes no lock, but does hash the
+ * name; on hot paths intern once instead:
+ *
+ *   static const pmt_t s_data = pmt_intern("data");
+ */
 pmt_t pmt_string_to_symbol(const std::string &s);
 
+//! Return the symbol whose name is the \p len bytes at \p name.
+pmt_t pmt_string_to_symbol(const char *name, size_t len);
+
 //! Alias for pmt_string_to_symbol
 pmt_t pmt_intern(const std::string &s);
 
+//! Alias for pmt_string_to_symbol
+pmt_t pmt_intern(const char *name, size_t len);
+
 
 /*!
  * If \p is a symbol, return the name of the symbol as a string.
@@ -151,7 +165,13 @@ bool pmt_is_number(pmt_t obj);
 //! Return true if \p x is an integer number, else false
 bool pmt_is_integer(pmt_t x);
 
-//! Return the pmt value that represents the integer \p x.
+/*!
+ * \brief Return the pmt value that represents the integer \p x.
+ *
+ * Small integers (-128 to 1023) are shared and never freed, so
+ * pmt_eq may or may not be true of two equal integers.  Compare
+ * numbers with pmt_eqv.
+ */
 pmt_t pmt_from_long(long x);
 
 /*!
@@ -468,11 +488,20 @@ std::complex<double> *pmt_c64vector_writable_elements(pmt_t v, size_t &len); //<
  *
  * This is a functional data structure that is persistent.  Updating a
  * functional data structure does not destroy the existing version, but
- * rather creates a new version that coexists with the old.
+ * rather creates a new version that coexists with the old.  The versions
+ * share all but the O(log n) nodes the update touched, so passing a
+ * message on with one field changed is cheap.  Lookups hash the key and
+ * compare with pmt_eqv.  Keys, values and items are returned most
+ * recently added first.
  * ------------------------------------------------------------------------
  */
 
-//! Return true if \p obj is a dictionary
+/*!
+ * \brief Return true if \p obj is a dictionary.
+ *
+ * PMT_NIL counts as an empty one, and an a-list of (key . value) pairs,
+ * what dictionaries used to be, is accepted by all the pmt_dict_* functions.
+ */
 bool pmt_is_dict(const pmt_t &obj);
 
 //! Make an empty dictionary
@@ -765,6 +794,51 @@ bool pmt_serialize(pmt_t obj, std::streambuf &sink);
  */
 pmt_t pmt_deserialize(std::streambuf &source);
 
+/*
+ * The same representation in a contiguous buffer.  Uniform vector
+ * items are aligned relative to the start of the buffer and written
+ * in host byte order (the representation records which), so they're
+ * copied with memcpy and, when the buffer is suitably aligned, can be
+ * read back without copying at all.
+ */
+
+/*!
+ * \brief Return the number of bytes pmt_serialize_to_buffer will write for \p obj.
+ */
+size_t pmt_serialized_size(pmt_t obj);
+
+/*!
+ * \brief Write the representation of \p obj to buf[0, len).
+ *
+ * \returns the number of bytes written, or 0 (having written nothing)
+ * if \p len is less than pmt_serialized_size(obj).
+ */
+size_t pmt_serialize_to_buffer(pmt_t obj, void *buf, size_t len);
+
+/*!
+ * \brief Create obj from the representation at the start of buf[0, len).
+ *
+ * Returns PMT_EOF if \p len is 0.  If \p nused is non-zero, the
+ * number of bytes used is stored there, so that objects written
+ * back to back can be read one after another.  Throws pmt_exception
+ * on malformed or truncated input.
+ */
+pmt_t pmt_deserialize_from_buffer(const void *buf, size_t len, size_t *nused = 0);
+
+/*!
+ * \brief Like above, but uniform vectors refer to their items in \p buf
+ * rather than copying them.
+ *
+ * The vectors hold a reference to \p owner, which must keep \p buf
+ * alive and unchanged.  (Pass a boost::shared_ptr with a no-op deleter
+ * if the caller guarantees that some other way.)  A vector copies its
+ * items the first time it's written to.  Items that aren't aligned in
+ * memory, or are in the other byte order, are copied regardless.
+ */
+pmt_t pmt_deserialize_from_buffer(const void *buf, size_t len,
+				  boost::shared_ptr<void> owner,
+				  size_t *nused = 0);
+
 
 void pmt_dump_sizeof();	// debugging
 
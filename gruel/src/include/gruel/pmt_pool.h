@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2009 Free Software Foundation, Inc.
+ * Copyright 2007,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,33 +23,79 @@
 
 #include <cstddef>
 #include <vector>
+#include <gruel/futex.h>
 #include <boost/thread.hpp>
 
 namespace pmt {
 
 /*!
- * \brief very simple thread-safe fixed-size allocation pool
+ * \brief pmt_pool statistics
  *
- * FIXME may want to go to global allocation with per-thread free list.
- * This would eliminate virtually all lock contention.
+ * Threads fold their hit counts into these when they go to the
+ * central pool, so nhits may lag by up to a magazine per thread.
+ */
+struct pmt_pool_stats {
+  size_t	nhits;		//!< malloc/free served by the calling thread's magazine
+  size_t	nmisses;	//!< trips to the central pool (refill or batch return)
+  size_t	nitems;		//!< items out of the central pool (in use or in magazines)
+  size_t	high_water;	//!< most items ever out of the central pool
+  size_t	nallocated;	//!< items carved from memory obtained from the system
+};
+
+/*!
+ * \brief thread-safe fixed-size allocation pool
+ *
+ * Each thread allocates from and frees into a magazine of its own
+ * without taking a lock.  A thread whose magazine runs dry takes a
+ * whole batch from the central pool; one whose magazine overflows
+ * hands a batch back.  Items are interchangeable, so an item freed by
+ * a different thread than the one that allocated it just joins the
+ * freeing thread's magazine, and a producer / consumer pair settles
+ * into passing full batches through the central pool.  A thread's
+ * magazine is returned to the central pool when the thread exits.
+ *
+ * Pools with a max_items limit, or a magazine size of 0, don't use
+ * magazines: every malloc and free takes the lock.
  */
 class pmt_pool {
 
   struct item {
     struct item	*d_next;
+    struct item	*d_next_batch;	// only in the first item of a batch
   };
-  
-  typedef boost::unique_lock<boost::mutex>  scoped_lock;
-  mutable boost::mutex 		d_mutex;
-  boost::condition_variable	d_cond;
+
+  struct magazine {
+    pmt_pool	       *d_pool;		// 0 once the pool is gone
+    item	       *d_items;
+    size_t		d_nitems;
+    size_t		d_nhits;	// not yet folded into the pool's count
+  };
+
+  typedef gruel::futex_scoped_lock scoped_lock;
+  mutable gruel::futex_mutex	d_mutex;
+  gruel::futex_condition	d_cond;
   
   size_t	      d_itemsize;
   size_t	      d_alignment;
   size_t	      d_allocation_size;
   size_t	      d_max_items;
   size_t	      d_n_items;
-  item	       	     *d_freelist;
+  size_t	      d_batch_size;	// 0 disables magazines
+  item	       	     *d_freelist;	// loose items
+  item		     *d_batches;	// full batches of d_batch_size items
   std::vector<char *> d_allocations;
+  std::vector<magazine *> d_magazines;
+  boost::thread_specific_ptr<magazine> d_magazine;
+  pmt_pool_stats      d_stats;
+
+  void new_chunk();
+  void count_out(size_t n);
+  void refill(magazine *m);
+  void spill(magazine *m);
+  void drain(magazine *m);
+  magazine *new_magazine();
+  magazine *my_magazine();
+  static void release_magazine(magazine *m);
 
 public:
   /*!
@@ -58,13 +104,21 @@ public:
    * \param allocation_size number of bytes to allocate at a time from the underlying allocator.
    * \param max_items is the maximum number of items to allocate.  If this number is exceeded,
    *	      the allocate blocks.  0 implies no limit.
+   * \param batch_size number of items moved between a thread's magazine and the
+   *	      central pool at a time.  A magazine holds up to twice that.  0 disables magazines.
    */
   pmt_pool(size_t itemsize, size_t alignment = 16,
-	   size_t allocation_size = 4096, size_t max_items = 0);
+	   size_t allocation_size = 4096, size_t max_items = 0,
+	   size_t batch_size = 32);
   ~pmt_pool();
 
   void *malloc();
   void free(void *p);
+
+  //! Return the calling thread's magazine to the central pool.
+  void flush();
+
+  pmt_pool_stats stats() const;
 };
 
 } /* namespace pmt */
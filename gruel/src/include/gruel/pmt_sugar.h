@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2009 Free Software Foundation, Inc.
+ * Copyright 2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -39,7 +39,7 @@ namespace pmt {
   static inline pmt_t
   mp(const char *s)
   {
-    return pmt_string_to_symbol(s);
+    return pmt_string_to_symbol(s, std::char_traits<char>::length(s));
   }
 
   //! Make pmt long
@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_GRUEL_SEQLOCK_H
+#define INCLUDED_GRUEL_SEQLOCK_H
+
+#include <gruel/futex.h>
+
+namespace gruel {
+
+  /*!
+   * \brief sequence lock: readers never block writers, or each other
+   *
+   * For small, often read and seldom written data such as statistics
+   * or settings.  Writers serialize on a futex_mutex and bump a
+   * sequence number before and after they write.  Readers copy the data
+   * out without taking any lock, and try again if a write overlapped:
+   *
+   * \code
+   *   unsigned int seq;
+   *   do {
+   *     seq = lock.read_begin();
+   *     copy = data;
+   *   } while (lock.read_retry(seq));
+   * \endcode
+   *
+   * A reader may see torn data before read_retry says so, so it must
+   * only copy: no following pointers or dividing by what it read.
+   */
+  class seqlock : boost::noncopyable {
+    volatile unsigned int d_seq;	// odd while a write is in progress
+    futex_mutex		d_writer;
+
+  public:
+    seqlock() : d_seq(0) {}
+
+    unsigned int read_begin() const
+    {
+      spin_backoff backoff;
+      unsigned int seq;
+      while ((seq = atomic_load(&d_seq)) & 1)
+	backoff.pause();
+      return seq;
+    }
+
+    //! \returns true if the data read since read_begin may be inconsistent
+    bool read_retry(unsigned int seq) const
+    {
+      memory_barrier();		// our reads of the data are done first
+      return d_seq != seq;
+    }
+
+    void write_lock()
+    {
+      d_writer.lock();
+      d_seq = d_seq + 1;
+      memory_barrier();		// readers see the odd count before any data
+    }
+
+    void write_unlock()
+    {
+      memory_barrier();		// the data is written before the even count
+      d_seq = d_seq + 1;
+      d_writer.unlock();
+    }
+  };
+
+} /* namespace gruel */
+
+#endif /* INCLUDED_GRUEL_SEQLOCK_H */
@@ -0,0 +1,215 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gruel/msg_queue.h>
+#include <gruel/thread.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <deque>
+#include <vector>
+
+using namespace pmt;
+
+/*
+ * Time gruel::msg_queue against the mutex and condition variable
+ * queue it replaced (locked_queue below):
+ *
+ *   - insert / remove on one thread, nobody waiting
+ *   - latency: a message bounced between two threads through a pair
+ *     of queues, each side sleeping in delete_head
+ *   - throughput: 1 to 4 producers into one consumer, with and
+ *     without a limit, removing one at a time or in batches
+ *
+ *   benchmark_msg_queue [messages-per-measurement]
+ */
+
+// The previous gruel::msg_queue
+class locked_queue {
+  gruel::mutex              d_mutex;
+  gruel::condition_variable d_not_empty;
+  gruel::condition_variable d_not_full;
+  unsigned int		    d_limit;
+  std::deque<pmt_t>	    d_msgs;
+
+public:
+  locked_queue(unsigned int limit) : d_limit(limit) {}
+
+  void insert_tail(pmt_t msg)
+  {
+    gruel::scoped_lock guard(d_mutex);
+    while (d_limit != 0 && d_msgs.size() >= d_limit)
+      d_not_full.wait(guard);
+    d_msgs.push_back(msg);
+    d_not_empty.notify_one();
+  }
+
+  pmt_t delete_head()
+  {
+    gruel::scoped_lock guard(d_mutex);
+    while (d_msgs.empty())
+      d_not_empty.wait(guard);
+    pmt_t m(d_msgs.front());
+    d_msgs.pop_front();
+    if (d_limit > 0)
+      d_not_full.notify_one();
+    return m;
+  }
+
+  pmt_t delete_head_nowait()
+  {
+    gruel::scoped_lock guard(d_mutex);
+    if (d_msgs.empty())
+      return pmt_t();
+    pmt_t m(d_msgs.front());
+    d_msgs.pop_front();
+    if (d_limit > 0)
+      d_not_full.notify_one();
+    return m;
+  }
+
+  size_t delete_all(std::vector<pmt_t> &msgs)
+  {
+    gruel::scoped_lock guard(d_mutex);
+    size_t n = d_msgs.size();
+    msgs.insert(msgs.end(), d_msgs.begin(), d_msgs.end());
+    d_msgs.clear();
+    if (d_limit > 0)
+      d_not_full.notify_all();
+    return n;
+  }
+};
+
+static double
+wall_seconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static void
+report(const char *what, const char *impl, double t0, long nops)
+{
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%s (%s):", what, impl);
+  printf("%-44s %8.1f ns\n", buf, (wall_seconds() - t0) / nops * 1e9);
+}
+
+template<class Q>
+static void
+produce(Q *q, long nmsgs)
+{
+  pmt_t msg = pmt_from_long(1);
+  for (long i = 0; i < nmsgs; i++)
+    q->insert_tail(msg);
+}
+
+template<class Q>
+static void
+echo(Q *in, Q *out, long nmsgs)
+{
+  for (long i = 0; i < nmsgs; i++)
+    out->insert_tail(in->delete_head());
+}
+
+template<class Q>
+static void
+benchmark(const char *impl, long nmsgs)
+{
+  {
+    Q q(0);
+    pmt_t msg = pmt_from_long(1);
+    double t0 = wall_seconds();
+    for (long i = 0; i < nmsgs; i++){
+      q.insert_tail(msg);
+      q.delete_head_nowait();
+    }
+    report("insert + delete, 1 thread", impl, t0, nmsgs);
+  }
+
+  {
+    Q ping(0), pong(0);
+    long n = nmsgs / 10;
+    pmt_t msg = pmt_from_long(1);
+    double t0 = wall_seconds();
+    boost::thread t(boost::bind(echo<Q>, &ping, &pong, n));
+    for (long i = 0; i < n; i++){
+      ping.insert_tail(msg);
+      pong.delete_head();
+    }
+    t.join();
+    report("one-way latency, ping-pong", impl, t0, 2 * n);
+  }
+
+  static const int nproducers[] = { 1, 2, 4 };
+  static const unsigned int limits[] = { 0, 64 };
+  for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++){
+    for (size_t p = 0; p < sizeof(nproducers) / sizeof(nproducers[0]); p++){
+      for (int batch = 0; batch < 2; batch++){
+	Q q(limits[l]);
+	int np = nproducers[p];
+	long per_producer = nmsgs / np;
+	long total = per_producer * np;
+	std::vector<pmt_t> msgs;
+
+	double t0 = wall_seconds();
+	boost::thread_group producers;
+	for (int i = 0; i < np; i++)
+	  producers.create_thread(boost::bind(produce<Q>, &q, per_producer));
+
+	for (long n = 0; n < total; ){
+	  if (batch){
+	    msgs.clear();
+	    n += q.delete_all(msgs);
+	    if (msgs.empty()){		// nothing there, sleep
+	      q.delete_head();
+	      n++;
+	    }
+	  }
+	  else {
+	    q.delete_head();
+	    n++;
+	  }
+	}
+	producers.join_all();
+
+	char what[64];
+	snprintf(what, sizeof(what), "%d -> 1, limit %u, %s", np, limits[l],
+		 batch ? "delete_all" : "delete_head");
+	report(what, impl, t0, total);
+      }
+    }
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  long nmsgs = argc > 1 ? atol(argv[1]) : 1000000;
+
+  benchmark<locked_queue>("locked", nmsgs);
+  benchmark<gruel::msg_queue>("lock-free", nmsgs);
+  return 0;
+}
@@ -0,0 +1,333 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gruel/pmt.h>
+#include <gruel/pmt_pool.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+using namespace pmt;
+
+/*
+ * Time making, inspecting and copying (reference counting) the basic
+ * objects, pmt_pool malloc / free with and without per-thread
+ * magazines, interning existing symbols, serializing through a
+ * streambuf and to a contiguous buffer, and pmt_dict_add, pmt_dict_ref
+ * and pmt_dict_delete on dicts of 1 to 1000 symbol keys, next to the
+ * a-list (pmt_acons / pmt_assv) that used to implement dicts.
+ *
+ *   benchmark_pmt [operations-per-measurement]
+ */
+
+static double
+wall_seconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static void
+report(const char *what, double t0, long nops)
+{
+  printf("%-36s %7.1f ns\n", what, (wall_seconds() - t0) / nops * 1e9);
+}
+
+static void
+benchmark_construct(long nops)
+{
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_from_long(i & 511);
+  report("pmt_from_long (small):", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_from_long(i + 100000);
+  report("pmt_from_long (large):", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_from_double(i);
+  report("pmt_from_double:", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_cons(PMT_NIL, PMT_NIL);
+  report("pmt_cons:", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_make_u8vector(16, 0);
+  report("pmt_make_u8vector (16):", t0, nops);
+}
+
+static void
+benchmark_access(long nops)
+{
+  pmt_t num = pmt_from_long(100000);
+  pmt_t pair = pmt_cons(num, PMT_NIL);
+  pmt_t vec = pmt_make_f32vector(16, 1.0);
+  pmt_t obj[] = { num, pair, vec, PMT_T };
+
+  long n = 0;
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    n += pmt_is_pair(obj[i & 3]) + pmt_is_uniform_vector(obj[i & 3]);
+  report("pmt_is_pair + pmt_is_uniform_vector:", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    n += pmt_to_long(num);
+  report("pmt_to_long:", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    n += pmt_to_long(pmt_car(pair));
+  report("pmt_to_long(pmt_car):", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    n += (long) pmt_f32vector_ref(vec, i & 15);
+  report("pmt_f32vector_ref:", t0, nops);
+
+  if (n == 0)
+    fprintf(stderr, "benchmark_pmt: access failed\n");
+}
+
+static void
+benchmark_refcount(long nops)
+{
+  pmt_t heap = pmt_from_long(100000);
+  pmt_t immortal = pmt_from_long(1);
+
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    pmt_t x = heap;
+  }
+  report("copy pmt_t (heap object):", t0, nops);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    pmt_t x = immortal;
+  }
+  report("copy pmt_t (small integer):", t0, nops);
+}
+
+static void
+pool_churn(pmt_pool *pool, long nops)
+{
+  void *p[16];
+  for (long i = 0; i < nops; i += 16){
+    for (int k = 0; k < 16; k++)
+      p[k] = pool->malloc();
+    for (int k = 0; k < 16; k++)
+      pool->free(p[k]);
+  }
+}
+
+static void
+benchmark_pool(long nops)
+{
+  static const int NTHREADS = 4;
+
+  for (int batch = 0; batch <= 32; batch += 32){
+    pmt_pool pool(64, 16, 4096, 0, batch);
+    char what[64];
+
+    double t0 = wall_seconds();
+    pool_churn(&pool, nops);
+    snprintf(what, sizeof(what), "pmt_pool (batch %d):", batch);
+    report(what, t0, 2 * nops);
+
+    boost::thread_group threads;
+    t0 = wall_seconds();
+    for (int t = 0; t < NTHREADS; t++)
+      threads.create_thread(boost::bind(pool_churn, &pool, nops / NTHREADS));
+    threads.join_all();
+    snprintf(what, sizeof(what), "pmt_pool (batch %d, %d threads):", batch, NTHREADS);
+    report(what, t0, 2 * nops);
+  }
+}
+
+static void
+benchmark_intern(long nops)
+{
+  static const int NSYMBOLS = 10000;
+  std::vector<std::string> names;
+  for (int i = 0; i < NSYMBOLS; i++){
+    char name[32];
+    snprintf(name, sizeof(name), "benchmark-symbol-%d", i);
+    names.push_back(name);
+    pmt_intern(name);
+  }
+
+  long n = 0;
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    const std::string &name = names[i % NSYMBOLS];
+    n += pmt_is_symbol(pmt_intern(name.data(), name.size()));
+  }
+  double t_intern = (wall_seconds() - t0) / nops;
+
+  if (n != nops)
+    fprintf(stderr, "benchmark_pmt: intern failed\n");
+
+  printf("intern (existing, %d symbols):    %7.1f ns\n", NSYMBOLS, t_intern * 1e9);
+}
+
+// serialize and deserialize obj nops times each way, both ways
+static void
+benchmark_serialize(const char *what, pmt_t obj, long nops)
+{
+  std::stringbuf sb;
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    sb.str("");
+    pmt_serialize(obj, sb);
+  }
+  double t_stream_out = (wall_seconds() - t0) / nops;
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    sb.pubseekpos(0, std::ios_base::in);
+    pmt_t x = pmt_deserialize(sb);
+  }
+  double t_stream_in = (wall_seconds() - t0) / nops;
+
+  std::vector<double> storage(pmt_serialized_size(obj) / sizeof(double) + 1);
+  void *buf = &storage[0];
+  size_t len = storage.size() * sizeof(double);
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_serialize_to_buffer(obj, buf, len);
+  double t_buffer_out = (wall_seconds() - t0) / nops;
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_deserialize_from_buffer(buf, len);
+  double t_buffer_in = (wall_seconds() - t0) / nops;
+
+  boost::shared_ptr<void> owner(new int(0));
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    pmt_t x = pmt_deserialize_from_buffer(buf, len, owner);
+  double t_alias_in = (wall_seconds() - t0) / nops;
+
+  if (!pmt_equal(pmt_deserialize_from_buffer(buf, len), obj))
+    fprintf(stderr, "benchmark_pmt: serialize failed\n");
+
+  printf("%-12s streambuf: %9.1f / %9.1f ns  buffer: %9.1f / %9.1f ns  (aliased in %7.1f ns)\n",
+	 what, t_stream_out * 1e9, t_stream_in * 1e9,
+	 t_buffer_out * 1e9, t_buffer_in * 1e9, t_alias_in * 1e9);
+}
+
+static void
+benchmark_serialize(long nops)
+{
+  printf("serialize out / in:\n");
+
+  pmt_t msg = pmt_list4(pmt_intern("tune"),
+			pmt_cons(pmt_intern("freq"), pmt_from_double(2.4e9)),
+			pmt_cons(pmt_intern("gain"), pmt_from_long(30)),
+			pmt_cons(pmt_intern("chan"), pmt_from_long(0)));
+  benchmark_serialize("control msg", msg, nops);
+
+  long nvops = std::max(nops / 1000, 100L);
+  benchmark_serialize("64k u8", pmt_make_u8vector(65536, 0x55), nvops);
+  benchmark_serialize("64k c32", pmt_make_c32vector(65536, 1), nvops);
+}
+
+static void
+benchmark_dict(size_t nkeys, long nops)
+{
+  std::vector<pmt_t> keys;
+  for (size_t i = 0; i < nkeys; i++){
+    char name[32];
+    snprintf(name, sizeof(name), "benchmark-key-%zd", i);
+    keys.push_back(pmt_string_to_symbol(name));
+  }
+
+  pmt_t dict = pmt_make_dict();
+  pmt_t alist = PMT_NIL;
+  for (size_t i = 0; i < nkeys; i++){
+    dict = pmt_dict_add(dict, keys[i], PMT_T);
+    alist = pmt_acons(keys[i], PMT_T, alist);
+  }
+
+  long nfound = 0;
+  double t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    nfound += pmt_dict_has_key(dict, keys[i % nkeys]);
+  double t_ref = (wall_seconds() - t0) / nops;
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++)
+    nfound += pmt_is_pair(pmt_assv(keys[i % nkeys], alist));
+  double t_assv = (wall_seconds() - t0) / nops;
+
+  // replace a key, as when forking a message with one field changed
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    pmt_t d = pmt_dict_add(dict, keys[i % nkeys], PMT_F);
+  }
+  double t_add = (wall_seconds() - t0) / nops;
+
+  t0 = wall_seconds();
+  for (long i = 0; i < nops; i++){
+    pmt_t d = pmt_dict_delete(dict, keys[i % nkeys]);
+  }
+  double t_delete = (wall_seconds() - t0) / nops;
+
+  if (nfound != 2 * nops)
+    fprintf(stderr, "benchmark_pmt: lookup failed\n");
+
+  printf("%6zd keys:  ref: %7.1f ns  (a-list %9.1f ns)  add: %7.1f ns  delete: %7.1f ns\n",
+	 nkeys, t_ref * 1e9, t_assv * 1e9, t_add * 1e9, t_delete * 1e9);
+}
+
+int
+main(int argc, char **argv)
+{
+  long nops = argc > 1 ? atol(argv[1]) : 200000;
+
+  benchmark_construct(nops);
+  benchmark_access(nops);
+  benchmark_refcount(nops);
+  benchmark_pool(nops);
+  benchmark_intern(nops);
+  benchmark_serialize(nops);
+
+  static const size_t nkeys[] = { 1, 3, 10, 30, 100, 300, 1000 };
+  for (size_t i = 0; i < sizeof(nkeys) / sizeof(nkeys[0]); i++)
+    benchmark_dict(nkeys[i], nops);
+
+  return 0;
+}
@@ -0,0 +1,316 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gruel/futex.h>
+#include <gruel/event_count.h>
+#include <gruel/seqlock.h>
+#include <gruel/thread.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+/*
+ * Time the primitives in gruel/futex.h against the pthread mutex and
+ * condition variable (via boost) that omni_mutex and omni_condition
+ * wrap on POSIX systems:
+ *
+ *   - lock, increment, unlock on 1, 2 and 4 threads sharing one lock
+ *   - latency: a token passed back and forth between two threads,
+ *     each sleeping until it's their turn
+ *   - reading a small struct that a writer keeps updating, with 1, 2
+ *     and 4 readers: under a mutex vs. through a seqlock
+ *
+ *   benchmark_sync [operations-per-measurement]
+ */
+
+static double
+wall_seconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+static void
+report(const char *what, const char *impl, double t0, long nops)
+{
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%s (%s):", what, impl);
+  printf("%-44s %8.1f ns\n", buf, (wall_seconds() - t0) / nops * 1e9);
+}
+
+// ----------------------------------------------------------------
+//			    contended mutex
+// ----------------------------------------------------------------
+
+template<class Mutex>
+struct counter {
+  Mutex		d_mutex;
+  long		d_count;
+
+  counter() : d_count(0) {}
+};
+
+template<class Mutex, class Lock>
+static void
+increment(counter<Mutex> *c, long n)
+{
+  for (long i = 0; i < n; i++){
+    Lock guard(c->d_mutex);
+    c->d_count++;
+  }
+}
+
+template<class Mutex, class Lock>
+static void
+benchmark_mutex(const char *impl, long nops)
+{
+  static const int nthreads[] = { 1, 2, 4 };
+  for (size_t t = 0; t < sizeof(nthreads) / sizeof(nthreads[0]); t++){
+    counter<Mutex> c;
+    long per_thread = nops / nthreads[t];
+
+    double t0 = wall_seconds();
+    boost::thread_group threads;
+    for (int i = 0; i < nthreads[t]; i++)
+      threads.create_thread(boost::bind(increment<Mutex, Lock>, &c, per_thread));
+    threads.join_all();
+
+    if (c.d_count != per_thread * nthreads[t])
+      fprintf(stderr, "benchmark_sync: lost %ld increments\n",
+	      per_thread * nthreads[t] - c.d_count);
+
+    char what[64];
+    snprintf(what, sizeof(what), "lock + unlock, %d thread%s", nthreads[t],
+	     nthreads[t] == 1 ? "" : "s");
+    report(what, impl, t0, per_thread * nthreads[t]);
+  }
+}
+
+// ----------------------------------------------------------------
+//			  ping-pong handoff
+// ----------------------------------------------------------------
+
+// whose turn it is, guarded by a mutex and condition variable
+template<class Mutex, class Lock, class Cond>
+class cond_turn {
+  Mutex		d_mutex;
+  Cond		d_cond;
+  int		d_turn;
+
+public:
+  cond_turn() : d_turn(0) {}
+
+  void wait_for(int who)
+  {
+    Lock guard(d_mutex);
+    while (d_turn != who)
+      d_cond.wait(guard);
+  }
+
+  void pass_to(int who)
+  {
+    Lock guard(d_mutex);
+    d_turn = who;
+    d_cond.notify_all();
+  }
+};
+
+typedef cond_turn<gruel::mutex, gruel::scoped_lock,
+		  gruel::condition_variable> pthread_turn;
+
+typedef cond_turn<gruel::futex_mutex, gruel::futex_scoped_lock,
+		  gruel::futex_condition> futex_turn;
+
+// whose turn it is, in a plain word with an event_count to sleep on
+class event_count_turn {
+  gruel::event_count	d_changed;
+  volatile int		d_turn;
+
+public:
+  event_count_turn() : d_turn(0) {}
+
+  void wait_for(int who)
+  {
+    while (gruel::atomic_load(&d_turn) != who){
+      gruel::event_count::key_type key = d_changed.prepare_wait();
+      if (d_turn == who)
+	break;
+      d_changed.wait(key);
+    }
+  }
+
+  void pass_to(int who)
+  {
+    gruel::atomic_store(&d_turn, who);
+    d_changed.notify_all();
+  }
+};
+
+template<class Turn>
+static void
+pong(Turn *turn, long n)
+{
+  for (long i = 0; i < n; i++){
+    turn->wait_for(1);
+    turn->pass_to(0);
+  }
+}
+
+template<class Turn>
+static void
+benchmark_handoff(const char *impl, long nops)
+{
+  Turn turn;
+  long n = nops / 10;
+
+  double t0 = wall_seconds();
+  boost::thread t(boost::bind(pong<Turn>, &turn, n));
+  for (long i = 0; i < n; i++){
+    turn.pass_to(1);
+    turn.wait_for(0);
+  }
+  t.join();
+  report("one-way latency, ping-pong", impl, t0, 2 * n);
+}
+
+// ----------------------------------------------------------------
+//			   readers vs. writer
+// ----------------------------------------------------------------
+
+struct stats {
+  long	a, b, c, d;	// a writer keeps them equal
+};
+
+class locked_stats {
+  gruel::futex_mutex	d_mutex;
+  stats			d_stats;
+
+public:
+  locked_stats() { d_stats.a = d_stats.b = d_stats.c = d_stats.d = 0; }
+
+  stats read()
+  {
+    gruel::futex_scoped_lock guard(d_mutex);
+    return d_stats;
+  }
+
+  void write(long v)
+  {
+    gruel::futex_scoped_lock guard(d_mutex);
+    d_stats.a = d_stats.b = d_stats.c = d_stats.d = v;
+  }
+};
+
+class seqlock_stats {
+  gruel::seqlock	d_lock;
+  stats			d_stats;
+
+public:
+  seqlock_stats() { d_stats.a = d_stats.b = d_stats.c = d_stats.d = 0; }
+
+  stats read()
+  {
+    volatile stats *p = &d_stats;
+    stats s;
+    unsigned int seq;
+    do {
+      seq = d_lock.read_begin();
+      s.a = p->a; s.b = p->b; s.c = p->c; s.d = p->d;
+    } while (d_lock.read_retry(seq));
+    return s;
+  }
+
+  void write(long v)
+  {
+    d_lock.write_lock();
+    d_stats.a = d_stats.b = d_stats.c = d_stats.d = v;
+    d_lock.write_unlock();
+  }
+};
+
+template<class S>
+static void
+reader(S *s, long n)
+{
+  for (long i = 0; i < n; i++){
+    stats v = s->read();
+    if (v.a != v.d)
+      fprintf(stderr, "benchmark_sync: torn read\n");
+  }
+}
+
+template<class S>
+static void
+writer(S *s, volatile bool *done)
+{
+  for (long v = 1; !*done; v++){
+    s->write(v);
+    boost::this_thread::yield();	// mostly reads, as for real statistics
+  }
+}
+
+template<class S>
+static void
+benchmark_readers(const char *impl, long nops)
+{
+  static const int nreaders[] = { 1, 2, 4 };
+  for (size_t r = 0; r < sizeof(nreaders) / sizeof(nreaders[0]); r++){
+    S s;
+    volatile bool done = false;
+    long per_reader = nops / nreaders[r];
+
+    double t0 = wall_seconds();
+    boost::thread w(boost::bind(writer<S>, &s, &done));
+    boost::thread_group readers;
+    for (int i = 0; i < nreaders[r]; i++)
+      readers.create_thread(boost::bind(reader<S>, &s, per_reader));
+    readers.join_all();
+
+    char what[64];
+    snprintf(what, sizeof(what), "read, %d reader%s + 1 writer", nreaders[r],
+	     nreaders[r] == 1 ? "" : "s");
+    report(what, impl, t0, per_reader * nreaders[r]);
+
+    done = true;
+    w.join();
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  long nops = argc > 1 ? atol(argv[1]) : 1000000;
+
+  benchmark_mutex<gruel::mutex, gruel::scoped_lock>("pthread", nops);
+  benchmark_mutex<gruel::futex_mutex, gruel::futex_scoped_lock>("futex", nops);
+
+  benchmark_handoff<pthread_turn>("pthread", nops);
+  benchmark_handoff<futex_turn>("futex", nops);
+  benchmark_handoff<event_count_turn>("event_count", nops);
+
+  benchmark_readers<locked_stats>("futex_mutex", nops);
+  benchmark_readers<seqlock_stats>("seqlock", nops);
+  return 0;
+}
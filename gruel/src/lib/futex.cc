@@ -0,0 +1,225 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gruel/futex.h>
+#include <boost/thread.hpp>
+#include <limits.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace gruel {
+
+  static const int SPIN_COUNT = 100;	// polls of ~100 cycles each
+
+  static int
+  compute_spin_count()
+  {
+#ifdef _SC_NPROCESSORS_ONLN
+    if (sysconf(_SC_NPROCESSORS_ONLN) > 1)
+      return SPIN_COUNT;
+#endif
+    return 0;
+  }
+
+  static int s_spin_count = compute_spin_count();
+
+  int
+  spin_count()
+  {
+    return s_spin_count;
+  }
+
+  void
+  spin_backoff::pause()
+  {
+    if (d_count < s_spin_count){
+      d_count++;
+      cpu_relax();
+    }
+    else
+      boost::this_thread::yield();
+  }
+
+#ifdef HAVE_LINUX_FUTEX_H
+
+#ifdef FUTEX_PRIVATE_FLAG		// Linux 2.6.22 and later
+  static const int WAIT_OP = FUTEX_WAIT | FUTEX_PRIVATE_FLAG;
+  static const int WAKE_OP = FUTEX_WAKE | FUTEX_PRIVATE_FLAG;
+#else
+  static const int WAIT_OP = FUTEX_WAIT;
+  static const int WAKE_OP = FUTEX_WAKE;
+#endif
+
+  bool
+  futex_wait(volatile int *addr, int val, const struct timespec *abs_time)
+  {
+    if (abs_time == 0){
+      syscall(SYS_futex, addr, WAIT_OP, val, 0, 0, 0);
+      return true;
+    }
+
+    // FUTEX_WAIT takes a relative timeout
+    struct timeval now;
+    gettimeofday(&now, 0);
+    struct timespec rel;
+    rel.tv_sec = abs_time->tv_sec - now.tv_sec;
+    rel.tv_nsec = abs_time->tv_nsec - now.tv_usec * 1000;
+    if (rel.tv_nsec < 0){
+      rel.tv_nsec += 1000000000;
+      rel.tv_sec--;
+    }
+    if (rel.tv_sec < 0)
+      return false;
+
+    if (syscall(SYS_futex, addr, WAIT_OP, val, &rel, 0, 0) == -1
+	&& errno == ETIMEDOUT)
+      return false;
+    return true;
+  }
+
+  void
+  futex_wake(volatile int *addr, int nwaiters)
+  {
+    syscall(SYS_futex, addr, WAKE_OP, nwaiters, 0, 0, 0);
+  }
+
+#else
+
+  /*
+   * No futexes: sleep on a condition variable picked by address.
+   * Waiters check *addr with the bucket's mutex held, and wakers take
+   * it after changing *addr, so no wakeup can slip in between.
+   * Addresses that share a bucket just see spurious wakeups.
+   */
+  struct futex_bucket {
+    boost::mutex		mutex;
+    boost::condition_variable	cond;
+  };
+
+  static const int NBUCKETS = 64;
+
+  static futex_bucket &
+  bucket(volatile int *addr)
+  {
+    static futex_bucket *s_buckets = new futex_bucket[NBUCKETS];
+    return s_buckets[(reinterpret_cast<size_t>(addr) >> 2) % NBUCKETS];
+  }
+
+  bool
+  futex_wait(volatile int *addr, int val, const struct timespec *abs_time)
+  {
+    futex_bucket &b = bucket(addr);
+    boost::unique_lock<boost::mutex> guard(b.mutex);
+    if (*addr != val)
+      return true;
+
+    if (abs_time == 0){
+      b.cond.wait(guard);
+      return true;
+    }
+
+    boost::system_time t = boost::posix_time::from_time_t(abs_time->tv_sec)
+      + boost::posix_time::microseconds(abs_time->tv_nsec / 1000);
+    return b.cond.timed_wait(guard, t);
+  }
+
+  void
+  futex_wake(volatile int *addr, int nwaiters)
+  {
+    futex_bucket &b = bucket(addr);
+    boost::unique_lock<boost::mutex> guard(b.mutex);
+    b.cond.notify_all();	// the bucket may be shared
+  }
+
+#endif
+
+  void
+  futex_wake_all(volatile int *addr)
+  {
+    futex_wake(addr, INT_MAX);
+  }
+
+  // ----------------------------------------------------------------
+  //				futex_mutex
+  // ----------------------------------------------------------------
+
+  void
+  futex_mutex::lock_slow()
+  {
+    for (int i = s_spin_count; i > 0; i--){
+      cpu_relax();
+      if (d_state == 0 && atomic_cas(&d_state, 0, 1))
+	return;
+    }
+
+    // Mark it contended, so that whoever holds it wakes us.  If it was
+    // unlocked in the meantime we have it, still marked contended: that
+    // costs one needless wake, but the mark may be somebody else's.
+    while (atomic_exchange(&d_state, 2) != 0)
+      futex_wait(&d_state, 2);
+  }
+
+  void
+  futex_mutex::unlock_slow()
+  {
+    atomic_store(&d_state, 0);
+    futex_wake(&d_state, 1);
+  }
+
+  // ----------------------------------------------------------------
+  //				futex_condition
+  // ----------------------------------------------------------------
+
+  void
+  futex_condition::wait(futex_scoped_lock &lock)
+  {
+    atomic_fetch_add(&d_nwaiters, 1);
+    int seq = d_seq;		// notify for a change we haven't seen comes after we unlock
+    lock.unlock();
+    futex_wait(&d_seq, seq);
+    atomic_fetch_add(&d_nwaiters, -1);
+    lock.lock();
+  }
+
+  bool
+  futex_condition::timed_wait(futex_scoped_lock &lock,
+			      const struct timespec &abs_time)
+  {
+    atomic_fetch_add(&d_nwaiters, 1);
+    int seq = d_seq;
+    lock.unlock();
+    bool ok = futex_wait(&d_seq, seq, &abs_time);
+    atomic_fetch_add(&d_nwaiters, -1);
+    lock.lock();
+    return ok;
+  }
+
+} /* namespace gruel */
@@ -0,0 +1,170 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gruel/mpsc_queue.h>
+#include <gruel/pmt_pool.h>
+#include <gruel/atomic.h>
+#include <boost/thread.hpp>
+#include <new>
+
+using namespace pmt;
+
+namespace gruel {
+
+  pmt_pool &
+  mpsc_queue::node_pool()
+  {
+    // Never freed: queues may be destroyed during static destruction.
+    static pmt_pool *s_pool = new pmt_pool(sizeof(node), 16, 16 * 1024);
+    return *s_pool;
+  }
+
+  mpsc_queue::node *
+  mpsc_queue::new_node()
+  {
+    node *n = new (node_pool().malloc()) node;
+    n->d_next = 0;
+    return n;
+  }
+
+  void
+  mpsc_queue::free_node(node *n)
+  {
+    n->~node();
+    node_pool().free(n);
+  }
+
+  mpsc_queue::mpsc_queue()
+    : d_count(0), d_spare(0)
+  {
+    d_front = d_back = new_node();
+  }
+
+  mpsc_queue::~mpsc_queue()
+  {
+    node *n = d_front;
+    while (n){
+      node *next = n->d_next;
+      free_node(n);
+      n = next;
+    }
+    if (d_spare)
+      free_node(d_spare);
+  }
+
+  // Called by the consumer with the old stub, whose message is gone.
+  void
+  mpsc_queue::recycle(node *n)
+  {
+    n->d_next = 0;
+    node *old = atomic_exchange(&d_spare, n);
+    if (old)
+      free_node(old);
+  }
+
+  /*
+   * Return n's successor, which the caller knows is on its way: the
+   * producer that reserved it has swapped d_back but not linked it yet.
+   * That's a window of a few instructions unless it was preempted.
+   */
+  mpsc_queue::node *
+  mpsc_queue::wait_next(node *n) const
+  {
+    node *next;
+    while ((next = atomic_load_consume(&n->d_next)) == 0)
+      boost::this_thread::yield();
+    return next;
+  }
+
+  bool
+  mpsc_queue::insert_tail(const pmt_t &msg, unsigned long limit)
+  {
+    if (limit == 0)
+      atomic_fetch_add(&d_count, 1L);
+    else {
+      long n;
+      do {
+	n = d_count;
+	if (n >= (long) limit)
+	  return false;
+      } while (!atomic_cas(&d_count, n, n + 1));
+    }
+
+    node *n = atomic_exchange(&d_spare, (node *) 0);
+    if (n == 0)
+      n = new_node();
+    n->d_msg = msg;
+
+    // The exchange is a full barrier, so n is complete before the
+    // consumer can reach it through prev.
+    node *prev = atomic_exchange(&d_back, n);
+    prev->d_next = n;
+    return true;
+  }
+
+  bool
+  mpsc_queue::delete_head(pmt_t &msg)
+  {
+    if (d_count <= 0)
+      return false;
+
+    node *front = d_front;
+    node *next = wait_next(front);
+    msg.swap(next->d_msg);	// next becomes the stub
+    next->d_msg = pmt_t();
+    d_front = next;
+    recycle(front);
+
+    atomic_fetch_add(&d_count, -1L);
+    return true;
+  }
+
+  size_t
+  mpsc_queue::delete_all(std::vector<pmt_t> &msgs)
+  {
+    long n = d_count;
+    if (n <= 0)
+      return 0;
+
+    msgs.reserve(msgs.size() + n);
+    node *front = d_front;
+    for (long i = 0; i < n; i++){
+      node *next = wait_next(front);
+      msgs.push_back(pmt_t());
+      msgs.back().swap(next->d_msg);
+      if (i == 0)
+	recycle(front);
+      else
+	free_node(front);
+      front = next;
+    }
+    d_front = front;
+
+    atomic_fetch_add(&d_count, -n);
+    return n;
+  }
+
+} /* namespace gruel */
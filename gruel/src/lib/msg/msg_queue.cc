@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2009 Free Software Foundation, Inc.
+ * Copyright 2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -25,6 +25,7 @@
 #endif
 
 #include <gruel/msg_queue.h>
+#include <gruel/atomic.h>
 #include <stdexcept>
 
 using namespace pmt;
@@ -50,28 +51,32 @@ namespace gruel {
   void
   msg_queue::insert_tail(pmt_t msg)
   {
-    gruel::scoped_lock guard(d_mutex);
-
-    while (full_p())
-      d_not_full.wait(guard);
-
-    d_msgs.push_back(msg);
-    d_not_empty.notify_one();
+    while (!d_msgs.insert_tail(msg, d_limit)){
+      event_count::key_type key = d_not_full.prepare_wait();
+      if (full_p())
+	d_not_full.wait(key);
+    }
+    d_not_empty.notify_all();
   }
 
   pmt_t
   msg_queue::delete_head()
   {
-    gruel::scoped_lock guard(d_mutex);
-
-    while (empty_p())
-      d_not_empty.wait(guard);
-
-    pmt_t m(d_msgs.front());
-    d_msgs.pop_front();
-
-    if (d_limit > 0)		// Unlimited length queues never block on write
-      d_not_full.notify_one();
+    pmt_t m;
+
+    // Sleep without d_consumer_mutex, so other removers aren't held up
+    while (1){
+      {
+	futex_scoped_lock consumer(d_consumer_mutex);
+	if (d_msgs.delete_head(m))
+	  break;
+      }
+      event_count::key_type key = d_not_empty.prepare_wait();
+      if (empty_p())
+	d_not_empty.wait(key);
+    }
+    if (d_limit != 0)		// unlimited queues never block on write
+      d_not_full.notify_all();
 
     return m;
   }
@@ -79,25 +84,35 @@ namespace gruel {
   pmt_t
   msg_queue::delete_head_nowait()
   {
-    gruel::scoped_lock guard(d_mutex);
-
-    if (empty_p())
+    if (empty_p())		// cheap poll
       return pmt_t();
-	
-    pmt_t m(d_msgs.front());
-    d_msgs.pop_front();
 
-    if (d_limit > 0)		// Unlimited length queues never block on write
-      d_not_full.notify_one();
+    futex_scoped_lock consumer(d_consumer_mutex);
+    pmt_t m;
+
+    if (d_msgs.delete_head(m) && d_limit != 0)
+      d_not_full.notify_all();
 
     return m;
   }
 
+  size_t
+  msg_queue::delete_all(std::vector<pmt_t> &msgs)
+  {
+    futex_scoped_lock consumer(d_consumer_mutex);
+
+    size_t n = d_msgs.delete_all(msgs);
+    if (n != 0 && d_limit != 0)
+      d_not_full.notify_all();
+
+    return n;
+  }
+
   void
   msg_queue::flush()
   {
-    while (delete_head_nowait() != pmt_t())
-      ;
+    std::vector<pmt_t> msgs;
+    delete_all(msgs);
   }
 
 } /* namespace gruel */
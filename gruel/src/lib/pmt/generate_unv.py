@@ -1,6 +1,6 @@
 #!/usr/bin/env python
 #
-# Copyright 2006,2009 Free Software Foundation, Inc.
+# Copyright 2006,2009,2010 Free Software Foundation, Inc.
 # 
 # This file is part of GNU Radio
 # 
@@ -130,7 +130,7 @@ def generate_h():
     output.write(header)
     output.write(guard_head(output_filename))
     for tag, typ in unv_types:
-        d = { 'TAG' : tag, 'TYPE' : typ }
+        d = { 'TAG' : tag, 'UTAG' : tag.upper(), 'TYPE' : typ }
         do_substitution(d, template, output)
     output.write(guard_tail)
 
@@ -140,7 +140,7 @@ def generate_cc():
     output.write(header)
     output.write(includes)
     for tag, typ in unv_types:
-        d = { 'TAG' : tag, 'TYPE' : typ }
+        d = { 'TAG' : tag, 'UTAG' : tag.upper(), 'TYPE' : typ }
         do_substitution(d, template, output)
 
 
@@ -176,7 +176,7 @@ def generate_qa_cc():
     output.write(header)
     output.write(qa_includes)
     for tag, typ in unv_types:
-        d = { 'TAG' : tag, 'TYPE' : typ }
+        d = { 'TAG' : tag, 'UTAG' : tag.upper(), 'TYPE' : typ }
         do_substitution(d, template, output)
     
 
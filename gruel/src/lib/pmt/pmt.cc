@@ -24,12 +24,17 @@
 #include <config.h>
 #endif
 #include <vector>
+#include <algorithm>
 #include <gruel/pmt.h>
 #include "pmt_int.h"
 #include <gruel/msg_accepter.h>
 #include <gruel/pmt_pool.h>
+#include <gruel/atomic.h>
+#include <boost/thread/thread.hpp>
+#include <boost/detail/atomic_count.hpp>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 
 namespace pmt {
 
@@ -57,8 +62,19 @@ pmt_base::operator delete(void *p, size_t size)
 
 #endif
 
-void intrusive_ptr_add_ref(pmt_base* p) { ++(p->count_); }
-void intrusive_ptr_release(pmt_base* p) { if (--(p->count_) == 0 ) delete p; }
+void
+intrusive_ptr_add_ref(pmt_base* p)
+{
+  if (!p->d_immortal)
+    gruel::atomic_fetch_add(&p->count_, 1);
+}
+
+void
+intrusive_ptr_release(pmt_base* p)
+{
+  if (!p->d_immortal && gruel::atomic_fetch_add(&p->count_, -1) == 1)
+    delete p;
+}
 
 pmt_base::~pmt_base()
 {
@@ -90,77 +106,92 @@ pmt_notimplemented::pmt_notimplemented(const std::string &msg, pmt_t obj)
 }
 
 ////////////////////////////////////////////////////////////////////////////
-//                          Dynamic Casts
+//                          Downcasts
 ////////////////////////////////////////////////////////////////////////////
 
+// The caller has already checked the type tag.
+
 static pmt_symbol *
-_symbol(pmt_t x)
+_symbol(const pmt_t &x)
 {
-  return dynamic_cast<pmt_symbol*>(x.get());
+  return static_cast<pmt_symbol*>(x.get());
 }
 
 static pmt_integer *
-_integer(pmt_t x)
+_integer(const pmt_t &x)
 {
-  return dynamic_cast<pmt_integer*>(x.get());
+  return static_cast<pmt_integer*>(x.get());
 }
 
 static pmt_real *
-_real(pmt_t x)
+_real(const pmt_t &x)
 {
-  return dynamic_cast<pmt_real*>(x.get());
+  return static_cast<pmt_real*>(x.get());
 }
 
 static pmt_complex *
-_complex(pmt_t x)
+_complex(const pmt_t &x)
 {
-  return dynamic_cast<pmt_complex*>(x.get());
+  return static_cast<pmt_complex*>(x.get());
 }
 
 static pmt_pair *
-_pair(pmt_t x)
+_pair(const pmt_t &x)
 {
-  return dynamic_cast<pmt_pair*>(x.get());
+  return static_cast<pmt_pair*>(x.get());
 }
 
 static pmt_vector *
-_vector(pmt_t x)
+_vector(const pmt_t &x)
 {
-  return dynamic_cast<pmt_vector*>(x.get());
+  return static_cast<pmt_vector*>(x.get());
 }
 
 static pmt_tuple *
-_tuple(pmt_t x)
+_tuple(const pmt_t &x)
 {
-  return dynamic_cast<pmt_tuple*>(x.get());
+  return static_cast<pmt_tuple*>(x.get());
 }
 
 static pmt_uniform_vector *
-_uniform_vector(pmt_t x)
+_uniform_vector(const pmt_t &x)
+{
+  return static_cast<pmt_uniform_vector*>(x.get());
+}
+
+static pmt_dict *
+_dict(const pmt_t &x)
 {
-  return dynamic_cast<pmt_uniform_vector*>(x.get());
+  return static_cast<pmt_dict*>(x.get());
 }
 
 static pmt_any *
-_any(pmt_t x)
+_any(const pmt_t &x)
 {
-  return dynamic_cast<pmt_any*>(x.get());
+  return static_cast<pmt_any*>(x.get());
 }
 
 ////////////////////////////////////////////////////////////////////////////
 //                           Globals
 ////////////////////////////////////////////////////////////////////////////
 
-const pmt_t PMT_T = pmt_t(new pmt_bool());		// singleton
-const pmt_t PMT_F = pmt_t(new pmt_bool());		// singleton
-const pmt_t PMT_NIL = pmt_t(new pmt_null());		// singleton
+static pmt_base *
+immortal(pmt_base *p)
+{
+  p->make_immortal();
+  return p;
+}
+
+const pmt_t PMT_T = pmt_t(immortal(new pmt_bool()));	// singleton
+const pmt_t PMT_F = pmt_t(immortal(new pmt_bool()));	// singleton
+const pmt_t PMT_NIL = pmt_t(immortal(new pmt_null()));	// singleton
 const pmt_t PMT_EOF = pmt_cons(PMT_NIL, PMT_NIL);	// singleton
 
 ////////////////////////////////////////////////////////////////////////////
 //                           Booleans
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_bool::pmt_bool(){}
+pmt_bool::pmt_bool() : pmt_base(PMT_TYPE_BOOL) {}
 
 bool
 pmt_is_true(pmt_t obj)
@@ -200,51 +231,140 @@ pmt_to_bool(pmt_t val)
 //                             Symbols
 ////////////////////////////////////////////////////////////////////////////
 
-static const unsigned int SYMBOL_HASH_TABLE_SIZE = 701;
-static std::vector<pmt_t> s_symbol_hash_table(SYMBOL_HASH_TABLE_SIZE);
+/*
+ * Symbols live forever in an open addressing table of pointers.
+ *
+ * Looking up an existing symbol takes no lock: a table and the
+ * symbols in it are only published once they're complete.  Adding one
+ * takes a spin lock, rechecks and, if the table is half full, copies
+ * it into one twice the size.  A reader still in the old table may
+ * miss the newest symbols there, but then it comes round here and
+ * finds them under the lock.  Old tables are never freed, as someone
+ * may still be reading one; together they're smaller than the current
+ * table.
+ *
+ * None of this state has a constructor, so symbols can be interned
+ * during static initialization in any library.
+ */
+
+struct symbol_table {
+  size_t		mask;		// number of slots - 1
+  pmt_symbol * volatile	slots[1];
+};
 
-pmt_symbol::pmt_symbol(const std::string &name) : d_name(name){}
+static symbol_table * volatile	s_symbol_table;	// 0 until the first symbol
+static volatile int		s_symbol_lock;
+static size_t			s_nsymbols;	// guarded by s_symbol_lock
 
+static const size_t SYMBOL_TABLE_INITIAL_SIZE = 1024;
 
+pmt_symbol::pmt_symbol(const std::string &name, unsigned hash)
+  : pmt_base(PMT_TYPE_SYMBOL), d_name(name), d_hash(hash) {}
+
+// FNV-1a, then the MurmurHash3 finalizer to spread the low bits we index with
 static unsigned int
-hash_string(const std::string &s)
+hash_string(const char *s, size_t len)
 {
-  unsigned int h = 0;
-  unsigned int g = 0;
+  unsigned long long h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; i++){
+    h ^= (unsigned char) s[i];
+    h *= 0x100000001b3ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (unsigned int) h;
+}
 
-  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p){
-    h = (h << 4) + (*p & 0xff);
-    g = h & 0xf0000000;
-    if (g){
-      h = h ^ (g >> 24);
-      h = h ^ g;
-    }
+static symbol_table *
+new_symbol_table(size_t nslots)
+{
+  void *p = calloc(1, sizeof(symbol_table) + (nslots - 1) * sizeof(pmt_symbol *));
+  if (p == 0)
+    throw std::bad_alloc();
+  symbol_table *t = (symbol_table *) p;
+  t->mask = nslots - 1;
+  return t;
+}
+
+static pmt_symbol *
+symbol_lookup(const symbol_table *t, const char *name, size_t len, unsigned hash)
+{
+  if (t == 0)
+    return 0;
+
+  for (size_t i = hash & t->mask; ; i = (i + 1) & t->mask){
+    pmt_symbol *sym = gruel::atomic_load_consume(&t->slots[i]);
+    if (sym == 0)
+      return 0;
+    if (sym->hash() == hash && sym->has_name(name, len))
+      return sym;
   }
-  return h;
 }
 
+static void
+symbol_insert(symbol_table *t, pmt_symbol *sym)
+{
+  size_t i = sym->hash() & t->mask;
+  while (t->slots[i] != 0)
+    i = (i + 1) & t->mask;
+  gruel::atomic_store(&t->slots[i], sym);
+}
+
+class symbol_table_lock {
+public:
+  symbol_table_lock() {
+    while (!gruel::atomic_cas(&s_symbol_lock, 0, 1))
+      boost::this_thread::yield();
+  }
+  ~symbol_table_lock() { gruel::atomic_store(&s_symbol_lock, 0); }
+};
+
 bool 
 pmt_is_symbol(const pmt_t& obj)
 {
   return obj->is_symbol();
 }
 
+pmt_t
+pmt_string_to_symbol(const char *name, size_t len)
+{
+  unsigned hash = hash_string(name, len);
+
+  pmt_symbol *sym = symbol_lookup(gruel::atomic_load_consume(&s_symbol_table),
+				  name, len, hash);
+  if (sym)
+    return pmt_t(sym);
+
+  symbol_table_lock lock;
+
+  symbol_table *t = s_symbol_table;
+  sym = symbol_lookup(t, name, len, hash);
+  if (sym)
+    return pmt_t(sym);		// somebody beat us to it
+
+  if (t == 0 || 2 * (s_nsymbols + 1) > t->mask + 1){
+    symbol_table *bigger =
+      new_symbol_table(t ? 2 * (t->mask + 1) : SYMBOL_TABLE_INITIAL_SIZE);
+    if (t)
+      for (size_t i = 0; i <= t->mask; i++)
+	if (t->slots[i])
+	  symbol_insert(bigger, t->slots[i]);
+    gruel::atomic_store(&s_symbol_table, bigger);
+    t = bigger;
+  }
+
+  sym = new pmt_symbol(std::string(name, len), hash);
+  sym->make_immortal();		// the table never lets go of it
+  symbol_insert(t, sym);
+  s_nsymbols++;
+  return pmt_t(sym);
+}
+
 pmt_t 
 pmt_string_to_symbol(const std::string &name)
 {
-  unsigned hash = hash_string(name) % SYMBOL_HASH_TABLE_SIZE;
-
-  // Does a symbol with this name already exist?
-  for (pmt_t sym = s_symbol_hash_table[hash]; sym; sym = _symbol(sym)->next()){
-    if (name == _symbol(sym)->name())
-      return sym;		// Yes.  Return it
-  }
-
-  // Nope.  Make a new one.
-  pmt_t sym = pmt_t(new pmt_symbol(name));
-  _symbol(sym)->set_next(s_symbol_hash_table[hash]);
-  s_symbol_hash_table[hash] = sym;
-  return sym;
+  return pmt_string_to_symbol(name.data(), name.size());
 }
 
 // alias...
@@ -254,6 +374,12 @@ pmt_intern(const std::string &name)
   return pmt_string_to_symbol(name);
 }
 
+pmt_t
+pmt_intern(const char *name, size_t len)
+{
+  return pmt_string_to_symbol(name, len);
+}
+
 const std::string
 pmt_symbol_to_string(const pmt_t& sym)
 {
@@ -279,7 +405,8 @@ pmt_is_number(pmt_t x)
 //                             Integer
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_integer::pmt_integer(long value) : d_value(value) {}
+pmt_integer::pmt_integer(long value)
+  : pmt_base(PMT_TYPE_INTEGER), d_value(value) {}
 
 bool
 pmt_is_integer(pmt_t x)
@@ -288,18 +415,44 @@ pmt_is_integer(pmt_t x)
 }
 
 
+/*
+ * Small integers (message ids, channel numbers, lengths, ...) are
+ * preallocated and immortal, so making and dropping them costs neither
+ * an allocation nor an atomic op.  The cache is filled by a static
+ * initializer; until then pmt_from_long just allocates.
+ */
+static const long SMALL_INTEGER_MIN = -128;
+static const long SMALL_INTEGER_MAX = 1023;
+
+static pmt_integer *s_small_integer[SMALL_INTEGER_MAX - SMALL_INTEGER_MIN + 1];
+
+static struct small_integer_init {
+  small_integer_init()
+  {
+    for (long i = SMALL_INTEGER_MIN; i <= SMALL_INTEGER_MAX; i++){
+      pmt_integer *p = new pmt_integer(i);
+      p->make_immortal();
+      s_small_integer[i - SMALL_INTEGER_MIN] = p;
+    }
+  }
+} s_small_integer_init;
+
 pmt_t
 pmt_from_long(long x)
 {
+  if (x >= SMALL_INTEGER_MIN && x <= SMALL_INTEGER_MAX){
+    pmt_integer *p = s_small_integer[x - SMALL_INTEGER_MIN];
+    if (p)
+      return pmt_t(p);
+  }
   return pmt_t(new pmt_integer(x));
 }
 
 long
 pmt_to_long(pmt_t x)
 {
-  pmt_integer* i = dynamic_cast<pmt_integer*>(x.get());
-  if ( i )
-    return i->value();
+  if (x->is_integer())
+    return _integer(x)->value();
 
   throw pmt_wrong_type("pmt_to_long", x);
 }
@@ -308,7 +461,8 @@ pmt_to_long(pmt_t x)
 //                              Real
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_real::pmt_real(double value) : d_value(value) {}
+pmt_real::pmt_real(double value)
+  : pmt_base(PMT_TYPE_REAL), d_value(value) {}
 
 bool 
 pmt_is_real(pmt_t x)
@@ -337,7 +491,8 @@ pmt_to_double(pmt_t x)
 //                              Complex
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_complex::pmt_complex(std::complex<double> value) : d_value(value) {}
+pmt_complex::pmt_complex(std::complex<double> value)
+  : pmt_base(PMT_TYPE_COMPLEX), d_value(value) {}
 
 bool 
 pmt_is_complex(pmt_t x)
@@ -368,8 +523,9 @@ pmt_to_complex(pmt_t x)
 //                              Pairs
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_null::pmt_null() {}
-pmt_pair::pmt_pair(const pmt_t& car, const pmt_t& cdr) : d_car(car), d_cdr(cdr) {}
+pmt_null::pmt_null() : pmt_base(PMT_TYPE_NULL) {}
+pmt_pair::pmt_pair(const pmt_t& car, const pmt_t& cdr)
+  : pmt_base(PMT_TYPE_PAIR), d_car(car), d_cdr(cdr) {}
 
 bool
 pmt_is_null(const pmt_t& x)
@@ -392,20 +548,18 @@ pmt_cons(const pmt_t& x, const pmt_t& y)
 pmt_t
 pmt_car(const pmt_t& pair)
 {
-  pmt_pair* p = dynamic_cast<pmt_pair*>(pair.get());
-  if ( p )
-    return p->car();
-  
+  if (pair->is_pair())
+    return _pair(pair)->car();
+
   throw pmt_wrong_type("pmt_car", pair);
 }
 
 pmt_t
 pmt_cdr(const pmt_t& pair)
 {
-  pmt_pair* p = dynamic_cast<pmt_pair*>(pair.get());
-  if ( p )
-    return p->cdr();
-  
+  if (pair->is_pair())
+    return _pair(pair)->cdr();
+
   throw pmt_wrong_type("pmt_cdr", pair);
 }
 
@@ -432,7 +586,7 @@ pmt_set_cdr(pmt_t pair, pmt_t obj)
 ////////////////////////////////////////////////////////////////////////////
 
 pmt_vector::pmt_vector(size_t len, pmt_t fill)
-  : d_v(len)
+  : pmt_base(PMT_TYPE_VECTOR), d_v(len)
 {
   for (size_t i = 0; i < len; i++)
     d_v[i] = fill;
@@ -502,7 +656,7 @@ pmt_vector_fill(pmt_t vector, pmt_t obj)
 ////////////////////////////////////////////////////////////////////////////
 
 pmt_tuple::pmt_tuple(size_t len)
-  : d_v(len)
+  : pmt_base(PMT_TYPE_TUPLE), d_v(len)
 {
 }
 
@@ -723,97 +877,431 @@ pmt_uniform_vector_writable_elements(pmt_t vector, size_t &len)
 ////////////////////////////////////////////////////////////////////////////
 
 /*
- * This is an a-list implementation.
+ * Keys are compared with pmt_eqv, so symbols (and everything else
+ * that isn't a number) hash on identity and numbers hash on value.
+ * Each trie level consumes 5 bits of the 32-bit hash; keys whose
+ * hashes are equal end up together in a collision node, searched
+ * linearly, below the last level.
  *
- * When we need better performance for large dictionaries, consider implementing
- * persistent Red-Black trees as described in "Purely Functional Data Structures", 
- * Chris Okasaki, 1998, section 3.3.
+ * Every entry carries the dict's insertion stamp so that keys, values
+ * and items come back most recently added first, as they did when
+ * dicts were a-lists.
  */
 
+static const int DICT_BITS = 5;
+static const int DICT_HASH_BITS = 32;
+
+struct pmt_dict_entry {
+  pmt_t		key;
+  pmt_t		value;
+  unsigned	hash;
+  unsigned long	seq;
+};
+
+class pmt_dict_node {
+public:
+  mutable boost::detail::atomic_count	d_refs;
+  unsigned				d_entrymap;	// slots holding an entry
+  unsigned				d_nodemap;	// slots holding a subnode
+  std::vector<pmt_dict_entry>		d_entries;	// in slot order
+  std::vector<pmt_dict_node_ptr>	d_nodes;	// in slot order
+
+  pmt_dict_node() : d_refs(0), d_entrymap(0), d_nodemap(0) {}
+
+  pmt_dict_node(const pmt_dict_node &n)
+    : d_refs(0), d_entrymap(n.d_entrymap), d_nodemap(n.d_nodemap),
+      d_entries(n.d_entries), d_nodes(n.d_nodes) {}
+};
+
+void intrusive_ptr_add_ref(pmt_dict_node *p) { ++(p->d_refs); }
+void intrusive_ptr_release(pmt_dict_node *p) { if (--(p->d_refs) == 0) delete p; }
+
+static inline unsigned
+popcount(unsigned x)
+{
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+// index of slot \p bit among the slots set in \p map
+static inline size_t
+slot_index(unsigned map, unsigned bit)
+{
+  return popcount(map & (bit - 1));
+}
+
+static unsigned
+dict_hash(const pmt_t &key)
+{
+  unsigned long long h;
+
+  if (key->is_symbol())
+    return static_cast<pmt_symbol *>(key.get())->hash();	// already well mixed
+
+  if (!key->is_number())
+    h = (size_t) key.get();
+  else if (key->is_integer())
+    h = _integer(key)->value();
+  else if (key->is_real()){
+    double d = _real(key)->value();
+    if (d == 0)
+      d = 0;			// -0.0 is eqv to 0.0
+    memcpy(&h, &d, sizeof(h));
+  }
+  else {
+    std::complex<double> z = _complex(key)->value();
+    double re = z.real() == 0 ? 0 : z.real();
+    double im = z.imag() == 0 ? 0 : z.imag();
+    unsigned long long hi;
+    memcpy(&h, &re, sizeof(h));
+    memcpy(&hi, &im, sizeof(hi));
+    h ^= hi * 0x9e3779b97f4a7c15ULL;
+  }
+
+  // MurmurHash3 finalizer: every input bit affects every output bit
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (unsigned) h;
+}
+
+static inline bool
+entry_matches(const pmt_dict_entry &e, const pmt_t &key, unsigned hash)
+{
+  return e.hash == hash && (e.key == key || pmt_eqv(e.key, key));
+}
+
+static const pmt_dict_entry *
+dict_find(const pmt_dict_node *n, const pmt_t &key, unsigned hash)
+{
+  for (int shift = 0; n != 0; shift += DICT_BITS){
+    if (shift >= DICT_HASH_BITS){		// collision node
+      for (size_t i = 0; i < n->d_entries.size(); i++)
+	if (entry_matches(n->d_entries[i], key, hash))
+	  return &n->d_entries[i];
+      return 0;
+    }
+
+    unsigned bit = 1u << ((hash >> shift) & 31);
+    if (n->d_entrymap & bit){
+      const pmt_dict_entry &e = n->d_entries[slot_index(n->d_entrymap, bit)];
+      return entry_matches(e, key, hash) ? &e : 0;
+    }
+    if (!(n->d_nodemap & bit))
+      return 0;
+    n = n->d_nodes[slot_index(n->d_nodemap, bit)].get();
+  }
+  return 0;
+}
+
+// a new node at level \p shift holding just \p a and \p b
+static pmt_dict_node_ptr
+dict_pair_node(const pmt_dict_entry &a, const pmt_dict_entry &b, int shift)
+{
+  pmt_dict_node_ptr r(new pmt_dict_node());
+
+  if (shift >= DICT_HASH_BITS){
+    r->d_entries.push_back(a);
+    r->d_entries.push_back(b);
+    return r;
+  }
+
+  unsigned ia = (a.hash >> shift) & 31;
+  unsigned ib = (b.hash >> shift) & 31;
+  if (ia == ib){
+    r->d_nodemap = 1u << ia;
+    r->d_nodes.push_back(dict_pair_node(a, b, shift + DICT_BITS));
+  }
+  else {
+    r->d_entrymap = (1u << ia) | (1u << ib);
+    r->d_entries.push_back(ia < ib ? a : b);
+    r->d_entries.push_back(ia < ib ? b : a);
+  }
+  return r;
+}
+
+// a copy of \p n (which may be 0) with \p e added or replacing the entry for its key
+static pmt_dict_node_ptr
+dict_assoc(const pmt_dict_node *n, const pmt_dict_entry &e, int shift, bool &added)
+{
+  pmt_dict_node_ptr r(n ? new pmt_dict_node(*n) : new pmt_dict_node());
+
+  if (shift >= DICT_HASH_BITS){
+    for (size_t i = 0; i < r->d_entries.size(); i++)
+      if (entry_matches(r->d_entries[i], e.key, e.hash)){
+	r->d_entries[i] = e;
+	return r;
+      }
+    r->d_entries.push_back(e);
+    added = true;
+    return r;
+  }
+
+  unsigned bit = 1u << ((e.hash >> shift) & 31);
+
+  if (r->d_entrymap & bit){
+    size_t i = slot_index(r->d_entrymap, bit);
+    if (entry_matches(r->d_entries[i], e.key, e.hash)){
+      r->d_entries[i] = e;
+      return r;
+    }
+
+    // Two keys share this slot; move both down a level.
+    pmt_dict_node_ptr sub = dict_pair_node(r->d_entries[i], e, shift + DICT_BITS);
+    r->d_entries.erase(r->d_entries.begin() + i);
+    r->d_entrymap &= ~bit;
+    r->d_nodemap |= bit;
+    r->d_nodes.insert(r->d_nodes.begin() + slot_index(r->d_nodemap, bit), sub);
+    added = true;
+    return r;
+  }
+
+  if (r->d_nodemap & bit){
+    size_t i = slot_index(r->d_nodemap, bit);
+    r->d_nodes[i] = dict_assoc(r->d_nodes[i].get(), e, shift + DICT_BITS, added);
+    return r;
+  }
+
+  r->d_entrymap |= bit;
+  r->d_entries.insert(r->d_entries.begin() + slot_index(r->d_entrymap, bit), e);
+  added = true;
+  return r;
+}
+
+/*
+ * \p n without \p key: \p n itself if the key isn't there, 0 if
+ * nothing is left.  A subnode left holding a single entry is folded
+ * into its parent, so lookups never walk through such nodes.
+ */
+static pmt_dict_node_ptr
+dict_dissoc(pmt_dict_node *n, const pmt_t &key, unsigned hash, int shift,
+	    bool &removed)
+{
+  if (shift >= DICT_HASH_BITS){
+    for (size_t i = 0; i < n->d_entries.size(); i++)
+      if (entry_matches(n->d_entries[i], key, hash)){
+	removed = true;
+	if (n->d_entries.size() == 1)
+	  return 0;
+	pmt_dict_node_ptr r(new pmt_dict_node(*n));
+	r->d_entries.erase(r->d_entries.begin() + i);
+	return r;
+      }
+    return n;
+  }
+
+  unsigned bit = 1u << ((hash >> shift) & 31);
+
+  if (n->d_entrymap & bit){
+    size_t i = slot_index(n->d_entrymap, bit);
+    if (!entry_matches(n->d_entries[i], key, hash))
+      return n;
+
+    removed = true;
+    if (n->d_entries.size() == 1 && n->d_nodes.empty())
+      return 0;
+    pmt_dict_node_ptr r(new pmt_dict_node(*n));
+    r->d_entries.erase(r->d_entries.begin() + i);
+    r->d_entrymap &= ~bit;
+    return r;
+  }
+
+  if (n->d_nodemap & bit){
+    size_t i = slot_index(n->d_nodemap, bit);
+    pmt_dict_node_ptr sub = dict_dissoc(n->d_nodes[i].get(), key, hash,
+					shift + DICT_BITS, removed);
+    if (!removed)
+      return n;
+
+    if (sub && (sub->d_entries.size() > 1 || !sub->d_nodes.empty())){
+      pmt_dict_node_ptr r(new pmt_dict_node(*n));
+      r->d_nodes[i] = sub;
+      return r;
+    }
+
+    if (!sub && n->d_entries.empty() && n->d_nodes.size() == 1)
+      return 0;
+
+    pmt_dict_node_ptr r(new pmt_dict_node(*n));
+    r->d_nodes.erase(r->d_nodes.begin() + i);
+    r->d_nodemap &= ~bit;
+    if (sub){						// fold up its last entry
+      r->d_entrymap |= bit;
+      r->d_entries.insert(r->d_entries.begin() + slot_index(r->d_entrymap, bit),
+			  sub->d_entries[0]);
+    }
+    return r;
+  }
+
+  return n;
+}
+
+static void
+dict_collect(const pmt_dict_node *n, std::vector<const pmt_dict_entry *> &v)
+{
+  if (n == 0)
+    return;
+  for (size_t i = 0; i < n->d_entries.size(); i++)
+    v.push_back(&n->d_entries[i]);
+  for (size_t i = 0; i < n->d_nodes.size(); i++)
+    dict_collect(n->d_nodes[i].get(), v);
+}
+
+static bool
+older(const pmt_dict_entry *a, const pmt_dict_entry *b)
+{
+  return a->seq < b->seq;
+}
+
+// Dicts used to be a-lists, and pmt_make_dict returned PMT_NIL.  Both
+// are still accepted: PMT_NIL is an empty dict, and an a-list is read
+// into one (the first binding of a key wins, as with pmt_assv).
+// Returns the pmt_dict to use, or 0 if empty; \p hold keeps it alive.
+static const pmt_dict *
+dict_of(const pmt_t &dict, pmt_t &hold, const char *who)
+{
+  if (dict->is_dict())
+    return _dict(dict);
+  if (dict->is_null())
+    return 0;
+  if (!dict->is_pair())
+    throw pmt_wrong_type(who, dict);
+
+  std::vector<pmt_t> bindings;
+  for (pmt_t p = dict; !p->is_null(); p = _pair(p)->d_cdr){
+    if (!p->is_pair() || !_pair(p)->d_car->is_pair())
+      throw pmt_wrong_type(who, dict);
+    bindings.push_back(_pair(p)->d_car);
+  }
+  hold = pmt_make_dict();
+  for (size_t i = bindings.size(); i-- > 0; )
+    hold = pmt_dict_add(hold, _pair(bindings[i])->d_car, _pair(bindings[i])->d_cdr);
+  return _dict(hold);
+}
+
+enum dict_part { DICT_ITEMS, DICT_KEYS, DICT_VALUES };
+
+static pmt_t
+dict_list(const pmt_t &dict, dict_part part, const char *who)
+{
+  pmt_t hold;
+  const pmt_dict *d = dict_of(dict, hold, who);
+  std::vector<const pmt_dict_entry *> v;
+  if (d){
+    v.reserve(d->d_size);
+    dict_collect(d->d_root.get(), v);
+  }
+  std::sort(v.begin(), v.end(), older);
+
+  pmt_t r = PMT_NIL;
+  for (size_t i = 0; i < v.size(); i++){
+    switch (part){
+    case DICT_ITEMS:  r = pmt_acons(v[i]->key, v[i]->value, r); break;
+    case DICT_KEYS:   r = pmt_cons(v[i]->key, r); break;
+    case DICT_VALUES: r = pmt_cons(v[i]->value, r); break;
+    }
+  }
+  return r;
+}
+
 bool
 pmt_is_dict(const pmt_t &obj)
 {
-  return pmt_is_null(obj) || pmt_is_pair(obj);
+  return obj->is_dict() || obj->is_null() || obj->is_pair();
 }
 
 pmt_t
 pmt_make_dict()
 {
-  return PMT_NIL;
+  return pmt_t(new pmt_dict());
 }
 
 pmt_t
 pmt_dict_add(const pmt_t &dict, const pmt_t &key, const pmt_t &value)
 {
-  if (pmt_is_null(dict))
-    return pmt_acons(key, value, PMT_NIL);
+  pmt_t hold;
+  const pmt_dict *d = dict_of(dict, hold, "pmt_dict_add");
 
-  if (pmt_dict_has_key(dict, key))
-    return pmt_acons(key, value, pmt_dict_delete(dict, key));
+  pmt_dict_entry e;
+  e.key = key;
+  e.value = value;
+  e.hash = dict_hash(key);
+  e.seq = d ? d->d_seq : 0;
 
-  return pmt_acons(key, value, dict);
+  bool added = false;
+  pmt_dict *r = new pmt_dict();
+  pmt_t result(r);
+  r->d_root = dict_assoc(d ? d->d_root.get() : 0, e, 0, added);
+  r->d_size = (d ? d->d_size : 0) + (added ? 1 : 0);
+  r->d_seq = e.seq + 1;
+  return result;
 }
 
 pmt_t
 pmt_dict_delete(const pmt_t &dict, const pmt_t &key)
 {
-  if (pmt_is_null(dict))
+  pmt_t hold;
+  const pmt_dict *d = dict_of(dict, hold, "pmt_dict_delete");
+  if (d == 0 || d->d_root == 0)
     return dict;
 
-  if (pmt_eqv(pmt_caar(dict), key))
-    return pmt_cdr(dict);
-  
-  return pmt_cons(pmt_car(dict), pmt_dict_delete(pmt_cdr(dict), key));
+  bool removed = false;
+  pmt_dict_node_ptr root = dict_dissoc(d->d_root.get(), key, dict_hash(key), 0, removed);
+  if (!removed)
+    return dict;
+
+  pmt_dict *r = new pmt_dict();
+  pmt_t result(r);
+  r->d_root = root;
+  r->d_size = d->d_size - 1;
+  r->d_seq = d->d_seq;
+  return result;
 }
 
 pmt_t
 pmt_dict_ref(const pmt_t &dict, const pmt_t &key, const pmt_t &not_found)
 {
-  pmt_t	p = pmt_assv(key, dict);	// look for (key . value) pair
-  if (pmt_is_pair(p))
-    return pmt_cdr(p);
-  else
-    return not_found;
+  pmt_t hold;
+  const pmt_dict *d = dict_of(dict, hold, "pmt_dict_ref");
+  const pmt_dict_entry *e = d ? dict_find(d->d_root.get(), key, dict_hash(key)) : 0;
+  return e ? e->value : not_found;
 }
 
 bool
 pmt_dict_has_key(const pmt_t &dict, const pmt_t &key)
 {
-  return pmt_is_pair(pmt_assv(key, dict));
+  pmt_t hold;
+  const pmt_dict *d = dict_of(dict, hold, "pmt_dict_has_key");
+  return d && dict_find(d->d_root.get(), key, dict_hash(key)) != 0;
 }
 
 pmt_t
 pmt_dict_items(pmt_t dict)
 {
-  if (!pmt_is_dict(dict))
-    throw pmt_wrong_type("pmt_dict_values", dict);
-
-  return dict;		// equivalent to dict in the a-list case
+  return dict_list(dict, DICT_ITEMS, "pmt_dict_items");
 }
 
 pmt_t
 pmt_dict_keys(pmt_t dict)
 {
-  if (!pmt_is_dict(dict))
-    throw pmt_wrong_type("pmt_dict_keys", dict);
-
-  return pmt_map(pmt_car, dict);
+  return dict_list(dict, DICT_KEYS, "pmt_dict_keys");
 }
 
 pmt_t
 pmt_dict_values(pmt_t dict)
 {
-  if (!pmt_is_dict(dict))
-    throw pmt_wrong_type("pmt_dict_keys", dict);
-
-  return pmt_map(pmt_cdr, dict);
+  return dict_list(dict, DICT_VALUES, "pmt_dict_values");
 }
 
 ////////////////////////////////////////////////////////////////////////////
 //                                 Any
 ////////////////////////////////////////////////////////////////////////////
 
-pmt_any::pmt_any(const boost::any &any) : d_any(any) {}
+pmt_any::pmt_any(const boost::any &any)
+  : pmt_base(PMT_TYPE_ANY), d_any(any) {}
 
 bool
 pmt_is_any(pmt_t obj)
@@ -1006,6 +1494,22 @@ pmt_equal(const pmt_t& x, const pmt_t& y)
     return true;
   }
 
+  if (x->is_dict() && y->is_dict()){
+    const pmt_dict *xd = _dict(x);
+    const pmt_dict *yd = _dict(y);
+    if (xd->d_size != yd->d_size)
+      return false;
+
+    std::vector<const pmt_dict_entry *> v;
+    dict_collect(xd->d_root.get(), v);
+    for (size_t i = 0; i < v.size(); i++){
+      const pmt_dict_entry *e = dict_find(yd->d_root.get(), v[i]->key, v[i]->hash);
+      if (e == 0 || !pmt_equal(v[i]->value, e->value))
+	return false;
+    }
+    return true;
+  }
+
   // FIXME add other cases here...
 
   return false;
@@ -1040,7 +1544,8 @@ pmt_length(const pmt_t& x)
     throw pmt_wrong_type("pmt_length", x);
   }
 
-  // FIXME dictionary length (number of entries)
+  if (x->is_dict())
+    return _dict(x)->d_size;
 
   throw pmt_wrong_type("pmt_length", x);
 }
@@ -24,7 +24,7 @@
 
 #include <gruel/pmt.h>
 #include <boost/utility.hpp>
-#include <boost/detail/atomic_count.hpp>
+#include <cstring>
 
 /*
  * EVERYTHING IN THIS FILE IS PRIVATE TO THE IMPLEMENTATION!
@@ -35,40 +35,80 @@
 #define PMT_LOCAL_ALLOCATOR 0		// define to 0 or 1
 namespace pmt {
 
+/*
+ * Every object carries its type in a byte of pmt_base, so the type
+ * predicates are a compare and the accessors a static_cast rather than
+ * a virtual call or a dynamic_cast.  The numbers and the uniform
+ * vectors are kept contiguous so is_number() and is_uniform_vector()
+ * are range checks.
+ */
+enum pmt_type {
+  PMT_TYPE_BOOL,
+  PMT_TYPE_SYMBOL,
+  PMT_TYPE_INTEGER,		// numbers
+  PMT_TYPE_REAL,
+  PMT_TYPE_COMPLEX,
+  PMT_TYPE_NULL,
+  PMT_TYPE_PAIR,
+  PMT_TYPE_TUPLE,
+  PMT_TYPE_VECTOR,
+  PMT_TYPE_DICT,
+  PMT_TYPE_ANY,
+  PMT_TYPE_U8VECTOR,		// uniform vectors
+  PMT_TYPE_S8VECTOR,
+  PMT_TYPE_U16VECTOR,
+  PMT_TYPE_S16VECTOR,
+  PMT_TYPE_U32VECTOR,
+  PMT_TYPE_S32VECTOR,
+  PMT_TYPE_U64VECTOR,
+  PMT_TYPE_S64VECTOR,
+  PMT_TYPE_F32VECTOR,
+  PMT_TYPE_F64VECTOR,
+  PMT_TYPE_C32VECTOR,
+  PMT_TYPE_C64VECTOR
+};
+
 class pmt_base : boost::noncopyable {
-  mutable boost::detail::atomic_count count_;
+  mutable volatile int	count_;
+  const unsigned char	d_type;		// pmt_type
+  bool			d_immortal;	// never counted, never deleted
 
 protected:
-  pmt_base() : count_(0) {};
+  pmt_base(pmt_type type) : count_(0), d_type(type), d_immortal(false) {};
   virtual ~pmt_base();
 
 public:
-  virtual bool is_bool()    const { return false; }
-  virtual bool is_symbol()  const { return false; }
-  virtual bool is_number()  const { return false; }
-  virtual bool is_integer() const { return false; }
-  virtual bool is_real()    const { return false; }
-  virtual bool is_complex() const { return false; }
-  virtual bool is_null()    const { return false; }
-  virtual bool is_pair()    const { return false; }
-  virtual bool is_tuple()   const { return false; }
-  virtual bool is_vector()  const { return false; }
-  virtual bool is_dict()    const { return false; }
-  virtual bool is_any()     const { return false; }
-
-  virtual bool is_uniform_vector() const { return false; }
-  virtual bool is_u8vector()  const { return false; }
-  virtual bool is_s8vector()  const { return false; }
-  virtual bool is_u16vector() const { return false; }
-  virtual bool is_s16vector() const { return false; }
-  virtual bool is_u32vector() const { return false; }
-  virtual bool is_s32vector() const { return false; }
-  virtual bool is_u64vector() const { return false; }
-  virtual bool is_s64vector() const { return false; }
-  virtual bool is_f32vector() const { return false; }
-  virtual bool is_f64vector() const { return false; }
-  virtual bool is_c32vector() const { return false; }
-  virtual bool is_c64vector() const { return false; }
+  pmt_type type() const { return (pmt_type) d_type; }
+
+  bool is_bool()    const { return d_type == PMT_TYPE_BOOL; }
+  bool is_symbol()  const { return d_type == PMT_TYPE_SYMBOL; }
+  bool is_number()  const { return d_type >= PMT_TYPE_INTEGER && d_type <= PMT_TYPE_COMPLEX; }
+  bool is_integer() const { return d_type == PMT_TYPE_INTEGER; }
+  bool is_real()    const { return d_type == PMT_TYPE_REAL; }
+  bool is_complex() const { return d_type == PMT_TYPE_COMPLEX; }
+  bool is_null()    const { return d_type == PMT_TYPE_NULL; }
+  bool is_pair()    const { return d_type == PMT_TYPE_PAIR; }
+  bool is_tuple()   const { return d_type == PMT_TYPE_TUPLE; }
+  bool is_vector()  const { return d_type == PMT_TYPE_VECTOR; }
+  bool is_dict()    const { return d_type == PMT_TYPE_DICT; }
+  bool is_any()     const { return d_type == PMT_TYPE_ANY; }
+
+  bool is_uniform_vector() const { return d_type >= PMT_TYPE_U8VECTOR; }
+  bool is_u8vector()  const { return d_type == PMT_TYPE_U8VECTOR; }
+  bool is_s8vector()  const { return d_type == PMT_TYPE_S8VECTOR; }
+  bool is_u16vector() const { return d_type == PMT_TYPE_U16VECTOR; }
+  bool is_s16vector() const { return d_type == PMT_TYPE_S16VECTOR; }
+  bool is_u32vector() const { return d_type == PMT_TYPE_U32VECTOR; }
+  bool is_s32vector() const { return d_type == PMT_TYPE_S32VECTOR; }
+  bool is_u64vector() const { return d_type == PMT_TYPE_U64VECTOR; }
+  bool is_s64vector() const { return d_type == PMT_TYPE_S64VECTOR; }
+  bool is_f32vector() const { return d_type == PMT_TYPE_F32VECTOR; }
+  bool is_f64vector() const { return d_type == PMT_TYPE_F64VECTOR; }
+  bool is_c32vector() const { return d_type == PMT_TYPE_C32VECTOR; }
+  bool is_c64vector() const { return d_type == PMT_TYPE_C64VECTOR; }
+
+  //! Exempt from reference counting.  Only for objects that live until exit.
+  void make_immortal() { d_immortal = true; }
 
   friend void intrusive_ptr_add_ref(pmt_base* p);
   friend void intrusive_ptr_release(pmt_base* p);
@@ -84,25 +124,24 @@ class pmt_bool : public pmt_base
 public:
   pmt_bool();
   //~pmt_bool(){}
-
-  bool is_bool() const { return true; }
 };
 
 
 class pmt_symbol : public pmt_base
 {
   std::string	d_name;
-  pmt_t		d_next;
+  unsigned	d_hash;
   
 public:
-  pmt_symbol(const std::string &name);
+  pmt_symbol(const std::string &name, unsigned hash);
   //~pmt_symbol(){}
 
-  bool is_symbol() const { return true; }
-  const std::string name() { return d_name; }
+  const std::string &name() const { return d_name; }
+  unsigned hash() const { return d_hash; }
 
-  pmt_t next() { return d_next; }		// symbol table link
-  void set_next(pmt_t next) { d_next = next; }
+  bool has_name(const char *name, size_t len) const {
+    return d_name.size() == len && memcmp(d_name.data(), name, len) == 0;
+  }
 };
 
 class pmt_integer : public pmt_base
@@ -113,8 +152,6 @@ public:
   pmt_integer(long value);
   //~pmt_integer(){}
 
-  bool is_number()  const { return true; }
-  bool is_integer() const { return true; }
   long value() const { return d_value; }
 };
 
@@ -126,8 +163,6 @@ public:
   pmt_real(double value);
   //~pmt_real(){}
 
-  bool is_number()  const { return true; }
-  bool is_real() const { return true; }
   double value() const { return d_value; }
 };
 
@@ -139,8 +174,6 @@ public:
   pmt_complex(std::complex<double> value);
   //~pmt_complex(){}
 
-  bool is_number()  const { return true; }
-  bool is_complex() const { return true; }
   std::complex<double> value() const { return d_value; }
 };
 
@@ -149,8 +182,6 @@ class pmt_null  : public pmt_base
 public:
   pmt_null();
   //~pmt_null(){}
-
-  bool is_null() const { return true; }
 };
 
 class pmt_pair : public pmt_base
@@ -162,7 +193,6 @@ public:
   pmt_pair(const pmt_t& car, const pmt_t& cdr);
   //~pmt_pair(){};
 
-  bool is_pair() const { return true; }
   pmt_t car() const { return d_car; }
   pmt_t cdr() const { return d_cdr; }
 
@@ -178,7 +208,6 @@ public:
   pmt_vector(size_t len, pmt_t fill);
   //~pmt_vector();
 
-  bool is_vector() const { return true; }
   pmt_t ref(size_t k) const;
   void  set(size_t k, pmt_t obj);
   void  fill(pmt_t fill);
@@ -195,7 +224,6 @@ public:
   pmt_tuple(size_t len);
   //~pmt_tuple();
 
-  bool is_tuple() const { return true; }
   pmt_t ref(size_t k) const;
   size_t length() const { return d_v.size(); }
 
@@ -203,6 +231,28 @@ public:
   void _set(size_t k, pmt_t v) { d_v[k] = v; }
 };
 
+class pmt_dict_node;
+void intrusive_ptr_add_ref(pmt_dict_node *p);
+void intrusive_ptr_release(pmt_dict_node *p);
+typedef boost::intrusive_ptr<pmt_dict_node> pmt_dict_node_ptr;
+
+/*
+ * A persistent hash array mapped trie (Bagwell, "Ideal Hash Trees",
+ * 2001).  Nodes are never modified once they're shared, so adding or
+ * deleting a key copies just the path down to it (at most 7 nodes of
+ * up to 32 slots) and everything else is shared with the old dict.
+ */
+class pmt_dict : public pmt_base
+{
+public:
+  pmt_dict_node_ptr	d_root;		// 0 when empty
+  size_t		d_size;
+  unsigned long		d_seq;		// insertion stamp for the next entry
+
+  pmt_dict() : pmt_base(PMT_TYPE_DICT), d_size(0), d_seq(0) {}
+  //~pmt_dict(){}
+};
+
 class pmt_any : public pmt_base
 {
   boost::any	d_any;
@@ -211,7 +261,6 @@ public:
   pmt_any(const boost::any &any);
   //~pmt_any();
 
-  bool is_any() const { return true; }
   const boost::any &ref() const { return d_any; }
   void  set(const boost::any &any) { d_any = any; }
 };
@@ -219,8 +268,10 @@ public:
 
 class pmt_uniform_vector : public pmt_base
 {
+protected:
+  pmt_uniform_vector(pmt_type type) : pmt_base(type) {}
+
 public:
-  bool is_uniform_vector() const { return true; }
   virtual const void *uniform_elements(size_t &len) = 0;
   virtual void *uniform_writable_elements(size_t &len) = 0;
   virtual size_t length() const = 0;
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2009 Free Software Foundation, Inc.
+ * Copyright 2007,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,6 +23,7 @@
 #include <config.h>
 #endif
 #include <gruel/pmt_pool.h>
+#include <gruel/atomic.h>
 #include <algorithm>
 #include <stdint.h>
 
@@ -34,42 +35,57 @@ ROUNDUP(size_t x, size_t stride)
   return ((((x) + (stride) - 1)/(stride)) * (stride));
 }
 
+/*
+ * Guards magazine::d_pool against a thread exiting while the pool is
+ * being destroyed.  A spin lock, since it must outlive every static
+ * destructor; it's only taken when a thread exits or a pool dies.
+ */
+static volatile int s_magazine_lock;
+
+class magazine_lock {
+public:
+  magazine_lock() {
+    while (!gruel::atomic_cas(&s_magazine_lock, 0, 1))
+      boost::this_thread::yield();
+  }
+  ~magazine_lock() { gruel::atomic_store(&s_magazine_lock, 0); }
+};
+
 pmt_pool::pmt_pool(size_t itemsize, size_t alignment,
-		   size_t allocation_size, size_t max_items)
-  : d_itemsize(ROUNDUP(itemsize, alignment)),
+		   size_t allocation_size, size_t max_items,
+		   size_t batch_size)
+  : d_itemsize(ROUNDUP(std::max(itemsize, sizeof(item)), alignment)),
     d_alignment(alignment),
     d_allocation_size(std::max(allocation_size, 16 * itemsize)),
     d_max_items(max_items), d_n_items(0),
-    d_freelist(0)
+    d_batch_size(max_items == 0 ? batch_size : 0),
+    d_freelist(0), d_batches(0),
+    d_magazine(release_magazine)
 {
+  d_stats.nhits = 0;
+  d_stats.nmisses = 0;
+  d_stats.nitems = 0;
+  d_stats.high_water = 0;
+  d_stats.nallocated = 0;
 }
 
 pmt_pool::~pmt_pool()
 {
+  {
+    magazine_lock lock;
+    for (unsigned int i = 0; i < d_magazines.size(); i++)
+      d_magazines[i]->d_pool = 0;
+  }
+
   for (unsigned int i = 0; i < d_allocations.size(); i++){
     delete [] d_allocations[i];
   }
 }
 
-void *
-pmt_pool::malloc()
+// Carve a new chunk onto the loose free list.  Call with d_mutex held.
+void
+pmt_pool::new_chunk()
 {
-  scoped_lock guard(d_mutex);
-  item *p;
-
-  if (d_max_items != 0){
-    while (d_n_items >= d_max_items)
-      d_cond.wait(guard);
-  }
-
-  if (d_freelist){	// got something?
-    p = d_freelist;
-    d_freelist = p->d_next;
-    d_n_items++;
-    return p;
-  }
-
-  // allocate a new chunk
   char *alloc = new char[d_allocation_size + d_alignment - 1];
   d_allocations.push_back(alloc);
 
@@ -79,17 +95,179 @@ pmt_pool::malloc()
   size_t n = (end - start) / d_itemsize;
 
   // link the new items onto the free list.
-  p = (item *) start;
+  item *p = (item *) start;
   for (size_t i = 0; i < n; i++){
     p->d_next = d_freelist;
     d_freelist = p;
     p = (item *)((char *) p + d_itemsize);
   }
+  d_stats.nallocated += n;
+}
+
+void
+pmt_pool::count_out(size_t n)
+{
+  d_n_items += n;
+  d_stats.high_water = std::max(d_stats.high_water, d_n_items);
+}
+
+// Fill m's empty magazine with a batch from the central pool.
+void
+pmt_pool::refill(magazine *m)
+{
+  scoped_lock guard(d_mutex);
+
+  d_stats.nhits += m->d_nhits;
+  d_stats.nmisses++;
+  m->d_nhits = 0;
+
+  if (d_batches){
+    m->d_items = d_batches;
+    m->d_nitems = d_batch_size;
+    d_batches = d_batches->d_next_batch;
+    count_out(d_batch_size);
+    return;
+  }
+
+  if (!d_freelist)
+    new_chunk();
+
+  // take up to a batch of loose items
+  item *last = d_freelist;
+  size_t n = 1;
+  for (; n < d_batch_size && last->d_next; n++)
+    last = last->d_next;
+
+  m->d_items = d_freelist;
+  m->d_nitems = n;
+  d_freelist = last->d_next;
+  last->d_next = 0;
+  count_out(n);
+}
+
+// Hand a batch from m's full magazine back to the central pool.
+void
+pmt_pool::spill(magazine *m)
+{
+  // keep the most recently freed (cache-warm) half
+  item *keep = m->d_items;
+  for (size_t i = 1; i < d_batch_size; i++)
+    keep = keep->d_next;
+  item *batch = keep->d_next;
+  keep->d_next = 0;
+  m->d_nitems -= d_batch_size;
+
+  scoped_lock guard(d_mutex);
+
+  d_stats.nhits += m->d_nhits;
+  d_stats.nmisses++;
+  m->d_nhits = 0;
+
+  batch->d_next_batch = d_batches;
+  d_batches = batch;
+  d_n_items -= d_batch_size;
+}
+
+// Put all of m's items on the loose free list.
+void
+pmt_pool::drain(magazine *m)
+{
+  scoped_lock guard(d_mutex);
+
+  d_stats.nhits += m->d_nhits;
+  m->d_nhits = 0;
+
+  if (m->d_items){
+    item *last = m->d_items;
+    while (last->d_next)
+      last = last->d_next;
+    last->d_next = d_freelist;
+    d_freelist = m->d_items;
+    d_n_items -= m->d_nitems;
+    m->d_items = 0;
+    m->d_nitems = 0;
+  }
+}
+
+pmt_pool::magazine *
+pmt_pool::new_magazine()
+{
+  magazine *m = new magazine;
+  m->d_pool = this;
+  m->d_items = 0;
+  m->d_nitems = 0;
+  m->d_nhits = 0;
+
+  {
+    scoped_lock guard(d_mutex);
+    d_magazines.push_back(m);
+  }
+  d_magazine.reset(m);
+  return m;
+}
+
+/*
+ * The calling thread's magazine.  Thread specific slots are keyed by
+ * address, so the slot may still hold a magazine orphaned by a pool
+ * that used to live at this address; its items point into freed
+ * chunks.  Replacing it releases it.
+ */
+pmt_pool::magazine *
+pmt_pool::my_magazine()
+{
+  magazine *m = d_magazine.get();
+  if (!m || m->d_pool != this)
+    m = new_magazine();
+  return m;
+}
+
+// Called when a thread exits (or the pool is destroyed).
+void
+pmt_pool::release_magazine(magazine *m)
+{
+  magazine_lock lock;
+
+  pmt_pool *pool = m->d_pool;
+  if (pool){
+    pool->drain(m);
+    scoped_lock guard(pool->d_mutex);
+    pool->d_magazines.erase(std::find(pool->d_magazines.begin(),
+				      pool->d_magazines.end(), m));
+  }
+  delete m;
+}
+
+void *
+pmt_pool::malloc()
+{
+  if (d_batch_size != 0){
+    magazine *m = my_magazine();
+
+    if (m->d_items)
+      m->d_nhits++;
+    else
+      refill(m);
+
+    item *p = m->d_items;
+    m->d_items = p->d_next;
+    m->d_nitems--;
+    return p;
+  }
+
+  scoped_lock guard(d_mutex);
+  item *p;
+
+  if (d_max_items != 0){
+    while (d_n_items >= d_max_items)
+      d_cond.wait(guard);
+  }
+
+  if (!d_freelist)
+    new_chunk();
 
-  // now return the first one
   p = d_freelist;
   d_freelist = p->d_next;
-  d_n_items++;
+  count_out(1);
   return p;
 }
 
@@ -99,9 +277,22 @@ pmt_pool::free(void *foo)
   if (!foo)
     return;
 
+  item *p = (item *) foo;
+
+  if (d_batch_size != 0){
+    magazine *m = my_magazine();
+
+    p->d_next = m->d_items;
+    m->d_items = p;
+    if (++m->d_nitems < 2 * d_batch_size)
+      m->d_nhits++;
+    else
+      spill(m);
+    return;
+  }
+
   scoped_lock guard(d_mutex);
 
-  item *p = (item *) foo;
   p->d_next = d_freelist;
   d_freelist = p;
   d_n_items--;
@@ -109,4 +300,22 @@ pmt_pool::free(void *foo)
     d_cond.notify_one();
 }
 
+void
+pmt_pool::flush()
+{
+  magazine *m = d_batch_size != 0 ? d_magazine.get() : 0;
+  if (m && m->d_pool == this)
+    drain(m);
+}
+
+pmt_pool_stats
+pmt_pool::stats() const
+{
+  scoped_lock guard(d_mutex);
+
+  pmt_pool_stats s = d_stats;
+  s.nitems = d_n_items;
+  return s;
+}
+
 } /* namespace pmt */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2009 Free Software Foundation, Inc.
+ * Copyright 2007,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,14 +23,118 @@
 #include <config.h>
 #endif
 #include <vector>
+#include <algorithm>
 #include <gruel/pmt.h>
 #include "pmt_int.h"
 #include "gruel/pmt_serial_tags.h"
+#include <string.h>
+#include <stdint.h>
 
 namespace pmt {
 
 static pmt_t parse_pair(std::streambuf &sb);
 
+// ----------------------------------------------------------------
+// uniform vectors
+// ----------------------------------------------------------------
+
+// indexed by UVI subtype, which is also pmt_type - PMT_TYPE_U8VECTOR
+static const size_t uvi_itemsize[] = { 1, 1, 2, 2, 4, 4, 8, 8, 4, 8, 8, 16 };
+static const size_t uvi_swapsize[] = { 1, 1, 2, 2, 4, 4, 8, 8, 4, 8, 4, 8 };
+static const int NUVI = sizeof(uvi_itemsize) / sizeof(uvi_itemsize[0]);
+static const size_t UVI_READ_CHUNK = 64 * 1024;	// pmt_deserialize(streambuf)
+
+static inline bool
+host_is_big_endian()
+{
+  const uint16_t one = 1;
+  return *(const unsigned char *) &one == 0;
+}
+
+static inline int
+host_uvi_endian()
+{
+  return host_is_big_endian() ? UVI_BIG_ENDIAN : UVI_LITTLE_ENDIAN;
+}
+
+static inline int
+uvi_subtype(const pmt_t &obj)
+{
+  return obj->type() - PMT_TYPE_U8VECTOR;
+}
+
+// reverse the bytes of each width byte unit in p[0 .. nbytes)
+static void
+swap_bytes(unsigned char *p, size_t nbytes, size_t width)
+{
+  if (width == 1)
+    return;
+  for (size_t i = 0; i < nbytes; i += width)
+    std::reverse(p + i, p + i + width);
+}
+
+template<class V, class T>
+static pmt_t
+make_uniform_vector(size_t n, const unsigned char *data,
+		    const boost::shared_ptr<void> *owner)
+{
+  if (owner)
+    return pmt_t(new V(n, (const T *) data, *owner));
+
+  V *v = new V(n, T());
+  pmt_t r(v);
+  size_t len;
+  if (data && n)
+    memcpy(v->writable_elements(len), data, n * sizeof(T));
+  return r;
+}
+
+/*
+ * Make a uniform vector of the given subtype from n items at data,
+ * which are in host byte order, or zeros if data is 0.  If owner is
+ * non-zero the vector refers to data instead of copying it.
+ */
+static pmt_t
+make_uniform_vector(int subtype, size_t n, const unsigned char *data,
+		    const boost::shared_ptr<void> *owner)
+{
+  switch (subtype){
+  case UVI_U8:  return make_uniform_vector<pmt_u8vector,  uint8_t>(n, data, owner);
+  case UVI_S8:  return make_uniform_vector<pmt_s8vector,  int8_t>(n, data, owner);
+  case UVI_U16: return make_uniform_vector<pmt_u16vector, uint16_t>(n, data, owner);
+  case UVI_S16: return make_uniform_vector<pmt_s16vector, int16_t>(n, data, owner);
+  case UVI_U32: return make_uniform_vector<pmt_u32vector, uint32_t>(n, data, owner);
+  case UVI_S32: return make_uniform_vector<pmt_s32vector, int32_t>(n, data, owner);
+  case UVI_U64: return make_uniform_vector<pmt_u64vector, uint64_t>(n, data, owner);
+  case UVI_S64: return make_uniform_vector<pmt_s64vector, int64_t>(n, data, owner);
+  case UVI_F32: return make_uniform_vector<pmt_f32vector, float>(n, data, owner);
+  case UVI_F64: return make_uniform_vector<pmt_f64vector, double>(n, data, owner);
+  case UVI_C32: return make_uniform_vector<pmt_c32vector, std::complex<float> >(n, data, owner);
+  case UVI_C64: return make_uniform_vector<pmt_c64vector, std::complex<double> >(n, data, owner);
+  default:
+    throw pmt_exception("pmt_deserialize: malformed input, uniform vector subtype = ",
+			pmt_from_long(subtype));
+  }
+}
+
+// ----------------------------------------------------------------
+// dictionaries
+// ----------------------------------------------------------------
+
+/*
+ * On the wire a dict is its item count, then each key and value,
+ * newest first as pmt_dict_items returns them.  kv holds them in that
+ * order; add them oldest first so the copy lists the same way.
+ */
+static pmt_t
+dict_from_items(const std::vector<pmt_t> &kv)
+{
+  pmt_t d = pmt_make_dict();
+  for (size_t i = kv.size(); i > 0; i -= 2)
+    d = pmt_dict_add(d, kv[i - 2], kv[i - 1]);
+  return d;
+}
+
 // ----------------------------------------------------------------
 // output primitives
 // ----------------------------------------------------------------
@@ -59,7 +163,6 @@ serialize_untagged_u32(unsigned int i, std::streambuf &sb)
   return sb.sputc((i >> 0) & 0xff) != std::streambuf::traits_type::eof();
 }
 
-#if 0
 // always writes big-endian
 static bool
 serialize_untagged_u64(uint64_t i, std::streambuf &sb)
@@ -73,7 +176,15 @@ serialize_untagged_u64(uint64_t i, std::streambuf &sb)
   sb.sputc((i >>  8) & 0xff);
   return sb.sputc((i >> 0) & 0xff) != std::streambuf::traits_type::eof();
 }
-#endif
+
+// IEEE 754 double, big-endian
+static bool
+serialize_untagged_f64(double x, std::streambuf &sb)
+{
+  uint64_t i;
+  memcpy(&i, &x, sizeof(i));
+  return serialize_untagged_u64(i, sb);
+}
 
 // ----------------------------------------------------------------
 // input primitives
@@ -132,7 +243,6 @@ deserialize_untagged_u32(uint32_t *ip, std::streambuf &sb)
   return t != std::streambuf::traits_type::eof();
 }
 
-#if 0
 // always reads big-endian
 static bool
 deserialize_untagged_u64(uint64_t *ip, std::streambuf &sb)
@@ -161,7 +271,15 @@ deserialize_untagged_u64(uint64_t *ip, std::streambuf &sb)
   *ip = i;
   return t != std::streambuf::traits_type::eof();
 }
-#endif
+
+static bool
+deserialize_untagged_f64(double *xp, std::streambuf &sb)
+{
+  uint64_t i;
+  bool ok = deserialize_untagged_u64(&i, sb);
+  memcpy(xp, &i, sizeof(*xp));
+  return ok;
+}
 
 /*
  * Write portable byte-serial representation of \p obj to \p sb
@@ -188,6 +306,8 @@ pmt_serialize(pmt_t obj, std::streambuf &sb)
   if (pmt_is_symbol(obj)){
     const std::string s = pmt_symbol_to_string(obj);
     size_t len = s.size();
+    if (len > 0xffff)
+      throw pmt_notimplemented("pmt_serialize (very long symbol)", obj);
     ok = serialize_untagged_u8(PST_SYMBOL, sb);
     ok &= serialize_untagged_u16(len, sb);
     for (size_t i = 0; i < len; i++)
@@ -217,22 +337,52 @@ pmt_serialize(pmt_t obj, std::streambuf &sb)
       return ok;
     }
 
-    if (pmt_is_real(obj))
-      throw pmt_notimplemented("pmt_serialize (real)", obj);
+    if (pmt_is_real(obj)){
+      ok = serialize_untagged_u8(PST_DOUBLE, sb);
+      ok &= serialize_untagged_f64(pmt_to_double(obj), sb);
+      return ok;
+    }
 
-    if (pmt_is_complex(obj))
-      throw pmt_notimplemented("pmt_serialize (complex)", obj);
+    if (pmt_is_complex(obj)){
+      std::complex<double> z = pmt_to_complex(obj);
+      ok = serialize_untagged_u8(PST_COMPLEX, sb);
+      ok &= serialize_untagged_f64(z.real(), sb);
+      ok &= serialize_untagged_f64(z.imag(), sb);
+      return ok;
+    }
   }
 
-  if (pmt_is_vector(obj))
-    throw pmt_notimplemented("pmt_serialize (vector)", obj);
+  if (pmt_is_vector(obj)){
+    size_t n = pmt_length(obj);
+    ok = serialize_untagged_u8(PST_VECTOR, sb);
+    ok &= serialize_untagged_u32(n, sb);
+    for (size_t i = 0; i < n && ok; i++)
+      ok &= pmt_serialize(pmt_vector_ref(obj, i), sb);
+    return ok;
+  }
 
-  if (pmt_is_uniform_vector(obj))
-    throw pmt_notimplemented("pmt_serialize (uniform-vector)", obj);
-    
-  if (pmt_is_dict(obj))
-    throw pmt_notimplemented("pmt_serialize (dict)", obj);
+  // no padding: the reader copies the items anyway
+  if (pmt_is_uniform_vector(obj)){
+    int subtype = uvi_subtype(obj);
+    size_t nbytes;
+    const void *data = pmt_uniform_vector_elements(obj, nbytes);
+    ok = serialize_untagged_u8(PST_UNIFORM_VECTOR, sb);
+    ok &= serialize_untagged_u8(host_uvi_endian() | subtype, sb);
+    ok &= serialize_untagged_u32(nbytes / uvi_itemsize[subtype], sb);
+    ok &= serialize_untagged_u8(0, sb);
+    return ok && sb.sputn((const char *) data, nbytes) == (std::streamsize) nbytes;
+  }
     
+  if (pmt_is_dict(obj)){	// PMT_NIL was taken care of above
+    pmt_t items = pmt_dict_items(obj);
+    ok = serialize_untagged_u8(PST_DICT, sb);
+    ok &= serialize_untagged_u32(pmt_length(items), sb);
+    for (; ok && pmt_is_pair(items); items = pmt_cdr(items)){
+      ok &= pmt_serialize(pmt_car(pmt_car(items)), sb);
+      ok &= pmt_serialize(pmt_cdr(pmt_car(items)), sb);
+    }
+    return ok;
+  }
 
   throw pmt_notimplemented("pmt_serialize (?)", obj);
 }
@@ -247,11 +397,11 @@ pmt_t
 pmt_deserialize(std::streambuf &sb)
 {
   uint8_t	tag;
-  //uint8_t	u8;
+  uint8_t	u8;
   uint16_t	u16;
   uint32_t	u32;
-  //uint32_t	u64;
-  static char   tmpbuf[1024];
+  double	re, im;
+  char		tmpbuf[1024];
 
   if (!deserialize_untagged_u8(&tag, sb))
     return PMT_EOF;
@@ -274,7 +424,7 @@ pmt_deserialize(std::streambuf &sb)
 			       PMT_F);
     if (sb.sgetn(tmpbuf, u16) != u16)
       goto error;
-    return pmt_intern(std::string(tmpbuf, u16));
+    return pmt_intern(tmpbuf, u16);
 
   case PST_INT32:
     if (!deserialize_untagged_u32(&u32, sb))
@@ -285,10 +435,75 @@ pmt_deserialize(std::streambuf &sb)
     return parse_pair(sb);
 
   case PST_DOUBLE:
+    if (!deserialize_untagged_f64(&re, sb))
+      goto error;
+    return pmt_from_double(re);
+
   case PST_COMPLEX:
-  case PST_VECTOR:
-  case PST_DICT:
-  case PST_UNIFORM_VECTOR:
+    if (!deserialize_untagged_f64(&re, sb)
+	|| !deserialize_untagged_f64(&im, sb))
+      goto error;
+    return pmt_make_rectangular(re, im);
+
+  case PST_VECTOR: {
+    if (!deserialize_untagged_u32(&u32, sb))
+      goto error;
+    // u32 is untrusted; only allocate for elements we actually read
+    std::vector<pmt_t> items;
+    for (uint32_t i = 0; i < u32; i++){
+      pmt_t x = pmt_deserialize(sb);
+      if (pmt_eq(x, PMT_EOF))
+	goto error;
+      items.push_back(x);
+    }
+    pmt_t v = pmt_make_vector(items.size(), PMT_NIL);
+    for (size_t i = 0; i < items.size(); i++)
+      pmt_vector_set(v, i, items[i]);
+    return v;
+  }
+
+  case PST_UNIFORM_VECTOR: {
+    uint8_t uvi;
+    if (!deserialize_untagged_u8(&uvi, sb)
+	|| !deserialize_untagged_u32(&u32, sb)
+	|| !deserialize_untagged_u8(&u8, sb))
+      goto error;
+    int subtype = uvi & UVI_SUBTYPE_MASK;
+    if (subtype >= NUVI)
+      goto error;
+    for (int i = 0; i < u8; i++)
+      if (!deserialize_untagged_u8(&tag, sb))
+	goto error;
+
+    // Read in bounded chunks, so a bogus u32 fails on the short read
+    // instead of allocating for it up front
+    uint64_t nbytes = (uint64_t) u32 * uvi_itemsize[subtype];
+    std::vector<unsigned char> data;
+    while (data.size() < nbytes){
+      size_t n = (size_t) std::min(nbytes - data.size(), (uint64_t) UVI_READ_CHUNK);
+      size_t old_size = data.size();
+      data.resize(old_size + n);
+      if (sb.sgetn((char *) &data[old_size], n) != (std::streamsize) n)
+	goto error;
+    }
+    if (nbytes != 0 && (uvi & UVI_ENDIAN_MASK) != host_uvi_endian())
+      swap_bytes(&data[0], data.size(), uvi_swapsize[subtype]);
+    return make_uniform_vector(subtype, u32, nbytes ? &data[0] : 0, 0);
+  }
+
+  case PST_DICT: {
+    if (!deserialize_untagged_u32(&u32, sb))
+      goto error;
+    std::vector<pmt_t> kv;
+    for (uint64_t i = 0; i < 2 * (uint64_t) u32; i++){
+      pmt_t x = pmt_deserialize(sb);
+      if (pmt_eq(x, PMT_EOF))
+	goto error;
+      kv.push_back(x);
+    }
+    return dict_from_items(kv);
+  }
+
   case PST_COMMENT:
     throw pmt_notimplemented("pmt_deserialize: tag value = ",
 			     pmt_from_long(tag));
@@ -354,4 +569,397 @@ parse_pair(std::streambuf &sb)
   return val;
 }
 
+// ----------------------------------------------------------------
+// contiguous buffers
+// ----------------------------------------------------------------
+
+/*
+ * The same representation as above, except that the items of uniform
+ * vectors are padded to their natural alignment (relative to the
+ * start of the buffer) and left in host byte order, so they go in and
+ * out with a memcpy, or on the way in, no copy at all.
+ */
+
+static const size_t UVI_HEADER_SIZE = 7;	// tag, uvi, n-items, npad
+
+static inline size_t
+uvi_npad(size_t offset, int subtype)
+{
+  return -(offset + UVI_HEADER_SIZE) & (uvi_swapsize[subtype] - 1);
+}
+
+// offset just past obj's representation, if it starts at offset
+static size_t
+serialized_end(const pmt_t &obj, size_t offset)
+{
+  const pmt_t *x = &obj;
+
+  while ((*x)->is_pair()){
+    const pmt_pair *p = static_cast<const pmt_pair *>(x->get());
+    offset = serialized_end(p->d_car, offset + 1);
+    x = &p->d_cdr;
+  }
+
+  switch ((*x)->type()){
+  case PMT_TYPE_BOOL:
+  case PMT_TYPE_NULL:
+    return offset + 1;
+
+  case PMT_TYPE_SYMBOL: {
+    size_t len = static_cast<const pmt_symbol *>(x->get())->name().size();
+    if (len > 0xffff)
+      throw pmt_notimplemented("pmt_serialize (very long symbol)", *x);
+    return offset + 3 + len;
+  }
+
+  case PMT_TYPE_INTEGER: {
+    long i = static_cast<const pmt_integer *>(x->get())->value();
+    if (sizeof(long) > 4 && (i < -2147483647 || i > 2147483647))
+      throw pmt_notimplemented("pmt_serialize (64-bit integers)", *x);
+    return offset + 5;
+  }
+
+  case PMT_TYPE_REAL:
+    return offset + 9;
+
+  case PMT_TYPE_COMPLEX:
+    return offset + 17;
+
+  case PMT_TYPE_VECTOR: {
+    const pmt_vector *v = static_cast<const pmt_vector *>(x->get());
+    offset += 5;
+    for (size_t i = 0; i < v->length(); i++)
+      offset = serialized_end(v->_ref(i), offset);
+    return offset;
+  }
+
+  case PMT_TYPE_DICT: {
+    offset += 5;
+    for (pmt_t items = pmt_dict_items(*x); pmt_is_pair(items); items = pmt_cdr(items)){
+      offset = serialized_end(pmt_car(pmt_car(items)), offset);
+      offset = serialized_end(pmt_cdr(pmt_car(items)), offset);
+    }
+    return offset;
+  }
+
+  default:
+    if ((*x)->is_uniform_vector()){
+      int subtype = uvi_subtype(*x);
+      size_t n = static_cast<pmt_uniform_vector *>(x->get())->length();
+      return offset + UVI_HEADER_SIZE + uvi_npad(offset, subtype)
+	+ n * uvi_itemsize[subtype];
+    }
+    throw pmt_notimplemented("pmt_serialize", *x);
+  }
+}
+
+static inline unsigned char *
+put_u16(unsigned char *p, unsigned int i)
+{
+  p[0] = i >> 8;
+  p[1] = i;
+  return p + 2;
+}
+
+static inline unsigned char *
+put_u32(unsigned char *p, unsigned int i)
+{
+  p[0] = i >> 24;
+  p[1] = i >> 16;
+  p[2] = i >> 8;
+  p[3] = i;
+  return p + 4;
+}
+
+static inline unsigned char *
+put_f64(unsigned char *p, double x)
+{
+  uint64_t i;
+  memcpy(&i, &x, sizeof(i));
+  put_u32(p, i >> 32);
+  return put_u32(p + 4, i);
+}
+
+// write obj at p, which serialized_end has checked fits
+static unsigned char *
+serialize_to(const pmt_t &obj, unsigned char *base, unsigned char *p)
+{
+  const pmt_t *x = &obj;
+
+  while ((*x)->is_pair()){
+    const pmt_pair *pair = static_cast<const pmt_pair *>(x->get());
+    *p++ = PST_PAIR;
+    p = serialize_to(pair->d_car, base, p);
+    x = &pair->d_cdr;
+  }
+
+  switch ((*x)->type()){
+  case PMT_TYPE_BOOL:
+    *p++ = *x == PMT_T ? PST_TRUE : PST_FALSE;
+    return p;
+
+  case PMT_TYPE_NULL:
+    *p++ = PST_NULL;
+    return p;
+
+  case PMT_TYPE_SYMBOL: {
+    const std::string &name = static_cast<const pmt_symbol *>(x->get())->name();
+    *p++ = PST_SYMBOL;
+    p = put_u16(p, name.size());
+    memcpy(p, name.data(), name.size());
+    return p + name.size();
+  }
+
+  case PMT_TYPE_INTEGER:
+    *p++ = PST_INT32;
+    return put_u32(p, static_cast<const pmt_integer *>(x->get())->value());
+
+  case PMT_TYPE_REAL:
+    *p++ = PST_DOUBLE;
+    return put_f64(p, static_cast<const pmt_real *>(x->get())->value());
+
+  case PMT_TYPE_COMPLEX: {
+    std::complex<double> z = static_cast<const pmt_complex *>(x->get())->value();
+    *p++ = PST_COMPLEX;
+    p = put_f64(p, z.real());
+    return put_f64(p, z.imag());
+  }
+
+  case PMT_TYPE_VECTOR: {
+    const pmt_vector *v = static_cast<const pmt_vector *>(x->get());
+    *p++ = PST_VECTOR;
+    p = put_u32(p, v->length());
+    for (size_t i = 0; i < v->length(); i++)
+      p = serialize_to(v->_ref(i), base, p);
+    return p;
+  }
+
+  case PMT_TYPE_DICT: {
+    pmt_t items = pmt_dict_items(*x);
+    *p++ = PST_DICT;
+    p = put_u32(p, pmt_length(items));
+    for (; pmt_is_pair(items); items = pmt_cdr(items)){
+      p = serialize_to(pmt_car(pmt_car(items)), base, p);
+      p = serialize_to(pmt_cdr(pmt_car(items)), base, p);
+    }
+    return p;
+  }
+
+  default: {	// uniform vector
+    int subtype = uvi_subtype(*x);
+    size_t npad = uvi_npad(p - base, subtype);
+    size_t nbytes;
+    const void *data =
+      static_cast<pmt_uniform_vector *>(x->get())->uniform_elements(nbytes);
+    *p++ = PST_UNIFORM_VECTOR;
+    *p++ = host_uvi_endian() | subtype;
+    p = put_u32(p, nbytes / uvi_itemsize[subtype]);
+    *p++ = npad;
+    memset(p, 0, npad);
+    p += npad;
+    if (nbytes)
+      memcpy(p, data, nbytes);
+    return p + nbytes;
+  }
+  }
+}
+
+size_t
+pmt_serialized_size(pmt_t obj)
+{
+  return serialized_end(obj, 0);
+}
+
+size_t
+pmt_serialize_to_buffer(pmt_t obj, void *buf, size_t len)
+{
+  size_t n = serialized_end(obj, 0);
+  if (n > len)
+    return 0;
+  serialize_to(obj, (unsigned char *) buf, (unsigned char *) buf);
+  return n;
+}
+
+// Deepest nesting of cars, vector elements and dict entries we accept
+static const unsigned int MAX_DEPTH = 1024;
+
+struct buffer_source {
+  const unsigned char	       *d_base;
+  const unsigned char	       *d_p;
+  const unsigned char	       *d_end;
+  const boost::shared_ptr<void> *d_owner;	// non-zero to alias uniform vectors
+  unsigned int			d_depth;	// deserialize_from calls in progress
+
+  void need(size_t n) {
+    if ((size_t)(d_end - d_p) < n)
+      throw pmt_exception("pmt_deserialize: truncated input", PMT_F);
+  }
+  unsigned int u8() { need(1); return *d_p++; }
+  unsigned int u16() { need(2); d_p += 2; return (d_p[-2] << 8) | d_p[-1]; }
+  uint32_t u32() {
+    need(4);
+    d_p += 4;
+    return ((uint32_t) d_p[-4] << 24) | (d_p[-3] << 16) | (d_p[-2] << 8) | d_p[-1];
+  }
+  double f64() {
+    uint64_t i = (uint64_t) u32() << 32;
+    i |= u32();
+    double x;
+    memcpy(&x, &i, sizeof(x));
+    return x;
+  }
+};
+
+static pmt_t
+deserialize_from(buffer_source &src)
+{
+  pmt_t head, last;
+
+  // Everything but a list's cdr recurses; don't let the input decide
+  // how deep
+  if (++src.d_depth > MAX_DEPTH)
+    throw pmt_exception("pmt_deserialize: input nested too deeply", PMT_F);
+
+  // Iterate down lists, so long ones don't exhaust the stack
+  unsigned int tag;
+  while ((tag = src.u8()) == PST_PAIR){
+    pmt_t cell = pmt_cons(deserialize_from(src), PMT_NIL);
+    if (last)
+      static_cast<pmt_pair *>(last.get())->d_cdr = cell;
+    else
+      head = cell;
+    last = cell;
+  }
+
+  pmt_t x;
+  switch (tag){
+  case PST_TRUE:
+    x = PMT_T;
+    break;
+
+  case PST_FALSE:
+    x = PMT_F;
+    break;
+
+  case PST_NULL:
+    x = PMT_NIL;
+    break;
+
+  case PST_SYMBOL: {
+    size_t len = src.u16();
+    src.need(len);
+    x = pmt_intern((const char *) src.d_p, len);
+    src.d_p += len;
+    break;
+  }
+
+  case PST_INT32:
+    x = pmt_from_long((int32_t) src.u32());
+    break;
+
+  case PST_DOUBLE:
+    x = pmt_from_double(src.f64());
+    break;
+
+  case PST_COMPLEX: {
+    double re = src.f64();
+    x = pmt_make_rectangular(re, src.f64());
+    break;
+  }
+
+  case PST_VECTOR: {
+    uint32_t n = src.u32();
+    src.need(n);			// at least a byte apiece
+    x = pmt_make_vector(n, PMT_NIL);
+    for (uint32_t i = 0; i < n; i++)
+      pmt_vector_set(x, i, deserialize_from(src));
+    break;
+  }
+
+  case PST_UNIFORM_VECTOR: {
+    unsigned int uvi = src.u8();
+    int subtype = uvi & UVI_SUBTYPE_MASK;
+    if (subtype >= NUVI)
+      throw pmt_exception("pmt_deserialize: malformed input, uniform vector subtype = ",
+			  pmt_from_long(subtype));
+    uint32_t n = src.u32();
+    size_t npad = src.u8();
+    src.need(npad);
+    src.d_p += npad;
+    size_t nbytes = n * uvi_itemsize[subtype];
+    if (nbytes / uvi_itemsize[subtype] != n)
+      throw pmt_exception("pmt_deserialize: truncated input", PMT_F);
+    src.need(nbytes);
+
+    bool swap = (uvi & UVI_ENDIAN_MASK) != (unsigned) host_uvi_endian();
+    bool aligned = ((uintptr_t) src.d_p & (uvi_swapsize[subtype] - 1)) == 0;
+    if (src.d_owner && aligned && !swap)
+      x = make_uniform_vector(subtype, n, src.d_p, src.d_owner);
+    else {
+      x = make_uniform_vector(subtype, n, src.d_p, 0);
+      if (swap){
+	size_t len;
+	swap_bytes((unsigned char *) pmt_uniform_vector_writable_elements(x, len),
+		   nbytes, uvi_swapsize[subtype]);
+      }
+    }
+    src.d_p += nbytes;
+    break;
+  }
+
+  case PST_DICT: {
+    uint32_t n = src.u32();
+    src.need(n);			// at least a byte apiece
+    std::vector<pmt_t> kv;
+    for (uint64_t i = 0; i < 2 * (uint64_t) n; i++)
+      kv.push_back(deserialize_from(src));
+    x = dict_from_items(kv);
+    break;
+  }
+
+  case PST_COMMENT:
+    throw pmt_notimplemented("pmt_deserialize: tag value = ",
+			     pmt_from_long(tag));
+
+  default:
+    throw pmt_exception("pmt_deserialize: malformed input, tag value = ",
+			pmt_from_long(tag));
+  }
+
+  --src.d_depth;
+  if (!last)
+    return x;
+  static_cast<pmt_pair *>(last.get())->d_cdr = x;
+  return head;
+}
+
+static pmt_t
+deserialize_buffer(const void *buf, size_t len, size_t *nused,
+		   const boost::shared_ptr<void> *owner)
+{
+  buffer_source src;
+  src.d_base = src.d_p = (const unsigned char *) buf;
+  src.d_end = src.d_base + len;
+  src.d_owner = owner;
+  src.d_depth = 0;
+
+  pmt_t x = len == 0 ? PMT_EOF : deserialize_from(src);
+  if (nused)
+    *nused = src.d_p - src.d_base;
+  return x;
+}
+
+pmt_t
+pmt_deserialize_from_buffer(const void *buf, size_t len, size_t *nused)
+{
+  return deserialize_buffer(buf, len, nused, 0);
+}
+
+pmt_t
+pmt_deserialize_from_buffer(const void *buf, size_t len,
+			    boost::shared_ptr<void> owner, size_t *nused)
+{
+  return deserialize_buffer(buf, len, nused, &owner);
+}
+
 } /* namespace pmt */
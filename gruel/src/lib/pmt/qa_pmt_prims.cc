@@ -23,9 +23,18 @@
 #include <qa_pmt_prims.h>
 #include <cppunit/TestAssert.h>
 #include <gruel/msg_passing.h>
+#include <gruel/msg_queue.h>
+#include <gruel/pmt_pool.h>
 #include <cstdio>
+#include <climits>
 #include <cstring>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <new>
 
 using namespace pmt;
 
@@ -76,6 +85,41 @@ qa_pmt_prims::test_symbols()
     CPPUNIT_ASSERT(v1[i] == v2[i]);
 }
 
+// intern the same names as every other thread, in a different order
+static void
+intern_symbols(int offset, int n, std::vector<pmt_t> *result)
+{
+  result->resize(n);
+  for (int k = 0; k < n; k++){
+    int i = (k + offset) % n;
+    char buf[100];
+    snprintf(buf, sizeof(buf), "threaded-%d", i);
+    (*result)[i] = pmt_intern(buf);
+  }
+}
+
+void
+qa_pmt_prims::test_symbols_threaded()
+{
+  static const int NTHREADS = 4;
+  static const int N = 20000;	// enough to make the table grow a few times
+  std::vector<pmt_t> v[NTHREADS];
+
+  boost::thread_group threads;
+  for (int t = 0; t < NTHREADS; t++)
+    threads.create_thread(boost::bind(intern_symbols, t * N / NTHREADS, N, &v[t]));
+  threads.join_all();
+
+  for (int i = 0; i < N; i++){
+    char buf[100];
+    snprintf(buf, sizeof(buf), "threaded-%d", i);
+    CPPUNIT_ASSERT_EQUAL(std::string(buf), pmt_symbol_to_string(v[0][i]));
+    for (int t = 1; t < NTHREADS; t++)
+      CPPUNIT_ASSERT(v[t][i] == v[0][i]);
+  }
+  CPPUNIT_ASSERT(pmt_intern("threaded-7", 10) == v[0][7]);
+}
+
 void
 qa_pmt_prims::test_booleans()
 {
@@ -101,6 +145,20 @@ qa_pmt_prims::test_integers()
   CPPUNIT_ASSERT_THROW(pmt_to_long(PMT_T), pmt_wrong_type);
   CPPUNIT_ASSERT_EQUAL(-1L, pmt_to_long(m1));
   CPPUNIT_ASSERT_EQUAL(1L, pmt_to_long(p1));
+
+  // small integers are shared, large ones are not
+  CPPUNIT_ASSERT(pmt_eq(pmt_from_long(5), pmt_from_long(5)));
+  CPPUNIT_ASSERT(pmt_eq(pmt_from_long(-128), pmt_from_long(-128)));
+  CPPUNIT_ASSERT(!pmt_eq(pmt_from_long(1L << 20), pmt_from_long(1L << 20)));
+  CPPUNIT_ASSERT(pmt_eqv(pmt_from_long(1L << 20), pmt_from_long(1L << 20)));
+  for (long i = -130; i <= 1030; i++){
+    pmt_t x = pmt_from_long(i);
+    CPPUNIT_ASSERT(pmt_is_integer(x));
+    CPPUNIT_ASSERT(pmt_is_number(x));
+    CPPUNIT_ASSERT_EQUAL(i, pmt_to_long(x));
+  }
+  CPPUNIT_ASSERT_EQUAL(LONG_MIN, pmt_to_long(pmt_from_long(LONG_MIN)));
+  CPPUNIT_ASSERT_EQUAL(LONG_MAX, pmt_to_long(pmt_from_long(LONG_MAX)));
 }
 
 void
@@ -345,6 +403,48 @@ qa_pmt_prims::test_misc()
   CPPUNIT_ASSERT(pmt_equal(vals, pmt_map(pmt_cdr, alist)));
 }
 
+// which of the basic type predicates are true of x, one bit each
+static unsigned
+predicate_bits(pmt_t x)
+{
+  bool p[] = {
+    pmt_is_bool(x), pmt_is_symbol(x), pmt_is_integer(x), pmt_is_real(x),
+    pmt_is_complex(x), pmt_is_null(x), pmt_is_pair(x), pmt_is_tuple(x),
+    pmt_is_vector(x), pmt_is_any(x), pmt_is_u8vector(x), pmt_is_s8vector(x),
+    pmt_is_u16vector(x), pmt_is_s16vector(x), pmt_is_u32vector(x),
+    pmt_is_s32vector(x), pmt_is_u64vector(x), pmt_is_s64vector(x),
+    pmt_is_f32vector(x), pmt_is_f64vector(x), pmt_is_c32vector(x),
+    pmt_is_c64vector(x)
+  };
+  unsigned bits = 0;
+  for (size_t i = 0; i < sizeof(p) / sizeof(p[0]); i++)
+    if (p[i])
+      bits |= 1 << i;
+  return bits;
+}
+
+void
+qa_pmt_prims::test_predicates()
+{
+  // in the order of the predicates above
+  pmt_t obj[] = {
+    PMT_T, mp("sym"), pmt_from_long(3), pmt_from_double(3),
+    pmt_make_rectangular(3, 4), PMT_NIL, pmt_cons(PMT_T, PMT_F),
+    pmt_make_tuple(PMT_T), pmt_make_vector(2, PMT_NIL), pmt_make_any(3),
+    pmt_make_u8vector(1, 0), pmt_make_s8vector(1, 0), pmt_make_u16vector(1, 0),
+    pmt_make_s16vector(1, 0), pmt_make_u32vector(1, 0), pmt_make_s32vector(1, 0),
+    pmt_make_u64vector(1, 0), pmt_make_s64vector(1, 0), pmt_make_f32vector(1, 0),
+    pmt_make_f64vector(1, 0), pmt_make_c32vector(1, 0), pmt_make_c64vector(1, 0)
+  };
+
+  for (size_t i = 0; i < sizeof(obj) / sizeof(obj[0]); i++){
+    CPPUNIT_ASSERT_EQUAL(1U << i, predicate_bits(obj[i]));
+    CPPUNIT_ASSERT_EQUAL(i >= 2 && i <= 4, pmt_is_number(obj[i]));
+    CPPUNIT_ASSERT_EQUAL(i >= 10, pmt_is_uniform_vector(obj[i]));
+  }
+  CPPUNIT_ASSERT(pmt_is_dict(pmt_dict_add(pmt_make_dict(), PMT_T, PMT_F)));
+}
+
 void
 qa_pmt_prims::test_dict()
 {
@@ -378,6 +478,90 @@ qa_pmt_prims::test_dict()
   //std::cout << "pmt_dict_values: " << pmt_dict_values(dict) << std::endl;
   CPPUNIT_ASSERT(pmt_equal(keys, pmt_dict_keys(dict)));
   CPPUNIT_ASSERT(pmt_equal(vals, pmt_dict_values(dict)));
+
+  // a-lists, what dicts used to be, still work; the first binding wins
+  pmt_t alist = pmt_acons(k1, v1, pmt_acons(k0, v0, pmt_acons(k1, v2, PMT_NIL)));
+  CPPUNIT_ASSERT(pmt_is_dict(alist));
+  CPPUNIT_ASSERT(pmt_dict_has_key(alist, k0));
+  CPPUNIT_ASSERT(!pmt_dict_has_key(alist, k2));
+  CPPUNIT_ASSERT(pmt_eqv(pmt_dict_ref(alist, k1, not_found), v1));
+  CPPUNIT_ASSERT(pmt_equal(pmt_list2(k1, k0), pmt_dict_keys(alist)));
+  CPPUNIT_ASSERT(pmt_equal(pmt_list2(v1, v0), pmt_dict_values(alist)));
+  pmt_t d2 = pmt_dict_add(alist, k2, v2);
+  CPPUNIT_ASSERT(pmt_equal(pmt_list3(k2, k1, k0), pmt_dict_keys(d2)));
+  d2 = pmt_dict_delete(alist, k1);
+  CPPUNIT_ASSERT(!pmt_dict_has_key(d2, k1));
+  CPPUNIT_ASSERT(pmt_eq(alist, pmt_dict_delete(alist, k3)));
+  CPPUNIT_ASSERT(!pmt_is_dict(v0));
+  CPPUNIT_ASSERT_THROW(pmt_dict_ref(pmt_list1(v0), k0, not_found), pmt_wrong_type);
+}
+
+void
+qa_pmt_prims::test_dict_large()
+{
+  const long N = 2000;
+  pmt_t not_found = pmt_cons(PMT_NIL, PMT_NIL);
+  std::vector<pmt_t> keys;
+  for (long i = 0; i < N; i++){
+    char name[32];
+    snprintf(name, sizeof(name), "k%ld", i);
+    keys.push_back(i % 2 ? pmt_from_long(i) : mp(name));
+  }
+
+  pmt_t dict = pmt_make_dict();
+  pmt_t half;
+  for (long i = 0; i < N; i++){
+    dict = pmt_dict_add(dict, keys[i], pmt_from_long(i));
+    if (i == N/2 - 1)
+      half = dict;
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t) N, pmt_length(dict));
+  for (long i = 0; i < N; i++)
+    CPPUNIT_ASSERT_EQUAL(i, pmt_to_long(pmt_dict_ref(dict, keys[i], not_found)));
+  CPPUNIT_ASSERT(pmt_dict_has_key(dict, pmt_from_long(N - 1)));	// numbers compare by value
+
+  // earlier versions are untouched
+  CPPUNIT_ASSERT_EQUAL((size_t) N/2, pmt_length(half));
+  CPPUNIT_ASSERT(pmt_dict_has_key(half, keys[N/2 - 1]));
+  CPPUNIT_ASSERT(!pmt_dict_has_key(half, keys[N/2]));
+
+  // replacing doesn't grow it
+  pmt_t d2 = pmt_dict_add(dict, keys[7], PMT_T);
+  CPPUNIT_ASSERT_EQUAL((size_t) N, pmt_length(d2));
+  CPPUNIT_ASSERT(pmt_eq(PMT_T, pmt_dict_ref(d2, keys[7], not_found)));
+  CPPUNIT_ASSERT_EQUAL(7L, pmt_to_long(pmt_dict_ref(dict, keys[7], not_found)));
+  CPPUNIT_ASSERT(!pmt_equal(dict, d2));
+
+  // delete the even ones, in another order
+  pmt_t d3 = dict;
+  for (long i = N - 2; i >= 0; i -= 2)
+    d3 = pmt_dict_delete(d3, keys[i]);
+  CPPUNIT_ASSERT_EQUAL((size_t) N/2, pmt_length(d3));
+  for (long i = 0; i < N; i++)
+    CPPUNIT_ASSERT_EQUAL(i % 2 == 1, pmt_dict_has_key(d3, keys[i]));
+  CPPUNIT_ASSERT_EQUAL((size_t) N, pmt_length(dict));
+  CPPUNIT_ASSERT(pmt_eq(d3, pmt_dict_delete(d3, keys[0])));	// not there
+
+  // equal holds regardless of insertion order
+  pmt_t d4 = pmt_make_dict();
+  for (long i = N - 1; i >= 0; i -= 2)
+    d4 = pmt_dict_add(d4, keys[i], pmt_from_long(i));
+  CPPUNIT_ASSERT(pmt_equal(d3, d4));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_keys(d4), pmt_reverse(pmt_dict_keys(d3))));
+
+  for (long i = 0; i < N; i++)
+    d4 = pmt_dict_delete(d4, keys[i]);
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, pmt_length(d4));
+  CPPUNIT_ASSERT(pmt_is_null(pmt_dict_items(d4)));
+
+  // -0.0 and 0.0 are the same key
+  pmt_t d5 = pmt_dict_add(pmt_make_dict(), pmt_from_double(0.0), PMT_T);
+  CPPUNIT_ASSERT(pmt_dict_has_key(d5, pmt_from_double(-0.0)));
+  CPPUNIT_ASSERT(!pmt_dict_has_key(d5, pmt_from_long(0)));
+
+  // PMT_NIL still works as the empty dict
+  CPPUNIT_ASSERT(pmt_dict_has_key(pmt_dict_add(PMT_NIL, keys[0], PMT_T), keys[0]));
+  CPPUNIT_ASSERT_THROW(pmt_dict_ref(pmt_from_long(0), keys[0], not_found), pmt_wrong_type);
 }
 
 void
@@ -491,6 +675,122 @@ qa_pmt_prims::test_msg_accepter()
 
 // ------------------------------------------------------------------------
 
+static void
+msgq_produce(gruel::msg_queue *q, long id, long n)
+{
+  for (long i = 0; i < n; i++)
+    q->insert_tail(pmt_cons(pmt_from_long(id), pmt_from_long(i)));
+}
+
+static void
+msgq_consume(gruel::msg_queue *q, pmt_t *result)
+{
+  *result = q->delete_head();
+}
+
+void
+qa_pmt_prims::test_msg_queue()
+{
+  gruel::msg_queue q(4);
+  CPPUNIT_ASSERT(q.empty_p());
+  CPPUNIT_ASSERT(q.delete_head_nowait() == pmt_t());
+
+  for (long i = 0; i < 4; i++)
+    q.insert_tail(pmt_from_long(i));
+  CPPUNIT_ASSERT(q.full_p());
+  CPPUNIT_ASSERT_EQUAL(4U, q.count());
+  CPPUNIT_ASSERT_EQUAL(0L, pmt_to_long(q.delete_head()));
+  CPPUNIT_ASSERT(!q.full_p());
+  CPPUNIT_ASSERT_EQUAL(1L, pmt_to_long(q.delete_head_nowait()));
+
+  std::vector<pmt_t> msgs;
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, q.delete_all(msgs));
+  CPPUNIT_ASSERT_EQUAL(2L, pmt_to_long(msgs[0]));
+  CPPUNIT_ASSERT_EQUAL(3L, pmt_to_long(msgs[1]));
+  CPPUNIT_ASSERT(q.empty_p());
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, q.delete_all(msgs));
+
+  // several producers blocking on a full queue and a consumer that
+  // alternates between blocking and batch removal: each producer's
+  // messages arrive complete and in order
+  static const long NPRODUCERS = 4;
+  static const long N = 5000;
+  boost::thread_group producers;
+  for (long id = 0; id < NPRODUCERS; id++)
+    producers.create_thread(boost::bind(msgq_produce, &q, id, N));
+
+  std::vector<long> next(NPRODUCERS, 0);
+  long nreceived = 0;
+  while (nreceived < NPRODUCERS * N){
+    msgs.clear();
+    if (nreceived & 1)
+      q.delete_all(msgs);
+    else
+      msgs.push_back(q.delete_head());
+    CPPUNIT_ASSERT(msgs.size() <= 4);
+    for (size_t i = 0; i < msgs.size(); i++){
+      long id = pmt_to_long(pmt_car(msgs[i]));
+      CPPUNIT_ASSERT_EQUAL(next[id], pmt_to_long(pmt_cdr(msgs[i])));
+      next[id]++;
+      nreceived++;
+    }
+  }
+  producers.join_all();
+  CPPUNIT_ASSERT(q.empty_p());
+
+  // an unbounded queue never blocks the producer
+  gruel::msg_queue u(0);
+  msgq_produce(&u, 0, N);
+  CPPUNIT_ASSERT(!u.full_p());
+  CPPUNIT_ASSERT_EQUAL((unsigned int) N, u.count());
+  u.flush();
+  CPPUNIT_ASSERT(u.empty_p());
+
+  // a reader asleep in delete_head doesn't hold up the other removers
+  pmt_t got;
+  boost::thread reader(boost::bind(msgq_consume, &u, &got));
+  boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+  CPPUNIT_ASSERT(u.delete_head_nowait() == pmt_t());
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, u.delete_all(msgs));
+  u.flush();
+  u.insert_tail(pmt_from_long(42));
+  reader.join();
+  CPPUNIT_ASSERT_EQUAL(42L, pmt_to_long(got));
+}
+
+// ------------------------------------------------------------------------
+
+static void
+serial_test_objects(std::vector<pmt_t> &objs)
+{
+  objs.push_back(pmt_from_double(3.25e9));
+  objs.push_back(pmt_from_double(-0.1));
+  objs.push_back(pmt_make_rectangular(1.5, -2));
+  pmt_t v = pmt_make_vector(3, PMT_NIL);
+  pmt_vector_set(v, 0, mp("vec"));
+  pmt_vector_set(v, 1, pmt_from_long(7));
+  pmt_vector_set(v, 2, pmt_list2(PMT_T, pmt_from_double(2)));
+  objs.push_back(v);
+  objs.push_back(pmt_make_vector(0, PMT_NIL));
+
+  uint8_t u8[] = { 1, 2, 255 };
+  int16_t s16[] = { -1, 2, 30000 };
+  uint32_t u32[] = { 1, 0xdeadbeef };
+  int64_t s64[] = { -1, 1LL << 40 };
+  double f64[] = { 1.5, -2.25 };
+  std::complex<float> c32[] = { std::complex<float>(1, -1), std::complex<float>(0.5, 2) };
+  std::complex<double> c64[] = { std::complex<double>(3, 4) };
+  objs.push_back(pmt_init_u8vector(3, u8));
+  objs.push_back(pmt_init_s16vector(3, s16));
+  objs.push_back(pmt_init_u32vector(2, u32));
+  objs.push_back(pmt_init_s64vector(2, s64));
+  objs.push_back(pmt_init_f64vector(2, f64));
+  objs.push_back(pmt_init_c32vector(2, c32));
+  objs.push_back(pmt_init_c64vector(1, c64));
+  objs.push_back(pmt_make_f32vector(0, 0));
+  objs.push_back(pmt_list2(pmt_init_u8vector(1, u8), pmt_init_c64vector(1, c64)));
+}
+
 void
 qa_pmt_prims::test_serialize()
 {
@@ -533,10 +833,157 @@ qa_pmt_prims::test_serialize()
 
   CPPUNIT_ASSERT(pmt_equal(pmt_deserialize(sb), PMT_EOF));	// last item
 
+  // numbers, vectors and uniform vectors
+  std::vector<pmt_t> objs;
+  serial_test_objects(objs);
+  sb.str("");
+  for (size_t i = 0; i < objs.size(); i++)
+    CPPUNIT_ASSERT(pmt_serialize(objs[i], sb));
+  for (size_t i = 0; i < objs.size(); i++)
+    CPPUNIT_ASSERT(pmt_equal(pmt_deserialize(sb), objs[i]));
+  CPPUNIT_ASSERT(pmt_equal(pmt_deserialize(sb), PMT_EOF));
+
+  // dicts come back as dicts, with the same items in the same order
+  pmt_t dict = pmt_make_dict();
+  dict = pmt_dict_add(dict, a, pmt_from_long(1));
+  dict = pmt_dict_add(dict, b, pmt_list2(c, pmt_from_double(2.5)));
+  dict = pmt_dict_add(dict, pmt_from_long(3), pmt_dict_add(pmt_make_dict(), c, PMT_T));
+  sb.str("");
+  CPPUNIT_ASSERT(pmt_serialize(dict, sb));
+  CPPUNIT_ASSERT(pmt_serialize(pmt_make_dict(), sb));
+  pmt_t d = pmt_deserialize(sb);
+  CPPUNIT_ASSERT(pmt_is_dict(d) && !pmt_is_null(d));
+  CPPUNIT_ASSERT_EQUAL(pmt_length(pmt_dict_items(dict)), pmt_length(pmt_dict_items(d)));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_keys(dict), pmt_dict_keys(d)));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_ref(d, a, PMT_NIL), pmt_from_long(1)));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_ref(d, b, PMT_NIL), pmt_list2(c, pmt_from_double(2.5))));
+  CPPUNIT_ASSERT(pmt_eq(pmt_dict_ref(pmt_dict_ref(d, pmt_from_long(3), PMT_NIL), c, PMT_F), PMT_T));
+  d = pmt_deserialize(sb);
+  CPPUNIT_ASSERT(pmt_is_dict(d) && !pmt_is_null(d));
+  CPPUNIT_ASSERT(pmt_is_null(pmt_dict_items(d)));
+  CPPUNIT_ASSERT(pmt_equal(pmt_deserialize(sb), PMT_EOF));
+
+  // a huge count followed by a short input fails without allocating
+  // for it: overwrite the counts of a vector (tag, n) and a uniform
+  // vector (tag, uvi, n)
+  sb.str("");
+  CPPUNIT_ASSERT(pmt_serialize(pmt_make_vector(2, PMT_T), sb));
+  std::string s = sb.str();
+  s.replace(1, 4, 4, '\xff');
+  sb.str(s);
+  CPPUNIT_ASSERT_THROW(pmt_deserialize(sb), pmt_exception);
+
+  sb.str("");
+  CPPUNIT_ASSERT(pmt_serialize(pmt_make_c64vector(2, 0), sb));
+  s = sb.str();
+  s.replace(2, 4, 4, '\xff');
+  sb.str(s);
+  CPPUNIT_ASSERT_THROW(pmt_deserialize(sb), pmt_exception);
+}
 
-  // FIXME add tests for real, complex, vector, uniform-vector, dict
-  // FIXME add tests for malformed input too.
+void
+qa_pmt_prims::test_serialize_buffer()
+{
+  std::vector<pmt_t> objs;
+  serial_test_objects(objs);
+  objs.push_back(mp("foobarvia"));
+  objs.push_back(pmt_list3(mp("a"), pmt_list3(PMT_T, PMT_F, PMT_NIL), pmt_from_long(-123456789)));
+  objs.push_back(pmt_cons(mp("a"), mp("b")));
+
+  // back to back, odd offsets and all
+  size_t size = 0;
+  for (size_t i = 0; i < objs.size(); i++)
+    size += pmt_serialized_size(objs[i]) + 8;
+  std::vector<double> storage(size / sizeof(double) + 1);	// aligned
+  unsigned char *buf = (unsigned char *) &storage[0];
+
+  size_t offset = 0;
+  for (size_t i = 0; i < objs.size(); i++){
+    size_t n = pmt_serialized_size(objs[i]);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, pmt_serialize_to_buffer(objs[i], buf + offset, n - 1));
+    CPPUNIT_ASSERT_EQUAL(n, pmt_serialize_to_buffer(objs[i], buf + offset, n));
+    offset += n;
+  }
 
+  // it's the same representation as the stream one
+  std::stringbuf sb(std::string((char *) buf, offset));
+  for (size_t i = 0; i < objs.size(); i++)
+    CPPUNIT_ASSERT(pmt_equal(pmt_deserialize(sb), objs[i]));
+
+  boost::shared_ptr<void> owner(new int(0));
+  for (int alias = 0; alias < 2; alias++){
+    size_t pos = 0;
+    for (size_t i = 0; i < objs.size(); i++){
+      size_t nused;
+      pmt_t x = alias
+	? pmt_deserialize_from_buffer(buf + pos, offset - pos, owner, &nused)
+	: pmt_deserialize_from_buffer(buf + pos, offset - pos, &nused);
+      CPPUNIT_ASSERT(pmt_equal(x, objs[i]));
+      pos += nused;
+    }
+    CPPUNIT_ASSERT_EQUAL(offset, pos);
+    CPPUNIT_ASSERT(pmt_eq(PMT_EOF, pmt_deserialize_from_buffer(buf + pos, 0)));
+  }
+
+  // aliased items are read in place until written to
+  float f[3] = { 1, 2, 3 };
+  size_t n = pmt_serialize_to_buffer(pmt_init_f32vector(3, f), buf, size);
+  CPPUNIT_ASSERT(n != 0);
+  long refs = owner.use_count();
+  pmt_t a = pmt_deserialize_from_buffer(buf, n, owner);
+  CPPUNIT_ASSERT_EQUAL(refs + 1, owner.use_count());
+  size_t len;
+  const float *e = pmt_f32vector_elements(a, len);
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, len);
+  CPPUNIT_ASSERT((const unsigned char *) e > buf && (const unsigned char *) e < buf + n);
+  pmt_f32vector_set(a, 1, 5);
+  CPPUNIT_ASSERT_EQUAL(refs, owner.use_count());		// let go of buf
+  CPPUNIT_ASSERT_EQUAL(5.0f, pmt_f32vector_ref(a, 1));
+  CPPUNIT_ASSERT_EQUAL(3.0f, pmt_f32vector_ref(a, 2));
+  CPPUNIT_ASSERT_EQUAL(2.0f, pmt_f32vector_ref(pmt_deserialize_from_buffer(buf, n), 1));
+
+  // truncated input
+  for (size_t k = 1; k < n; k++)
+    CPPUNIT_ASSERT_THROW(pmt_deserialize_from_buffer(buf, k), pmt_exception);
+
+  // dicts, read back from the buffer or as a stream
+  pmt_t dict = pmt_dict_add(pmt_make_dict(), mp("a"), pmt_init_f32vector(3, f));
+  dict = pmt_dict_add(dict, mp("b"), pmt_from_long(2));
+  n = pmt_serialize_to_buffer(dict, buf, size);
+  CPPUNIT_ASSERT_EQUAL(pmt_serialized_size(dict), n);
+  pmt_t d = pmt_deserialize_from_buffer(buf, n);
+  CPPUNIT_ASSERT(pmt_is_dict(d) && !pmt_is_null(d));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_items(dict), pmt_dict_items(d)));
+  std::stringbuf dsb(std::string((char *) buf, n));
+  d = pmt_deserialize(dsb);
+  CPPUNIT_ASSERT(pmt_is_dict(d) && !pmt_is_null(d));
+  CPPUNIT_ASSERT(pmt_equal(pmt_dict_items(dict), pmt_dict_items(d)));
+
+  // deeply nested cars and vectors are refused, not recursed into
+  pmt_t deep_car = PMT_NIL;
+  pmt_t deep_vec = PMT_NIL;
+  for (int i = 0; i < 100; i++){
+    deep_car = pmt_cons(deep_car, PMT_NIL);
+    deep_vec = pmt_make_vector(1, deep_vec);
+  }
+  pmt_t deep[2] = { deep_car, deep_vec };
+  for (int j = 0; j < 2; j++){
+    std::vector<unsigned char> dbuf(pmt_serialized_size(deep[j]));
+    n = pmt_serialize_to_buffer(deep[j], &dbuf[0], dbuf.size());
+    CPPUNIT_ASSERT(pmt_equal(deep[j], pmt_deserialize_from_buffer(&dbuf[0], n)));
+  }
+  for (int i = 100; i < 5000; i++){
+    deep_car = pmt_cons(deep_car, PMT_NIL);
+    deep_vec = pmt_make_vector(1, deep_vec);
+  }
+  deep[0] = deep_car;
+  deep[1] = deep_vec;
+  for (int j = 0; j < 2; j++){
+    std::vector<unsigned char> dbuf(pmt_serialized_size(deep[j]));
+    n = pmt_serialize_to_buffer(deep[j], &dbuf[0], dbuf.size());
+    CPPUNIT_ASSERT(n != 0);
+    CPPUNIT_ASSERT_THROW(pmt_deserialize_from_buffer(&dbuf[0], n), pmt_exception);
+  }
 }
 
 void
@@ -576,3 +1023,104 @@ qa_pmt_prims::test_sugar()
   CPPUNIT_ASSERT_EQUAL(sizeof(buf), nbytes);
   CPPUNIT_ASSERT(memcmp(buf, data, nbytes) == 0);
 }
+
+// ------------------------------------------------------------------------
+
+static void
+pool_alloc(pmt_pool *pool, std::vector<void *> *v, size_t n)
+{
+  for (size_t i = 0; i < n; i++){
+    void *p = pool->malloc();
+    memset(p, 0x55, 48);
+    v->push_back(p);
+  }
+}
+
+static void
+pool_free(pmt_pool *pool, std::vector<void *> *v)
+{
+  for (size_t i = 0; i < v->size(); i++)
+    pool->free((*v)[i]);
+  v->clear();
+}
+
+// Take items into this thread's magazine, then use a new pool that
+// the main thread builds at the same address.
+static void
+pool_outlive(pmt_pool **pool, boost::barrier *b)
+{
+  (*pool)->free((*pool)->malloc());
+  b->wait();			// main replaces the pool
+  b->wait();
+  void *p = (*pool)->malloc();
+  b->wait();			// main checks where p came from
+  b->wait();
+  (*pool)->free(p);
+}
+
+void
+qa_pmt_prims::test_pool()
+{
+  static const size_t N = 1000;
+  pmt_pool pool(48, 16, 4096, 0, 8);
+  std::vector<void *> v;
+
+  // everything distinct and aligned
+  pool_alloc(&pool, &v, N);
+  std::vector<void *> sorted(v);
+  std::sort(sorted.begin(), sorted.end());
+  CPPUNIT_ASSERT(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+  for (size_t i = 0; i < N; i++)
+    CPPUNIT_ASSERT_EQUAL((uintptr_t) 0, (uintptr_t) v[i] & 15);
+
+  // plus what's left of the last batch in our magazine
+  pmt_pool_stats s = pool.stats();
+  CPPUNIT_ASSERT(s.nitems >= N && s.nitems < N + 8);
+  CPPUNIT_ASSERT_EQUAL(s.nitems, s.high_water);
+  size_t high_water = s.high_water;
+  size_t nallocated = s.nallocated;
+  CPPUNIT_ASSERT(nallocated >= N);
+
+  pool_free(&pool, &v);
+  pool.flush();
+  s = pool.stats();
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, s.nitems);
+  CPPUNIT_ASSERT(s.nhits > N);		// most frees and allocs stay local
+
+  // allocate on one thread, free on another: nothing leaks
+  for (int round = 0; round < 3; round++){
+    boost::thread t1(boost::bind(pool_alloc, &pool, &v, N));
+    t1.join();
+    boost::thread t2(boost::bind(pool_free, &pool, &v));
+    t2.join();
+  }
+  s = pool.stats();
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, s.nitems);	// exiting threads give theirs back
+  CPPUNIT_ASSERT_EQUAL(nallocated, s.nallocated);
+  CPPUNIT_ASSERT(s.high_water < high_water + 8);
+
+  // a thread that outlives a pool doesn't use its magazine for the
+  // next pool at the same address
+  void *mem = ::operator new(sizeof(pmt_pool));
+  pmt_pool *p = new (mem) pmt_pool(48, 16, 4096, 0, 8);
+  boost::barrier b(2);
+  boost::thread t(boost::bind(pool_outlive, &p, &b));
+  b.wait();
+  p->~pmt_pool();
+  p = new (mem) pmt_pool(48, 16, 4096, 0, 8);
+  b.wait();
+  b.wait();
+  CPPUNIT_ASSERT(p->stats().nitems > 0);	// came from the new pool's chunks
+  b.wait();
+  t.join();
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, p->stats().nitems);
+  p->~pmt_pool();
+  ::operator delete(mem);
+
+  // a limited pool hands out exactly max_items
+  pmt_pool limited(48, 16, 4096, 10);
+  pool_alloc(&limited, &v, 10);
+  CPPUNIT_ASSERT_EQUAL((size_t) 10, limited.stats().nitems);
+  pool_free(&limited, &v);
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, limited.stats().nitems);
+}
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006 Free Software Foundation, Inc.
+ * Copyright 2006,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,6 +29,7 @@ class qa_pmt_prims : public CppUnit::TestCase {
 
   CPPUNIT_TEST_SUITE(qa_pmt_prims);
   CPPUNIT_TEST(test_symbols);
+  CPPUNIT_TEST(test_symbols_threaded);
   CPPUNIT_TEST(test_booleans);
   CPPUNIT_TEST(test_integers);
   CPPUNIT_TEST(test_reals);
@@ -38,18 +39,24 @@ class qa_pmt_prims : public CppUnit::TestCase {
   CPPUNIT_TEST(test_tuples);
   CPPUNIT_TEST(test_equivalence);
   CPPUNIT_TEST(test_misc);
+  CPPUNIT_TEST(test_predicates);
   CPPUNIT_TEST(test_dict);
+  CPPUNIT_TEST(test_dict_large);
   CPPUNIT_TEST(test_any);
   CPPUNIT_TEST(test_msg_accepter);
+  CPPUNIT_TEST(test_msg_queue);
   CPPUNIT_TEST(test_io);
   CPPUNIT_TEST(test_lists);
   CPPUNIT_TEST(test_serialize);
+  CPPUNIT_TEST(test_serialize_buffer);
   CPPUNIT_TEST(test_sets);
   CPPUNIT_TEST(test_sugar);
+  CPPUNIT_TEST(test_pool);
   CPPUNIT_TEST_SUITE_END();
 
  private:
   void test_symbols();
+  void test_symbols_threaded();
   void test_booleans();
   void test_integers();
   void test_reals();
@@ -59,14 +66,19 @@ class qa_pmt_prims : public CppUnit::TestCase {
   void test_tuples();
   void test_equivalence();
   void test_misc();
+  void test_predicates();
   void test_dict();
+  void test_dict_large();
   void test_any();
   void test_msg_accepter();
+  void test_msg_queue();
   void test_io();
   void test_lists();
   void test_serialize();
+  void test_serialize_buffer();
   void test_sets();
   void test_sugar();
+  void test_pool();
 };
 
 #endif /* INCLUDED_QA_PMT_PRIMS_H */
@@ -5,24 +5,37 @@
 namespace pmt {
 
 static pmt_@TAG@vector *
-_@TAG@vector(pmt_t x)
+_@TAG@vector(const pmt_t &x)
 {
-  return dynamic_cast<pmt_@TAG@vector*>(x.get());
+  return static_cast<pmt_@TAG@vector*>(x.get());
 }
 
 
 pmt_@TAG@vector::pmt_@TAG@vector(size_t k, @TYPE@ fill)
-  : d_v(k)
+  : pmt_uniform_vector(PMT_TYPE_@UTAG@VECTOR), d_v(k, fill), d_alias(0), d_len(k)
 {
-  for (size_t i = 0; i < k; i++)
-    d_v[i] = fill;
 }
 
 pmt_@TAG@vector::pmt_@TAG@vector(size_t k, const @TYPE@ *data)
-  : d_v(k)
+  : pmt_uniform_vector(PMT_TYPE_@UTAG@VECTOR), d_v(data, data + k), d_alias(0), d_len(k)
 {
-  for (size_t i = 0; i < k; i++)
-    d_v[i] = data[i];
+}
+
+pmt_@TAG@vector::pmt_@TAG@vector(size_t k, const @TYPE@ *data,
+				 boost::shared_ptr<void> owner)
+  : pmt_uniform_vector(PMT_TYPE_@UTAG@VECTOR), d_alias(data), d_len(k),
+    d_owner(owner)
+{
+}
+
+void
+pmt_@TAG@vector::unalias()
+{
+  if (d_alias){
+    d_v.assign(d_alias, d_alias + d_len);
+    d_alias = 0;
+    d_owner.reset();
+  }
 }
 
 @TYPE@
@@ -30,7 +43,7 @@ pmt_@TAG@vector::ref(size_t k) const
 {
   if (k >= length())
     throw pmt_out_of_range("pmt_@TAG@vector_ref", pmt_from_long(k));
-  return d_v[k];
+  return d_alias ? d_alias[k] : d_v[k];
 }
 
 void 
@@ -38,6 +51,7 @@ pmt_@TAG@vector::set(size_t k, @TYPE@ x)
 {
   if (k >= length())
     throw pmt_out_of_range("pmt_@TAG@vector_set", pmt_from_long(k));
+  unalias();
   d_v[k] = x;
 }
 
@@ -45,12 +59,13 @@ const @TYPE@ *
 pmt_@TAG@vector::elements(size_t &len)
 {
   len = length();
-  return &d_v[0];
+  return d_alias ? d_alias : &d_v[0];
 }
 
 @TYPE@ *
 pmt_@TAG@vector::writable_elements(size_t &len)
 {
+  unalias();
   len = length();
   return &d_v[0];
 }
@@ -59,12 +74,13 @@ const void*
 pmt_@TAG@vector::uniform_elements(size_t &len)
 {
   len = length() * sizeof(@TYPE@);
-  return &d_v[0];
+  return d_alias ? d_alias : &d_v[0];
 }
 
 void*
 pmt_@TAG@vector::uniform_writable_elements(size_t &len)
 {
+  unalias();
   len = length() * sizeof(@TYPE@);
   return &d_v[0];
 }
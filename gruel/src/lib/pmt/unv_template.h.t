@@ -6,14 +6,20 @@
 class pmt_@TAG@vector : public pmt_uniform_vector
 {
   std::vector< @TYPE@ >	d_v;
+  const @TYPE@	       *d_alias;	// someone else's elements, or 0
+  size_t		d_len;
+  boost::shared_ptr<void> d_owner;	// keeps d_alias valid
+
+  void unalias();
 
 public:
   pmt_@TAG@vector(size_t k, @TYPE@ fill);
   pmt_@TAG@vector(size_t k, const @TYPE@ *data);
+  // refer to data (not a copy) until written to; owner keeps it alive
+  pmt_@TAG@vector(size_t k, const @TYPE@ *data, boost::shared_ptr<void> owner);
   // ~pmt_@TAG@vector();
 
-  bool is_@TAG@vector() const { return true; }
-  size_t length() const { return d_v.size(); }
+  size_t length() const { return d_len; }
   @TYPE@ ref(size_t k) const;
   void set(size_t k, @TYPE@ x);
   const @TYPE@ *elements(size_t &len);
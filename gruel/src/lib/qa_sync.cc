@@ -0,0 +1,288 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <qa_sync.h>
+#include <cppunit/TestAssert.h>
+#include <gruel/futex.h>
+#include <gruel/event_count.h>
+#include <gruel/seqlock.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <sys/time.h>
+
+using namespace gruel;
+
+static double
+wall_seconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+// absolute time ms milliseconds from now
+static struct timespec
+in_ms(long ms)
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  long usecs = tv.tv_usec + ms * 1000;
+  struct timespec ts;
+  ts.tv_sec = tv.tv_sec + usecs / 1000000;
+  ts.tv_nsec = (usecs % 1000000) * 1000;
+  return ts;
+}
+
+// ----------------------------------------------------------------
+
+static void
+increment(futex_mutex *mutex, long *counter, long n)
+{
+  for (long i = 0; i < n; i++){
+    futex_scoped_lock guard(*mutex);
+    long v = *counter;		// not atomic: the lock has to work
+    *counter = v + 1;
+  }
+}
+
+void
+qa_sync::test_mutex()
+{
+  static const int NTHREADS = 4;
+  static const long N = 100000;
+
+  futex_mutex mutex;
+  long counter = 0;
+
+  CPPUNIT_ASSERT(mutex.try_lock());
+  CPPUNIT_ASSERT(!mutex.try_lock());
+  mutex.unlock();
+
+  boost::thread_group threads;
+  for (int t = 0; t < NTHREADS; t++)
+    threads.create_thread(boost::bind(increment, &mutex, &counter, N));
+  threads.join_all();
+
+  CPPUNIT_ASSERT_EQUAL(NTHREADS * N, counter);
+  CPPUNIT_ASSERT(mutex.try_lock());
+  mutex.unlock();
+}
+
+// ----------------------------------------------------------------
+
+// A one slot mailbox
+struct mailbox {
+  futex_mutex		mutex;
+  futex_condition	not_empty;
+  futex_condition	not_full;
+  bool			full;
+  long			value;
+
+  mailbox() : full(false), value(0) {}
+
+  void put(long v)
+  {
+    futex_scoped_lock guard(mutex);
+    while (full)
+      not_full.wait(guard);
+    value = v;
+    full = true;
+    not_empty.notify_one();
+  }
+
+  long get()
+  {
+    futex_scoped_lock guard(mutex);
+    while (!full)
+      not_empty.wait(guard);
+    full = false;
+    not_full.notify_one();
+    return value;
+  }
+};
+
+static void
+put_values(mailbox *mb, long first, long n)
+{
+  for (long i = 0; i < n; i++)
+    mb->put(first + i);
+}
+
+void
+qa_sync::test_condition()
+{
+  static const long N = 20000;
+
+  mailbox mb;
+  boost::thread_group threads;
+  threads.create_thread(boost::bind(put_values, &mb, 1, N));
+  threads.create_thread(boost::bind(put_values, &mb, N + 1, N));
+
+  long sum = 0;
+  for (long i = 0; i < 2 * N; i++)
+    sum += mb.get();
+  threads.join_all();
+
+  CPPUNIT_ASSERT_EQUAL(N * (2 * N + 1), sum);	// 1 + 2 + ... + 2N
+}
+
+void
+qa_sync::test_condition_timeout()
+{
+  futex_mutex mutex;
+  futex_condition cond;
+  futex_scoped_lock guard(mutex);
+
+  double t0 = wall_seconds();
+  CPPUNIT_ASSERT(!cond.timed_wait(guard, in_ms(50)));
+  CPPUNIT_ASSERT(wall_seconds() - t0 >= 0.045);
+  CPPUNIT_ASSERT(!mutex.try_lock());		// we have it back
+
+  // A time in the past times out right away
+  CPPUNIT_ASSERT(!cond.timed_wait(guard, in_ms(-10)));
+}
+
+// ----------------------------------------------------------------
+
+static void
+count_up(volatile long *counter, event_count *ec, long n)
+{
+  for (long i = 0; i < n; i++){
+    atomic_fetch_add(counter, 1L);
+    ec->notify_all();
+  }
+}
+
+static void
+wait_for(volatile long *counter, event_count *ec, long n)
+{
+  while (atomic_load(counter) < n){
+    event_count::key_type key = ec->prepare_wait();
+    if (atomic_load(counter) < n)
+      ec->wait(key);
+  }
+}
+
+void
+qa_sync::test_event_count()
+{
+  static const long N = 100000;
+  static const int NWAITERS = 3;
+
+  // One thread counts, the others each wait for it to be done.
+  // Every wake-up is a chance to miss one.
+  volatile long counter = 0;
+  event_count ec;
+
+  boost::thread_group threads;
+  for (int t = 0; t < NWAITERS; t++)
+    threads.create_thread(boost::bind(wait_for, &counter, &ec, N));
+  threads.create_thread(boost::bind(count_up, &counter, &ec, N));
+  threads.join_all();
+
+  CPPUNIT_ASSERT_EQUAL(N, (long) counter);
+}
+
+void
+qa_sync::test_event_count_timeout()
+{
+  event_count ec;
+
+  event_count::key_type key = ec.prepare_wait();
+  double t0 = wall_seconds();
+  CPPUNIT_ASSERT(!ec.timed_wait(key, in_ms(50)));
+  CPPUNIT_ASSERT(wall_seconds() - t0 >= 0.045);
+
+  // A notify since prepare_wait: no waiting
+  key = ec.prepare_wait();
+  ec.notify_all();
+  CPPUNIT_ASSERT(ec.timed_wait(key, in_ms(5000)));
+}
+
+// ----------------------------------------------------------------
+
+static const int NWORDS = 8;
+
+struct shared_words {
+  seqlock		lock;
+  volatile long		words[NWORDS];
+  volatile int		done;
+};
+
+static void
+write_words(shared_words *s, long n)
+{
+  for (long i = 1; i <= n; i++){
+    s->lock.write_lock();
+    for (int j = 0; j < NWORDS; j++)
+      s->words[j] = i;
+    s->lock.write_unlock();
+  }
+  atomic_store(&s->done, 1);
+}
+
+// Every copy a reader gets is from a single write
+static void
+read_words(shared_words *s, long *ntorn)
+{
+  long last = 0;
+  *ntorn = 0;
+  while (!atomic_load(&s->done)){
+    long copy[NWORDS];
+    unsigned int seq;
+    do {
+      seq = s->lock.read_begin();
+      for (int j = 0; j < NWORDS; j++)
+	copy[j] = s->words[j];
+    } while (s->lock.read_retry(seq));
+
+    for (int j = 1; j < NWORDS; j++)
+      if (copy[j] != copy[0])
+	(*ntorn)++;
+    if (copy[0] < last)		// writes never go backwards
+      (*ntorn)++;
+    last = copy[0];
+  }
+}
+
+void
+qa_sync::test_seqlock()
+{
+  static const long N = 200000;
+  static const int NREADERS = 2;
+
+  shared_words s;
+  for (int j = 0; j < NWORDS; j++)
+    s.words[j] = 0;
+  s.done = 0;
+
+  long ntorn[NREADERS];
+  boost::thread_group threads;
+  for (int t = 0; t < NREADERS; t++)
+    threads.create_thread(boost::bind(read_words, &s, &ntorn[t]));
+  threads.create_thread(boost::bind(write_words, &s, N));
+  threads.join_all();
+
+  for (int t = 0; t < NREADERS; t++)
+    CPPUNIT_ASSERT_EQUAL(0L, ntorn[t]);
+  CPPUNIT_ASSERT_EQUAL(N, (long) s.words[NWORDS - 1]);
+}
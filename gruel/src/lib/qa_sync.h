@@ -0,0 +1,50 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef INCLUDED_QA_SYNC_H
+#define INCLUDED_QA_SYNC_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+//! tests for gruel/futex.h, gruel/event_count.h and gruel/seqlock.h
+
+class qa_sync : public CppUnit::TestCase {
+
+  CPPUNIT_TEST_SUITE(qa_sync);
+  CPPUNIT_TEST(test_mutex);
+  CPPUNIT_TEST(test_condition);
+  CPPUNIT_TEST(test_condition_timeout);
+  CPPUNIT_TEST(test_event_count);
+  CPPUNIT_TEST(test_event_count_timeout);
+  CPPUNIT_TEST(test_seqlock);
+  CPPUNIT_TEST_SUITE_END();
+
+ private:
+  void test_mutex();
+  void test_condition();
+  void test_condition_timeout();
+  void test_event_count();
+  void test_event_count_timeout();
+  void test_seqlock();
+};
+
+#endif /* INCLUDED_QA_SYNC_H */
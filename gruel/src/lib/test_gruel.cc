@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2009 Free Software Foundation, Inc.
+ * Copyright 2006,2009,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -22,6 +22,7 @@
 
 #include <cppunit/TextTestRunner.h>
 #include "pmt/qa_pmt.h"
+#include "qa_sync.h"
 
 int 
 main(int argc, char **argv)
@@ -30,6 +31,7 @@ main(int argc, char **argv)
   CppUnit::TextTestRunner	runner;
 
   runner.addTest(qa_pmt::suite ());
+  runner.addTest(qa_sync::suite ());
   
   bool was_successful = runner.run("", false);
 
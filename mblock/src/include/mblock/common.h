@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2007,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -27,6 +27,7 @@
 #include <boost/utility.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/intrusive_ptr.hpp>
 
 /*
  * The priority type and valid range
@@ -86,7 +87,9 @@ class mb_msg_accepter;
 typedef boost::shared_ptr<mb_msg_accepter> mb_msg_accepter_sptr;
 
 class mb_message;
-typedef boost::shared_ptr<mb_message> mb_message_sptr;
+inline void intrusive_ptr_add_ref(mb_message *msg);	// in mblock/message.h
+inline void intrusive_ptr_release(mb_message *msg);
+typedef boost::intrusive_ptr<mb_message> mb_message_sptr;
 
 class mb_msg_queue;
 typedef boost::shared_ptr<mb_msg_queue> mb_msg_queue_sptr;
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -54,6 +54,13 @@ private:
   friend class mb_runtime;
   friend class mb_mblock_impl;
   friend class mb_worker;
+  friend class mb_runtime_thread_pool;
+
+  /*!
+   * \brief Deliver one message: exit on %halt, else handle_message.
+   * pmt exceptions raised by handle_message are reported and ignored.
+   */
+  void dispatch(mb_message_sptr msg);
 
 protected:
   /*!
@@ -223,7 +230,9 @@ protected:
    * \brief main event dispatching loop
    *
    * Although it is possible to override this, the default implementation
-   * should work for virtually all cases.
+   * should work for virtually all cases.  It is not used by runtimes
+   * that share threads between mblocks (mb_make_runtime_thread_pool);
+   * they deliver each message themselves.
    */
   virtual void main_loop();
   
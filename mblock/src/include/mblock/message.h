@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2007,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -22,15 +22,11 @@
 #define INCLUDED_MB_MESSAGE_H
 
 #include <mblock/common.h>
+#include <gruel/atomic.h>
 #include <iosfwd>
 
-#define MB_MESSAGE_LOCAL_ALLOCATOR 0	// define to 0 or 1
-
-class mb_message;
-typedef boost::shared_ptr<mb_message> mb_message_sptr;
-
 /*!
- * \brief construct a message and return boost::shared_ptr
+ * \brief construct a message and return an mb_message_sptr
  *
  * \param signal	identifier of the message
  * \param data		the data to be operated on
@@ -43,8 +39,15 @@ mb_make_message(pmt_t signal,
 		pmt_t metadata = PMT_NIL,
 		mb_pri_t priority = MB_PRI_DEFAULT);
 
+/*!
+ * \brief an mblock message
+ *
+ * Messages carry their own reference count, and are allocated from a
+ * pool, so making and passing one around costs no trips to the heap.
+ */
 class mb_message {
-  mb_message_sptr d_next;		// link field for msg queue
+  volatile long	  d_refcount;
+  mb_message	 *d_next;		// link field for msg queue
   pmt_t		  d_signal;
   pmt_t		  d_data;
   pmt_t		  d_metadata;
@@ -56,6 +59,9 @@ class mb_message {
   friend mb_message_sptr
   mb_make_message(pmt_t signal, pmt_t data, pmt_t metadata, mb_pri_t priority);
 
+  friend void intrusive_ptr_add_ref(mb_message *msg);
+  friend void intrusive_ptr_release(mb_message *msg);
+
   // private constructor
   mb_message(pmt_t signal, pmt_t data, pmt_t metadata, mb_pri_t priority);
 
@@ -70,12 +76,23 @@ public:
 
   void set_port_id(pmt_t port_id){ d_port_id = port_id; }
 
-#if (MB_MESSAGE_LOCAL_ALLOCATOR)
   void *operator new(size_t);
   void operator delete(void *, size_t);
-#endif
 };
 
+inline void
+intrusive_ptr_add_ref(mb_message *msg)
+{
+  gruel::atomic_fetch_add(&msg->d_refcount, 1L);
+}
+
+inline void
+intrusive_ptr_release(mb_message *msg)
+{
+  if (gruel::atomic_fetch_add(&msg->d_refcount, -1L) == 1)
+    delete msg;
+}
+
 std::ostream& operator<<(std::ostream& os, const mb_message &msg);
 
 inline
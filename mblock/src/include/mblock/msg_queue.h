@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -22,29 +22,62 @@
 #define INCLUDED_MB_MSG_QUEUE_H
 
 #include <mblock/common.h>
-#include <gnuradio/omnithread.h>
+#include <gruel/event_count.h>
 #include <mblock/time.h>
 
+/*!
+ * \brief Hands a queue that has messages to whoever runs its consumer.
+ * \internal
+ *
+ * Used by runtimes that don't block a thread in get_highest_pri_msg
+ * for every queue.  See mb_msg_queue::set_scheduler.
+ */
+class mb_msg_queue_scheduler
+{
+public:
+  virtual ~mb_msg_queue_scheduler();
+
+  //! Called, without any queue locks held, when an idle queue gets a message.
+  virtual void schedule() = 0;
+};
+
 /*!
  * \brief priority queue for mblock messages
+ *
+ * Any number of threads may insert; one thread at a time consumes.
+ * Neither side takes a lock; a consumer with nothing to do sleeps on
+ * an event count.
+ *
+ * Each priority has a lock-free stack that producers push onto, and a
+ * bit in d_nonempty that they set afterwards.  The consumer finds the
+ * best priority with messages by looking for the lowest set bit, takes
+ * that whole stack in one exchange, and keeps it in oldest-first order
+ * in a list of its own until it has delivered it.
  */
 class mb_msg_queue : boost::noncopyable
 {
+  // Consumer's messages for one priority, oldest first.
   // When empty both head and tail are zero.
   struct subq {
-    mb_message_sptr	head;
-    mb_message_sptr	tail;
-
-    bool empty_p() const { return head == 0; }
+    mb_message	*head;
+    mb_message	*tail;
   };
 
-  omni_mutex	 d_mutex;
-  omni_condition d_not_empty;	// reader waits on this
+  // Shared with producers.
+  mb_message *volatile	 d_inbox[MB_NPRI];	// newest first
+  volatile unsigned int	 d_nonempty;	// bit q set -> d_inbox[q] may be non-empty
+  mb_msg_queue_scheduler *volatile d_scheduler;	// 0 -> consumer waits on d_not_empty
+  volatile int		 d_scheduled;	// handed to d_scheduler, not yet released
+  gruel::event_count	 d_not_empty;	// consumer waits on this
+  char			 d_pad[64];
 
-  // FIXME add bitmap to indicate which queues are non-empty.
-  subq		 d_queue[MB_NPRI];
+  // Consumer only.
+  subq			 d_queue[MB_NPRI];
+  unsigned int		 d_queue_bits;	// bit q set -> d_queue[q] is non-empty
 
-  mb_message_sptr get_highest_pri_msg_helper();
+  mb_message *pop();
+  bool empty_p() const;
+  bool wait_for_insert(const mb_time *abs_time);
 
 public:
   mb_msg_queue();
@@ -77,6 +110,30 @@ public:
    * if the call timed out while waiting.
    */
   mb_message_sptr get_highest_pri_msg_timedwait(const mb_time &abs_time);
+
+  /*!
+   * \brief Have \p scheduler run our consumer instead of waking a thread.
+   * \internal
+   *
+   * From now on, a message inserted while the queue is idle calls
+   * scheduler->schedule().  The queue then stays scheduled, and further
+   * inserts just append, until the consumer calls release().  If
+   * messages are already waiting, the queue is scheduled right away.
+   * Pass 0 to go back to the default behavior.
+   */
+  void set_scheduler(mb_msg_queue_scheduler *scheduler);
+
+  /*!
+   * \brief Consumer is done with a scheduled queue for now.
+   * \internal
+   *
+   * \returns true if the queue is no longer the caller's: it was empty
+   * and has gone idle, or a producer has already scheduled it again.
+   * Returns false if messages arrived in the meantime and the queue is
+   * still scheduled.  In that case it's the caller's job to run the
+   * consumer again.
+   */
+  bool release();
 };
 
 #endif /* INCLUDED_MB_MSG_QUEUE_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,6 +29,18 @@
  */
 mb_runtime_sptr mb_make_runtime();
 
+/*!
+ * \brief Public constructor (factory) for a runtime that shares a
+ * fixed pool of threads between all mblocks.
+ *
+ * Use this one for systems with many more mblocks than processors.
+ * Messages are still delivered to each mblock one at a time and in
+ * order, but handle_message must not block.
+ *
+ * \param nthreads number of threads in the pool; 0 -> one per processor
+ */
+mb_runtime_sptr mb_make_runtime_thread_pool(int nthreads = 0);
+
 /*!
  * \brief Abstract runtime support for m-blocks
  *
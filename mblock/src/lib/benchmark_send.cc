@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -20,26 +20,161 @@
  */
 
 #include <mblock/runtime.h>
+#include <mblock/mblock.h>
+#include <mblock/class_registry.h>
+#include <mblock/message.h>
+#include <mblock/time.h>
 #include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
 
-int
-main(int argc, char **argv)
+/*
+ * Time message passing under the thread-per-block and thread-pool
+ * runtimes:
+ *
+ *   - qa_bitset_top: 4 pipelines of 8 mblocks, 1 source and 1 sink each
+ *   - a ring of many mblocks passing tokens around, one thread per
+ *     mblock under thread-per-block
+ *
+ *   benchmark_send [nmsgs [ring-size [pool-threads]]]
+ */
+
+static pmt_t s_cs = pmt_intern("cs");
+static pmt_t s_data = pmt_intern("data");
+static pmt_t s_send_batch = pmt_intern("send-batch");
+
+static std::string
+str(long x)
+{
+  std::ostringstream s;
+  s << x;
+  return s.str();
+}
+
+/*
+ * One mblock in the ring.  Tokens arriving on "in" carry the number of
+ * hops so far and go out on "out" with one more.  The first member
+ * starts ntokens tokens when told to on "cs".  Args: (ntokens nhops)
+ */
+class bench_ring_member : public mb_mblock
+{
+  mb_port_sptr	d_cs;
+  mb_port_sptr	d_in;
+  mb_port_sptr	d_out;
+  long		d_ntokens;
+  long		d_nhops;
+
+public:
+  bench_ring_member(mb_runtime *runtime, const std::string &instance_name,
+		    pmt_t user_arg)
+    : mb_mblock(runtime, instance_name, user_arg)
+  {
+    d_ntokens = pmt_to_long(pmt_nth(0, user_arg));
+    d_nhops   = pmt_to_long(pmt_nth(1, user_arg));
+
+    d_cs  = define_port("cs", "qa-bitset-cs", true, mb_port::EXTERNAL);
+    d_in  = define_port("in", "qa-bitset", false, mb_port::EXTERNAL);
+    d_out = define_port("out", "qa-bitset", true, mb_port::EXTERNAL);
+  }
+
+  void handle_message(mb_message_sptr msg)
+  {
+    if (pmt_eq(msg->signal(), s_send_batch)){
+      for (long i = 0; i < d_ntokens; i++)
+	d_out->send(s_data, pmt_from_long(0));
+    }
+    else if (pmt_eq(msg->signal(), s_data)){
+      long hops = pmt_to_long(msg->data()) + 1;
+      if (hops == d_nhops)
+	shutdown_all(PMT_T);
+      else if (hops < d_nhops)
+	d_out->send(s_data, pmt_from_long(hops));
+    }
+  }
+};
+
+REGISTER_MBLOCK_CLASS(bench_ring_member);
+
+// Args: (nmembers ntokens nhops)
+class bench_ring_top : public mb_mblock
+{
+  mb_port_sptr	d_cs;
+
+public:
+  bench_ring_top(mb_runtime *runtime, const std::string &instance_name,
+		 pmt_t user_arg)
+    : mb_mblock(runtime, instance_name, user_arg)
+  {
+    long nmembers = pmt_to_long(pmt_nth(0, user_arg));
+    pmt_t member_arg = pmt_cdr(user_arg);
+
+    d_cs = define_port("cs", "qa-bitset-cs", false, mb_port::INTERNAL);
+
+    for (long i = 0; i < nmembers; i++)
+      define_component("m"+str(i), "bench_ring_member", member_arg);
+
+    for (long i = 0; i < nmembers; i++)
+      connect("m"+str(i), "out", "m"+str((i + 1) % nmembers), "in");
+    connect("self", "cs", "m0", "cs");
+  }
+
+  void initial_transition()
+  {
+    d_cs->send(s_send_batch);
+  }
+};
+
+REGISTER_MBLOCK_CLASS(bench_ring_top);
+
+
+static bool
+run_one(mb_runtime_sptr rt, const char *what, const char *class_name,
+	pmt_t arg, long nmsgs)
 {
-  mb_runtime_sptr rt = mb_make_runtime();
   pmt_t result = PMT_NIL;
 
-  long nmsgs =      1000000;
+  double t0 = mb_time::time().double_time();
+  rt->run("top", class_name, arg, &result);
+  double t = mb_time::time().double_time() - t0;
+
+  if (!pmt_equal(PMT_T, result)){
+    std::cerr << "benchmark_send: incorrect result\n";
+    return false;
+  }
+
+  // The times include the runtime's 100ms shutdown grace period.
+  printf("%-36s %8.3f s  %8.0f msgs/s\n", what, t, nmsgs / t);
+  return true;
+}
+
+int
+main(int argc, char **argv)
+{
+  long nmsgs =      argc > 1 ? atol(argv[1]) : 1000000;
+  long nmembers =   argc > 2 ? atol(argv[2]) : 1000;
+  int  nthreads =   argc > 3 ? atoi(argv[3]) : 0;
   long batch_size =     100;
+  long ntokens =         16;
 
-  pmt_t arg = pmt_list2(pmt_from_long(nmsgs),	// # of messages to send through pipe
-			pmt_from_long(batch_size));
+  pmt_t bitset_arg = pmt_list2(pmt_from_long(nmsgs),	// # of messages to send through pipe
+			       pmt_from_long(batch_size));
 
-  rt->run("top", "qa_bitset_top", arg, &result);
+  pmt_t ring_arg = pmt_list3(pmt_from_long(nmembers),
+			     pmt_from_long(ntokens),
+			     pmt_from_long(nmsgs / ntokens));	// hops per token
 
-  if (!pmt_equal(PMT_T, result)){
-    std::cerr << "benchmark_send: incorrect result";
+  std::string ring = "ring of " + str(nmembers) + ", ";
+
+  if (!run_one(mb_make_runtime(), "bitset, thread-per-block",
+	       "qa_bitset_top", bitset_arg, nmsgs * 10)
+      || !run_one(mb_make_runtime_thread_pool(nthreads), "bitset, thread-pool",
+		  "qa_bitset_top", bitset_arg, nmsgs * 10)
+      || !run_one(mb_make_runtime(), (ring + "thread-per-block").c_str(),
+		  "bench_ring_top", ring_arg, nmsgs)
+      || !run_one(mb_make_runtime_thread_pool(nthreads), (ring + "thread-pool").c_str(),
+		  "bench_ring_top", ring_arg, nmsgs))
     return 1;
-  }
 
   return 0;
 }
@@ -0,0 +1,144 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <mb_timer_queue.h>
+#include <algorithm>
+#include <queue>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * Time mb_timer_queue against the binary heap it replaced (heap_queue
+ * below), for what a protocol mblock does with retransmit timers:
+ * arm one per packet and cancel it when the ack comes back, with a
+ * window of packets in flight.  Also time plain schedule and expire.
+ *
+ *   benchmark_timer_queue [operations]
+ */
+
+class timeout_later
+{
+public:
+  bool operator() (const mb_timeout_sptr t1, const mb_timeout_sptr t2)
+  {
+    return t1->d_when > t2->d_when;
+  }
+};
+
+// The previous mb_timer_queue
+class heap_queue : public std::priority_queue<mb_timeout_sptr,
+					      std::vector<mb_timeout_sptr>,
+					      timeout_later>
+{
+public:
+  void cancel(pmt_t handle)
+  {
+    container_type::iterator it;
+
+    for (it = c.begin(); it != c.end();){
+      if (pmt_equal((*it)->handle(), handle))
+	it = c.erase(it);
+      else
+	++it;
+    }
+    std::make_heap(c.begin(), c.end(), comp);
+  }
+
+  void expire(const mb_time &now, std::vector<mb_timeout_sptr> &expired)
+  {
+    while (!empty() && top()->d_when <= now){
+      expired.push_back(top());
+      pop();
+    }
+  }
+};
+
+static double
+now_secs()
+{
+  return mb_time::time().double_time();
+}
+
+static void
+report(const char *what, const char *impl, double t0, long nops)
+{
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%s (%s):", what, impl);
+  printf("%-44s %10.1f ns/op\n", buf, (now_secs() - t0) / nops * 1e9);
+}
+
+template<class Q>
+static void
+benchmark(const char *impl, long nops)
+{
+  mb_time base = mb_time::time();
+  mb_msg_accepter_sptr accepter;
+
+  static const int windows[] = { 16, 256, 4096 };
+  for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++){
+    int window = windows[w];
+    Q q;
+    std::vector<mb_timeout_sptr> inflight(window);
+    long n = std::max(nops * 16 / window, 4L * window);	// the heap's cancel is O(window)
+
+    double t0 = now_secs();
+    for (long i = 0; i < n; i++){
+      mb_timeout_sptr &slot = inflight[i % window];
+      if (slot)
+	q.cancel(slot->handle());	// acked
+      slot = mb_timeout_sptr(new mb_timeout(base + (1.0 + i * 1e-6),
+					    PMT_F, accepter));
+      q.push(slot);
+    }
+    char what[64];
+    snprintf(what, sizeof(what), "arm + cancel, %d in flight", window);
+    report(what, impl, t0, n);
+  }
+
+  {
+    Q q;
+    std::vector<mb_timeout_sptr> expired;
+    srandom(1);
+
+    double t0 = now_secs();
+    for (long i = 0; i < nops; i++)
+      q.push(mb_timeout_sptr(new mb_timeout(base + random() / (double) RAND_MAX,
+					    PMT_F, accepter)));
+    for (int ms = 0; !q.empty(); ms++){
+      expired.clear();
+      q.expire(base + ms * 1e-3, expired);
+    }
+    report("schedule, then expire 1 ms at a time", impl, t0, nops);
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  long nops = argc > 1 ? atol(argv[1]) : 1000000;
+
+  benchmark<heap_queue>("heap", nops);
+  benchmark<mb_timer_queue>("wheel", nops);
+  return 0;
+}
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -69,29 +69,29 @@ mb_mblock::handle_message(mb_message_sptr msg)
 void
 mb_mblock::main_loop()
 {
-  while (1){
-    mb_message_sptr msg;
-    try {
-      while (1){
-	msg = impl()->msgq().get_highest_pri_msg();
-
-	// check for %halt from %sys-port
-	if (pmt_eq(msg->port_id(), s_sys_port) && pmt_eq(msg->signal(), s_halt))
-	  exit();
-
-	handle_message(msg);
-      }
-    }
-    catch (pmt_exception e){
-      std::cerr << "\nmb_mblock::main_loop: ignored pmt_exception: "
-		<< e.what()
-		<< "\nin mblock instance \"" << instance_name()
-		<< "\" while handling message:"
-		<< "\n    port_id = " << msg->port_id()
-		<< "\n     signal = " << msg->signal()
-		<< "\n       data = " << msg->data()
-		<< "\n  metatdata = " << msg->metadata() << std::endl;
-    }
+  while (1)
+    dispatch(impl()->msgq().get_highest_pri_msg());
+}
+
+void
+mb_mblock::dispatch(mb_message_sptr msg)
+{
+  // check for %halt from %sys-port
+  if (pmt_eq(msg->port_id(), s_sys_port) && pmt_eq(msg->signal(), s_halt))
+    exit();
+
+  try {
+    handle_message(msg);
+  }
+  catch (pmt_exception e){
+    std::cerr << "\nmb_mblock::main_loop: ignored pmt_exception: "
+	      << e.what()
+	      << "\nin mblock instance \"" << instance_name()
+	      << "\" while handling message:"
+	      << "\n    port_id = " << msg->port_id()
+	      << "\n     signal = " << msg->signal()
+	      << "\n       data = " << msg->data()
+	      << "\n  metatdata = " << msg->metadata() << std::endl;
   }
 }
 
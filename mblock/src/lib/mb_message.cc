@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,23 +23,32 @@
 #include <config.h>
 #endif
 #include <mblock/message.h>
+#include <gruel/pmt_pool.h>
 #include <stdio.h>
-#include <pmt_pool.h>
+#include <assert.h>
+#include <stdint.h>
 
 static const int CACHE_LINE_SIZE = 64;	// good guess
-static const int MAX_MESSAGES =  1024;	// KLUDGE max number of messages in sys
-					//   0 -> no limit
-#if MB_MESSAGE_LOCAL_ALLOCATOR
 
-static pmt_pool 
-global_msg_pool(sizeof(mb_message), CACHE_LINE_SIZE, 16*1024, MAX_MESSAGES);
+/*
+ * Messages are made on one block's thread and freed on another's.
+ * The pool's per-thread magazines make both ends lock-free most of the
+ * time, and start every message on a cache line boundary.
+ */
+static pmt::pmt_pool &
+global_msg_pool()
+{
+  // Never freed: messages may outlive static destruction.
+  static pmt::pmt_pool *pool =
+    new pmt::pmt_pool(sizeof(mb_message), CACHE_LINE_SIZE, 16*1024);
+  return *pool;
+}
 
 void *
 mb_message::operator new(size_t size)
 {
-  void *p = global_msg_pool.malloc();
+  void *p = global_msg_pool().malloc();
 
-  // fprintf(stderr, "mb_message::new p = %p\n", p);
   assert((reinterpret_cast<intptr_t>(p) & (CACHE_LINE_SIZE - 1)) == 0);
   return p;
 }
@@ -47,11 +56,9 @@ mb_message::operator new(size_t size)
 void
 mb_message::operator delete(void *p, size_t size)
 {
-  global_msg_pool.free(p);
+  global_msg_pool().free(p);
 }
 
-#endif
-
 
 mb_message_sptr
 mb_make_message(pmt_t signal, pmt_t data, pmt_t metadata, mb_pri_t priority)
@@ -60,8 +67,8 @@ mb_make_message(pmt_t signal, pmt_t data, pmt_t metadata, mb_pri_t priority)
 }
 
 mb_message::mb_message(pmt_t signal, pmt_t data, pmt_t metadata, mb_pri_t priority)
-  : d_signal(signal), d_data(data), d_metadata(metadata), d_priority(priority),
-    d_port_id(PMT_NIL)
+  : d_refcount(0), d_next(0), d_signal(signal), d_data(data),
+    d_metadata(metadata), d_priority(priority), d_port_id(PMT_NIL)
 {
 }
 
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -26,103 +26,192 @@
 #include <mblock/message.h>
 
 
+mb_msg_queue_scheduler::~mb_msg_queue_scheduler()
+{
+}
+
 mb_msg_queue::mb_msg_queue()
-  : d_not_empty(&d_mutex)
+  : d_nonempty(0), d_scheduler(0), d_scheduled(0), d_queue_bits(0)
 {
+  for (mb_pri_t q = 0; q < MB_NPRI; q++){
+    d_inbox[q] = 0;
+    d_queue[q].head = d_queue[q].tail = 0;
+  }
 }
 
 mb_msg_queue::~mb_msg_queue()
 {
+  mb_message *msg;
+  while ((msg = pop()) != 0)
+    intrusive_ptr_release(msg);
 }
 
 void
 mb_msg_queue::insert(mb_message_sptr msg)
 {
-  omni_mutex_lock	l(d_mutex);
-  
   mb_pri_t q = mb_pri_clamp(msg->priority());
 
-  if (d_queue[q].empty_p()){
-    d_queue[q].tail = d_queue[q].head = msg;
-    msg->d_next.reset();	//msg->d_next = 0;
+  // The queue's reference is handed to the consumer by pop.
+  mb_message *m = msg.get();
+  intrusive_ptr_add_ref(m);
+
+  mb_message *head;
+  do {
+    head = d_inbox[q];
+    m->d_next = head;
+  } while (!gruel::atomic_cas(&d_inbox[q], head, m));
+
+  // This is a full barrier: our message is visible before we look at
+  // d_scheduler or d_not_empty, and the consumer sets those before it
+  // looks at d_nonempty.  One of us is sure to see the other.
+  gruel::atomic_fetch_or(&d_nonempty, 1U << q);
+
+  mb_msg_queue_scheduler *scheduler = d_scheduler;
+  if (scheduler != 0){
+    if (gruel::atomic_cas(&d_scheduled, 0, 1))
+      scheduler->schedule();
   }
-  else {
-    d_queue[q].tail->d_next = msg;
-    d_queue[q].tail = msg;
-    msg->d_next.reset();	// msg->d_next = 0;
+  else
+    d_not_empty.notify_all();
+}
+
+/*
+ * True if there are no messages.  Only the consumer gets a reliable
+ * answer, and may see a message that's still on its way in.
+ */
+bool
+mb_msg_queue::empty_p() const
+{
+  return d_queue_bits == 0 && gruel::atomic_load(&d_nonempty) == 0;
+}
+
+void
+mb_msg_queue::set_scheduler(mb_msg_queue_scheduler *scheduler)
+{
+  gruel::atomic_store(&d_scheduler, scheduler);
+  if (scheduler == 0){
+    gruel::atomic_store(&d_scheduled, 0);
+    return;
   }
 
-  // FIXME set bit in bitmap
+  gruel::memory_barrier();
+  if (!empty_p() && gruel::atomic_cas(&d_scheduled, 0, 1))
+    scheduler->schedule();
+}
 
-  d_not_empty.signal();
+bool
+mb_msg_queue::release()
+{
+  gruel::atomic_store(&d_scheduled, 0);
+  gruel::memory_barrier();	// pairs with the barrier in insert
+
+  if (empty_p())
+    return true;
+
+  // Something came in.  If its producer didn't beat us to scheduling
+  // the queue, it's still ours to run.
+  return !gruel::atomic_cas(&d_scheduled, 0, 1);
 }
 
 /*
- * Delete highest pri message from the queue and return it.
- * Returns equivalent of zero pointer if queue is empty.
+ * Delete highest pri message from the queue and return it, along with
+ * the queue's reference to it.  Returns 0 if the queue is empty.
  *
- * Caller must be holding d_mutex
+ * Consumer only.
  */
-mb_message_sptr
-mb_msg_queue::get_highest_pri_msg_helper()
+mb_message *
+mb_msg_queue::pop()
 {
-  // FIXME use bitmap and ffz to find best queue in O(1)
-
-  for (mb_pri_t q = 0; q <= MB_PRI_WORST; q++){
-
-    if (!d_queue[q].empty_p()){
-      mb_message_sptr msg = d_queue[q].head;
-      d_queue[q].head = msg->d_next;
-      if (d_queue[q].head == 0){
-	d_queue[q].tail.reset();	// d_queue[q].tail = 0;
-	// FIXME clear bit in bitmap
+  while (1){
+    unsigned int bits = d_queue_bits | gruel::atomic_load(&d_nonempty);
+    if (bits == 0)
+      return 0;
+
+    mb_pri_t q = __builtin_ctz(bits);	// best priority with messages
+    subq &sq = d_queue[q];
+
+    if (sq.head != 0){
+      mb_message *msg = sq.head;
+      sq.head = msg->d_next;
+      if (sq.head == 0){
+	sq.tail = 0;
+	d_queue_bits &= ~(1U << q);
       }
-
-      msg->d_next.reset();		// msg->d_next = 0;
+      msg->d_next = 0;
       return msg;
     }
-  }
 
-  return mb_message_sptr();		// eqv to a zero pointer
+    // Clear the bit before taking the stack: a producer that pushes
+    // after the exchange sets it again.
+    gruel::atomic_fetch_and(&d_nonempty, ~(1U << q));
+    mb_message *stack = gruel::atomic_exchange(&d_inbox[q], (mb_message *) 0);
+    if (stack == 0)		// the bit was left over from a stack we already took
+      continue;
+
+    // Reverse it onto our list
+    mb_message *tail = stack;
+    mb_message *head = 0;
+    while (stack){
+      mb_message *next = stack->d_next;
+      stack->d_next = head;
+      head = stack;
+      stack = next;
+    }
+    sq.head = head;
+    sq.tail = tail;
+    d_queue_bits |= 1U << q;
+  }
 }
 
+/*
+ * Sleep until a producer may have inserted something, or real-time
+ * exceeds *abs_time (0 -> forever).  Returns false if it timed out.
+ */
+bool
+mb_msg_queue::wait_for_insert(const mb_time *abs_time)
+{
+  gruel::event_count::key_type key = d_not_empty.prepare_wait();
+  if (!empty_p())
+    return true;
+
+  if (abs_time == 0){
+    d_not_empty.wait(key);
+    return true;
+  }
+
+  struct timespec t;
+  t.tv_sec = abs_time->d_secs;
+  t.tv_nsec = abs_time->d_nsecs;
+  return d_not_empty.timed_wait(key, t);
+}
 
 mb_message_sptr
 mb_msg_queue::get_highest_pri_msg_nowait()
 {
-  omni_mutex_lock	l(d_mutex);
-
-  return get_highest_pri_msg_helper();
+  return mb_message_sptr(pop(), false);
 }
 
 mb_message_sptr
 mb_msg_queue::get_highest_pri_msg()
 {
-  omni_mutex_lock l(d_mutex);
-
   while (1){
-    mb_message_sptr msg = get_highest_pri_msg_helper();
+    mb_message *msg = pop();
     if (msg)			// Got one; return it
-      return msg;
+      return mb_message_sptr(msg, false);
 
-    d_not_empty.wait();		// Wait for something
+    wait_for_insert(0);		// Wait for something
   }
 }
 
 mb_message_sptr
 mb_msg_queue::get_highest_pri_msg_timedwait(const mb_time &abs_time)
 {
-  unsigned long secs  = abs_time.d_secs;
-  unsigned long nsecs = abs_time.d_nsecs;
-
-  omni_mutex_lock l(d_mutex);
-
   while (1){
-    mb_message_sptr msg = get_highest_pri_msg_helper();
+    mb_message *msg = pop();
     if (msg)			// Got one; return it
-      return msg;
+      return mb_message_sptr(msg, false);
 
-    if (!d_not_empty.timedwait(secs, nsecs))	// timed out
+    if (!wait_for_insert(&abs_time))		// timed out
       return mb_message_sptr();			// eqv to zero pointer
   }
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -131,15 +131,7 @@ mb_runtime_thread_per_block::run_loop()
       msg = d_msgq.get_highest_pri_msg_timedwait(to->d_when);
 
       if (!msg){		// We timed out.
-	d_timer_queue.pop();	// Remove timeout from timer queue.
-
-	// send the %timeout msg
-	(*to->d_accepter)(s_timeout, to->d_user_data, to->handle(), MB_PRI_BEST);
-
-	if (to->d_is_periodic){
-	  to->d_when = to->d_when + to->d_delta; 	// update time of next firing
-	  d_timer_queue.push(to);			// push it back into the queue
-	}
+	fire_timeouts();
 	continue;
       }
     }
@@ -147,9 +139,7 @@ mb_runtime_thread_per_block::run_loop()
     pmt_t signal = msg->signal();
 
     if (pmt_eq(signal, s_worker_state_changed)){	// %worker-state-changed
-      omni_mutex_lock l1(d_workers_mutex);
-      reap_dead_workers();
-      if (d_workers.empty())	// no work left to do...
+      if (reap_dead_mblocks())	// no work left to do...
 	return;
     }
     else if (pmt_eq(signal, s_request_shutdown)){	// %request-shutdown
@@ -192,6 +182,39 @@ mb_runtime_thread_per_block::run_loop()
   }
 }
 
+//
+// Send %timeout for everything that's due.  Periodic timeouts go back
+// in the queue after the whole batch, so a short period can't starve
+// the rest of the loop.
+//
+void
+mb_runtime_thread_per_block::fire_timeouts()
+{
+  d_expired.clear();
+  d_timer_queue.expire(mb_time::time(), d_expired);
+
+  for (size_t i = 0; i < d_expired.size(); i++){
+    mb_timeout_sptr to = d_expired[i];
+
+    // send the %timeout msg
+    (*to->d_accepter)(s_timeout, to->d_user_data, to->handle(), MB_PRI_BEST);
+
+    if (to->d_is_periodic){
+      to->d_when = to->d_when + to->d_delta; 	// update time of next firing
+      d_timer_queue.push(to);			// push it back into the queue
+    }
+  }
+  d_expired.clear();
+}
+
+bool
+mb_runtime_thread_per_block::reap_dead_mblocks()
+{
+  omni_mutex_lock l1(d_workers_mutex);
+  reap_dead_workers();
+  return d_workers.empty();
+}
+
 void
 mb_runtime_thread_per_block::reap_dead_workers()
 {
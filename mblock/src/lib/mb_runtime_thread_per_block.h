@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007 Free Software Foundation, Inc.
+ * Copyright 2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -41,6 +41,7 @@ public:
   pmt_t			      d_shutdown_result;
   mb_msg_queue		      d_msgq;
   mb_timer_queue	      d_timer_queue;
+  std::vector<mb_timeout_sptr> d_expired;	// scratch for fire_timeouts
 
   typedef std::vector<mb_worker*>::iterator  worker_iter_t;
 
@@ -72,13 +73,21 @@ protected:
   void
   cancel_timeout(pmt_t handle);
 
+  /*!
+   * \brief Handle %worker-state-changed.
+   * \returns true if there are no live mblocks left.
+   */
+  virtual bool reap_dead_mblocks();
+
+  //! Send a %sys-port message to every live mblock.
+  virtual void send_all_sys_msg(pmt_t signal, pmt_t data = PMT_F,
+				pmt_t metadata = PMT_F,
+				mb_pri_t priority = MB_PRI_BEST);
+
 private:
   void reap_dead_workers();
   void run_loop();
-
-  void send_all_sys_msg(pmt_t signal, pmt_t data = PMT_F,
-			pmt_t metadata = PMT_F,
-			mb_pri_t priority = MB_PRI_BEST);
+  void fire_timeouts();
 };
 
 #endif /* INCLUDED_MB_RUNTIME_THREAD_PER_BLOCK_H */
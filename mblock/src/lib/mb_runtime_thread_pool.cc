@@ -0,0 +1,348 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <mb_runtime_thread_pool.h>
+#include <mblock/mblock.h>
+#include <mb_mblock_impl.h>
+#include <mblock/class_registry.h>
+#include <mblock/exception.h>
+#include <mblock/message.h>
+#include <gnuradio/omnithread.h>
+#include <gruel/atomic.h>
+#include <iostream>
+#include <unistd.h>
+
+
+static pmt_t s_sys_port = pmt_intern("%sys-port");
+static pmt_t s_worker_state_changed = pmt_intern("%worker-state-changed");
+
+// Messages delivered to an mblock before it goes to the back of the run queue
+static const int QUANTUM = 64;
+
+
+mb_runtime_sptr
+mb_make_runtime_thread_pool(int nthreads)
+{
+  return mb_runtime_sptr(new mb_runtime_thread_pool(nthreads));
+}
+
+/*!
+ * \brief One mblock, as seen by the thread pool
+ * \internal
+ */
+class mb_actor : public mb_msg_queue_scheduler
+{
+public:
+  mb_runtime_thread_pool       *d_runtime;
+  mb_mblock_sptr		d_mblock;
+  volatile bool			d_dead;		// exited; its messages are dropped
+  mb_actor		       *d_next;		// run queue link
+
+  mb_actor(mb_runtime_thread_pool *runtime, mb_mblock_sptr mblock)
+    : d_runtime(runtime), d_mblock(mblock), d_dead(false), d_next(0) {}
+
+  void schedule() { d_runtime->enqueue(this); }
+
+  mb_msg_queue &msgq() { return d_mblock->impl()->msgq(); }
+};
+
+/*!
+ * \brief Pool thread for the thread_pool runtime
+ * \internal
+ */
+class mb_pool_worker : public omni_thread
+{
+  mb_runtime_thread_pool       *d_runtime;
+
+public:
+  mb_pool_worker(mb_runtime_thread_pool *runtime)
+    : omni_thread((void *) 0, PRIORITY_NORMAL), d_runtime(runtime) {}
+
+  void *run_undetached(void *ignored)
+  {
+    d_runtime->worker_loop();
+    return 0;
+  }
+};
+
+
+mb_runtime_thread_pool::mb_runtime_thread_pool(int nthreads)
+  : d_nthreads(nthreads),
+    d_run_head(0), d_run_tail(0), d_stop(false), d_nlive(0)
+{
+  if (d_nthreads <= 0){
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    d_nthreads = ncpus > 0 ? ncpus : 1;
+  }
+}
+
+mb_runtime_thread_pool::~mb_runtime_thread_pool()
+{
+  for (size_t i = 0; i < d_retired.size(); i++)
+    delete d_retired[i];
+}
+
+bool
+mb_runtime_thread_pool::run(const std::string &instance_name,
+			    const std::string &class_name,
+			    pmt_t user_arg, pmt_t *result)
+{
+  start_pool();
+
+  bool ok;
+  try {
+    ok = mb_runtime_thread_per_block::run(instance_name, class_name,
+					  user_arg, result);
+  }
+  catch (...){
+    stop_pool();
+    throw;
+  }
+
+  stop_pool();
+  return ok;
+}
+
+void
+mb_runtime_thread_pool::start_pool()
+{
+  {
+    gruel::futex_scoped_lock l(d_run_mutex);
+    d_stop = false;
+  }
+  d_nlive = 0;
+  for (int i = 0; i < d_nthreads; i++){
+    mb_pool_worker *w = new mb_pool_worker(this);
+    w->start_undetached();
+    d_pool.push_back(w);
+  }
+}
+
+//
+// Stop the pool threads, then retire the mblocks.  Anything still on
+// the run queue is abandoned, along with its messages.
+//
+void
+mb_runtime_thread_pool::stop_pool()
+{
+  {
+    gruel::futex_scoped_lock l(d_run_mutex);
+    d_stop = true;
+    d_run_cond.notify_all();
+  }
+
+  for (size_t i = 0; i < d_pool.size(); i++){
+    void *ignore;
+    d_pool[i]->join(&ignore);	// join deletes the thread object
+  }
+  d_pool.clear();
+  d_run_head = d_run_tail = 0;
+
+  gruel::futex_scoped_lock l(d_actors_mutex);
+  for (size_t i = 0; i < d_actors.size(); i++){
+    d_actors[i]->msgq().set_scheduler(0);
+    d_actors[i]->d_dead = true;
+    d_retired.push_back(d_actors[i]);
+  }
+  d_actors.clear();
+  d_nlive = 0;
+}
+
+//
+// Called by mb_msg_queue::insert (via mb_actor::schedule) in whatever
+// thread sent the message, or by a pool thread that isn't done with
+// the actor yet.
+//
+void
+mb_runtime_thread_pool::enqueue(mb_actor *actor)
+{
+  gruel::futex_scoped_lock l(d_run_mutex);
+
+  if (d_stop)			// nobody left to run it
+    return;
+
+  actor->d_next = 0;
+  if (d_run_tail)
+    d_run_tail->d_next = actor;
+  else
+    d_run_head = actor;
+  d_run_tail = actor;
+
+  d_run_cond.notify_one();
+}
+
+void
+mb_runtime_thread_pool::worker_loop()
+{
+  while (1){
+    mb_actor *actor;
+    {
+      gruel::futex_scoped_lock l(d_run_mutex);
+      while (d_run_head == 0 && !d_stop)
+	d_run_cond.wait(l);
+
+      if (d_stop)
+	return;
+
+      actor = d_run_head;
+      d_run_head = actor->d_next;
+      if (d_run_head == 0)
+	d_run_tail = 0;
+    }
+
+    run_actor(actor);
+  }
+}
+
+//
+// Deliver up to QUANTUM messages.  The actor is scheduled, so no
+// other thread is running it; it's ours until we release the queue
+// or put it back on the run queue.
+//
+void
+mb_runtime_thread_pool::run_actor(mb_actor *actor)
+{
+  mb_msg_queue &msgq = actor->msgq();
+
+  for (int n = 0; n < QUANTUM; n++){
+    mb_message_sptr msg = msgq.get_highest_pri_msg_nowait();
+    if (!msg)
+      break;
+
+    if (gruel::atomic_load(&actor->d_dead))
+      continue;
+
+    try {
+      actor->d_mblock->dispatch(msg);
+    }
+    catch (mbe_terminate){
+      kill_actor(actor);
+    }
+    catch (mbe_exit){
+      kill_actor(actor);
+    }
+    catch (std::logic_error e){
+      std::cerr << "\nmb_runtime_thread_pool: unhandled exception:\n";
+      std::cerr << "  " << e.what() << std::endl;
+      kill_actor(actor);
+    }
+    catch (...){
+      kill_actor(actor);
+    }
+  }
+
+  if (!msgq.release())		// more arrived, or quantum used up
+    enqueue(actor);
+}
+
+//
+// The mblock has exited.  Tell the runtime thread, just as a
+// thread-per-block worker does when its thread ends.
+//
+void
+mb_runtime_thread_pool::kill_actor(mb_actor *actor)
+{
+  {
+    gruel::futex_scoped_lock l(d_actors_mutex);
+    if (actor->d_dead)
+      return;
+    actor->d_dead = true;
+    d_nlive--;
+  }
+
+  (*accepter())(s_worker_state_changed, PMT_F, PMT_F, MB_PRI_BEST);
+}
+
+bool
+mb_runtime_thread_pool::reap_dead_mblocks()
+{
+  gruel::futex_scoped_lock l(d_actors_mutex);
+  return d_nlive == 0;
+}
+
+//
+// Create the component in the calling thread, then hand it to the pool.
+// Return a pointer to the created mblock.
+//
+// Can be invoked from any thread
+//
+mb_mblock_sptr
+mb_runtime_thread_pool::create_component(const std::string &instance_name,
+					 const std::string &class_name,
+					 pmt_t user_arg)
+{
+  mb_mblock_maker_t maker;
+  if (!mb_class_registry::lookup_maker(class_name, &maker))
+    throw mbe_no_such_class(0, class_name + " (in " + instance_name + ")");
+
+  mb_mblock_sptr mblock;
+  bool is_dead = false;
+
+  try {
+    mblock = maker(this, instance_name, user_arg);
+    mblock->initial_transition();
+  }
+  catch (mbe_exit){		// exited in initial_transition: not an error
+    if (!mblock)
+      throw mbe_mblock_failed(0, instance_name);
+    is_dead = true;
+  }
+  catch (...){
+    throw mbe_mblock_failed(0, instance_name);
+  }
+
+  mb_actor *actor = new mb_actor(this, mblock);
+  {
+    gruel::futex_scoped_lock l(d_actors_mutex);
+    actor->d_dead = is_dead;
+    d_actors.push_back(actor);
+    if (!is_dead)
+      d_nlive++;
+  }
+
+  if (is_dead)
+    (*accepter())(s_worker_state_changed, PMT_F, PMT_F, MB_PRI_BEST);
+
+  // From here on, messages for the mblock are delivered by the pool.
+  actor->msgq().set_scheduler(actor);
+  return mblock;
+}
+
+void
+mb_runtime_thread_pool::send_all_sys_msg(pmt_t signal,
+					 pmt_t data,
+					 pmt_t metadata,
+					 mb_pri_t priority)
+{
+  gruel::futex_scoped_lock l(d_actors_mutex);
+
+  for (size_t i = 0; i < d_actors.size(); i++){
+    if (d_actors[i]->d_dead)
+      continue;
+
+    mb_message_sptr msg = mb_make_message(signal, data, metadata, priority);
+    msg->set_port_id(s_sys_port);
+    d_actors[i]->msgq().insert(msg);
+  }
+}
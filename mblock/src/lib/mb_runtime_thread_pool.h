@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2010 Free Software Foundation, Inc.
+ * 
+ * This file is part of GNU Radio
+ * 
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef INCLUDED_MB_RUNTIME_THREAD_POOL_H
+#define INCLUDED_MB_RUNTIME_THREAD_POOL_H
+
+#include <mb_runtime_thread_per_block.h>
+#include <gruel/futex.h>
+
+class mb_actor;
+class mb_pool_worker;
+
+/*!
+ * \brief Concrete runtime that runs mblocks on a fixed pool of threads
+ * \internal
+ *
+ * Each mblock is an actor: when its message queue goes from empty to
+ * non-empty, the queue is put on a shared run queue, and whichever
+ * pool thread picks it up delivers up to a quantum of messages before
+ * putting it back (or letting it go idle).  A queue is on the run
+ * queue at most once, so an mblock never runs on two threads at once
+ * and sees its messages in the same order as under thread-per-block.
+ *
+ * Timeouts and shutdown are handled by the inherited runtime loop,
+ * which runs in the thread that called run().  Handlers must not
+ * block: a handler that sleeps holds up one pool thread.  Messages
+ * sent to an mblock after its run() has returned are dropped.
+ */
+class mb_runtime_thread_pool : public mb_runtime_thread_per_block
+{
+  friend class mb_actor;
+  friend class mb_pool_worker;
+
+  int				d_nthreads;
+  std::vector<mb_pool_worker*>	d_pool;
+
+  gruel::futex_mutex		d_run_mutex;	// protects the run queue and d_stop
+  gruel::futex_condition	d_run_cond;	// run queue not empty, or d_stop
+  mb_actor		       *d_run_head;	// FIFO of scheduled actors
+  mb_actor		       *d_run_tail;
+  bool				d_stop;
+
+  gruel::futex_mutex		d_actors_mutex;	// protects d_actors, d_nlive and mb_actor::d_dead
+  std::vector<mb_actor*>	d_actors;
+  int				d_nlive;
+
+  // Actors from earlier runs.  A thread in mb_msg_queue::insert may
+  // still be about to schedule one, so they live as long as we do.
+  std::vector<mb_actor*>	d_retired;
+
+  void enqueue(mb_actor *actor);
+  void worker_loop();
+  void run_actor(mb_actor *actor);
+  void kill_actor(mb_actor *actor);
+  void start_pool();
+  void stop_pool();
+
+public:
+  /*!
+   * \param nthreads number of pool threads; 0 -> one per processor
+   */
+  mb_runtime_thread_pool(int nthreads = 0);
+  ~mb_runtime_thread_pool();
+
+  bool run(const std::string &instance_name,
+	   const std::string &class_name,
+	   pmt_t user_arg,
+	   pmt_t *result);
+
+protected:
+  mb_mblock_sptr
+  create_component(const std::string &instance_name,
+		   const std::string &class_name,
+		   pmt_t user_arg);
+
+  bool reap_dead_mblocks();
+
+  void send_all_sys_msg(pmt_t signal, pmt_t data = PMT_F,
+			pmt_t metadata = PMT_F,
+			mb_pri_t priority = MB_PRI_BEST);
+};
+
+#endif /* INCLUDED_MB_RUNTIME_THREAD_POOL_H */
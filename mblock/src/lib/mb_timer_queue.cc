@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007 Free Software Foundation, Inc.
+ * Copyright 2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -23,41 +23,361 @@
 #include <config.h>
 #endif
 #include <mb_timer_queue.h>
+#include <pmt_pool.h>
+#include <gruel/atomic.h>
+#include <algorithm>
+#include <cassert>
+
+static const int TICKS_PER_SEC = 1000;
+
+// Bits of the tick that select the slot at each level
+static const int s_shift[] = {  0,  8, 14, 20 };
+static const int s_width[] = {  8,  6,  6,  6 };
+static const int OVERFLOW_SHIFT = 26;
+
+static long
+make_id()
+{
+  static volatile long counter = 0;
+  return gruel::atomic_fetch_add(&counter, 1L);
+}
 
 static pmt_t
-make_handle()
+make_handle(long id)
+{
+  return pmt_list1(pmt_from_long(id));	// guaranteed to be a unique object
+}
+
+static unsigned long long
+time_to_tick(const mb_time &t)
+{
+  if (t.d_secs < 0)
+    return 0;
+  return ((unsigned long long) t.d_secs * TICKS_PER_SEC
+	  + t.d_nsecs / (1000000000 / TICKS_PER_SEC));
+}
+
+static pmt_pool &
+timeout_pool()
+{
+  // Never freed: timeouts may outlive static destruction.
+  static pmt_pool *s_pool = new pmt_pool(sizeof(mb_timeout));
+  return *s_pool;
+}
+
+void *
+mb_timeout::operator new(size_t size)
 {
-  static long counter = 0;
-  pmt_t n = pmt_from_long(counter++);
-  return pmt_list1(n);		// guaranteed to be a unique object
+  assert(size == sizeof(mb_timeout));
+  return timeout_pool().malloc();
+}
+
+void
+mb_timeout::operator delete(void *p, size_t size)
+{
+  timeout_pool().free(p);
 }
 
 // one-shot constructor
 mb_timeout::mb_timeout(const mb_time &abs_time,
 		       pmt_t user_data, mb_msg_accepter_sptr accepter)
   : d_when(abs_time), d_is_periodic(false),
-    d_user_data(user_data), d_handle(make_handle()), d_accepter(accepter)
+    d_user_data(user_data), d_accepter(accepter),
+    d_id(make_id()), d_tick(0), d_next(0), d_pprev(0), d_hash_next(0)
 {
+  d_handle = make_handle(d_id);
 }
 
 // periodic constructor
 mb_timeout::mb_timeout(const mb_time &first_abs_time, const mb_time &delta_time,
 		       pmt_t user_data, mb_msg_accepter_sptr accepter)
   : d_when(first_abs_time), d_delta(delta_time), d_is_periodic(true),
-    d_user_data(user_data), d_handle(make_handle()), d_accepter(accepter)
+    d_user_data(user_data), d_accepter(accepter),
+    d_id(make_id()), d_tick(0), d_next(0), d_pprev(0), d_hash_next(0)
+{
+  d_handle = make_handle(d_id);
+}
+
+// ------------------------------------------------------------------------
+
+mb_timer_queue::mb_timer_queue()
+  : d_overflow(0), d_now(0), d_size(0), d_earliest(0), d_sorted_slot(-1),
+    d_hash(64)
+{
+  for (int level = 0; level < NLEVELS; level++){
+    for (int i = 0; i < MAX_SLOTS; i++)
+      d_slots[level][i] = 0;
+    for (int i = 0; i < MAX_SLOTS / 64; i++)
+      d_nonempty[level][i] = 0;
+  }
+}
+
+mb_timer_queue::~mb_timer_queue()
+{
+  while (!empty())
+    pop();
+}
+
+/*
+ * A timeout lives at the highest level whose bits of d_tick differ
+ * from d_now, in the slot given by those bits.  So everything at
+ * level 0 is in d_now's quarter second, at or after d_now; everything
+ * at level 1 is in a later quarter second of the same 16 s; and so on.
+ * Earlier levels hold earlier timeouts, and within a level earlier
+ * slots do.
+ */
+void
+mb_timer_queue::place(mb_timeout *t)
 {
+  unsigned long long diff = t->d_tick ^ d_now;
+
+  mb_timeout **head;
+  if (diff >> OVERFLOW_SHIFT)
+    head = &d_overflow;
+  else {
+    int level = NLEVELS - 1;
+    while (level > 0 && (diff >> s_shift[level]) == 0)
+      level--;
+
+    int slot = (t->d_tick >> s_shift[level]) & ((1 << s_width[level]) - 1);
+    head = &d_slots[level][slot];
+    d_nonempty[level][slot / 64] |= 1ULL << (slot % 64);
+
+    if (level == 0 && slot == d_sorted_slot)
+      while (*head && !(t->d_when < (*head)->d_when))
+	head = &(*head)->d_next;
+  }
+
+  t->d_next = *head;
+  if (*head)
+    (*head)->d_pprev = &t->d_next;
+  t->d_pprev = head;
+  *head = t;
 }
 
 void
-mb_timer_queue::cancel(pmt_t handle)
+mb_timer_queue::unlink(mb_timeout *t)
+{
+  *t->d_pprev = t->d_next;
+  if (t->d_next)
+    t->d_next->d_pprev = t->d_pprev;
+  t->d_next = 0;
+  t->d_pprev = 0;
+
+  // The slot's d_nonempty bit is left set; first_slot clears it.
+}
+
+// First non-empty slot at index >= from, or -1.
+int
+mb_timer_queue::first_slot(int level, int from)
+{
+  int nslots = 1 << s_width[level];
+
+  for (int w = from / 64; w * 64 < nslots; w++){
+    unsigned long long bits = d_nonempty[level][w];
+    if (w == from / 64)
+      bits &= ~0ULL << (from % 64);
+
+    while (bits){
+      int slot = w * 64 + __builtin_ctzll(bits);
+      if (d_slots[level][slot])
+	return slot;
+      d_nonempty[level][w] &= ~(1ULL << (slot % 64));	// emptied by unlink
+      bits &= bits - 1;
+    }
+  }
+  return -1;
+}
+
+// The wheel has reached this slot: spread its timeouts over the lower levels.
+void
+mb_timer_queue::cascade(int level, int slot)
+{
+  int top = s_shift[level] + s_width[level];
+  d_sorted_slot = -1;		// level 0 is empty, and its ticks change
+  d_now = ((d_now >> top) << top) | ((unsigned long long) slot << s_shift[level]);
+
+  mb_timeout *t = d_slots[level][slot];
+  d_slots[level][slot] = 0;
+  d_nonempty[level][slot / 64] &= ~(1ULL << (slot % 64));
+
+  while (t){
+    mb_timeout *next = t->d_next;
+    place(t);
+    t = next;
+  }
+}
+
+// The wheel is empty: jump to the earliest overflow timeout.
+void
+mb_timer_queue::rebase()
 {
-  container_type::iterator it;
+  mb_timeout *t = d_overflow;
+  d_sorted_slot = -1;
+  d_now = t->d_tick;
+  for (; t; t = t->d_next)
+    if (t->d_tick < d_now)
+      d_now = t->d_tick;
 
-  for (it = c.begin(); it != c.end();){
-    if (pmt_equal((*it)->handle(), handle))
-      it = c.erase(it);
+  t = d_overflow;
+  d_overflow = 0;
+  while (t){
+    mb_timeout *next = t->d_next;
+    place(t);
+    t = next;
+  }
+}
+
+static bool
+earlier(const mb_timeout *a, const mb_timeout *b)
+{
+  return a->d_when < b->d_when;
+}
+
+void
+mb_timer_queue::sort_slot(int slot)
+{
+  d_scratch.clear();
+  for (mb_timeout *t = d_slots[0][slot]; t; t = t->d_next)
+    d_scratch.push_back(t);
+  std::stable_sort(d_scratch.begin(), d_scratch.end(), earlier);
+
+  mb_timeout **pp = &d_slots[0][slot];
+  for (size_t i = 0; i < d_scratch.size(); i++){
+    *pp = d_scratch[i];
+    d_scratch[i]->d_pprev = pp;
+    pp = &d_scratch[i]->d_next;
+  }
+  *pp = 0;
+  d_sorted_slot = slot;
+}
+
+mb_timeout *
+mb_timer_queue::earliest()
+{
+  if (d_earliest)
+    return d_earliest;
+
+  while (d_size > 0){
+    int slot = first_slot(0, d_now & ((1 << s_width[0]) - 1));
+    if (slot >= 0){
+      if (slot != d_sorted_slot)
+	sort_slot(slot);
+      return d_earliest = d_slots[0][slot];
+    }
+
+    int level;
+    for (level = 1; level < NLEVELS; level++){
+      int mask = (1 << s_width[level]) - 1;
+      slot = first_slot(level, ((d_now >> s_shift[level]) & mask) + 1);
+      if (slot >= 0)
+	break;
+    }
+
+    if (level < NLEVELS)
+      cascade(level, slot);
     else
-      ++it;
+      rebase();
+  }
+  return 0;
+}
+
+void
+mb_timer_queue::push(mb_timeout_sptr t)
+{
+  assert(!t->d_self);		// not already queued
+
+  // Timeouts in the past go in the current slot
+  t->d_tick = std::max(time_to_tick(t->d_when), d_now);
+  t->d_self = t;
+  place(t.get());
+  hash_insert(t.get());
+  d_size++;
+
+  if (d_earliest && t->d_when < d_earliest->d_when)
+    d_earliest = t.get();
+}
+
+mb_timeout_sptr
+mb_timer_queue::remove(mb_timeout *t)
+{
+  unlink(t);
+
+  mb_timeout **pp = hash_bucket(t->d_id);
+  while (*pp != t)
+    pp = &(*pp)->d_hash_next;
+  *pp = t->d_hash_next;
+  t->d_hash_next = 0;
+
+  d_size--;
+  if (d_earliest == t)
+    d_earliest = 0;
+
+  mb_timeout_sptr r;
+  r.swap(t->d_self);
+  return r;
+}
+
+void
+mb_timer_queue::cancel(pmt_t handle)
+{
+  if (!pmt_is_pair(handle) || !pmt_is_integer(pmt_car(handle)))
+    return;
+
+  long id = pmt_to_long(pmt_car(handle));
+  for (mb_timeout *t = *hash_bucket(id); t; t = t->d_hash_next){
+    if (t->d_id == id){
+      remove(t);
+      return;
+    }
+  }
+}
+
+void
+mb_timer_queue::expire(const mb_time &now, std::vector<mb_timeout_sptr> &expired)
+{
+  while (!empty()){
+    mb_timeout *t = earliest();
+    if (t->d_when > now)
+      break;
+    expired.push_back(remove(t));
+  }
+}
+
+// ------------------------------------------------------------------------
+
+mb_timeout **
+mb_timer_queue::hash_bucket(long id)
+{
+  return &d_hash[(unsigned long) id & (d_hash.size() - 1)];
+}
+
+void
+mb_timer_queue::hash_insert(mb_timeout *t)
+{
+  if (d_size >= d_hash.size())
+    hash_resize();
+
+  mb_timeout **b = hash_bucket(t->d_id);
+  t->d_hash_next = *b;
+  *b = t;
+}
+
+// Ids are sequential, so the low bits spread them evenly.
+void
+mb_timer_queue::hash_resize()
+{
+  std::vector<mb_timeout *> old(d_hash.size() * 2, (mb_timeout *) 0);
+  old.swap(d_hash);
+
+  for (size_t i = 0; i < old.size(); i++){
+    mb_timeout *t = old[i];
+    while (t){
+      mb_timeout *next = t->d_hash_next;
+      mb_timeout **b = hash_bucket(t->d_id);
+      t->d_hash_next = *b;
+      *b = t;
+      t = next;
+    }
   }
-  std::make_heap(c.begin(), c.end(), comp);
 }
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -24,10 +24,12 @@
 
 #include <mblock/time.h>
 #include <vector>
-#include <queue>
 #include <pmt.h>
 #include <mblock/msg_accepter.h>
 
+class mb_timeout;
+typedef boost::shared_ptr<mb_timeout> mb_timeout_sptr;
+
 class mb_timeout {
 public:
   mb_time		d_when;		// absolute time to fire timeout
@@ -37,6 +39,14 @@ public:
   pmt_t			d_handle;	// handle for cancellation
   mb_msg_accepter_sptr	d_accepter;	// where to send the message
 
+  // Used by mb_timer_queue while the timeout is queued
+  long			d_id;		// from d_handle
+  mb_timeout_sptr	d_self;		// the queue's reference
+  unsigned long long	d_tick;		// wheel position
+  mb_timeout	       *d_next;		// slot list
+  mb_timeout	      **d_pprev;
+  mb_timeout	       *d_hash_next;	// handle lookup chain
+
   // one-shot constructor
   mb_timeout(const mb_time &abs_time,
 	     pmt_t user_data, mb_msg_accepter_sptr accepter);
@@ -46,28 +56,78 @@ public:
 	     pmt_t user_data, mb_msg_accepter_sptr accepter);
 
   pmt_t handle() const { return d_handle; }
-};
 
-typedef boost::shared_ptr<mb_timeout> mb_timeout_sptr;
+  // allocated from a pool
+  void *operator new(size_t size);
+  void operator delete(void *p, size_t size);
+};
 
 
-//! Sort criterion for priority_queue
-class timeout_later
+/*!
+ * \brief Pending timeouts, earliest first
+ * \internal
+ *
+ * A hierarchical timing wheel (Varghese & Lauck) with 1 ms slots: 256
+ * of them for the current quarter second, then 3 levels of 64 slots
+ * that cover the next 18 hours, and an overflow list beyond that.
+ * push and cancel are O(1).  Timeouts move down a level when the
+ * wheel reaches their slot, at most 4 times each.
+ *
+ * The wheel only decides the order of the slots.  The first level 0
+ * slot is sorted by d_when when it's reached, so top() is exact to the
+ * nanosecond and the runtime still sleeps until the precise d_when.
+ */
+class mb_timer_queue : boost::noncopyable
 {
-public:
-  bool operator() (const mb_timeout_sptr t1, const mb_timeout_sptr t2)
-  {
-    return t1->d_when > t2->d_when;
-  }
-};
+  static const int NLEVELS = 4;
+  static const int MAX_SLOTS = 256;
 
+  mb_timeout	       *d_slots[NLEVELS][MAX_SLOTS];
+  unsigned long long	d_nonempty[NLEVELS][MAX_SLOTS / 64];	// bit per slot
+  mb_timeout	       *d_overflow;
+  unsigned long long	d_now;		// no timeout is before this tick
+  size_t		d_size;
+  mb_timeout	       *d_earliest;	// cached result of earliest(), or 0
+  int			d_sorted_slot;	// level 0 slot kept in d_when order, or -1
+  std::vector<mb_timeout *> d_scratch;
+
+  std::vector<mb_timeout *> d_hash;	// by d_id, power of 2 buckets
+
+  void place(mb_timeout *t);
+  void unlink(mb_timeout *t);
+  void cascade(int level, int slot);
+  void rebase();
+  void sort_slot(int slot);
+  int first_slot(int level, int from);
+  mb_timeout *earliest();
+  mb_timeout_sptr remove(mb_timeout *t);
+  mb_timeout **hash_bucket(long id);
+  void hash_insert(mb_timeout *t);
+  void hash_resize();
 
-class mb_timer_queue : public std::priority_queue<mb_timeout_sptr,
-						  std::vector<mb_timeout_sptr>,
-						  timeout_later>
-{
 public:
+  mb_timer_queue();
+  ~mb_timer_queue();
+
+  bool empty() const { return d_size == 0; }
+  size_t size() const { return d_size; }
+
+  void push(mb_timeout_sptr t);
+
+  //! The earliest timeout.  Only valid if !empty().
+  mb_timeout_sptr top() { return earliest()->d_self; }
+
+  //! Remove the earliest timeout.  Only valid if !empty().
+  void pop() { remove(earliest()); }
+
+  //! Remove the timeout with this handle, if it's queued.
   void cancel(pmt_t handle);
+
+  /*!
+   * \brief Remove every timeout due at or before \p now and append
+   * them to \p expired, earliest first.
+   */
+  void expire(const mb_time &now, std::vector<mb_timeout_sptr> &expired);
 };
 
 #endif /* INCLUDED_MB_TIMER_QUEUE_H */
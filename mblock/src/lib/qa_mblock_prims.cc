@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2007,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -35,6 +35,7 @@
 #include <mb_mblock_impl.h>
 #include <mblock/msg_accepter.h>
 #include <mblock/class_registry.h>
+#include <gnuradio/omnithread.h>
 #include <stdio.h>
 
 static pmt_t s_cs = pmt_intern("cs");
@@ -413,6 +414,66 @@ qa_mblock_prims::test_msg_queue()
   CPPUNIT_ASSERT(q.get_highest_pri_msg_nowait() == 0);
 }
 
+// Inserts nmsgs messages, cycling through the priorities.
+// data is (producer << 16) | sequence number.
+class msgq_producer : public omni_thread
+{
+  mb_msg_queue *d_q;
+  long		d_id;
+  long		d_nmsgs;
+
+public:
+  msgq_producer(mb_msg_queue *q, long id, long nmsgs)
+    : omni_thread(), d_q(q), d_id(id), d_nmsgs(nmsgs)
+  {
+    start_undetached();
+  }
+
+  void *run_undetached(void *arg)
+  {
+    for (long i = 0; i < d_nmsgs; i++)
+      d_q->insert(mb_make_message(PMT_NIL, pmt_from_long((d_id << 16) | i),
+				  PMT_NIL, i % MB_NPRI));
+    return 0;
+  }
+};
+
+void
+qa_mblock_prims::test_msg_queue_threads()
+{
+  static const long NPRODUCERS = 4;
+  static const long NMSGS = 20000;
+
+  mb_msg_queue	q;
+  long		last[NPRODUCERS][MB_NPRI];
+
+  for (long p = 0; p < NPRODUCERS; p++)
+    for (mb_pri_t pri = 0; pri < MB_NPRI; pri++)
+      last[p][pri] = -1;
+
+  msgq_producer *producer[NPRODUCERS];
+  for (long p = 0; p < NPRODUCERS; p++)
+    producer[p] = new msgq_producer(&q, p, NMSGS);
+
+  // Every message arrives, and each producer's messages of a given
+  // priority arrive in the order they were sent.
+  for (long n = 0; n < NPRODUCERS * NMSGS; n++){
+    mb_message_sptr msg = q.get_highest_pri_msg();
+    long data = pmt_to_long(msg->data());
+    long p = data >> 16;
+    long i = data & 0xffff;
+    CPPUNIT_ASSERT(p >= 0 && p < NPRODUCERS);
+    CPPUNIT_ASSERT_EQUAL((mb_pri_t) (i % MB_NPRI), msg->priority());
+    CPPUNIT_ASSERT(i > last[p][msg->priority()]);
+    last[p][msg->priority()] = i;
+  }
+
+  for (long p = 0; p < NPRODUCERS; p++)
+    producer[p]->join(0);
+
+  CPPUNIT_ASSERT(q.get_highest_pri_msg_nowait() == 0);
+}
+
 ////////////////////////////////////////////////////////////////
 
 void
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2007,2008 Free Software Foundation, Inc.
+ * Copyright 2006,2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -269,3 +269,37 @@ qa_mblock_sys::test_disconnect()
 
   CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
 }
+
+// ================================================================
+//		          test_thread_pool
+// ================================================================
+
+void
+qa_mblock_sys::test_thread_pool()
+{
+  // More mblocks than threads, so they have to share.
+  mb_runtime_sptr rt = mb_make_runtime_thread_pool(2);
+  pmt_t result = PMT_NIL;
+
+  define_protocol_classes();
+
+  pmt_t	n1 = pmt_from_long(1);
+  pmt_t	n2 = pmt_from_long(2);
+  rt->run("top-1", "sys_1", n1, &result);
+  CPPUNIT_ASSERT(pmt_equal(n1, result));
+  rt->run("top-2", "sys_1", n2, &result);	// run it again, same rt
+  CPPUNIT_ASSERT(pmt_equal(n2, result));
+
+  result = PMT_NIL;
+  rt->run("top-sys-2", "sys_2", PMT_F, &result);
+  CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
+
+  result = PMT_NIL;
+  rt->run("top", "qa_bitset_top",
+	  pmt_list2(pmt_from_long(1000), pmt_from_long(8)), &result);
+  CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
+
+  result = PMT_NIL;
+  rt->run("top", "qa_disconnect_top", pmt_list1(pmt_from_long(10240)), &result);
+  CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
+}
@@ -32,6 +32,7 @@ class qa_mblock_sys : public CppUnit::TestCase {
   CPPUNIT_TEST(test_sys_2);
   CPPUNIT_TEST(test_bitset_1);
   CPPUNIT_TEST(test_disconnect);
+  CPPUNIT_TEST(test_thread_pool);
   CPPUNIT_TEST_SUITE_END();
 
  private:
@@ -39,6 +40,7 @@ class qa_mblock_sys : public CppUnit::TestCase {
   void test_sys_2();
   void test_bitset_1();
   void test_disconnect();
+  void test_thread_pool();
 };
 
 #endif /* INCLUDED_QA_MBLOCK_SYS_H */
@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007,2008 Free Software Foundation, Inc.
+ * Copyright 2007,2008,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -32,7 +32,9 @@
 #include <mblock/class_registry.h>
 #include <mb_timer_queue.h>
 #include <string.h>
+#include <stdlib.h>
 #include <iostream>
+#include <map>
 
 
 static pmt_t s_timeout = pmt_intern("%timeout");
@@ -123,6 +125,101 @@ qa_timeouts::test_timer_queue()
   CPPUNIT_ASSERT(tq.empty());
 }
 
+// ------------------------------------------------------------------------
+//    Lots of timeouts, from nanoseconds to days apart, checked against
+//    a std::multimap.  Exercises every level of the timing wheel.
+// ------------------------------------------------------------------------
+
+typedef std::multimap<std::pair<long, long>, mb_timeout_sptr> tq_ref_t;
+
+static std::pair<long, long>
+tq_key(const mb_time &t)
+{
+  return std::make_pair(t.d_secs, t.d_nsecs);
+}
+
+static mb_timeout_sptr
+tq_random_timeout(const mb_time &base)
+{
+  static const double spans[] = { 1e-6, 1e-3, 0.250, 16.0, 3600.0, 3 * 86400.0 };
+  double span = spans[random() % 6];
+  mb_time when = base + span * (random() / (double) RAND_MAX);
+  return mb_timeout_sptr(new mb_timeout(when, PMT_F, mb_msg_accepter_sptr()));
+}
+
+static void
+tq_push(mb_timer_queue &tq, tq_ref_t &ref, mb_timeout_sptr t)
+{
+  tq.push(t);
+  ref.insert(std::make_pair(tq_key(t->d_when), t));
+}
+
+static void
+tq_check_pop(mb_timer_queue &tq, tq_ref_t &ref)
+{
+  CPPUNIT_ASSERT(!tq.empty());
+  mb_timeout_sptr t = tq.top();
+  CPPUNIT_ASSERT(tq_key(t->d_when) == ref.begin()->first);	// ties in either order
+
+  tq_ref_t::iterator it = ref.find(tq_key(t->d_when));
+  while (it->second != t)
+    ++it;
+  ref.erase(it);
+  tq.pop();
+}
+
+void
+qa_timeouts::test_timer_queue_random()
+{
+  mb_timer_queue	tq;
+  tq_ref_t		ref;
+  mb_time		base(1234567890, 0);
+
+  srandom(1);
+
+  std::vector<mb_timeout_sptr> v;
+  for (int i = 0; i < 5000; i++){
+    v.push_back(tq_random_timeout(base));
+    tq_push(tq, ref, v.back());
+  }
+
+  // cancel every 7th
+  for (size_t i = 0; i < v.size(); i += 7){
+    tq.cancel(v[i]->handle());
+    tq_ref_t::iterator it = ref.find(tq_key(v[i]->d_when));
+    while (it->second != v[i])
+      ++it;
+    ref.erase(it);
+  }
+  CPPUNIT_ASSERT_EQUAL(ref.size(), tq.size());
+
+  // take some, then add more: some later, some already overdue
+  for (int i = 0; i < 1000; i++)
+    tq_check_pop(tq, ref);
+
+  mb_time now = ref.begin()->second->d_when;
+  for (int i = 0; i < 1000; i++)
+    tq_push(tq, ref, tq_random_timeout(i % 4 == 0 ? base : now));
+
+  // expire everything due within the next hour, as the runtime would
+  std::vector<mb_timeout_sptr> expired;
+  mb_time then = now + 3600.0;
+  tq.expire(then, expired);
+  for (size_t i = 0; i < expired.size(); i++){
+    CPPUNIT_ASSERT(tq_key(expired[i]->d_when) == ref.begin()->first);
+    CPPUNIT_ASSERT(expired[i]->d_when <= then);
+    tq_ref_t::iterator it = ref.find(tq_key(expired[i]->d_when));
+    while (it->second != expired[i])
+      ++it;
+    ref.erase(it);
+  }
+  CPPUNIT_ASSERT(tq.empty() || tq.top()->d_when > then);
+
+  while (!ref.empty())
+    tq_check_pop(tq, ref);
+  CPPUNIT_ASSERT(tq.empty());
+}
+
 // ------------------------------------------------------------------------
 //   Test one-shot timeouts
 // ------------------------------------------------------------------------
@@ -288,3 +385,96 @@ qa_timeouts::test_timeouts_2()
 
   CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
 }
+
+// ------------------------------------------------------------------------
+//   Test many one-shot timeouts, half of them cancelled
+// ------------------------------------------------------------------------
+
+class qa_timeouts_3_top : public mb_mblock
+{
+  static const int NTIMEOUTS = 100;
+
+  int		d_nfired;
+  int		d_nerrors;
+  mb_time	d_t0;
+  
+public:
+  qa_timeouts_3_top(mb_runtime *runtime,
+		    const std::string &instance_name, pmt_t user_arg);
+
+  void initial_transition();
+  void handle_message(mb_message_sptr msg);
+};
+
+qa_timeouts_3_top::qa_timeouts_3_top(mb_runtime *runtime,
+				     const std::string &instance_name,
+				     pmt_t user_arg)
+  : mb_mblock(runtime, instance_name, user_arg),
+    d_nfired(0), d_nerrors(0)
+{
+}
+
+void
+qa_timeouts_3_top::initial_transition()
+{
+  d_t0 = mb_time::time();	// now
+
+  // 50 ms to 250 ms, 2 ms apart, in a scrambled order
+  for (int i = 0; i < NTIMEOUTS; i++){
+    int k = (i * 37) % NTIMEOUTS;
+    double delta_t = 0.050 + k * 0.002;
+    pmt_t handle = schedule_one_shot_timeout(d_t0 + delta_t,
+					     pmt_cons(pmt_from_long(k),
+						      pmt_from_double(delta_t)));
+    if (k & 1)
+      cancel_timeout(handle);
+  }
+
+  schedule_one_shot_timeout(d_t0 + 0.300, s_done);
+}
+
+void
+qa_timeouts_3_top::handle_message(mb_message_sptr msg)
+{
+  if (!pmt_eq(msg->signal(), s_timeout))
+    return;
+
+  if (pmt_eq(msg->data(), s_done)){
+    if (d_nfired != NTIMEOUTS / 2){
+      std::cerr << "qa_timeouts_3_top: d_nfired = " << d_nfired
+		<< " expected " << NTIMEOUTS / 2 << std::endl;
+      d_nerrors++;
+    }
+    shutdown_all(d_nerrors == 0 ? PMT_T : PMT_F);
+    return;
+  }
+
+  mb_time t_now = mb_time::time();
+  long k = pmt_to_long(pmt_car(msg->data()));
+  double expected_delta_t = pmt_to_double(pmt_cdr(msg->data()));
+  double actual_delta_t = (t_now - d_t0).double_time();
+
+  d_nfired++;
+  if (k & 1){
+    std::cerr << "qa_timeouts_3_top: cancelled timeout " << k << " fired\n";
+    d_nerrors++;
+  }
+  if (fabs(expected_delta_t - actual_delta_t) > TIMING_MARGIN){
+    std::cerr << "qa_timeouts_3_top: expected_delta_t = " << expected_delta_t
+	      << " actual_delta_t = " << actual_delta_t << std::endl;
+    d_nerrors++;
+  }
+}
+
+REGISTER_MBLOCK_CLASS(qa_timeouts_3_top);
+
+void
+qa_timeouts::test_timeouts_3()
+{
+  mb_runtime_sptr rt = mb_make_runtime();
+  pmt_t result = PMT_NIL;
+
+  rt->run("top", "qa_timeouts_3_top", PMT_F, &result);
+
+  CPPUNIT_ASSERT(pmt_equal(PMT_T, result));
+}
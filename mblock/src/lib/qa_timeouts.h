@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2006,2007 Free Software Foundation, Inc.
+ * Copyright 2006,2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -29,14 +29,18 @@ class qa_timeouts : public CppUnit::TestCase {
 
   CPPUNIT_TEST_SUITE(qa_timeouts);
   CPPUNIT_TEST(test_timer_queue);
+  CPPUNIT_TEST(test_timer_queue_random);
   CPPUNIT_TEST(test_timeouts_1);
   CPPUNIT_TEST(test_timeouts_2);
+  CPPUNIT_TEST(test_timeouts_3);
   CPPUNIT_TEST_SUITE_END();
 
  private:
   void test_timer_queue();
+  void test_timer_queue_random();
   void test_timeouts_1();
   void test_timeouts_2();
+  void test_timeouts_3();
 };
 
 #endif /* INCLUDED_QA_TIMEOUTS_H */
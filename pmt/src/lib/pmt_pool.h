@@ -1,6 +1,6 @@
 /* -*- c++ -*- */
 /*
- * Copyright 2007 Free Software Foundation, Inc.
+ * Copyright 2007,2010 Free Software Foundation, Inc.
  * 
  * This file is part of GNU Radio
  * 
@@ -22,7 +22,7 @@
 #define INCLUDED_PMT_POOL_H
 
 #include <cstddef>
-#include <gnuradio/omnithread.h>
+#include <gruel/futex.h>
 #include <vector>
 
 /*!
@@ -37,8 +37,8 @@ class pmt_pool {
     struct item	*d_next;
   };
   
-  omni_mutex	      d_mutex;
-  omni_condition      d_cond;
+  gruel::futex_mutex     d_mutex;
+  gruel::futex_condition d_cond;
   
   size_t	      d_itemsize;
   size_t	      d_alignment;